@@ -6,16 +6,25 @@
 
 #include <fmod_errors.h>
 #include <spdlog/spdlog.h>
+#include <json/json.hpp>
 #include <algorithm>
+#include <fstream>
 #include <ctime>
+#include <chrono>
 
 namespace TSM
 {
+    using json = nlohmann::json;
+
+std::string AnnouncementManager::FragmentSoundId(const std::string& fragmentId)
+{
+    return "announce_fragment_" + fragmentId;
+}
 
 void AnnouncementManager::ScheduleAnnouncement(int hour, int minute, const std::string& announcementId)
 {
     FMOD::Sound* sound = AudioManager::GetInstance().GetSound(announcementId);
-    if (!sound) {
+    if (!sound && !IsPhrase(announcementId)) {
         spdlog::error("Impossible to schedule announcement '{}' because it is not loaded or not found.", announcementId);
         return;
     }
@@ -28,6 +37,7 @@ void AnnouncementManager::ScheduleAnnouncement(int hour, int minute, const std::
     announcement.triggered = false;
     
     m_scheduled.push_back(announcement);
+    m_scheduleRevision++;
     
     spdlog::info("Announcement '{}' scheduled at {:02d}:{:02d}", announcementId, hour, minute);
 }
@@ -45,6 +55,7 @@ void AnnouncementManager::UpdateScheduledAnnouncement(size_t index, int hour, in
     m_scheduled[index].announcementId = announcementId;
     m_scheduled[index].announceID = announcementId; 
     m_scheduled[index].triggered = false;
+    m_scheduleRevision++;
 
     spdlog::info("Updated scheduled announcement at index {} to {}:{} with ID '{}'", 
                  index, hour, minute, announcementId);
@@ -53,6 +64,15 @@ void AnnouncementManager::UpdateScheduledAnnouncement(size_t index, int hour, in
 void AnnouncementManager::Update(float deltaTime)
 {
     CheckSchedules(deltaTime);
+
+    // Les fins de canal arrivent par le callback FMOD ; un canal fini repasse à nullptr
+    if (m_channelEnds.HasEvents()) {
+        m_channelEnds.Drain(m_endedChannels);
+        for (const auto& ended : m_endedChannels) {
+            if (ended.channel == m_sfxChannel) m_sfxChannel = nullptr;
+            if (ended.channel == m_currentAnnouncementChannel) m_currentAnnouncementChannel = nullptr;
+        }
+    }
     
     switch (m_state)
     {
@@ -75,10 +95,11 @@ void AnnouncementManager::Update(float deltaTime)
                 if (m_useSFXBefore)
                 {
                     float sfxVolume = UIManager::GetInstance().GetSFXVolume() * UIManager::GetInstance().GetMasterVolume();
-                    m_sfxChannel = AudioManager::GetInstance().PlaySound(m_sfxName, false, sfxVolume);
+                    m_sfxChannel = AudioManager::GetInstance().PlaySound(m_sfxName, false, sfxVolume, 1.0f, m_output);
                     
                     if (m_sfxChannel) {
                         m_sfxChannel->setVolume(sfxVolume);
+                        m_channelEnds.Watch(m_sfxChannel, 0);
                     }
                     
                     UIManager::GetInstance().ForceUpdateAllVolumes();
@@ -88,11 +109,11 @@ void AnnouncementManager::Update(float deltaTime)
                 else
                 {
                     float announcementVolume = UIManager::GetInstance().GetAnnouncementVolume() * UIManager::GetInstance().GetMasterVolume();
-                    m_currentAnnouncementChannel = AudioManager::GetInstance().PlaySound(
-                        m_currentAnnouncementName, false, announcementVolume);
+                    m_currentAnnouncementChannel = StartAnnouncementVoice(announcementVolume);
                     
                     if (m_currentAnnouncementChannel) {
                         m_currentAnnouncementChannel->setVolume(announcementVolume);
+                        m_channelEnds.Watch(m_currentAnnouncementChannel, 0);
                     }
                     
                     UIManager::GetInstance().ForceUpdateAllVolumes();
@@ -105,32 +126,13 @@ void AnnouncementManager::Update(float deltaTime)
 
         case AnnouncementState::PLAYING_SFX_BEFORE:
         {
-            if (m_sfxChannel) {
-                bool isPlaying = false;
-                m_sfxChannel->isPlaying(&isPlaying);
-
-                if (!isPlaying) {
-                    m_sfxChannel = nullptr;
-                    float announcementVolume = UIManager::GetInstance().GetAnnouncementVolume() * UIManager::GetInstance().GetMasterVolume();
-                    m_currentAnnouncementChannel = AudioManager::GetInstance().PlaySound(
-                        m_currentAnnouncementName, false, announcementVolume);
-                    
-                    if (m_currentAnnouncementChannel) {
-                        m_currentAnnouncementChannel->setVolume(announcementVolume);
-                    }
-                    
-                    UIManager::GetInstance().ForceUpdateAllVolumes();
-
-                    m_state = AnnouncementState::PLAYING_ANNOUNCEMENT;
-                }
-            }
-            else {
+            if (!m_sfxChannel) {
                 float announcementVolume = UIManager::GetInstance().GetAnnouncementVolume() * UIManager::GetInstance().GetMasterVolume();
-                m_currentAnnouncementChannel = AudioManager::GetInstance().PlaySound(
-                    m_currentAnnouncementName, false, announcementVolume);
+                m_currentAnnouncementChannel = StartAnnouncementVoice(announcementVolume);
                 
                 if (m_currentAnnouncementChannel) {
                     m_currentAnnouncementChannel->setVolume(announcementVolume);
+                    m_channelEnds.Watch(m_currentAnnouncementChannel, 0);
                 }
                 
                 UIManager::GetInstance().ForceUpdateAllVolumes();
@@ -142,36 +144,15 @@ void AnnouncementManager::Update(float deltaTime)
 
         case AnnouncementState::PLAYING_ANNOUNCEMENT:
         {
-            if (m_currentAnnouncementChannel) {
-                bool isPlaying = false;
-                m_currentAnnouncementChannel->isPlaying(&isPlaying);
-                if (!isPlaying) {
-                    m_currentAnnouncementChannel = nullptr;
-                    if (m_useSFXAfter) {
-                        float sfxVolume = UIManager::GetInstance().GetSFXVolume() * UIManager::GetInstance().GetMasterVolume();
-                        m_sfxChannel = AudioManager::GetInstance().PlaySound(m_sfxName, false, sfxVolume);
-                        
-                        if (m_sfxChannel) {
-                            m_sfxChannel->setVolume(sfxVolume);
-                        }
-                        
-                        UIManager::GetInstance().ForceUpdateAllVolumes();
-
-                        m_state = AnnouncementState::PLAYING_SFX_AFTER;
-                    }
-                    else {
-                        m_duckTimer = 0.0f;
-                        m_state = AnnouncementState::DUCKING_OUT;
-                    }
-                }
-            }
-            else {
+            if (!m_currentAnnouncementChannel) {
+                m_phraseChannels.clear();
                 if (m_useSFXAfter) {
                     float sfxVolume = UIManager::GetInstance().GetSFXVolume() * UIManager::GetInstance().GetMasterVolume();
-                    m_sfxChannel = AudioManager::GetInstance().PlaySound(m_sfxName, false, sfxVolume);
+                    m_sfxChannel = AudioManager::GetInstance().PlaySound(m_sfxName, false, sfxVolume, 1.0f, m_output);
                     
                     if (m_sfxChannel) {
                         m_sfxChannel->setVolume(sfxVolume);
+                        m_channelEnds.Watch(m_sfxChannel, 0);
                     }
                     
                     UIManager::GetInstance().ForceUpdateAllVolumes();
@@ -188,16 +169,7 @@ void AnnouncementManager::Update(float deltaTime)
 
         case AnnouncementState::PLAYING_SFX_AFTER:
         {
-            if (m_sfxChannel) {
-                bool isPlaying = false;
-                m_sfxChannel->isPlaying(&isPlaying);
-                if (!isPlaying) {
-                    m_sfxChannel = nullptr;
-                    m_duckTimer = 0.0f;
-                    m_state = AnnouncementState::DUCKING_OUT;
-                }
-            }
-            else {
+            if (!m_sfxChannel) {
                 m_duckTimer = 0.0f;
                 m_state = AnnouncementState::DUCKING_OUT;
             }
@@ -244,6 +216,15 @@ void AnnouncementManager::StopAnnouncement()
         m_sfxChannel = nullptr;
     }
 
+    for (auto* channel : m_phraseChannels) {
+        bool isPlaying = false;
+        channel->isPlaying(&isPlaying);
+        if (isPlaying) {
+            channel->stop();
+        }
+    }
+    m_phraseChannels.clear();
+
     UIManager::GetInstance().SetDuckFactor(1.0f);
     UIManager::GetInstance().ForceUpdateAllVolumes();
 
@@ -258,7 +239,7 @@ FMOD::Channel* AnnouncementManager::PlayAnnouncement(const std::string& announce
     StopAnnouncement();
 
     FMOD::Sound* sound = AudioManager::GetInstance().GetSound(announcementId);
-    if (!sound) {
+    if (!sound && !IsPhrase(announcementId)) {
         spdlog::error("Announcement '{}' not loaded or not found.", announcementId);
         return nullptr;
     }
@@ -284,7 +265,7 @@ FMOD::Channel* AnnouncementManager::PlayAnnouncement(const std::string& announce
 void AnnouncementManager::AddScheduledAnnouncement(int hour, int minute, const std::string& annID)
 {
     FMOD::Sound* sound = AudioManager::GetInstance().GetSound(annID);
-    if (!sound) {
+    if (!sound && !IsPhrase(annID)) {
         spdlog::error("Impossible to schedule announcement '{}' because it is not loaded or not found.", annID);
         return;
     }
@@ -297,6 +278,7 @@ void AnnouncementManager::AddScheduledAnnouncement(int hour, int minute, const s
     announcement.triggered = false;
     
     m_scheduled.push_back(announcement);
+    m_scheduleRevision++;
     
     spdlog::info("Announcement '{}' scheduled at {:02d}:{:02d}", annID, hour, minute);
 }
@@ -308,6 +290,7 @@ void AnnouncementManager::RemoveScheduledAnnouncement(size_t index)
         spdlog::info("Removed scheduled announcement '{}' at {:02d}:{:02d}", 
                      ann.announcementId, ann.hour, ann.minute);
         m_scheduled.erase(m_scheduled.begin() + index);
+        m_scheduleRevision++;
     }
 }
 
@@ -316,14 +299,31 @@ void AnnouncementManager::ResetTriggeredAnnouncements()
     for (auto& ann : m_scheduled) {
         ann.triggered = false;
     }
+    m_scheduleRevision++;
     spdlog::info("Reset all triggered flags for scheduled announcements");
 }
 
+void AnnouncementManager::SetScheduleTriggered(size_t index, bool triggered)
+{
+    if (index >= m_scheduled.size() || m_scheduled[index].triggered == triggered) return;
+    m_scheduled[index].triggered = triggered;
+    m_scheduleRevision++;
+}
+
 float AnnouncementManager::GetAnnouncementProgress() const
 {
     if (!m_isAnnouncing || !m_currentAnnouncementChannel) {
         return 0.0f;
     }
+
+    if (!m_phraseChannels.empty() && m_phraseTotalSamples > 0) {
+        unsigned long long clock = AudioManager::GetInstance().GetMasterDSPClock(m_output);
+        if (clock <= m_phraseStartClock) {
+            return 0.0f;
+        }
+        float progress = static_cast<float>(clock - m_phraseStartClock) / static_cast<float>(m_phraseTotalSamples);
+        return std::min(progress, 1.0f);
+    }
     
     bool isPlaying = false;
     m_currentAnnouncementChannel->isPlaying(&isPlaying);
@@ -389,9 +389,10 @@ void AnnouncementManager::CheckSchedules(float /*deltaTime*/)
             if (s.hour == currentHour && s.minute == currentMinute)
             {
                 FMOD::Sound* sound = AudioManager::GetInstance().GetSound(s.announcementId);
-                if (!sound) {
+                if (!sound && !IsPhrase(s.announcementId)) {
                     spdlog::error("Impossible to play scheduled announcement '{}' because it is not loaded or not found.", s.announcementId);
                     s.triggered = true;
+                    m_scheduleRevision++;
                     continue;
                 }
                 
@@ -400,14 +401,264 @@ void AnnouncementManager::CheckSchedules(float /*deltaTime*/)
 
                 PlayAnnouncement(s.announcementId, 0.05f, true, true);
                 s.triggered = true;
+                m_scheduleRevision++;
             }
         }
     }
 }
 
+float AnnouncementManager::GetSecondsUntilNextSchedule() const
+{
+    const auto now = std::chrono::system_clock::now();
+    std::time_t t = std::chrono::system_clock::to_time_t(now);
+    std::tm localTm;
+#ifdef _WIN32
+    localtime_s(&localTm, &t);
+#else
+    localtime_r(&t, &localTm);
+#endif
+    const double fraction = std::chrono::duration<double>(now - std::chrono::system_clock::from_time_t(t)).count();
+    const double secondsOfDay = localTm.tm_hour * 3600.0 + localTm.tm_min * 60.0 + localTm.tm_sec + fraction;
+
+    // CheckSchedules fires on the first frame of the scheduled minute
+    double next = -1.0;
+    for (const auto& s : m_scheduled)
+    {
+        if (s.triggered) continue;
+        const double in = s.hour * 3600.0 + s.minute * 60.0 - secondsOfDay;
+        if (in > 0.0 && (next < 0.0 || in < next)) next = in;
+    }
+    return static_cast<float>(next);
+}
+
 bool AnnouncementManager::LoadAnnouncement(const std::string& announcementId, const std::string& filePath)
 {
     return AudioManager::GetInstance().LoadAnnouncement(announcementId, filePath);
 }
 
+bool AnnouncementManager::RegisterFragment(const std::string& fragmentId, const std::string& filePath)
+{
+    if (fragmentId.empty() || filePath.empty()) {
+        spdlog::error("Invalid announcement fragment definition.");
+        return false;
+    }
+
+    auto it = m_fragmentPaths.find(fragmentId);
+    if (it != m_fragmentPaths.end() && it->second != filePath &&
+        AudioManager::GetInstance().GetFragmentRefCount(FragmentSoundId(fragmentId)) > 0) {
+        spdlog::error("Fragment '{}' is in use and cannot be redefined.", fragmentId);
+        return false;
+    }
+
+    m_fragmentPaths[fragmentId] = filePath;
+    spdlog::debug("Announcement fragment '{}' registered: {}", fragmentId, filePath);
+    return true;
+}
+
+bool AnnouncementManager::RegisterPhrase(const std::string& phraseId, const std::vector<std::string>& fragmentIds)
+{
+    if (fragmentIds.empty()) {
+        spdlog::error("Phrase '{}' has no fragments.", phraseId);
+        return false;
+    }
+
+    for (const auto& fragmentId : fragmentIds) {
+        if (m_fragmentPaths.find(fragmentId) == m_fragmentPaths.end()) {
+            spdlog::error("Phrase '{}' uses unknown fragment '{}'.", phraseId, fragmentId);
+            return false;
+        }
+    }
+
+    auto& audioManager = AudioManager::GetInstance();
+    std::vector<std::string> acquired;
+    for (const auto& fragmentId : fragmentIds) {
+        if (!audioManager.AcquireFragment(FragmentSoundId(fragmentId), m_fragmentPaths[fragmentId], m_output)) {
+            for (const auto& acquiredId : acquired) {
+                audioManager.ReleaseFragment(FragmentSoundId(acquiredId));
+            }
+            return false;
+        }
+        acquired.push_back(fragmentId);
+    }
+
+    // Acquire before releasing the previous definition so shared fragments are not reloaded.
+    UnregisterPhrase(phraseId);
+
+    Phrase phrase;
+    phrase.fragments = fragmentIds;
+    m_phrases[phraseId] = phrase;
+
+    spdlog::info("Phrase '{}' registered with {} fragments.", phraseId, fragmentIds.size());
+    return true;
+}
+
+void AnnouncementManager::UnregisterPhrase(const std::string& phraseId)
+{
+    auto it = m_phrases.find(phraseId);
+    if (it == m_phrases.end()) {
+        return;
+    }
+
+    if (m_isAnnouncing && m_currentAnnouncementName == phraseId) {
+        StopAnnouncement();
+    }
+
+    for (const auto& fragmentId : it->second.fragments) {
+        AudioManager::GetInstance().ReleaseFragment(FragmentSoundId(fragmentId));
+    }
+
+    m_phrases.erase(it);
+}
+
+bool AnnouncementManager::LoadPhraseLibrary(const std::string& filePath)
+{
+    try
+    {
+        std::ifstream file(filePath.c_str());
+        if (!file.is_open())
+        {
+            spdlog::warn("Phrase library '{}' not found.", filePath);
+            return false;
+        }
+
+        json j;
+        file >> j;
+        file.close();
+
+        if (j.contains("fragments"))
+        {
+            for (const auto& [fragmentId, path] : j["fragments"].items())
+            {
+                RegisterFragment(fragmentId, path.get<std::string>());
+            }
+        }
+
+        size_t phraseCount = 0;
+        if (j.contains("phrases"))
+        {
+            for (const auto& [phraseId, fragments] : j["phrases"].items())
+            {
+                if (RegisterPhrase(phraseId, fragments.get<std::vector<std::string>>()))
+                {
+                    phraseCount++;
+                }
+            }
+        }
+
+        spdlog::info("Loaded {} phrases from '{}'.", phraseCount, filePath);
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+        spdlog::error("Error loading phrase library: {}", e.what());
+        return false;
+    }
+}
+
+bool AnnouncementManager::IsPhrase(const std::string& announcementId) const
+{
+    return m_phrases.find(announcementId) != m_phrases.end();
+}
+
+void AnnouncementManager::SetOutput(OutputId output)
+{
+    if (output == m_output) return;
+
+    if (m_isAnnouncing) {
+        StopAnnouncement();
+    }
+    m_output = output;
+
+    // Les décalages sont en échantillons de la sortie : à recalculer sur la nouvelle
+    for (auto& [phraseId, phrase] : m_phrases) {
+        phrase.assembled = false;
+    }
+}
+
+std::vector<unsigned long long> AnnouncementManager::GetPhraseOffsets(const std::string& phraseId)
+{
+    auto it = m_phrases.find(phraseId);
+    if (it == m_phrases.end() || (!it->second.assembled && !AssemblePhrase(it->second))) {
+        return {};
+    }
+    return it->second.offsets;
+}
+
+std::vector<std::string> AnnouncementManager::GetPhraseIds() const
+{
+    std::vector<std::string> ids;
+    ids.reserve(m_phrases.size());
+    for (const auto& [phraseId, phrase] : m_phrases) {
+        ids.push_back(phraseId);
+    }
+    return ids;
+}
+
+bool AnnouncementManager::AssemblePhrase(Phrase& phrase)
+{
+    auto& audioManager = AudioManager::GetInstance();
+    const int outputRate = audioManager.GetOutputSampleRate(m_output);
+
+    phrase.offsets.clear();
+    phrase.totalSamples = 0;
+
+    for (const auto& fragmentId : phrase.fragments) {
+        FMOD::Sound* sound = audioManager.GetSound(FragmentSoundId(fragmentId), m_output);
+        if (!sound) {
+            spdlog::error("Fragment '{}' is not loaded.", fragmentId);
+            return false;
+        }
+
+        unsigned int lengthPcm = 0;
+        float frequency = 0.0f;
+        sound->getLength(&lengthPcm, FMOD_TIMEUNIT_PCM);
+        sound->getDefaults(&frequency, nullptr);
+        if (frequency <= 0.0f) {
+            frequency = static_cast<float>(outputRate);
+        }
+
+        phrase.offsets.push_back(phrase.totalSamples);
+        phrase.totalSamples += static_cast<unsigned long long>(
+            static_cast<double>(lengthPcm) * outputRate / frequency);
+    }
+
+    phrase.assembled = true;
+    return true;
+}
+
+FMOD::Channel* AnnouncementManager::StartAnnouncementVoice(float volume)
+{
+    auto phraseIt = m_phrases.find(m_currentAnnouncementName);
+    if (phraseIt == m_phrases.end()) {
+        return AudioManager::GetInstance().PlaySound(m_currentAnnouncementName, false, volume, 1.0f, m_output);
+    }
+
+    Phrase& phrase = phraseIt->second;
+    if (!phrase.assembled && !AssemblePhrase(phrase)) {
+        return nullptr;
+    }
+
+    auto& audioManager = AudioManager::GetInstance();
+
+    // Leave a small lead so every fragment start lies in the future of the mixer.
+    const unsigned long long lead = static_cast<unsigned long long>(audioManager.GetOutputSampleRate(m_output) / 20);
+    const unsigned long long startClock = audioManager.GetMasterDSPClock(m_output) + lead;
+
+    m_phraseChannels.clear();
+    for (size_t i = 0; i < phrase.fragments.size(); i++) {
+        FMOD::Channel* channel = audioManager.PlaySoundScheduled(
+            FragmentSoundId(phrase.fragments[i]), startClock + phrase.offsets[i], volume, m_output);
+        if (channel) {
+            m_phraseChannels.push_back(channel);
+        }
+    }
+
+    m_phraseStartClock   = startClock;
+    m_phraseTotalSamples = phrase.totalSamples;
+
+    spdlog::info("Phrase '{}' scheduled with {} fragments.", m_currentAnnouncementName, m_phraseChannels.size());
+
+    return m_phraseChannels.empty() ? nullptr : m_phraseChannels.back();
+}
+
 } // namespace TSM
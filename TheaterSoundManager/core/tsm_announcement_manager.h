@@ -5,6 +5,10 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <cstdint>
+
+#include "tsm_channel_end_queue.h"
+#include "tsm_fmod_wrapper.h"
 
 namespace TSM
 {
@@ -33,6 +37,24 @@ public:
     void AddScheduledAnnouncement(int hour, int minute, const std::string& annID);
     
     bool LoadAnnouncement(const std::string& announcementId, const std::string& filePath);
+
+    // Phrase announcements are assembled from shared, reference-counted fragments
+    // and scheduled back to back on the DSP clock.
+    bool RegisterFragment(const std::string& fragmentId, const std::string& filePath);
+    bool RegisterPhrase(const std::string& phraseId, const std::vector<std::string>& fragmentIds);
+    void UnregisterPhrase(const std::string& phraseId);
+    bool LoadPhraseLibrary(const std::string& filePath);
+    bool IsPhrase(const std::string& announcementId) const;
+    std::vector<std::string> GetPhraseIds() const;
+    // Where each fragment starts, in output samples from the start of the phrase; empty
+    // if the phrase is unknown or one of its fragments cannot be opened.
+    std::vector<unsigned long long> GetPhraseOffsets(const std::string& phraseId);
+    // AudioManager id a fragment's sound is loaded under.
+    static std::string FragmentSoundId(const std::string& fragmentId);
+
+    // Stops the current announcement; the next ones play on that output.
+    void SetOutput(OutputId output);
+    OutputId GetOutput() const { return m_output; }
     
     void Update(float deltaTime);
     void StopAnnouncement();
@@ -50,6 +72,12 @@ public:
     void RemoveScheduledAnnouncement(size_t index);
     void UpdateScheduledAnnouncement(size_t index, int hour, int minute, const std::string& announcementId);
     void ResetTriggeredAnnouncements();
+    void SetScheduleTriggered(size_t index, bool triggered);
+
+    // Seconds until the next schedule still to fire today, -1 if there is none.
+    float GetSecondsUntilNextSchedule() const;
+    // Bumped whenever the schedule changes or one of its entries fires.
+    uint64_t GetScheduleRevision() const { return m_scheduleRevision; }
     
     bool IsAnnouncing() const { return m_isAnnouncing; }
     AnnouncementState GetAnnouncementState() const { return m_state; }
@@ -78,9 +106,31 @@ private:
     std::string    m_currentAnnouncementName;
     bool           m_isAnnouncing = false;
 
+    OutputId       m_output = FModWrapper::MainOutput;
+
 private:
     void CheckSchedules(float deltaTime);
     std::vector<ScheduledAnnouncement> m_scheduled;
+    uint64_t m_scheduleRevision = 0;
+
+    struct Phrase
+    {
+        std::vector<std::string> fragments;
+        std::vector<unsigned long long> offsets;
+        unsigned long long totalSamples = 0;
+        bool assembled = false;
+    };
+
+    bool AssemblePhrase(Phrase& phrase);
+    FMOD::Channel* StartAnnouncementVoice(float volume);
+
+    std::map<std::string, std::string> m_fragmentPaths;
+    std::map<std::string, Phrase>      m_phrases;
+    std::vector<FMOD::Channel*>        m_phraseChannels;
+    ChannelEndQueue                    m_channelEnds;
+    std::vector<ChannelEndEvent>       m_endedChannels;
+    unsigned long long                 m_phraseStartClock   = 0;
+    unsigned long long                 m_phraseTotalSamples = 0;
 };
 
 } // namespace TSM
@@ -2,8 +2,11 @@
 
 #include "tsm_audio_manager.h"
 #include "tsm_fmod_wrapper.h"
+#include "tsm_audio_probe.h"
+#include "tsm_cue_stack.h"
 
 #include <spdlog/spdlog.h>
+#include <algorithm>
 
 namespace TSM 
 {
@@ -16,30 +19,58 @@ bool AudioManager::LoadSound(const std::string& soundName, const std::string& fi
         return true;
     }
 
-    FMOD_MODE mode = FMOD_DEFAULT;
-    if (isStream)
+    SoundData data; 
+    data.filePath = filePath;
+    data.isStream = isStream;
+    data.sound = CreateOutputSound(data, FModWrapper::GetInstance().GetSystem());
+    if (!data.sound)
     {
-        mode |= FMOD_CREATESTREAM;
+        return false;
     }
+    spdlog::info("FMOD createSound success: {} for file: {}", soundName, filePath);
 
-    FMOD::Sound* newSound = nullptr;
-    FMOD_RESULT result = FModWrapper::GetInstance().GetSystem()->createSound(filePath.c_str(), mode, nullptr, &newSound);
-    if (result != FMOD_OK)
+    m_sounds[soundName] = data;
+
+    spdlog::info("Sound loaded successfully: {}", soundName);
+    return true;
+}
+
+bool AudioManager::LoadSeamlessLoop(const std::string& soundName, const std::string& filePath, const LoopRenderSettings& settings)
+{
+    if (m_sounds.find(soundName) != m_sounds.end())
     {
-        spdlog::error("FMOD createSound failed: {} for file: {}", FMOD_ErrorString(result), filePath);
-        return false;
+        spdlog::error("Sound already loaded: {}", soundName);
+        return true;
     }
-    else
+
+    SoundData data;
+    data.filePath = filePath;
+    ReadGaplessTrim(data);
+
+    FMOD::System* system = FModWrapper::GetInstance().GetSystem();
+    RenderedLoop loop;
+    if (!LoopRenderer::GetInstance().Render(system, filePath, data.leadInPcm, data.tailPcm, settings, loop))
     {
-        spdlog::info("FMOD createSound success: {} for file: {}", soundName, filePath);
+        spdlog::warn("No seamless loop for {}, looping the file as is.", soundName);
+        return LoadSound(soundName, filePath, true);
     }
-    
-    SoundData data; 
+
+    FMOD::Sound* newSound = PcmCache::CreateSound(system, *loop.pcm, FMOD_LOOP_NORMAL);
+    if (!newSound) return false;
+
+    const unsigned int frames = static_cast<unsigned int>(loop.pcm->data.size() / (loop.pcm->channels * sizeof(int16_t)));
+    newSound->setLoopPoints(0, FMOD_TIMEUNIT_PCM, frames - 1, FMOD_TIMEUNIT_PCM);
+
+    // Le rendu a déjà retiré le silence d'encodeur
     data.sound = newSound;
-    data.filePath = filePath;
+    data.pcm = loop.pcm;
+    data.isStream = false;
+    data.leadInPcm = 0;
+    data.tailPcm = 0;
+    data.lengthMs = static_cast<unsigned int>(uint64_t(frames) * 1000 / loop.pcm->sampleRate);
     m_sounds[soundName] = data;
 
-    spdlog::info("Sound loaded successfully: {}", soundName);
+    spdlog::info("Seamless loop loaded: {} ({} ms)", soundName, data.lengthMs);
     return true;
 }
 
@@ -48,16 +79,6 @@ bool AudioManager::UnloadSound(const std::string& soundName)
     auto it = m_sounds.find(soundName);
     if (it != m_sounds.end())
     {
-        if (it->second.sound)
-        {
-            FMOD_RESULT result = it->second.sound->release();
-            if (result != FMOD_OK)
-            {
-                spdlog::error("Failed to release sound {}: {}", soundName, FMOD_ErrorString(result));
-                return false;
-            }
-        }
-
         for (auto channel : it->second.channels)
         {
             if (channel)
@@ -71,6 +92,28 @@ bool AudioManager::UnloadSound(const std::string& soundName)
             }
         }
 
+        // Les canaux armés sont en pause : ils ne partiraient jamais et garderaient le son
+        CueStack::GetInstance().ReleaseSound(soundName);
+        for (auto channel : it->second.armedChannels)
+        {
+            if (channel) channel->stop();
+        }
+        it->second.armedChannels.clear();
+
+        ReleaseOutputSounds(it->second);
+        if (it->second.sound)
+        {
+            FMOD_RESULT result = it->second.sound->release();
+            if (result != FMOD_OK)
+            {
+                spdlog::error("Failed to release sound {}: {}", soundName, FMOD_ErrorString(result));
+                return false;
+            }
+            it->second.sound = nullptr;
+        }
+
+        // Plus aucun son ne pointe sur les échantillons
+        it->second.pcm.reset();
         m_sounds.erase(it);
         spdlog::info("Sound {} unloaded successfully", soundName);
         return true;
@@ -80,32 +123,208 @@ bool AudioManager::UnloadSound(const std::string& soundName)
     return false;
 }
 
-FMOD::Channel* AudioManager::PlaySound(const std::string& soundName, bool loop, float volume, float pitch)
+bool AudioManager::RegisterDeferredSound(const std::string& soundName, const std::string& filePath, unsigned int lengthMs, bool isStream)
+{
+    auto [it, inserted] = m_sounds.try_emplace(soundName);
+    if (inserted)
+    {
+        it->second.filePath = filePath;
+        it->second.isStream = isStream;
+        it->second.lengthMs = lengthMs;
+    }
+    return true;
+}
+
+AudioManager::SoundData* AudioManager::ResolveSound(const std::string& soundName)
 {
     auto it = m_sounds.find(soundName);
     if (it == m_sounds.end())
     {
-        spdlog::error("Sound not found: {}", soundName);
         return nullptr;
     }
-    
+
     SoundData& data = it->second;
-    if (!data.sound)
+    FMOD::System* system = FModWrapper::GetInstance().GetSystem();
+    if (!data.sound && !data.filePath.empty() && system)
+    {
+        data.sound = CreateOutputSound(data, system);
+        if (!data.sound)
+        {
+            return &data;
+        }
+        spdlog::debug("Deferred sound created on first use: {}", soundName);
+    }
+    return &data;
+}
+
+bool AudioManager::PrefetchSound(const std::string& soundName, OutputId output)
+{
+    SoundData* data = ResolveSound(soundName);
+    return data && GetOutputSound(*data, output) != nullptr;
+}
+
+FMOD::Sound* AudioManager::GetOutputSound(SoundData& data, OutputId output)
+{
+    if (output == FModWrapper::MainOutput) return data.sound;
+
+    auto it = data.outputSounds.find(output);
+    if (it != data.outputSounds.end()) return it->second;
+
+    FMOD::System* system = FModWrapper::GetInstance().GetSystem(output);
+    if (!system || data.filePath.empty()) return nullptr;
+
+    FMOD::Sound* sound = CreateOutputSound(data, system);
+    if (!sound) return nullptr;
+
+    data.outputSounds[output] = sound;
+    return sound;
+}
+
+// Every output, the main one included, goes through here: samples are decoded once
+// into data.pcm and each system points its sound at them.
+FMOD::Sound* AudioManager::CreateOutputSound(SoundData& data, FMOD::System* system)
+{
+    if (!system) return nullptr;
+
+    // Un stream ne se partage pas : chaque sortie lit le fichier de son côté
+    if (data.isStream)
+    {
+        FMOD::Sound* sound = nullptr;
+        FMOD_RESULT result = system->createSound(data.filePath.c_str(), FMOD_DEFAULT | FMOD_CREATESTREAM, nullptr, &sound);
+        if (result != FMOD_OK)
+        {
+            spdlog::error("FMOD createSound failed: {} for file: {}", FMOD_ErrorString(result), data.filePath);
+            return nullptr;
+        }
+        return sound;
+    }
+
+    if (!data.pcm)
+    {
+        data.pcm = PcmCache::GetInstance().Decode(system, data.filePath);
+        if (!data.pcm) return nullptr;
+    }
+    return PcmCache::CreateSound(system, *data.pcm);
+}
+
+void AudioManager::ReleaseOutputSounds(SoundData& data)
+{
+    for (auto& [output, sound] : data.outputSounds)
+    {
+        if (sound) sound->release();
+    }
+    data.outputSounds.clear();
+}
+
+void AudioManager::ReleaseOutputSounds(OutputId output)
+{
+    for (auto& [name, data] : m_sounds)
+    {
+        auto it = data.outputSounds.find(output);
+        if (it == data.outputSounds.end()) continue;
+
+        if (it->second) it->second->release();
+        data.outputSounds.erase(it);
+    }
+}
+
+unsigned int AudioManager::GetSoundLengthMs(const std::string& soundName) const
+{
+    auto it = m_sounds.find(soundName);
+    if (it == m_sounds.end())
+    {
+        return 0;
+    }
+
+    unsigned int lengthMs = it->second.lengthMs;
+    if (it->second.sound)
+    {
+        it->second.sound->getLength(&lengthMs, FMOD_TIMEUNIT_MS);
+    }
+    return lengthMs;
+}
+
+bool AudioManager::SetSoundMetadata(const std::string& soundName, const std::string& title, const std::string& artist, const std::string& album)
+{
+    auto it = m_sounds.find(soundName);
+    if (it == m_sounds.end())
+    {
+        spdlog::error("Sound not found: {}", soundName);
+        return false;
+    }
+
+    it->second.title = title;
+    it->second.artist = artist;
+    it->second.album = album;
+    return true;
+}
+
+FMOD::Channel* AudioManager::PlaySound(const std::string& soundName, bool loop, float volume, float pitch, OutputId output, unsigned int startPcm)
+{
+    SoundData* resolved = ResolveSound(soundName);
+    if (!resolved)
+    {
+        spdlog::error("Sound not found: {}", soundName);
+        return nullptr;
+    }
+
+    FMOD::Channel* channel = OpenChannel(*resolved, soundName, loop, volume, pitch, output, startPcm);
+    if (!channel)
+    {
+        return nullptr;
+    }
+    if (channel->setPaused(false) != FMOD_OK)
+    {
+        channel->stop();
+        return nullptr;
+    }
+    resolved->channels.push_back(channel);
+
+    float volumeTemp;
+    channel->getVolume(&volumeTemp);
+    spdlog::info("Volume of {} after configuration: {}", soundName, volumeTemp);
+
+    return channel;
+}
+
+FMOD::Channel* AudioManager::ArmSound(const std::string& soundName, bool loop, float volume, float pitch, OutputId output, unsigned int startPcm)
+{
+    SoundData* resolved = ResolveSound(soundName);
+    if (!resolved)
+    {
+        spdlog::error("Sound not found: {}", soundName);
+        return nullptr;
+    }
+
+    // Un flux n'a qu'un canal : l'armer maintenant couperait ce qui joue déjà
+    SoundData& data = *resolved;
+    FMOD::Sound* sound = GetOutputSound(data, output);
+    if (data.isStream && sound && IsSoundInUse(data, sound))
+    {
+        spdlog::warn("Stream {} is playing and cannot be armed.", soundName);
+        return nullptr;
+    }
+
+    FMOD::Channel* channel = OpenChannel(data, soundName, loop, volume, pitch, output, startPcm);
+    if (channel)
+    {
+        data.armedChannels.push_back(channel);
+    }
+    return channel;
+}
+
+FMOD::Channel* AudioManager::OpenChannel(SoundData& data, const std::string& soundName, bool loop, float volume, float pitch,
+                                         OutputId output, unsigned int startPcm)
+{
+    FMOD::Sound* sound = GetOutputSound(data, output);
+    if (!sound)
     {
         spdlog::error("Sound not valid: {}", soundName);
         return nullptr;
     }
-    
-    FMOD_MODE currentMode;
-    data.sound->getMode(&currentMode);
-    if (loop)
-        currentMode |= FMOD_LOOP_NORMAL;
-    else
-        currentMode &= ~FMOD_LOOP_NORMAL;
-    data.sound->setMode(currentMode);
 
     FMOD::Channel* channel = nullptr;
-    FMOD_RESULT result = FModWrapper::GetInstance().GetSystem()->playSound(data.sound, nullptr, true, &channel);
+    FMOD_RESULT result = FModWrapper::GetInstance().GetSystem(output)->playSound(sound, nullptr, true, &channel);
     if (result != FMOD_OK)
     {
         spdlog::error("FMOD playSound failed: {}", FMOD_ErrorString(result));
@@ -115,20 +334,65 @@ FMOD::Channel* AudioManager::PlaySound(const std::string& soundName, bool loop,
     {
         spdlog::info("FMOD playSound success: {}", soundName);
     }
-    
+
+    // Le mode de boucle va sur le canal : le son est partagé par les autres lectures
+    channel->setMode(loop ? FMOD_LOOP_NORMAL : FMOD_LOOP_OFF);
+
+    // La boucle saute le silence de l'encodeur aux deux bouts
+    if (loop)
+    {
+        ReadGaplessTrim(data);
+        unsigned int lengthPcm = 0;
+        if ((data.leadInPcm > 0 || data.tailPcm > 0) && sound->getLength(&lengthPcm, FMOD_TIMEUNIT_PCM) == FMOD_OK &&
+            lengthPcm > data.leadInPcm + data.tailPcm)
+        {
+            channel->setLoopPoints(data.leadInPcm, FMOD_TIMEUNIT_PCM, lengthPcm - data.tailPcm - 1, FMOD_TIMEUNIT_PCM);
+            startPcm = std::max(startPcm, data.leadInPcm);
+        }
+    }
+
     channel->setVolume(volume);
     float defaultFrequency;
     channel->getFrequency(&defaultFrequency);
     channel->setFrequency(defaultFrequency * pitch);
-    channel->setPaused(false);
+    if (startPcm > 0)
+    {
+        channel->setPosition(startPcm, FMOD_TIMEUNIT_PCM);
+    }
 
-    float volumeTemp;
-    channel->getVolume(&volumeTemp);
-    spdlog::info("Volume of {} after configuration: {}", soundName, volumeTemp);
+    return channel;
+}
 
-    data.channels.push_back(channel);
+// Armed channels are still paused, which isPlaying counts as playing.
+bool AudioManager::IsSoundInUse(SoundData& data, FMOD::Sound* sound)
+{
+    auto usesSound = [sound](FMOD::Channel* channel) {
+        FMOD::Sound* current = nullptr;
+        bool isPlaying = false;
+        return channel && channel->getCurrentSound(&current) == FMOD_OK && current == sound &&
+               channel->isPlaying(&isPlaying) == FMOD_OK && isPlaying;
+    };
+
+    std::erase_if(data.armedChannels, [](FMOD::Channel* channel) {
+        bool isPlaying = false;
+        return !channel || channel->isPlaying(&isPlaying) != FMOD_OK || !isPlaying;
+    });
+    return std::any_of(data.channels.begin(), data.channels.end(), usesSound) ||
+           std::any_of(data.armedChannels.begin(), data.armedChannels.end(), usesSound);
+}
 
-    return channel;
+bool AudioManager::StartArmedSound(const std::string& soundName, FMOD::Channel* channel)
+{
+    auto it = m_sounds.find(soundName);
+    if (it == m_sounds.end() || !channel || channel->setPaused(false) != FMOD_OK)
+    {
+        spdlog::error("Armed channel of {} cannot start.", soundName);
+        return false;
+    }
+
+    std::erase(it->second.armedChannels, channel);
+    it->second.channels.push_back(channel);
+    return true;
 }
 
 void AudioManager::StopSound(const std::string& soundName)
@@ -225,7 +489,7 @@ void AudioManager::SetChannelPitch(FMOD::Channel* channel, float pitch)
 }
 void AudioManager::Update(float deltaTime)
 {
-    FModWrapper::GetInstance().GetSystem()->update();
+    FModWrapper::GetInstance().Update();
     
     if (m_isFadingIn)
     {
@@ -363,7 +627,8 @@ bool AudioManager::LoadWeddingPhaseSound(int phase, const std::string& filePath)
         UnloadSound(soundId);
     }
     
-    bool success = LoadSound(soundId, filePath, true);
+    // La cérémonie tourne en boucle sous les discours
+    bool success = (phase == 2) ? LoadSeamlessLoop(soundId, filePath) : LoadSound(soundId, filePath, true);
     
     if (success) {
         spdlog::info("Wedding phase {} sound loaded successfully: {}", phase, filePath);
@@ -392,39 +657,162 @@ bool AudioManager::LoadAnnouncement(const std::string& announcementId, const std
     return success;
 }
 
-FMOD::Sound* AudioManager::GetSound(const std::string& soundName)
+bool AudioManager::AcquireFragment(const std::string& fragmentId, const std::string& filePath, OutputId output)
 {
-    auto it = m_sounds.find(soundName);
-    if (it != m_sounds.end()) {
-        return it->second.sound;
+    auto it = m_sounds.find(fragmentId);
+    if (it != m_sounds.end())
+    {
+        it->second.refCount++;
+        return true;
+    }
+
+    // Fragments are short and scheduled sample-accurately, so they are decoded once into memory.
+    RegisterDeferredSound(fragmentId, filePath, 0, false);
+    if (!PrefetchSound(fragmentId, output))
+    {
+        spdlog::error("Failed to load announcement fragment '{}': {}", fragmentId, filePath);
+        UnloadSound(fragmentId);
+        return false;
     }
-    return nullptr;
+
+    m_sounds[fragmentId].refCount = 1;
+    return true;
 }
 
-FMOD::Channel* AudioManager::PlaySoundWithFadeIn(const std::string& soundName, bool loop, float volume, float pitch)
+void AudioManager::ReleaseFragment(const std::string& fragmentId)
+{
+    auto it = m_sounds.find(fragmentId);
+    if (it == m_sounds.end())
+    {
+        spdlog::warn("Attempted to release non-existent fragment: {}", fragmentId);
+        return;
+    }
+
+    it->second.refCount--;
+    if (it->second.refCount <= 0)
+    {
+        StopSound(fragmentId);
+        UnloadSound(fragmentId);
+    }
+}
+
+int AudioManager::GetFragmentRefCount(const std::string& fragmentId) const
+{
+    auto it = m_sounds.find(fragmentId);
+    return (it != m_sounds.end()) ? it->second.refCount : 0;
+}
+
+FMOD::Channel* AudioManager::PlaySoundScheduled(const std::string& soundName, unsigned long long startDspClock, float volume,
+                                                OutputId output, unsigned int startPcm)
+{
+    SoundData* resolved = ResolveSound(soundName);
+    FMOD::Sound* sound = resolved ? GetOutputSound(*resolved, output) : nullptr;
+    if (!sound)
+    {
+        spdlog::error("Sound not found: {}", soundName);
+        return nullptr;
+    }
+
+    SoundData& data = *resolved;
+
+    FMOD::Channel* channel = nullptr;
+    FMOD_RESULT result = FModWrapper::GetInstance().GetSystem(output)->playSound(sound, nullptr, true, &channel);
+    if (result != FMOD_OK)
+    {
+        spdlog::error("FMOD playSound failed: {}", FMOD_ErrorString(result));
+        return nullptr;
+    }
+
+    channel->setMode(FMOD_LOOP_OFF);
+    channel->setVolume(volume);
+    if (startPcm > 0)
+    {
+        channel->setPosition(startPcm, FMOD_TIMEUNIT_PCM);
+    }
+    channel->setDelay(startDspClock, 0, false);
+    channel->setPaused(false);
+
+    data.channels.push_back(channel);
+
+    return channel;
+}
+
+unsigned long long AudioManager::GetMasterDSPClock(OutputId output) const
+{
+    FMOD::System* system = FModWrapper::GetInstance().GetSystem(output);
+    FMOD::ChannelGroup* master = nullptr;
+    if (!system || system->getMasterChannelGroup(&master) != FMOD_OK || !master)
+    {
+        return 0;
+    }
+
+    unsigned long long clock = 0;
+    master->getDSPClock(&clock, nullptr);
+    return clock;
+}
+
+int AudioManager::GetOutputSampleRate(OutputId output) const
+{
+    int sampleRate = 48000;
+    if (FMOD::System* system = FModWrapper::GetInstance().GetSystem(output))
+    {
+        system->getSoftwareFormat(&sampleRate, nullptr, nullptr);
+    }
+    return sampleRate;
+}
+
+bool AudioManager::GetGaplessTrim(const std::string& soundName, unsigned int& leadInPcm, unsigned int& tailPcm)
 {
     auto it = m_sounds.find(soundName);
     if (it == m_sounds.end())
+    {
+        return false;
+    }
+
+    ReadGaplessTrim(it->second);
+    leadInPcm = it->second.leadInPcm;
+    tailPcm = it->second.tailPcm;
+    return true;
+}
+
+// Only the headers are read. Without a LAME tag nothing is trimmed: the delay of other
+// encoders is unknown and guessing it would cut real audio.
+void AudioManager::ReadGaplessTrim(SoundData& data)
+{
+    if (data.gaplessTrimKnown) return;
+    data.gaplessTrimKnown = true;
+    if (data.filePath.empty()) return;
+
+    const AudioProbeResult probe = ProbeAudioFile(data.filePath);
+    if (!probe.IsValid() || (probe.encoderDelay == 0 && probe.encoderPadding == 0)) return;
+
+    data.leadInPcm = probe.encoderDelay + Mp3DecoderDelay;
+    data.tailPcm = probe.encoderPadding > Mp3DecoderDelay ? probe.encoderPadding - Mp3DecoderDelay : 0;
+    spdlog::debug("Gapless trim of '{}': {} samples in, {} out.", data.filePath, data.leadInPcm, data.tailPcm);
+}
+
+FMOD::Sound* AudioManager::GetSound(const std::string& soundName, OutputId output)
+{
+    SoundData* data = ResolveSound(soundName);
+    return data ? GetOutputSound(*data, output) : nullptr;
+}
+
+FMOD::Channel* AudioManager::PlaySoundWithFadeIn(const std::string& soundName, bool loop, float volume, float pitch)
+{
+    SoundData* resolved = ResolveSound(soundName);
+    if (!resolved)
     {
         spdlog::error("Sound not found: {}", soundName);
         return nullptr;
     }
     
-    SoundData& data = it->second;
+    SoundData& data = *resolved;
     if (!data.sound)
     {
         spdlog::error("Sound not valid: {}", soundName);
         return nullptr;
     }
     
-    FMOD_MODE currentMode;
-    data.sound->getMode(&currentMode);
-    if (loop)
-        currentMode |= FMOD_LOOP_NORMAL;
-    else
-        currentMode &= ~FMOD_LOOP_NORMAL;
-    data.sound->setMode(currentMode);
-
     FMOD::Channel* channel = nullptr;
     FMOD_RESULT result = FModWrapper::GetInstance().GetSystem()->playSound(data.sound, nullptr, true, &channel);
     if (result != FMOD_OK)
@@ -437,6 +825,7 @@ FMOD::Channel* AudioManager::PlaySoundWithFadeIn(const std::string& soundName, b
         spdlog::info("FMOD playSound success with fade-in: {}", soundName);
     }
     
+    channel->setMode(loop ? FMOD_LOOP_NORMAL : FMOD_LOOP_OFF);
     channel->setVolume(0.0f);
     float defaultFrequency;
     channel->getFrequency(&defaultFrequency);
@@ -5,6 +5,11 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <memory>
+#include "tsm_track_id.h"
+#include "tsm_fmod_wrapper.h"
+#include "tsm_pcm_cache.h"
+#include "tsm_loop_renderer.h"
 
 namespace TSM 
 {
@@ -16,9 +21,30 @@ public:
     {
         FMOD::Sound* sound = nullptr;
         std::vector<FMOD::Channel*> channels;
+        std::vector<FMOD::Channel*> armedChannels;  // paused by ArmSound, not started yet
         std::string filePath;
+        int refCount = 0;
+        bool isStream = false;
+        unsigned int lengthMs = 0;  // cached length, known before the sound is created
+        std::string title;
+        std::string artist;
+        std::string album;
+
+        // Encoder silence at both ends (mp3 LAME tag), read from the file on first use.
+        bool gaplessTrimKnown = false;
+        unsigned int leadInPcm = 0;
+        unsigned int tailPcm = 0;
+
+        // Copies of the sound on the other outputs; samples share one decoded buffer with `sound`.
+        std::map<OutputId, FMOD::Sound*> outputSounds;
+        // Samples every in-memory sound above points at (FMOD_OPENMEMORY_POINT). Only
+        // UnloadSound drops them, once `sound` itself is released.
+        std::shared_ptr<const PcmBuffer> pcm;
     };
 
+    // Priming samples every mp3 decoder outputs on top of the encoder delay.
+    static constexpr unsigned int Mp3DecoderDelay = 529;
+
     static AudioManager& GetInstance() 
     {
         static AudioManager instance;
@@ -26,20 +52,52 @@ public:
     }
 
     bool LoadSound(const std::string& soundName, const std::string& filePath, bool isStream = false);
+    // Ambience bed rendered to a buffer whose end joins its start; falls back to a streamed loop.
+    bool LoadSeamlessLoop(const std::string& soundName, const std::string& filePath, const LoopRenderSettings& settings = {});
+    // Stops the sound's channels, the armed ones included, and releases the cues armed on it.
     bool UnloadSound(const std::string& soundName);
+    // Registers the sound without opening the file; it is created on first use.
+    bool RegisterDeferredSound(const std::string& soundName, const std::string& filePath, unsigned int lengthMs, bool isStream = true);
+    bool HasSound(const std::string& soundName) const { return m_sounds.find(soundName) != m_sounds.end(); }
+    unsigned int GetSoundLengthMs(const std::string& soundName) const;
+    bool SetSoundMetadata(const std::string& soundName, const std::string& title, const std::string& artist, const std::string& album = "");
     bool LoadWeddingPhaseSound(int phase, const std::string& filePath);
     bool LoadWeddingEntranceSound(const std::string& filePath) { return LoadWeddingPhaseSound(1, filePath); }
     bool LoadWeddingCeremonySound(const std::string& filePath) { return LoadWeddingPhaseSound(2, filePath); }
     bool LoadWeddingExitSound(const std::string& filePath) { return LoadWeddingPhaseSound(3, filePath); }
     bool LoadAnnouncement(const std::string& announcementId, const std::string& filePath);
-    FMOD::Channel* PlaySound(const std::string& soundName, bool loop = false, float volume = 1.0f, float pitch = 1.0f);
+    // Opened on `output` by the first acquire, unloaded after the last release.
+    bool AcquireFragment(const std::string& fragmentId, const std::string& filePath, OutputId output = FModWrapper::MainOutput);
+    void ReleaseFragment(const std::string& fragmentId);
+    int GetFragmentRefCount(const std::string& fragmentId) const;
+    // startPcm is applied while the channel is still paused, so nothing before it is heard.
+    // A looping sound loops between its gapless trim points.
+    FMOD::Channel* PlaySound(const std::string& soundName, bool loop = false, float volume = 1.0f, float pitch = 1.0f,
+                             OutputId output = FModWrapper::MainOutput, unsigned int startPcm = 0);
+    // The same channel, left paused and not tracked: StopAllSounds leaves it alone until
+    // StartArmedSound, which only unpauses it. The caller stops it if it never starts.
+    // A stream already playing or armed is refused: it has only one channel.
+    FMOD::Channel* ArmSound(const std::string& soundName, bool loop = false, float volume = 1.0f, float pitch = 1.0f,
+                            OutputId output = FModWrapper::MainOutput, unsigned int startPcm = 0);
+    bool StartArmedSound(const std::string& soundName, FMOD::Channel* channel);
+    // Opens the sound on that output now, so a later PlaySound does no file access.
+    bool PrefetchSound(const std::string& soundName, OutputId output = FModWrapper::MainOutput);
+    // Before the output's system goes away. The shared samples stay for the other outputs.
+    void ReleaseOutputSounds(OutputId output);
     FMOD::Channel* PlaySoundWithFadeIn(const std::string& soundName, bool loop = false, float volume = 1.0f, float pitch = 1.0f);
+    // Starts on that DSP clock of the output's mixer, sample-accurately.
+    FMOD::Channel* PlaySoundScheduled(const std::string& soundName, unsigned long long startDspClock, float volume = 1.0f,
+                                      OutputId output = FModWrapper::MainOutput, unsigned int startPcm = 0);
+    unsigned long long GetMasterDSPClock(OutputId output = FModWrapper::MainOutput) const;
+    int GetOutputSampleRate(OutputId output = FModWrapper::MainOutput) const;
+    // Samples to skip at the start and the end so consecutive tracks join without silence.
+    bool GetGaplessTrim(const std::string& soundName, unsigned int& leadInPcm, unsigned int& tailPcm);
     void StopSound(const std::string& soundName);
     void StopSoundWithFadeOut(const std::string& soundName);
     void StopAllSounds();
     void StopAllSoundsWithFadeOut();
-    FMOD::Sound* GetSound(const std::string& soundName);
-    const std::map<std::string, SoundData>& GetAllSounds() const { return m_sounds; }
+    FMOD::Sound* GetSound(const std::string& soundName, OutputId output = FModWrapper::MainOutput);
+    const std::map<TrackId, SoundData, std::less<>>& GetAllSounds() const { return m_sounds; }
     void SetVolume(const std::string& soundName, float volume);
     void SetPitch(const std::string& soundName, float pitch);
     void SetChannelVolume(FMOD::Channel* channel, float volume);
@@ -47,7 +105,17 @@ public:
     void Update(float deltaTime);
     FMOD::Channel* GetLastChannelOfSound(const std::string& soundName);
 private:
-    std::map<std::string, SoundData> m_sounds;
+    SoundData* ResolveSound(const std::string& soundName);
+    FMOD::Sound* GetOutputSound(SoundData& data, OutputId output);
+    static FMOD::Sound* CreateOutputSound(SoundData& data, FMOD::System* system);
+    FMOD::Channel* OpenChannel(SoundData& data, const std::string& soundName, bool loop, float volume, float pitch,
+                               OutputId output, unsigned int startPcm);
+    static bool IsSoundInUse(SoundData& data, FMOD::Sound* sound);
+    static void ReleaseOutputSounds(SoundData& data);
+    static void ReadGaplessTrim(SoundData& data);
+
+    // Keyed by interned id: playlists and the journal refer to the same strings.
+    std::map<TrackId, SoundData, std::less<>> m_sounds;
     bool m_isFadingIn = false;
     bool m_isFadingOut = false;
     float m_fadeTimer = 0.0f;
@@ -0,0 +1,746 @@
+// tsm_audio_probe.cpp
+
+#include "tsm_audio_probe.h"
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+namespace TSM
+{
+
+namespace
+{
+
+class ProbeFile
+{
+public:
+    explicit ProbeFile(const std::string& filePath)
+        : m_file(filePath.c_str(), std::ios::binary)
+    {
+        if (m_file.is_open())
+        {
+            m_file.seekg(0, std::ios::end);
+            m_size = static_cast<uint64_t>(m_file.tellg());
+        }
+    }
+
+    bool IsOpen() const { return m_file.is_open(); }
+    uint64_t GetSize() const { return m_size; }
+
+    bool Read(uint64_t offset, void* buffer, size_t size)
+    {
+        if (offset > m_size || size > m_size - offset) return false;
+        m_file.clear();
+        m_file.seekg(static_cast<std::streamoff>(offset));
+        m_file.read(static_cast<char*>(buffer), static_cast<std::streamsize>(size));
+        return static_cast<size_t>(m_file.gcount()) == size;
+    }
+
+    std::vector<uint8_t> ReadUpTo(uint64_t offset, size_t size)
+    {
+        if (offset >= m_size) return {};
+        std::vector<uint8_t> data(static_cast<size_t>(std::min<uint64_t>(size, m_size - offset)));
+        if (!Read(offset, data.data(), data.size())) data.clear();
+        return data;
+    }
+
+private:
+    std::ifstream m_file;
+    uint64_t m_size = 0;
+};
+
+uint16_t LE16(const uint8_t* p) { return uint16_t(p[0] | (p[1] << 8)); }
+uint32_t LE32(const uint8_t* p) { return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24); }
+uint64_t LE64(const uint8_t* p) { return uint64_t(LE32(p)) | (uint64_t(LE32(p + 4)) << 32); }
+uint32_t BE24(const uint8_t* p) { return (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | uint32_t(p[2]); }
+uint32_t BE32(const uint8_t* p) { return (uint32_t(p[0]) << 24) | BE24(p + 1); }
+uint32_t SyncSafe32(const uint8_t* p) { return (uint32_t(p[0] & 0x7F) << 21) | (uint32_t(p[1] & 0x7F) << 14) | (uint32_t(p[2] & 0x7F) << 7) | uint32_t(p[3] & 0x7F); }
+
+uint32_t ToMs(uint64_t samples, uint32_t sampleRate)
+{
+    return sampleRate > 0 ? static_cast<uint32_t>(samples * 1000 / sampleRate) : 0;
+}
+
+void AppendUtf8(std::string& out, uint32_t codePoint)
+{
+    if (codePoint < 0x80)
+    {
+        out += char(codePoint);
+    }
+    else if (codePoint < 0x800)
+    {
+        out += char(0xC0 | (codePoint >> 6));
+        out += char(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000)
+    {
+        out += char(0xE0 | (codePoint >> 12));
+        out += char(0x80 | ((codePoint >> 6) & 0x3F));
+        out += char(0x80 | (codePoint & 0x3F));
+    }
+    else
+    {
+        out += char(0xF0 | (codePoint >> 18));
+        out += char(0x80 | ((codePoint >> 12) & 0x3F));
+        out += char(0x80 | ((codePoint >> 6) & 0x3F));
+        out += char(0x80 | (codePoint & 0x3F));
+    }
+}
+
+std::string Latin1ToUtf8(const uint8_t* data, size_t size)
+{
+    std::string out;
+    for (size_t i = 0; i < size && data[i] != 0; i++)
+    {
+        AppendUtf8(out, data[i]);
+    }
+    return out;
+}
+
+std::string Utf16ToUtf8(const uint8_t* data, size_t size, bool bigEndian)
+{
+    std::string out;
+    for (size_t i = 0; i + 1 < size; i += 2)
+    {
+        uint32_t unit = bigEndian ? uint32_t((data[i] << 8) | data[i + 1]) : uint32_t(data[i] | (data[i + 1] << 8));
+        if (unit == 0) break;
+
+        if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < size)
+        {
+            uint32_t low = bigEndian ? uint32_t((data[i + 2] << 8) | data[i + 3]) : uint32_t(data[i + 2] | (data[i + 3] << 8));
+            if (low >= 0xDC00 && low < 0xE000)
+            {
+                unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                i += 2;
+            }
+        }
+        AppendUtf8(out, unit);
+    }
+    return out;
+}
+
+std::string TrimTag(std::string value)
+{
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\0'))
+    {
+        value.pop_back();
+    }
+    return value;
+}
+
+std::string DecodeId3Text(const uint8_t* data, size_t size)
+{
+    if (size < 1) return {};
+
+    const uint8_t encoding = data[0];
+    data++;
+    size--;
+
+    switch (encoding)
+    {
+    case 0:
+        return TrimTag(Latin1ToUtf8(data, size));
+    case 1:
+        if (size >= 2 && data[0] == 0xFE && data[1] == 0xFF) return TrimTag(Utf16ToUtf8(data + 2, size - 2, true));
+        if (size >= 2 && data[0] == 0xFF && data[1] == 0xFE) return TrimTag(Utf16ToUtf8(data + 2, size - 2, false));
+        return TrimTag(Utf16ToUtf8(data, size, false));
+    case 2:
+        return TrimTag(Utf16ToUtf8(data, size, true));
+    default:
+        return TrimTag(std::string(reinterpret_cast<const char*>(data), strnlen(reinterpret_cast<const char*>(data), size)));
+    }
+}
+
+bool EqualsIgnoreCase(const std::string& a, const char* b)
+{
+    const size_t length = std::strlen(b);
+    if (a.size() != length) return false;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (std::toupper(static_cast<unsigned char>(a[i])) != std::toupper(static_cast<unsigned char>(b[i]))) return false;
+    }
+    return true;
+}
+
+// Vorbis comment block as found in FLAC and Ogg streams (little-endian lengths).
+void ParseVorbisComment(const uint8_t* data, size_t size, AudioProbeResult& result)
+{
+    if (size < 8) return;
+    uint64_t position = 4 + uint64_t(LE32(data));
+    if (position + 4 > size) return;
+
+    const uint32_t count = LE32(data + position);
+    position += 4;
+
+    for (uint32_t i = 0; i < count && position + 4 <= size; i++)
+    {
+        const uint32_t length = LE32(data + position);
+        position += 4;
+        if (position + length > size) return;
+
+        std::string comment(reinterpret_cast<const char*>(data + position), length);
+        position += length;
+
+        const size_t separator = comment.find('=');
+        if (separator == std::string::npos) continue;
+
+        const std::string key = comment.substr(0, separator);
+        if (result.title.empty() && EqualsIgnoreCase(key, "TITLE"))        result.title = comment.substr(separator + 1);
+        else if (result.artist.empty() && EqualsIgnoreCase(key, "ARTIST")) result.artist = comment.substr(separator + 1);
+        else if (result.album.empty() && EqualsIgnoreCase(key, "ALBUM"))   result.album = comment.substr(separator + 1);
+    }
+}
+
+// Size of an ID3v2 tag starting at offset, 0 if there is none. Title, artist and album are read on the way.
+uint64_t ReadId3v2(ProbeFile& file, uint64_t offset, AudioProbeResult& result)
+{
+    uint8_t header[10];
+    if (!file.Read(offset, header, sizeof(header)) || std::memcmp(header, "ID3", 3) != 0) return 0;
+
+    const uint8_t version = header[3];
+    const uint8_t flags = header[5];
+    const uint64_t tagSize = 10 + uint64_t(SyncSafe32(header + 6)) + ((flags & 0x10) ? 10 : 0);
+    const uint64_t end = offset + 10 + SyncSafe32(header + 6);
+
+    uint64_t position = offset + 10;
+    if ((flags & 0x40) && version >= 3)
+    {
+        uint8_t extended[4];
+        if (!file.Read(position, extended, sizeof(extended))) return tagSize;
+        position += (version == 3) ? 4 + uint64_t(BE32(extended)) : uint64_t(SyncSafe32(extended));
+    }
+
+    const size_t frameHeaderSize = (version == 2) ? 6 : 10;
+    while (position + frameHeaderSize <= end)
+    {
+        uint8_t frame[10];
+        if (!file.Read(position, frame, frameHeaderSize) || frame[0] == 0) break;
+
+        std::string id;
+        uint32_t frameSize = 0;
+        if (version == 2)
+        {
+            id.assign(reinterpret_cast<const char*>(frame), 3);
+            frameSize = BE24(frame + 3);
+        }
+        else
+        {
+            id.assign(reinterpret_cast<const char*>(frame), 4);
+            frameSize = (version >= 4) ? SyncSafe32(frame + 4) : BE32(frame + 4);
+        }
+
+        position += frameHeaderSize;
+        if (frameSize == 0 || position + frameSize > end) break;
+
+        std::string* field = nullptr;
+        if (id == "TIT2" || id == "TT2")      field = &result.title;
+        else if (id == "TPE1" || id == "TP1") field = &result.artist;
+        else if (id == "TALB" || id == "TAL") field = &result.album;
+        if (field && field->empty())
+        {
+            std::vector<uint8_t> text = file.ReadUpTo(position, std::min<uint32_t>(frameSize, 4096));
+            *field = DecodeId3Text(text.data(), text.size());
+        }
+        position += frameSize;
+    }
+
+    return tagSize;
+}
+
+struct MpegFrameHeader
+{
+    uint32_t bitrate = 0;           // bits per second
+    uint32_t sampleRate = 0;
+    uint32_t samplesPerFrame = 0;
+    uint32_t frameLength = 0;
+    uint32_t sideInfoSize = 0;
+    uint16_t channels = 0;
+};
+
+bool ParseMpegFrameHeader(const uint8_t* p, MpegFrameHeader& header)
+{
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return false;
+
+    const int versionBits = (p[1] >> 3) & 3;    // 0: 2.5, 2: 2, 3: 1
+    const int layerBits = (p[1] >> 1) & 3;      // 1: III, 2: II, 3: I
+    const int bitrateIndex = (p[2] >> 4) & 0xF;
+    const int sampleRateIndex = (p[2] >> 2) & 3;
+    const int padding = (p[2] >> 1) & 1;
+    const bool mono = ((p[3] >> 6) & 3) == 3;
+
+    if (versionBits == 1 || layerBits == 0 || bitrateIndex == 0 || bitrateIndex == 15 || sampleRateIndex == 3) return false;
+
+    static const uint16_t bitrates[2][3][15] = {
+        {   // MPEG-1: layer I, II, III
+            { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+            { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 }
+        },
+        {   // MPEG-2 / 2.5
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+            { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+            { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 }
+        }
+    };
+    static const uint32_t sampleRates[3] = { 44100, 48000, 32000 };
+
+    const bool mpeg1 = (versionBits == 3);
+    const int layer = 4 - layerBits;            // 1, 2 or 3
+
+    header.bitrate = bitrates[mpeg1 ? 0 : 1][layer - 1][bitrateIndex] * 1000u;
+    header.sampleRate = sampleRates[sampleRateIndex] >> (mpeg1 ? 0 : (versionBits == 2 ? 1 : 2));
+    header.channels = mono ? 1 : 2;
+
+    if (layer == 1)
+    {
+        header.samplesPerFrame = 384;
+        header.frameLength = (12 * header.bitrate / header.sampleRate + padding) * 4;
+    }
+    else
+    {
+        header.samplesPerFrame = (layer == 3 && !mpeg1) ? 576 : 1152;
+        header.frameLength = header.samplesPerFrame / 8 * header.bitrate / header.sampleRate + padding;
+    }
+
+    header.sideInfoSize = mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+    return header.frameLength >= 4;
+}
+
+bool ProbeMp3(ProbeFile& file, AudioProbeResult& result)
+{
+    uint64_t audioStart = 0;
+    while (uint64_t tagSize = ReadId3v2(file, audioStart, result))
+    {
+        audioStart += tagSize;
+    }
+
+    // A frame only counts when the next one starts where its length says.
+    std::vector<uint8_t> window = file.ReadUpTo(audioStart, 64 * 1024);
+    size_t frameOffset = SIZE_MAX;
+    MpegFrameHeader header;
+    for (size_t i = 0; i + 4 <= window.size(); i++)
+    {
+        if (!ParseMpegFrameHeader(window.data() + i, header)) continue;
+
+        const size_t next = i + header.frameLength;
+        MpegFrameHeader following;
+        if (next + 4 <= window.size() && !ParseMpegFrameHeader(window.data() + next, following)) continue;
+        if (next + 4 > window.size() && audioStart + next < file.GetSize()) continue;
+
+        frameOffset = i;
+        break;
+    }
+
+    if (frameOffset == SIZE_MAX)
+    {
+        return false;
+    }
+
+    // Only accept leading garbage after an ID3 tag, otherwise this is probably not an MP3.
+    if (audioStart == 0 && frameOffset != 0)
+    {
+        return false;
+    }
+
+    result.format = "mp3";
+    result.sampleRate = header.sampleRate;
+    result.channels = header.channels;
+
+    uint64_t frameCount = 0;
+    const uint8_t* frame = window.data() + frameOffset;
+    const size_t available = window.size() - frameOffset;
+    const size_t xingOffset = 4 + header.sideInfoSize;
+    if (available >= xingOffset + 12 &&
+        (std::memcmp(frame + xingOffset, "Xing", 4) == 0 || std::memcmp(frame + xingOffset, "Info", 4) == 0))
+    {
+        const uint32_t xingFlags = BE32(frame + xingOffset + 4);
+        if (xingFlags & 0x1)
+        {
+            frameCount = BE32(frame + xingOffset + 8);
+        }
+
+        // The LAME tag follows the optional Xing fields; 21 bytes in, two 12-bit counts of
+        // the silence the encoder added before and after the audio.
+        size_t lameOffset = xingOffset + 8;
+        if (xingFlags & 0x1) lameOffset += 4;
+        if (xingFlags & 0x2) lameOffset += 4;
+        if (xingFlags & 0x4) lameOffset += 100;
+        if (xingFlags & 0x8) lameOffset += 4;
+        if (available >= lameOffset + 24 &&
+            (std::memcmp(frame + lameOffset, "LAME", 4) == 0 || std::memcmp(frame + lameOffset, "Lavc", 4) == 0))
+        {
+            const uint8_t* gapless = frame + lameOffset + 21;
+            result.encoderDelay = (uint32_t(gapless[0]) << 4) | (gapless[1] >> 4);
+            result.encoderPadding = (uint32_t(gapless[1] & 0x0F) << 8) | gapless[2];
+        }
+    }
+    else if (available >= 36 + 18 && std::memcmp(frame + 36, "VBRI", 4) == 0)
+    {
+        frameCount = BE32(frame + 36 + 14);
+    }
+
+    if (frameCount > 0)
+    {
+        result.lengthMs = ToMs(frameCount * header.samplesPerFrame, header.sampleRate);
+    }
+    else
+    {
+        uint64_t audioEnd = file.GetSize();
+        uint8_t id3v1[128];
+        if (audioEnd >= 128 && file.Read(audioEnd - 128, id3v1, sizeof(id3v1)) && std::memcmp(id3v1, "TAG", 3) == 0)
+        {
+            audioEnd -= 128;
+        }
+        const uint64_t audioBytes = audioEnd - (audioStart + frameOffset);
+        result.lengthMs = static_cast<uint32_t>(audioBytes * 8 * 1000 / header.bitrate);
+    }
+
+    if (result.title.empty() || result.artist.empty() || result.album.empty())
+    {
+        uint8_t id3v1[128];
+        if (file.GetSize() >= 128 && file.Read(file.GetSize() - 128, id3v1, sizeof(id3v1)) && std::memcmp(id3v1, "TAG", 3) == 0)
+        {
+            if (result.title.empty())  result.title = TrimTag(Latin1ToUtf8(id3v1 + 3, 30));
+            if (result.artist.empty()) result.artist = TrimTag(Latin1ToUtf8(id3v1 + 33, 30));
+            if (result.album.empty())  result.album = TrimTag(Latin1ToUtf8(id3v1 + 63, 30));
+        }
+    }
+
+    result.status = AudioProbeResult::Status::Valid;
+    return true;
+}
+
+bool ProbeWav(ProbeFile& file, AudioProbeResult& result)
+{
+    uint8_t riff[12];
+    if (!file.Read(0, riff, sizeof(riff)) || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0)
+    {
+        return false;
+    }
+
+    result.format = "wav";
+
+    uint32_t byteRate = 0;
+    uint64_t dataSize = 0;
+    bool hasFormat = false;
+    bool hasData = false;
+
+    uint64_t offset = 12;
+    while (offset + 8 <= file.GetSize())
+    {
+        uint8_t chunk[8];
+        if (!file.Read(offset, chunk, sizeof(chunk))) break;
+
+        const uint64_t body = offset + 8;
+        uint64_t chunkSize = LE32(chunk + 4);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16)
+        {
+            uint8_t format[16];
+            if (!file.Read(body, format, sizeof(format))) break;
+            result.channels = LE16(format + 2);
+            result.sampleRate = LE32(format + 4);
+            byteRate = LE32(format + 8);
+            hasFormat = true;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0)
+        {
+            // Writers that could not seek back leave the size at 0 or 0xFFFFFFFF.
+            dataSize = std::min<uint64_t>(chunkSize, file.GetSize() - body);
+            if (chunkSize == 0 || chunkSize == 0xFFFFFFFFu) dataSize = file.GetSize() - body;
+            chunkSize = dataSize;
+            hasData = true;
+        }
+        else if (std::memcmp(chunk, "LIST", 4) == 0 && chunkSize >= 4)
+        {
+            std::vector<uint8_t> list = file.ReadUpTo(body, static_cast<size_t>(std::min<uint64_t>(chunkSize, 64 * 1024)));
+            if (list.size() >= 4 && std::memcmp(list.data(), "INFO", 4) == 0)
+            {
+                size_t position = 4;
+                while (position + 8 <= list.size())
+                {
+                    const uint32_t size = LE32(list.data() + position + 4);
+                    const uint8_t* text = list.data() + position + 8;
+                    const size_t textSize = std::min<size_t>(size, list.size() - position - 8);
+
+                    if (std::memcmp(list.data() + position, "INAM", 4) == 0)
+                        result.title = TrimTag(std::string(reinterpret_cast<const char*>(text), strnlen(reinterpret_cast<const char*>(text), textSize)));
+                    else if (std::memcmp(list.data() + position, "IART", 4) == 0)
+                        result.artist = TrimTag(std::string(reinterpret_cast<const char*>(text), strnlen(reinterpret_cast<const char*>(text), textSize)));
+                    else if (std::memcmp(list.data() + position, "IPRD", 4) == 0)
+                        result.album = TrimTag(std::string(reinterpret_cast<const char*>(text), strnlen(reinterpret_cast<const char*>(text), textSize)));
+
+                    position += 8 + size + (size & 1);
+                }
+            }
+        }
+
+        offset = body + chunkSize + (chunkSize & 1);
+    }
+
+    if (!hasFormat || !hasData || byteRate == 0)
+    {
+        result.error = "incomplete WAV header";
+        return true;
+    }
+
+    result.lengthMs = static_cast<uint32_t>(dataSize * 1000 / byteRate);
+    result.status = AudioProbeResult::Status::Valid;
+    return true;
+}
+
+bool ProbeFlac(ProbeFile& file, AudioProbeResult& result)
+{
+    AudioProbeResult tags;
+    const uint64_t start = ReadId3v2(file, 0, tags);
+
+    uint8_t magic[4];
+    if (!file.Read(start, magic, sizeof(magic)) || std::memcmp(magic, "fLaC", 4) != 0)
+    {
+        return false;
+    }
+
+    result.format = "flac";
+
+    uint64_t totalSamples = 0;
+    bool hasStreamInfo = false;
+    uint64_t offset = start + 4;
+    bool last = false;
+    while (!last && offset + 4 <= file.GetSize())
+    {
+        uint8_t block[4];
+        if (!file.Read(offset, block, sizeof(block))) break;
+
+        last = (block[0] & 0x80) != 0;
+        const int type = block[0] & 0x7F;
+        const uint32_t length = BE24(block + 1);
+        const uint64_t body = offset + 4;
+
+        if (type == 0 && length >= 34)
+        {
+            uint8_t info[34];
+            if (!file.Read(body, info, sizeof(info))) break;
+            result.sampleRate = (uint32_t(info[10]) << 12) | (uint32_t(info[11]) << 4) | (info[12] >> 4);
+            result.channels = uint16_t(((info[12] >> 1) & 0x7) + 1);
+            totalSamples = (uint64_t(info[13] & 0x0F) << 32) | BE32(info + 14);
+            hasStreamInfo = true;
+        }
+        else if (type == 4)
+        {
+            std::vector<uint8_t> comment = file.ReadUpTo(body, std::min<uint32_t>(length, 64 * 1024));
+            ParseVorbisComment(comment.data(), comment.size(), result);
+        }
+
+        offset = body + length;
+    }
+
+    if (result.title.empty())  result.title = tags.title;
+    if (result.artist.empty()) result.artist = tags.artist;
+    if (result.album.empty())  result.album = tags.album;
+
+    if (!hasStreamInfo || result.sampleRate == 0)
+    {
+        result.error = "missing STREAMINFO";
+        return true;
+    }
+
+    result.lengthMs = ToMs(totalSamples, result.sampleRate);
+    result.status = AudioProbeResult::Status::Valid;
+    return true;
+}
+
+bool ProbeOgg(ProbeFile& file, AudioProbeResult& result)
+{
+    std::vector<uint8_t> head = file.ReadUpTo(0, 64 * 1024);
+    if (head.size() < 27 || std::memcmp(head.data(), "OggS", 4) != 0)
+    {
+        return false;
+    }
+
+    // Rebuild the first two packets (identification and comment headers) from the pages.
+    const uint32_t serial = LE32(head.data() + 14);
+    std::vector<std::vector<uint8_t>> packets(1);
+    size_t position = 0;
+    while (position + 27 <= head.size() && packets.size() <= 2)
+    {
+        const uint8_t* page = head.data() + position;
+        if (std::memcmp(page, "OggS", 4) != 0) break;
+
+        const uint8_t segmentCount = page[26];
+        if (position + 27 + segmentCount > head.size()) break;
+
+        size_t dataOffset = position + 27 + segmentCount;
+        for (uint8_t s = 0; s < segmentCount && packets.size() <= 2; s++)
+        {
+            const uint8_t lacing = page[27 + s];
+            if (dataOffset + lacing > head.size()) break;
+            if (LE32(page + 14) == serial)
+            {
+                packets.back().insert(packets.back().end(), head.begin() + dataOffset, head.begin() + dataOffset + lacing);
+                if (lacing < 255) packets.emplace_back();
+            }
+            dataOffset += lacing;
+        }
+        position = dataOffset;
+    }
+
+    const std::vector<uint8_t>& identification = packets[0];
+    uint64_t preSkip = 0;
+    uint32_t granuleRate = 0;
+    size_t commentOffset = 0;
+    if (identification.size() >= 16 && std::memcmp(identification.data(), "\x01vorbis", 7) == 0)
+    {
+        result.format = "ogg";
+        result.channels = identification[11];
+        result.sampleRate = LE32(identification.data() + 12);
+        granuleRate = result.sampleRate;
+        commentOffset = 7;
+    }
+    else if (identification.size() >= 19 && std::memcmp(identification.data(), "OpusHead", 8) == 0)
+    {
+        result.format = "opus";
+        result.channels = identification[9];
+        preSkip = LE16(identification.data() + 10);
+        result.sampleRate = LE32(identification.data() + 12);
+        granuleRate = 48000;
+        commentOffset = 8;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (packets.size() > 1 && packets[1].size() > commentOffset)
+    {
+        ParseVorbisComment(packets[1].data() + commentOffset, packets[1].size() - commentOffset, result);
+    }
+
+    // The granule position of the last page is the stream length in samples.
+    const uint64_t tailSize = std::min<uint64_t>(file.GetSize(), 64 * 1024);
+    std::vector<uint8_t> tail = file.ReadUpTo(file.GetSize() - tailSize, static_cast<size_t>(tailSize));
+    for (size_t i = tail.size() >= 27 ? tail.size() - 27 : 0; tail.size() >= 27; i--)
+    {
+        if (std::memcmp(tail.data() + i, "OggS", 4) == 0 && LE32(tail.data() + i + 14) == serial)
+        {
+            const uint64_t granule = LE64(tail.data() + i + 6);
+            if (granule != ~uint64_t(0) && granule > preSkip)
+            {
+                result.lengthMs = ToMs(granule - preSkip, granuleRate);
+            }
+            break;
+        }
+        if (i == 0) break;
+    }
+
+    if (granuleRate == 0)
+    {
+        result.error = "invalid identification header";
+        return true;
+    }
+
+    result.status = AudioProbeResult::Status::Valid;
+    return true;
+}
+
+} // namespace
+
+AudioProbeResult ProbeAudioFile(const std::string& filePath)
+{
+    AudioProbeResult result;
+
+    ProbeFile file(filePath);
+    if (!file.IsOpen() || file.GetSize() == 0)
+    {
+        result.error = "cannot open file";
+        return result;
+    }
+
+    // Each prober returns false when the magic does not match, true once it has decided.
+    if (ProbeWav(file, result) || ProbeFlac(file, result) || ProbeOgg(file, result))
+    {
+        return result;
+    }
+
+    result = AudioProbeResult();
+    if (ProbeMp3(file, result))
+    {
+        return result;
+    }
+
+    result = AudioProbeResult();
+    result.status = AudioProbeResult::Status::Unknown;
+    return result;
+}
+
+AudioProbePool::AudioProbePool(size_t threadCount)
+{
+    threadCount = std::max<size_t>(1, threadCount);
+    for (size_t i = 0; i < threadCount; i++)
+    {
+        m_threads.emplace_back(&AudioProbePool::WorkerLoop, this);
+    }
+}
+
+AudioProbePool::~AudioProbePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workAvailable.notify_all();
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+size_t AudioProbePool::DefaultThreadCount()
+{
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    return std::clamp<size_t>(cores * 2, 4, 32);
+}
+
+std::vector<AudioProbeResult> AudioProbePool::ProbeAll(const std::vector<std::string>& filePaths)
+{
+    std::vector<AudioProbeResult> results(filePaths.size());
+    if (filePaths.empty()) return results;
+
+    std::lock_guard<std::mutex> call(m_callMutex);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_paths = &filePaths;
+    m_results = &results;
+    m_nextIndex = 0;
+    m_remaining = filePaths.size();
+    m_workAvailable.notify_all();
+
+    m_workDone.wait(lock, [this] { return m_remaining == 0; });
+    m_paths = nullptr;
+    m_results = nullptr;
+    return results;
+}
+
+void AudioProbePool::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_workAvailable.wait(lock, [this] { return m_stopping || (m_paths && m_nextIndex < m_paths->size()); });
+        if (m_stopping) return;
+
+        const size_t index = m_nextIndex++;
+        const std::string& path = (*m_paths)[index];
+        lock.unlock();
+
+        AudioProbeResult result = ProbeAudioFile(path);
+
+        lock.lock();
+        (*m_results)[index] = std::move(result);
+        if (--m_remaining == 0)
+        {
+            m_workDone.notify_all();
+        }
+    }
+}
+
+} // namespace TSM
@@ -0,0 +1,74 @@
+// tsm_audio_probe.h
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+
+namespace TSM
+{
+
+struct AudioProbeResult
+{
+    enum class Status
+    {
+        Valid,          // format recognised, header consistent
+        Unknown,        // not a format we parse, FMOD has to decide
+        Invalid         // missing, unreadable or corrupt file
+    };
+
+    Status status = Status::Invalid;
+    std::string format;             // "wav", "mp3", "flac", "ogg", "opus"
+    uint32_t lengthMs = 0;
+    uint32_t sampleRate = 0;
+    uint16_t channels = 0;
+    uint32_t encoderDelay = 0;      // mp3 with a LAME tag: samples of encoder silence before the audio
+    uint32_t encoderPadding = 0;    // and after it, up to the end of the last frame
+    std::string title;
+    std::string artist;
+    std::string album;
+    std::string error;
+
+    bool IsValid() const { return status == Status::Valid; }
+};
+
+// Reads only the headers and tags; the audio data itself is never decoded.
+AudioProbeResult ProbeAudioFile(const std::string& filePath);
+
+// Fixed set of threads probing files concurrently. Probing is dominated by seek latency
+// on removable media, so more threads than cores keeps the device queue busy.
+class AudioProbePool
+{
+public:
+    explicit AudioProbePool(size_t threadCount = DefaultThreadCount());
+    ~AudioProbePool();
+    AudioProbePool(const AudioProbePool&) = delete;
+    AudioProbePool& operator=(const AudioProbePool&) = delete;
+
+    // Blocks until every file is probed; results are in the order of filePaths.
+    std::vector<AudioProbeResult> ProbeAll(const std::vector<std::string>& filePaths);
+
+    size_t GetThreadCount() const { return m_threads.size(); }
+    static size_t DefaultThreadCount();
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_callMutex;
+
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_workDone;
+    const std::vector<std::string>* m_paths = nullptr;
+    std::vector<AudioProbeResult>* m_results = nullptr;
+    size_t m_nextIndex = 0;
+    size_t m_remaining = 0;
+    bool m_stopping = false;
+};
+
+} // namespace TSM
@@ -9,6 +9,7 @@
 
 #include "tsm_playlist_manager.h"
 #include "tsm_ui_manager.h"
+#include "tsm_cue_stack.h"
 
 #include <spdlog/spdlog.h>
 
@@ -146,6 +147,11 @@ void processCommand(SOCKET clientSocket, char* buffer)
         const char* response = "Moving to next wedding phase";
         send(clientSocket, response, (int)strlen(response), 0);
     }
+    else if (strcmp(buffer, "GO") == 0)
+    {
+        const char* response = TSM::CueStack::GetInstance().Go() ? "GO" : "No cue on standby";
+        send(clientSocket, response, (int)strlen(response), 0);
+    }
     else if (strncmp(buffer, "SET_VOLUME", 10) == 0)
     {
         float volume = 0.5f;
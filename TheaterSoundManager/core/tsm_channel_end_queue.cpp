@@ -0,0 +1,69 @@
+// tsm_channel_end_queue.cpp
+#include "tsm_channel_end_queue.h"
+
+namespace TSM
+{
+
+bool ChannelEndQueue::Watch(FMOD::Channel* channel, uint32_t tag)
+{
+    if (!channel) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_watched[channel] = tag;
+    }
+
+    if (channel->setUserData(this) != FMOD_OK || channel->setCallback(&ChannelEndQueue::OnChannelCallback) != FMOD_OK)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_watched.erase(channel);
+        return false;
+    }
+    return true;
+}
+
+void ChannelEndQueue::Drain(std::vector<ChannelEndEvent>& events)
+{
+    events.clear();
+    if (!HasEvents()) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    events.swap(m_events);
+    m_pending.store(false, std::memory_order_release);
+}
+
+size_t ChannelEndQueue::GetWatchedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_watched.size();
+}
+
+void ChannelEndQueue::Push(FMOD::Channel* channel)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_watched.find(channel);
+    if (it == m_watched.end()) return;
+
+    m_events.push_back({ channel, it->second });
+    m_watched.erase(it);
+    m_pending.store(true, std::memory_order_release);
+}
+
+FMOD_RESULT F_CALLBACK ChannelEndQueue::OnChannelCallback(FMOD_CHANNELCONTROL* control, FMOD_CHANNELCONTROL_TYPE controlType,
+                                                          FMOD_CHANNELCONTROL_CALLBACK_TYPE callbackType, void*, void*)
+{
+    if (controlType != FMOD_CHANNELCONTROL_CHANNEL || callbackType != FMOD_CHANNELCONTROL_CALLBACK_END)
+    {
+        return FMOD_OK;
+    }
+
+    auto* channel = reinterpret_cast<FMOD::Channel*>(control);
+    void* userData = nullptr;
+    if (channel->getUserData(&userData) == FMOD_OK && userData)
+    {
+        static_cast<ChannelEndQueue*>(userData)->Push(channel);
+    }
+    return FMOD_OK;
+}
+
+} // namespace TSM
@@ -0,0 +1,52 @@
+// tsm_channel_end_queue.h
+#pragma once
+
+#include <fmod.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace TSM
+{
+
+struct ChannelEndEvent
+{
+    FMOD::Channel* channel = nullptr;
+    uint32_t tag = 0;
+};
+
+// Collects the FMOD END callbacks of the channels it watches, so their owner learns that a
+// track ended without asking FMOD every frame. The callbacks run inside System::update;
+// the events wait here until the owner's Update drains them on the engine thread.
+// Checking an empty queue is one atomic load.
+class ChannelEndQueue
+{
+public:
+    ChannelEndQueue() = default;
+    ChannelEndQueue(const ChannelEndQueue&) = delete;
+    ChannelEndQueue& operator=(const ChannelEndQueue&) = delete;
+
+    // `tag` comes back with the event. A channel stopped by its owner still reports its end.
+    bool Watch(FMOD::Channel* channel, uint32_t tag);
+
+    bool HasEvents() const { return m_pending.load(std::memory_order_acquire); }
+    // Replaces the content of `events` with the pending events, oldest first.
+    void Drain(std::vector<ChannelEndEvent>& events);
+
+    size_t GetWatchedCount() const;
+
+private:
+    static FMOD_RESULT F_CALLBACK OnChannelCallback(FMOD_CHANNELCONTROL* control, FMOD_CHANNELCONTROL_TYPE controlType,
+                                                    FMOD_CHANNELCONTROL_CALLBACK_TYPE callbackType, void* data1, void* data2);
+    void Push(FMOD::Channel* channel);
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<FMOD::Channel*, uint32_t> m_watched;
+    std::vector<ChannelEndEvent> m_events;
+    std::atomic<bool> m_pending{ false };
+};
+
+} // namespace TSM
@@ -0,0 +1,198 @@
+// tsm_crossfade_curve.h
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <string_view>
+
+namespace TSM
+{
+
+enum class CrossfadeCurve
+{
+    Linear,
+    EqualPower,     // out² + in² = 1 : two unrelated tracks keep their loudness through the fade
+    SCurve,         // slow at both ends, for fades that must not be noticed starting
+    Logarithmic,    // linear in dB : the outgoing track drops away at once, the incoming one arrives late
+    Custom          // power law in = t^shape : below 1 it bulges like equal power, above 1 it sags
+};
+
+struct CrossfadeGains
+{
+    float out = 1.0f;
+    float in = 0.0f;
+};
+
+namespace CrossfadeMath
+{
+    // std::sin and std::exp are not constexpr before C++26; the series are exact enough on
+    // the ranges the fades use ([0, π/2] and [-6, 0]).
+    constexpr double Sin(double x)
+    {
+        double term = x;
+        double sum = x;
+        for (int n = 1; n < 12; n++)
+        {
+            term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double Exp(double x)
+    {
+        int halvings = 0;
+        while (x < -0.5 || x > 0.5)
+        {
+            x *= 0.5;
+            halvings++;
+        }
+
+        double term = 1.0;
+        double sum = 1.0;
+        for (int n = 1; n < 16; n++)
+        {
+            term *= x / n;
+            sum += term;
+        }
+        while (halvings-- > 0) sum *= sum;
+        return sum;
+    }
+}
+
+// Fade-in gain for t in [0, 1]. Every curve is mirrored for the fade-out: out(t) = in(1 - t).
+struct LinearFade
+{
+    constexpr float operator()(float t) const { return t; }
+};
+
+struct EqualPowerFade
+{
+    constexpr float operator()(float t) const { return static_cast<float>(CrossfadeMath::Sin(t * 1.5707963267948966)); }
+};
+
+struct SCurveFade
+{
+    constexpr float operator()(float t) const { return t * t * (3.0f - 2.0f * t); }
+};
+
+struct LogarithmicFade
+{
+    static constexpr double RangeDb = 48.0;
+
+    constexpr float operator()(float t) const
+    {
+        if (t <= 0.0f) return 0.0f;
+        return static_cast<float>(CrossfadeMath::Exp((t - 1.0) * RangeDb / 20.0 * 2.302585092994046));
+    }
+};
+
+struct PowerFade
+{
+    float shape = 2.0f;
+
+    float operator()(float t) const { return std::pow(t, shape); }
+};
+
+// Fade-in gain sampled on Steps + 1 points and interpolated in between, so a crossfade
+// tick costs two lookups whatever the curve. Built-in curves are tabulated at compile time.
+class CrossfadeTable
+{
+public:
+    static constexpr int Steps = 64;
+
+    constexpr CrossfadeTable() : CrossfadeTable(Build(LinearFade{})) {}
+
+    template <typename Fade>
+    static constexpr CrossfadeTable Build(const Fade& fade)
+    {
+        CrossfadeTable table(0);
+        for (int i = 0; i <= Steps; i++)
+        {
+            table.m_gains[i] = fade(static_cast<float>(i) / Steps);
+        }
+        return table;
+    }
+
+    constexpr float FadeIn(float t) const
+    {
+        if (!(t > 0.0f)) return m_gains[0];
+        if (t >= 1.0f) return m_gains[Steps];
+
+        const float position = t * Steps;
+        const int index = static_cast<int>(position);
+        const float frac = position - static_cast<float>(index);
+        return m_gains[index] + (m_gains[index + 1] - m_gains[index]) * frac;
+    }
+
+    // t runs from 0 (only the outgoing channel) to 1 (only the incoming one).
+    constexpr CrossfadeGains operator()(float t) const { return { FadeIn(1.0f - t), FadeIn(t) }; }
+
+private:
+    explicit constexpr CrossfadeTable(int) {}
+
+    std::array<float, Steps + 1> m_gains{};
+};
+
+template <typename Fade>
+inline constexpr CrossfadeTable CrossfadeTableFor = CrossfadeTable::Build(Fade{});
+
+// `shape` is only used by CrossfadeCurve::Custom, which is sampled when asked for.
+inline CrossfadeTable GetCrossfadeTable(CrossfadeCurve curve, float shape = 2.0f)
+{
+    switch (curve)
+    {
+    case CrossfadeCurve::EqualPower: return CrossfadeTableFor<EqualPowerFade>;
+    case CrossfadeCurve::SCurve: return CrossfadeTableFor<SCurveFade>;
+    case CrossfadeCurve::Logarithmic: return CrossfadeTableFor<LogarithmicFade>;
+    case CrossfadeCurve::Custom: return CrossfadeTable::Build(PowerFade{ shape > 0.0f ? shape : 2.0f });
+    case CrossfadeCurve::Linear:
+    default:
+        return CrossfadeTableFor<LinearFade>;
+    }
+}
+
+inline constexpr CrossfadeCurve AllCrossfadeCurves[] = {
+    CrossfadeCurve::Linear, CrossfadeCurve::EqualPower, CrossfadeCurve::SCurve,
+    CrossfadeCurve::Logarithmic, CrossfadeCurve::Custom
+};
+
+inline const char* GetCrossfadeCurveName(CrossfadeCurve curve)
+{
+    switch (curve)
+    {
+    case CrossfadeCurve::EqualPower: return "Equal power";
+    case CrossfadeCurve::SCurve: return "S-curve";
+    case CrossfadeCurve::Logarithmic: return "Logarithmic";
+    case CrossfadeCurve::Custom: return "Custom";
+    default: return "Linear";
+    }
+}
+
+// Identifiers used in the playlist files and the journal.
+inline const char* GetCrossfadeCurveKey(CrossfadeCurve curve)
+{
+    switch (curve)
+    {
+    case CrossfadeCurve::EqualPower: return "equalPower";
+    case CrossfadeCurve::SCurve: return "sCurve";
+    case CrossfadeCurve::Logarithmic: return "logarithmic";
+    case CrossfadeCurve::Custom: return "custom";
+    default: return "linear";
+    }
+}
+
+inline bool ParseCrossfadeCurve(std::string_view key, CrossfadeCurve& curve)
+{
+    for (CrossfadeCurve candidate : AllCrossfadeCurves)
+    {
+        if (key == GetCrossfadeCurveKey(candidate))
+        {
+            curve = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace TSM
@@ -0,0 +1,169 @@
+// tsm_cue_planner.cpp
+
+#include "tsm_cue_planner.h"
+
+#include <algorithm>
+
+namespace TSM
+{
+
+namespace
+{
+
+// Shortens the entries, in proportion to their slack, until they add up to `targetMs`.
+// The caller guarantees that sum(min) <= target <= sum(max).
+std::vector<uint32_t> Distribute(const std::vector<CuePlanItem>& items, uint64_t targetMs)
+{
+    uint64_t totalMs = 0;
+    uint64_t totalSlack = 0;
+    for (const auto& item : items)
+    {
+        totalMs += item.maxMs;
+        totalSlack += item.maxMs - item.minMs;
+    }
+
+    std::vector<uint32_t> durations(items.size());
+    uint64_t excess = totalMs - targetMs;
+    uint64_t removed = 0;
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        const uint64_t slack = items[i].maxMs - items[i].minMs;
+        const uint64_t cut = totalSlack > 0 ? excess * slack / totalSlack : 0;
+        durations[i] = static_cast<uint32_t>(items[i].maxMs - cut);
+        removed += cut;
+    }
+
+    // Les arrondis restants sont pris là où il reste de la marge
+    for (size_t i = 0; i < items.size() && removed < excess; i++)
+    {
+        const uint64_t cut = std::min<uint64_t>(excess - removed, durations[i] - items[i].minMs);
+        durations[i] -= static_cast<uint32_t>(cut);
+        removed += cut;
+    }
+    return durations;
+}
+
+void Accept(CuePlan& plan, const CuePlanRequest& request, const std::vector<size_t>& order)
+{
+    std::vector<CuePlanItem> items{ request.current };
+    for (size_t index : order)
+    {
+        items.push_back(request.upcoming[index]);
+    }
+
+    std::vector<uint32_t> durations = Distribute(items, request.cueInMs);
+    plan.found = true;
+    plan.currentMs = durations[0];
+    plan.order = order;
+    plan.durationsMs.assign(durations.begin() + 1, durations.end());
+}
+
+bool PlanPrefix(CuePlan& plan, const CuePlanRequest& request)
+{
+    uint64_t minMs = request.current.minMs;
+    uint64_t maxMs = request.current.maxMs;
+    std::vector<size_t> order;
+
+    for (size_t i = 0; ; i++)
+    {
+        if (minMs <= request.cueInMs && request.cueInMs <= maxMs)
+        {
+            Accept(plan, request, order);
+            return true;
+        }
+        if (minMs > request.cueInMs || i >= request.upcoming.size()) return false;
+
+        const CuePlanItem& item = request.upcoming[i];
+        if (item.maxMs == 0) return false;      // unknown length, nothing can be planned past it
+        minMs += item.minMs;
+        maxMs += item.maxMs;
+        order.push_back(i);
+    }
+}
+
+bool PlanSubset(CuePlan& plan, const CuePlanRequest& request)
+{
+    if (request.cueInMs <= request.current.maxMs) return false;
+
+    const uint64_t granularity = std::max<uint32_t>(request.granularityMs, 1);
+    const uint64_t needMs = request.cueInMs - request.current.maxMs;
+
+    std::vector<uint64_t> weights(request.upcoming.size(), 0);
+    uint64_t totalUnits = 0;
+    uint64_t totalSlack = request.current.maxMs - request.current.minMs;
+    for (size_t i = 0; i < request.upcoming.size(); i++)
+    {
+        const CuePlanItem& item = request.upcoming[i];
+        if (item.maxMs == 0) continue;
+        weights[i] = std::max<uint64_t>((item.maxMs + granularity / 2) / granularity, 1);
+        totalUnits += weights[i];
+        totalSlack += item.maxMs - item.minMs;
+    }
+
+    // Sommes atteignables : reachedBy[s] est la dernière entrée ajoutée pour atteindre s
+    const uint64_t firstUnit = needMs / granularity;
+    const uint64_t lastUnit = std::min(totalUnits, (needMs + totalSlack) / granularity + request.upcoming.size() + 1);
+    if (firstUnit > lastUnit) return false;
+
+    constexpr int32_t Unreached = -1;
+    constexpr int32_t Start = -2;
+    std::vector<int32_t> reachedBy(lastUnit + 1, Unreached);
+    reachedBy[0] = Start;
+    for (size_t i = 0; i < request.upcoming.size(); i++)
+    {
+        const uint64_t weight = weights[i];
+        if (weight == 0 || weight > lastUnit) continue;
+        for (uint64_t s = lastUnit; s >= weight; s--)
+        {
+            if (reachedBy[s] == Unreached && reachedBy[s - weight] != Unreached)
+            {
+                reachedBy[s] = static_cast<int32_t>(i);
+            }
+        }
+    }
+
+    // The smallest total that can be trimmed down to the cue, in exact milliseconds.
+    for (uint64_t s = firstUnit; s <= lastUnit; s++)
+    {
+        if (reachedBy[s] == Unreached || reachedBy[s] == Start) continue;
+
+        std::vector<size_t> order;
+        uint64_t sumMs = 0;
+        uint64_t slack = request.current.maxMs - request.current.minMs;
+        for (uint64_t unit = s; reachedBy[unit] != Start; unit -= weights[reachedBy[unit]])
+        {
+            const size_t index = static_cast<size_t>(reachedBy[unit]);
+            order.push_back(index);
+            sumMs += request.upcoming[index].maxMs;
+            slack += request.upcoming[index].maxMs - request.upcoming[index].minMs;
+        }
+        if (sumMs < needMs || sumMs - needMs > slack) continue;
+
+        std::sort(order.begin(), order.end());
+        Accept(plan, request, order);
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+uint32_t CuePlan::TotalMs() const
+{
+    uint64_t total = currentMs;
+    for (uint32_t duration : durationsMs)
+    {
+        total += duration;
+    }
+    return static_cast<uint32_t>(total);
+}
+
+CuePlan PlanToCue(const CuePlanRequest& request)
+{
+    CuePlan plan;
+    if (PlanPrefix(plan, request)) return plan;
+    if (request.reorder && PlanSubset(plan, request)) return plan;
+    return CuePlan();
+}
+
+} // namespace TSM
@@ -0,0 +1,43 @@
+// tsm_cue_planner.h
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace TSM
+{
+
+// How long an entry may play before the next one starts: its full length, or down to
+// minMs when its end (or its segment) can be cut short.
+struct CuePlanItem
+{
+    uint32_t maxMs = 0;
+    uint32_t minMs = 0;
+};
+
+struct CuePlanRequest
+{
+    CuePlanItem current;                // what is left of the current track
+    uint32_t cueInMs = 0;               // from now to the cue
+    std::vector<CuePlanItem> upcoming;  // in the order they would play
+    bool reorder = false;               // entries may be picked out of order (shuffle)
+    uint32_t granularityMs = 250;       // subset search resolution
+};
+
+struct CuePlan
+{
+    bool found = false;
+    uint32_t currentMs = 0;             // time the current track keeps playing
+    std::vector<size_t> order;          // upcoming entries played before the cue
+    std::vector<uint32_t> durationsMs;  // how long each of them plays
+
+    uint32_t TotalMs() const;
+};
+
+// Chooses the entries and their lengths so that one of them ends exactly on the cue.
+// An ordered prefix is tried first; when `reorder` is set a 0/1 subset sum over the
+// upcoming entries is solved next, in O(entries x cue / granularity).
+CuePlan PlanToCue(const CuePlanRequest& request);
+
+} // namespace TSM
@@ -0,0 +1,514 @@
+// tsm_cue_stack.cpp
+
+#include "tsm_cue_stack.h"
+#include "tsm_audio_manager.h"
+#include "tsm_announcement_manager.h"
+#include "tsm_playlist_manager.h"
+
+#include <spdlog/spdlog.h>
+#include <json/json.hpp>
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace TSM
+{
+    using json = nlohmann::json;
+
+namespace
+{
+    bool IsPausedChannel(FMOD::Channel* channel)
+    {
+        bool paused = false;
+        return channel && channel->getPaused(&paused) == FMOD_OK && paused;
+    }
+
+    bool IsPlayingChannel(FMOD::Channel* channel)
+    {
+        bool isPlaying = false;
+        return channel && channel->isPlaying(&isPlaying) == FMOD_OK && isPlaying;
+    }
+}
+
+bool CueStack::LoadFile(const std::string& filePath)
+{
+    std::ifstream file(filePath.c_str());
+    if (!file.is_open())
+    {
+        spdlog::debug("No cue stack at '{}'.", filePath);
+        return false;
+    }
+
+    std::stringstream text;
+    text << file.rdbuf();
+    return LoadString(text.str(), filePath);
+}
+
+bool CueStack::LoadString(const std::string& text, const std::string& sourceName)
+{
+    std::string name;
+    std::vector<Cue> cues;
+
+    try
+    {
+        const json j = json::parse(text);
+        name = j.value("name", sourceName);
+
+        const json items = j.at("cues");
+        for (const auto& item : items)
+        {
+            Cue cue;
+            const std::string type = item.at("type").get<std::string>();
+            if (!item.contains("number")) cue.number = std::to_string(cues.size() + 1);
+            else if (item["number"].is_string()) cue.number = item["number"].get<std::string>();
+            else cue.number = item["number"].dump();
+            cue.label = item.value("label", "");
+            cue.autoContinue = item.value("continue", false);
+
+            auto requireTarget = [&](const char* key) {
+                if (!item.contains(key)) throw std::runtime_error("cue " + cue.number + " has no '" + key + "'");
+                cue.target = item[key].get<std::string>();
+            };
+
+            if (type == "play")
+            {
+                cue.type = CueType::Play;
+                requireTarget("sound");
+                cue.bus = item.value("bus", "sfx") == "music" ? ShowBus::Music : ShowBus::Sfx;
+                cue.loop = item.value("loop", false);
+                cue.volume = item.value("volume", 1.0f);
+                cue.startSeconds = std::max(item.value("start", 0.0f), 0.0f);
+            }
+            else if (type == "stop")
+            {
+                cue.type = CueType::Stop;
+                cue.target = item.value("sound", "");
+            }
+            else if (type == "fade")
+            {
+                cue.type = CueType::Fade;
+                requireTarget("sound");
+                cue.level = item.value("to", 0.0f);
+                cue.seconds = item.value("seconds", 0.0f);
+                cue.stopAtEnd = item.value("stop", false);
+            }
+            else if (type == "duck")
+            {
+                cue.type = CueType::Duck;
+                cue.level = item.value("to", 1.0f);
+                cue.seconds = item.value("seconds", 0.0f);
+            }
+            else if (type == "playlist")
+            {
+                cue.type = CueType::Playlist;
+                cue.target = item.value("name", "");
+            }
+            else if (type == "announcement")
+            {
+                cue.type = CueType::Announcement;
+                requireTarget("name");
+                cue.level = item.value("to", 0.05f);
+            }
+            else if (type == "show")
+            {
+                cue.type = CueType::Show;
+                requireTarget("name");
+            }
+            else
+            {
+                throw std::runtime_error("unknown cue type '" + type + "'");
+            }
+            cues.push_back(cue);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Error loading cue stack '{}': {}", sourceName, e.what());
+        return false;
+    }
+
+    Disarm();
+    m_name = std::move(name);
+    m_cues = std::move(cues);
+    m_armed.assign(m_cues.size(), nullptr);
+    m_ready.assign(m_cues.size(), false);
+    m_standby = 0;
+    m_armRetryAt = 0.0;
+
+    // Les mesures parlent des numéros de l'ancienne liste
+    m_latencySerial += m_latencies.size();
+    m_latencies.clear();
+    m_pendingLatencies.clear();
+
+    spdlog::info("Cue stack '{}' loaded from '{}': {} cues.", m_name, sourceName, m_cues.size());
+    return true;
+}
+
+void CueStack::SetOutput(OutputId output)
+{
+    if (output == m_output) return;
+    Disarm();
+    m_output = output;
+}
+
+void CueStack::SetPreloadCount(size_t count)
+{
+    m_preloadCount = std::max<size_t>(count, 1);
+}
+
+bool CueStack::SetStandby(size_t cue)
+{
+    if (cue >= m_cues.size())
+    {
+        spdlog::error("Cue stack '{}' has no cue {}.", m_name, cue);
+        return false;
+    }
+
+    m_standby = cue;
+    m_armRetryAt = 0.0;
+    spdlog::info("Cue stack '{}': cue {} on standby.", m_name, m_cues[cue].number);
+    return true;
+}
+
+bool CueStack::Go()
+{
+    if (m_standby >= m_cues.size())
+    {
+        spdlog::warn("Cue stack '{}': no cue on standby.", m_name);
+        return false;
+    }
+
+    const auto goTime = std::chrono::steady_clock::now();
+    const unsigned long long goClock = AudioManager::GetInstance().GetMasterDSPClock(m_output);
+
+    size_t cue = m_standby;
+    bool next = true;
+    while (next && cue < m_cues.size())
+    {
+        next = m_cues[cue].autoContinue;
+        Fire(cue++, goTime, goClock);
+    }
+    m_standby = cue;
+    return true;
+}
+
+void CueStack::Disarm()
+{
+    for (size_t i = 0; i < m_armed.size(); i++) Release(i);
+}
+
+void CueStack::ReleaseSound(const std::string& soundName)
+{
+    for (size_t i = 0; i < m_armed.size(); i++)
+    {
+        if (m_ready[i] && m_cues[i].target == soundName) Release(i);
+    }
+}
+
+void CueStack::Update(float deltaTime)
+{
+    m_clock += deltaTime;
+
+    if (m_ducking)
+    {
+        const float t = std::min(static_cast<float>((m_clock - m_duckStart) / m_duckSeconds), 1.0f);
+        if (m_host.setLevel) m_host.setLevel(m_duckFrom + (m_duckTo - m_duckFrom) * t);
+        if (t >= 1.0f) m_ducking = false;
+    }
+
+    MeasureLatencies();
+    m_fades.erase(std::remove_if(m_fades.begin(), m_fades.end(),
+                                 [](const ChannelFade& fade) { return !IsPlayingChannel(fade.channel); }),
+                  m_fades.end());
+
+    // Seules les prochaines cues gardent un canal
+    const size_t end = WindowEnd();
+    for (size_t i = 0; i < m_cues.size(); i++)
+    {
+        if ((i < m_standby || i >= end) && m_ready[i]) Release(i);
+    }
+
+    if (m_clock < m_armRetryAt) return;
+    for (size_t i = m_standby; i < end; i++)
+    {
+        if (IsArmed(i)) continue;
+        Release(i);
+        if (!Arm(i)) m_armRetryAt = m_clock + ArmRetrySeconds;
+    }
+}
+
+bool CueStack::IsArmed(size_t cue) const
+{
+    if (cue >= m_cues.size() || !m_ready[cue]) return false;
+    return m_cues[cue].type != CueType::Play || IsPausedChannel(m_armed[cue]);
+}
+
+const char* CueStack::GetCueTypeName(CueType type)
+{
+    switch (type)
+    {
+    case CueType::Play: return "Play";
+    case CueType::Stop: return "Stop";
+    case CueType::Fade: return "Fade";
+    case CueType::Duck: return "Duck";
+    case CueType::Playlist: return "Playlist";
+    case CueType::Announcement: return "Announcement";
+    case CueType::Show:
+    default: return "Show";
+    }
+}
+
+size_t CueStack::WindowEnd() const
+{
+    size_t end = std::min(m_standby + m_preloadCount, m_cues.size());
+    // Une GO part avec toutes ses cues enchaînées
+    while (end > m_standby && end < m_cues.size() && m_cues[end - 1].autoContinue) end++;
+    return end;
+}
+
+bool CueStack::Arm(size_t cue)
+{
+    const Cue& c = m_cues[cue];
+    bool armed = true;
+
+    switch (c.type)
+    {
+    case CueType::Play:
+    {
+        FMOD::Channel* channel = AudioManager::GetInstance().ArmSound(c.target, c.loop, c.volume * BusVolume(c.bus), 1.0f, m_output);
+        if (channel && c.startSeconds > 0.0f)
+        {
+            channel->setPosition(static_cast<unsigned int>(c.startSeconds * 1000.0f), FMOD_TIMEUNIT_MS);
+        }
+        m_armed[cue] = channel;
+        armed = channel != nullptr;
+        break;
+    }
+    case CueType::Announcement:
+        armed = AudioManager::GetInstance().PrefetchSound(c.target) || AnnouncementManager::GetInstance().IsPhrase(c.target);
+        break;
+    case CueType::Show:
+        armed = ShowTimeline::GetInstance().PrefetchSequence(c.target);
+        break;
+    default:
+        break;
+    }
+
+    if (!armed)
+    {
+        spdlog::warn("Cue stack '{}': cue {} cannot be armed ('{}').", m_name, c.number, c.target);
+        return false;
+    }
+    m_ready[cue] = true;
+    return true;
+}
+
+void CueStack::Release(size_t cue)
+{
+    if (m_armed[cue])
+    {
+        m_armed[cue]->stop();
+        m_armed[cue] = nullptr;
+    }
+    m_ready[cue] = false;
+}
+
+void CueStack::Fire(size_t cue, std::chrono::steady_clock::time_point goTime, unsigned long long goClock)
+{
+    const Cue& c = m_cues[cue];
+    CueLatency latency;
+    latency.cue = cue;
+    latency.armed = IsArmed(cue);
+
+    FMOD::Channel* channel = nullptr;
+    unsigned int startPcm = 0;
+
+    switch (c.type)
+    {
+    case CueType::Play:
+        // Pas armée à temps : le fichier s'ouvre maintenant, quitte à reprendre le flux là où il joue
+        if (!latency.armed)
+        {
+            Release(cue);
+            channel = AudioManager::GetInstance().PlaySound(c.target, c.loop, c.volume * BusVolume(c.bus), 1.0f, m_output);
+            if (channel && c.startSeconds > 0.0f)
+            {
+                channel->setPosition(static_cast<unsigned int>(c.startSeconds * 1000.0f), FMOD_TIMEUNIT_MS);
+            }
+            if (channel) channel->getPosition(&startPcm, FMOD_TIMEUNIT_PCM);
+            break;
+        }
+        channel = m_armed[cue];
+        m_armed[cue] = nullptr;
+        m_ready[cue] = false;
+        if (channel)
+        {
+            channel->getPosition(&startPcm, FMOD_TIMEUNIT_PCM);
+            channel->setVolume(c.volume * BusVolume(c.bus));
+            if (!AudioManager::GetInstance().StartArmedSound(c.target, channel))
+            {
+                channel->stop();
+                channel = nullptr;
+            }
+        }
+        break;
+
+    case CueType::Stop:
+        if (c.target.empty())
+        {
+            PlaylistManager::GetInstance().Stop("");
+            AudioManager::GetInstance().StopAllSounds();
+            if (AnnouncementManager::GetInstance().IsAnnouncing()) AnnouncementManager::GetInstance().StopAnnouncement();
+        }
+        else
+        {
+            AudioManager::GetInstance().StopSound(c.target);
+        }
+        break;
+
+    case CueType::Fade:
+    {
+        const auto& sounds = AudioManager::GetInstance().GetAllSounds();
+        auto it = sounds.find(c.target);
+        if (it == sounds.end()) break;
+        for (FMOD::Channel* playing : it->second.channels)
+        {
+            if (IsPlayingChannel(playing)) FadeChannel(playing, c.level, c.seconds, c.stopAtEnd);
+        }
+        break;
+    }
+
+    case CueType::Duck:
+        StartDuck(c.level, c.seconds);
+        break;
+
+    case CueType::Playlist:
+        if (m_host.startPlaylist) m_host.startPlaylist(c.target);
+        break;
+
+    case CueType::Announcement:
+        AnnouncementManager::GetInstance().PlayAnnouncement(c.target, c.level, true, true);
+        break;
+
+    case CueType::Show:
+        ShowTimeline::GetInstance().Start(c.target);
+        break;
+    }
+
+    latency.dispatchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - goTime).count();
+
+    unsigned int bufferLength = 0;
+    int bufferCount = 0;
+    FMOD::System* system = FModWrapper::GetInstance().GetSystem(m_output);
+    if (system && system->getDSPBufferSize(&bufferLength, &bufferCount) == FMOD_OK)
+    {
+        latency.outputBufferMs = 1000.0 * bufferLength * bufferCount / AudioManager::GetInstance().GetOutputSampleRate(m_output);
+    }
+
+    m_latencies.push_back(latency);
+    if (channel) m_pendingLatencies.push_back({ m_latencySerial + m_latencies.size() - 1, channel, goClock, startPcm });
+    if (m_latencies.size() > MaxLatencies)
+    {
+        m_latencies.erase(m_latencies.begin());
+        m_latencySerial++;
+    }
+
+    spdlog::info("Cue {} GO: {} '{}'{} in {:.3f} ms.", c.number, GetCueTypeName(c.type), c.target,
+                 c.type == CueType::Play && !latency.armed ? " (not armed)" : "", latency.dispatchMs);
+}
+
+void CueStack::FadeChannel(FMOD::Channel* channel, float level, float seconds, bool stop)
+{
+    unsigned long long clock = 0;
+    FMOD::System* system = nullptr;
+    int sampleRate = 48000;
+    if (channel->getDSPClock(nullptr, &clock) != FMOD_OK || channel->getSystemObject(&system) != FMOD_OK) return;
+    system->getSoftwareFormat(&sampleRate, nullptr, nullptr);
+
+    // Un fondu encore en cours repart du niveau où il en est
+    float from = 1.0f;
+    auto it = std::find_if(m_fades.begin(), m_fades.end(), [channel](const ChannelFade& fade) { return fade.channel == channel; });
+    if (it != m_fades.end())
+    {
+        if (clock >= it->endClock) from = it->to;
+        else if (clock > it->startClock)
+        {
+            const double t = static_cast<double>(clock - it->startClock) / (it->endClock - it->startClock);
+            from = static_cast<float>(it->from + (it->to - it->from) * t);
+        }
+        else from = it->from;
+        m_fades.erase(it);
+    }
+
+    // Au moins 64 échantillons, pour qu'une coupure ne claque pas
+    const unsigned long long length = std::max<unsigned long long>(static_cast<unsigned long long>(std::max(seconds, 0.0f) * sampleRate), 64);
+    const unsigned long long endClock = clock + length;
+    channel->removeFadePoints(0, ULLONG_MAX);
+    channel->addFadePoint(clock, from);
+    channel->addFadePoint(endClock, level);
+    if (stop) channel->setDelay(0, endClock, true);
+
+    m_fades.push_back({ channel, clock, endClock, from, level });
+}
+
+void CueStack::StartDuck(float level, float seconds)
+{
+    if (seconds <= 0.0f)
+    {
+        m_ducking = false;
+        if (m_host.setLevel) m_host.setLevel(level);
+        return;
+    }
+
+    m_ducking = true;
+    m_duckFrom = m_host.getLevel ? m_host.getLevel() : level;
+    m_duckTo = level;
+    m_duckStart = m_clock;
+    m_duckSeconds = seconds;
+}
+
+// The channel was unpaused at the GO; once the mixer has played it, the samples it has
+// moved through are counted back from the output's clock to find its first one.
+void CueStack::MeasureLatencies()
+{
+    for (auto it = m_pendingLatencies.begin(); it != m_pendingLatencies.end();)
+    {
+        CueLatency* latency = it->serial >= m_latencySerial && it->serial - m_latencySerial < m_latencies.size()
+            ? &m_latencies[it->serial - m_latencySerial] : nullptr;
+
+        unsigned int position = 0;
+        float frequency = 0.0f;
+        if (!latency || !IsPlayingChannel(it->channel) ||
+            it->channel->getPosition(&position, FMOD_TIMEUNIT_PCM) != FMOD_OK ||
+            it->channel->getFrequency(&frequency) != FMOD_OK || frequency <= 0.0f || position < it->startPcm)
+        {
+            it = m_pendingLatencies.erase(it);
+            continue;
+        }
+        if (position == it->startPcm)
+        {
+            ++it;
+            continue;
+        }
+
+        const int sampleRate = AudioManager::GetInstance().GetOutputSampleRate(m_output);
+        const double played = (position - it->startPcm) * static_cast<double>(sampleRate) / frequency;
+        const double now = static_cast<double>(AudioManager::GetInstance().GetMasterDSPClock(m_output));
+        const double firstSample = std::max(now - played - static_cast<double>(it->goClock), 0.0);
+
+        latency->firstSampleMs = 1000.0 * firstSample / sampleRate;
+        latency->measured = true;
+        spdlog::info("Cue {}: first sample {:.1f} ms after GO, {:.1f} ms more in the device buffer.",
+                     m_cues[latency->cue].number, latency->firstSampleMs, latency->outputBufferMs);
+        it = m_pendingLatencies.erase(it);
+    }
+}
+
+float CueStack::BusVolume(ShowBus bus) const
+{
+    return m_host.getVolume ? m_host.getVolume(bus) : 1.0f;
+}
+
+} // namespace TSM
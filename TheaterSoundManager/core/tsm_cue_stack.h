@@ -0,0 +1,165 @@
+// tsm_cue_stack.h
+#pragma once
+
+#include <fmod.hpp>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "tsm_fmod_wrapper.h"
+#include "tsm_show_timeline.h"
+
+namespace TSM
+{
+
+enum class CueType : uint8_t
+{
+    Play,
+    Stop,           // one sound, or every sound and playlist when none is named
+    Fade,           // the sound's channels, on the DSP clock; `stop` ends them with the fade
+    Duck,           // moves the music level, like a show fade
+    Playlist,
+    Announcement,
+    Show            // starts a sequence of the show timeline
+};
+
+struct Cue
+{
+    std::string number;         // what the stage manager calls: "12", "12.5"
+    std::string label;
+    CueType type = CueType::Play;
+    std::string target;         // sound, playlist, announcement or show sequence
+    ShowBus bus = ShowBus::Sfx;
+    bool loop = false;
+    float volume = 1.0f;        // on top of the bus volume
+    float startSeconds = 0.0f;  // where the sound starts
+    float level = 0.0f;         // fade and duck: where the volume goes; announcement: the music under it
+    float seconds = 0.0f;
+    bool stopAtEnd = false;
+    bool autoContinue = false;  // the same GO fires the next cue too
+};
+
+// One fired cue. dispatchMs is the time spent inside Go(); firstSampleMs runs from the GO
+// to the first sample of the cue in the mix, read on the output's DSP clock, and the
+// device buffer plays it outputBufferMs later.
+struct CueLatency
+{
+    size_t cue = 0;
+    bool armed = false;         // fired from a channel prepared ahead
+    bool measured = false;
+    double dispatchMs = 0.0;
+    double firstSampleMs = 0.0;
+    double outputBufferMs = 0.0;
+};
+
+// Ordered cues with a standby/GO model. The standby cue and the next ones are kept armed:
+// a play cue holds a paused channel already seeked to its start, the others have their
+// sounds opened. GO only unpauses and never touches a file.
+//
+// { "name": "Act 1", "cues": [
+//     { "number": "1", "label": "Preshow", "type": "playlist", "name": "Preshow" },
+//     { "number": "2", "type": "duck", "to": 0.2, "seconds": 3, "continue": true },
+//     { "number": "2.5", "type": "play", "sound": "sfx_thunder", "start": 1.5, "volume": 0.8 },
+//     { "number": "3", "type": "fade", "sound": "sfx_rain", "to": 0, "seconds": 5, "stop": true },
+//     { "number": "4", "type": "announcement", "name": "ann_intermission", "to": 0.05 },
+//     { "number": "5", "type": "show", "name": "ceremony" } ] }
+class CueStack
+{
+public:
+    static constexpr size_t MaxLatencies = 32;
+    static constexpr float ArmRetrySeconds = 2.0f;     // after a cue could not be armed
+
+    static CueStack& GetInstance()
+    {
+        static CueStack instance;
+        return instance;
+    }
+
+    // Replaces the stack and puts the first cue on standby; a broken file changes nothing.
+    bool LoadFile(const std::string& filePath);
+    bool LoadString(const std::string& text, const std::string& sourceName);
+
+    const std::string& GetName() const { return m_name; }
+    const std::vector<Cue>& GetCues() const { return m_cues; }
+
+    void SetHost(const ShowTimelineHost& host) { m_host = host; }
+    void SetOutput(OutputId output);
+    // Cues armed from the standby one on.
+    void SetPreloadCount(size_t count);
+    size_t GetPreloadCount() const { return m_preloadCount; }
+
+    bool SetStandby(size_t cue);
+    // The cue count once the last cue has gone.
+    size_t GetStandby() const { return m_standby; }
+    bool Go();
+    // Releases the armed channels; the cues are armed again on the next Update.
+    void Disarm();
+    // Same, for the cues on `soundName` only; AudioManager calls it when the sound is unloaded.
+    void ReleaseSound(const std::string& soundName);
+
+    void Update(float deltaTime);
+
+    bool IsArmed(size_t cue) const;
+    FMOD::Channel* GetArmedChannel(size_t cue) const { return cue < m_armed.size() ? m_armed[cue] : nullptr; }
+    // Oldest first.
+    const std::vector<CueLatency>& GetLatencies() const { return m_latencies; }
+
+    static const char* GetCueTypeName(CueType type);
+
+private:
+    struct PendingLatency
+    {
+        uint64_t serial;
+        FMOD::Channel* channel;
+        unsigned long long goClock;
+        unsigned int startPcm;
+    };
+
+    struct ChannelFade
+    {
+        FMOD::Channel* channel;
+        unsigned long long startClock;
+        unsigned long long endClock;
+        float from;
+        float to;
+    };
+
+    CueStack() = default;
+    CueStack(const CueStack&) = delete;
+    CueStack& operator=(const CueStack&) = delete;
+
+    size_t WindowEnd() const;
+    bool Arm(size_t cue);
+    void Release(size_t cue);
+    void Fire(size_t cue, std::chrono::steady_clock::time_point goTime, unsigned long long goClock);
+    void FadeChannel(FMOD::Channel* channel, float level, float seconds, bool stop);
+    void StartDuck(float level, float seconds);
+    void MeasureLatencies();
+    float BusVolume(ShowBus bus) const;
+
+    std::string m_name;
+    std::vector<Cue> m_cues;
+    ShowTimelineHost m_host;
+    OutputId m_output = FModWrapper::MainOutput;
+    size_t m_preloadCount = 3;
+    size_t m_standby = 0;
+
+    std::vector<FMOD::Channel*> m_armed;        // per cue, paused until its GO
+    std::vector<bool> m_ready;
+    double m_armRetryAt = 0.0;
+    std::vector<ChannelFade> m_fades;
+
+    std::vector<CueLatency> m_latencies;
+    uint64_t m_latencySerial = 0;               // of m_latencies.front()
+    std::vector<PendingLatency> m_pendingLatencies;
+
+    double m_clock = 0.0;
+    bool m_ducking = false;
+    float m_duckFrom = 0.0f;
+    float m_duckTo = 0.0f;
+    double m_duckStart = 0.0;
+    float m_duckSeconds = 0.0f;
+};
+
+} // namespace TSM
@@ -1,22 +1,38 @@
 // tsm_fmod_wrapper.cpp
 
 #include "tsm_fmod_wrapper.h"
+#include "tsm_audio_manager.h"
+
+#include <json/json.hpp>
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
 
 namespace TSM 
 {
+    using json = nlohmann::json;
 
 bool FModWrapper::Initialize()
 {
     FMOD_RESULT result;
 
-    result = FMOD::System_Create(&m_system);
+    if (m_outputs.empty())
+    {
+        m_outputs.emplace_back();
+    }
+    Output& main = m_outputs[MainOutput];
+    main.name = "main";
+
+    result = FMOD::System_Create(&main.system);
     if (result != FMOD_OK)
     {
         spdlog::error("Failed to create FMOD system: {}", FMOD_ErrorString(result));
+        main.system = nullptr;
         return false;
     }
 
-    result = m_system->init(512, FMOD_INIT_NORMAL, nullptr);
+    result = main.system->init(512, FMOD_INIT_NORMAL, nullptr);
     if (result != FMOD_OK)
     {
         spdlog::error("Failed to initialize FMOD system: {}", FMOD_ErrorString(result));
@@ -29,26 +45,213 @@ bool FModWrapper::Initialize()
 
 void FModWrapper::Update() 
 {
-    if (m_system)
+    for (const auto& output : m_outputs)
     {
-        FMOD_RESULT result = m_system->update();
+        if (!output.system) continue;
+
+        FMOD_RESULT result = output.system->update();
         if (result != FMOD_OK)
         {
-            spdlog::error("FMOD update failed: {}", FMOD_ErrorString(result));
+            spdlog::error("FMOD update failed on output '{}': {}", output.name, FMOD_ErrorString(result));
         }
     }
 }
 
 void FModWrapper::Shutdown() 
 {
-    if (m_system)
+    // Les sorties secondaires d'abord : leurs sons pointent sur des buffers partagés
+    for (OutputId output = static_cast<OutputId>(m_outputs.size()); output-- > 0; )
     {
-        m_system->close();
-        m_system->release();
-        m_system = nullptr;
+        if (!m_outputs[output].system) continue;
+
+        AudioManager::GetInstance().ReleaseOutputSounds(output);
+        m_outputs[output].system->close();
+        m_outputs[output].system->release();
+        m_outputs[output].system = nullptr;
     }
+    m_outputs.clear();
 
     spdlog::info("FMOD shutdown successfully.");
 }
 
+FMOD::System* FModWrapper::GetSystem(OutputId output) const
+{
+    return output < m_outputs.size() ? m_outputs[output].system : nullptr;
+}
+
+OutputId FModWrapper::AddOutput(const OutputConfig& config)
+{
+    if (config.name.empty() || FindOutput(config.name) != InvalidOutput)
+    {
+        spdlog::error("Output name '{}' is empty or already used.", config.name);
+        return InvalidOutput;
+    }
+
+    FMOD::System* system = nullptr;
+    FMOD_RESULT result = FMOD::System_Create(&system);
+    if (result != FMOD_OK)
+    {
+        spdlog::error("Failed to create FMOD system for output '{}': {}", config.name, FMOD_ErrorString(result));
+        return InvalidOutput;
+    }
+
+    // Le type de sortie doit être choisi avant d'énumérer les drivers
+    result = system->setOutput(config.outputType);
+    int driver = (result == FMOD_OK) ? FindDriver(system, config.driver) : -1;
+    if (driver < 0)
+    {
+        spdlog::error("Output '{}': driver '{}' not found.", config.name, config.driver);
+        system->release();
+        return InvalidOutput;
+    }
+
+    result = system->setDriver(driver);
+    if (result == FMOD_OK)
+    {
+        result = system->init(config.maxChannels, FMOD_INIT_NORMAL, nullptr);
+    }
+    if (result != FMOD_OK)
+    {
+        spdlog::error("Failed to initialize output '{}': {}", config.name, FMOD_ErrorString(result));
+        system->release();
+        return InvalidOutput;
+    }
+
+    if (m_outputs.empty())
+    {
+        m_outputs.emplace_back();
+    }
+
+    Output output;
+    output.name = config.name;
+    output.system = system;
+    char name[256] = {};
+    system->getDriverInfo(driver, name, sizeof(name), nullptr, nullptr, nullptr, nullptr);
+    output.driver = name;
+    m_outputs.push_back(output);
+
+    spdlog::info("Output '{}' opened on '{}'.", config.name, output.driver);
+    return static_cast<OutputId>(m_outputs.size() - 1);
+}
+
+bool FModWrapper::RemoveOutput(OutputId output)
+{
+    if (output == MainOutput || !GetSystem(output))
+    {
+        spdlog::error("Output {} cannot be removed.", output);
+        return false;
+    }
+
+    AudioManager::GetInstance().ReleaseOutputSounds(output);
+
+    Output& removed = m_outputs[output];
+    removed.system->close();
+    removed.system->release();
+    spdlog::info("Output '{}' closed.", removed.name);
+    removed = Output();
+    return true;
+}
+
+OutputId FModWrapper::FindOutput(const std::string& name) const
+{
+    for (size_t i = 0; i < m_outputs.size(); i++)
+    {
+        if (m_outputs[i].system && m_outputs[i].name == name) return static_cast<OutputId>(i);
+    }
+    return InvalidOutput;
+}
+
+std::string FModWrapper::GetOutputName(OutputId output) const
+{
+    return GetSystem(output) ? m_outputs[output].name : "";
+}
+
+std::string FModWrapper::GetOutputDriver(OutputId output) const
+{
+    return GetSystem(output) ? m_outputs[output].driver : "";
+}
+
+bool FModWrapper::LoadOutputs(const std::string& filePath)
+{
+    try
+    {
+        std::ifstream file(filePath.c_str());
+        if (!file.is_open())
+        {
+            spdlog::debug("No output configuration at '{}'.", filePath);
+            return false;
+        }
+
+        json j;
+        file >> j;
+
+        size_t opened = 0;
+        for (const auto& entry : j.value("outputs", json::array()))
+        {
+            OutputConfig config;
+            config.name = entry.value("name", "");
+            config.driver = entry.value("driver", "");
+            const std::string type = entry.value("output", "auto");
+            if (type == "nosound") config.outputType = FMOD_OUTPUTTYPE_NOSOUND;
+            else if (type == "wavwriter") config.outputType = FMOD_OUTPUTTYPE_WAVWRITER;
+
+            if (AddOutput(config) != InvalidOutput) opened++;
+        }
+
+        spdlog::info("{} extra output(s) opened from '{}'.", opened, filePath);
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Error loading outputs: {}", e.what());
+        return false;
+    }
+}
+
+std::vector<std::string> FModWrapper::GetDriverNames(FMOD::System* system)
+{
+    std::vector<std::string> names;
+    int count = 0;
+    if (!system || system->getNumDrivers(&count) != FMOD_OK) return names;
+
+    for (int i = 0; i < count; i++)
+    {
+        char name[256] = {};
+        if (system->getDriverInfo(i, name, sizeof(name), nullptr, nullptr, nullptr, nullptr) == FMOD_OK)
+        {
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+std::string FModWrapper::FormatGuid(const FMOD_GUID& guid)
+{
+    char text[40];
+    std::snprintf(text, sizeof(text), "{%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X}",
+                  guid.Data1, guid.Data2, guid.Data3,
+                  guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3],
+                  guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
+    return text;
+}
+
+int FModWrapper::FindDriver(FMOD::System* system, const std::string& driver)
+{
+    int count = 0;
+    if (system->getNumDrivers(&count) != FMOD_OK || count <= 0) return -1;
+    if (driver.empty()) return 0;
+
+    std::string wanted = driver;
+    std::transform(wanted.begin(), wanted.end(), wanted.begin(), [](unsigned char c) { return (char)std::toupper(c); });
+
+    for (int i = 0; i < count; i++)
+    {
+        char name[256] = {};
+        FMOD_GUID guid = {};
+        if (system->getDriverInfo(i, name, sizeof(name), &guid, nullptr, nullptr, nullptr) != FMOD_OK) continue;
+        if (driver == name || wanted == FormatGuid(guid)) return i;
+    }
+    return -1;
+}
+
 } // namespace TSM
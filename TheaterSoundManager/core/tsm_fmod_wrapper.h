@@ -5,11 +5,23 @@
 #include <fmod_errors.h>
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <spdlog/spdlog.h>
 
 namespace TSM 
 {
 
+// Index of an FMOD system; the main output is the one created by Initialize.
+using OutputId = uint32_t;
+
+struct OutputConfig
+{
+    std::string name;
+    std::string driver;         // driver name or GUID ({xxxxxxxx-...}), empty for the default one
+    FMOD_OUTPUTTYPE outputType = FMOD_OUTPUTTYPE_AUTODETECT;  // NOSOUND stands in for a device in tests
+    int maxChannels = 512;
+};
+
 class FModWrapper 
 {
 public:
@@ -19,20 +31,46 @@ public:
         return instance;
     }
 
+    static constexpr OutputId MainOutput = 0;
+    static constexpr OutputId InvalidOutput = 0xFFFFFFFFu;
+
     bool Initialize();
     void Update();
     void Shutdown();
 
-    FMOD::System* GetSystem() { return m_system; }
+    FMOD::System* GetSystem(OutputId output = MainOutput) const;
+
+    // Extra outputs each run their own FMOD system bound to one driver, so a second
+    // amplifier can be fed from the same process. Ids are never reused.
+    OutputId AddOutput(const OutputConfig& config);
+    bool RemoveOutput(OutputId output);
+    OutputId FindOutput(const std::string& name) const;
+    size_t GetOutputCount() const { return m_outputs.size(); }
+    std::string GetOutputName(OutputId output) const;
+    std::string GetOutputDriver(OutputId output) const;
+    // {"outputs": [{"name": "terrace", "driver": "...", "output": "nosound"}]}
+    bool LoadOutputs(const std::string& filePath);
+
+    static std::vector<std::string> GetDriverNames(FMOD::System* system);
+    static std::string FormatGuid(const FMOD_GUID& guid);
 
 private:
-    FModWrapper() : m_system(nullptr) {}
+    FModWrapper() = default;
     ~FModWrapper() {}
 
     FModWrapper(const FModWrapper&) = delete;
     FModWrapper& operator=(const FModWrapper&) = delete;
 
-    FMOD::System* m_system;
+    struct Output
+    {
+        std::string name;
+        std::string driver;
+        FMOD::System* system = nullptr;
+    };
+
+    static int FindDriver(FMOD::System* system, const std::string& driver);
+
+    std::vector<Output> m_outputs;      // MainOutput first
 };
 
 } // namespace TSM
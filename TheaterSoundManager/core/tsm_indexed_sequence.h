@@ -0,0 +1,332 @@
+// tsm_indexed_sequence.h
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <initializer_list>
+
+namespace TSM
+{
+
+// Sequence addressed by position, stored as an implicit treap: every node keeps the size
+// of its subtree, so index lookup, insert, erase and move are O(log n) instead of the
+// O(n) element shifts of std::vector.
+// Nodes are immutable and shared: an edit copies only the O(log n) nodes on its path, and
+// copying a sequence copies one pointer. A copy is therefore a cheap snapshot that stays
+// valid, and safe to read from another thread, while the original keeps changing.
+// The interface follows std::vector where it can; positions replace iterators for edits.
+template <typename T>
+class IndexedSequence
+{
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+        const_iterator(const IndexedSequence* sequence, size_t index) : m_sequence(sequence), m_index(index) {}
+
+        reference operator*() const { return (*m_sequence)[m_index]; }
+        pointer operator->() const { return &(*m_sequence)[m_index]; }
+        reference operator[](difference_type n) const { return (*m_sequence)[m_index + n]; }
+
+        const_iterator& operator++() { ++m_index; return *this; }
+        const_iterator operator++(int) { const_iterator copy = *this; ++m_index; return copy; }
+        const_iterator& operator--() { --m_index; return *this; }
+        const_iterator operator--(int) { const_iterator copy = *this; --m_index; return copy; }
+        const_iterator& operator+=(difference_type n) { m_index += n; return *this; }
+        const_iterator& operator-=(difference_type n) { m_index -= n; return *this; }
+        const_iterator operator+(difference_type n) const { return const_iterator(m_sequence, m_index + n); }
+        const_iterator operator-(difference_type n) const { return const_iterator(m_sequence, m_index - n); }
+        difference_type operator-(const const_iterator& other) const { return difference_type(m_index) - difference_type(other.m_index); }
+
+        bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+        bool operator<(const const_iterator& other) const { return m_index < other.m_index; }
+        bool operator>(const const_iterator& other) const { return m_index > other.m_index; }
+        bool operator<=(const const_iterator& other) const { return m_index <= other.m_index; }
+        bool operator>=(const const_iterator& other) const { return m_index >= other.m_index; }
+
+        size_t GetIndex() const { return m_index; }
+
+    private:
+        const IndexedSequence* m_sequence = nullptr;
+        size_t m_index = 0;
+    };
+    using iterator = const_iterator;
+
+    IndexedSequence() = default;
+    IndexedSequence(std::initializer_list<T> values) { insert(0, values.begin(), values.end()); }
+    template <typename InputIt>
+    IndexedSequence(InputIt first, InputIt last) { insert(0, first, last); }
+
+    size_t size() const { return SizeOf(m_root); }
+    bool empty() const { return !m_root; }
+    void clear() { m_root.reset(); }
+
+    // Elements are read-only: set() replaces one without touching shared copies.
+    const T& operator[](size_t index) const { return Find(index)->value; }
+    const T& front() const { return (*this)[0]; }
+    const T& back() const { return (*this)[size() - 1]; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    // True when both sequences are the same version, without comparing elements.
+    bool SharesStorageWith(const IndexedSequence& other) const { return m_root == other.m_root; }
+
+    // Heap bytes one element costs: its node, and the control block make_shared allocates
+    // with it (vtable pointer and two reference counts). The element's own heap is not counted.
+    static size_t NodeFootprint() { return sizeof(Node) + sizeof(void*) + 2 * sizeof(uint32_t); }
+
+    void set(size_t index, T value)
+    {
+        m_root = SetAt(m_root, index, std::move(value));
+    }
+
+    void push_back(T value)
+    {
+        m_root = Merge(m_root, MakeLeaf(std::move(value)));
+    }
+
+    void insert(size_t index, T value)
+    {
+        auto [left, right] = Split(m_root, index);
+        m_root = Merge(Merge(left, MakeLeaf(std::move(value))), right);
+    }
+
+    template <typename InputIt>
+    void insert(size_t index, InputIt first, InputIt last)
+    {
+        NodePtr inserted = Build(first, last);
+        auto [left, right] = Split(m_root, index);
+        m_root = Merge(Merge(left, inserted), right);
+    }
+
+    void erase(size_t index, size_t count = 1)
+    {
+        auto [left, rest] = Split(m_root, index);
+        auto [removed, right] = Split(rest, count);
+        m_root = Merge(left, right);
+    }
+
+    // Removes the element at `from`, then inserts it so that it ends up at `to`.
+    void move(size_t from, size_t to)
+    {
+        if (from == to) return;
+
+        auto [left, rest] = Split(m_root, from);
+        auto [node, right] = Split(rest, 1);
+        auto [before, after] = Split(Merge(left, right), to);
+        m_root = Merge(Merge(before, node), after);
+    }
+
+    // In-order traversal without the O(log n) lookup per element of the iterators.
+    template <typename Function>
+    void ForEach(Function&& function) const
+    {
+        std::vector<const Node*> stack;
+        const Node* node = m_root.get();
+        while (node || !stack.empty())
+        {
+            while (node)
+            {
+                stack.push_back(node);
+                node = node->left.get();
+            }
+            node = stack.back();
+            stack.pop_back();
+            function(node->value);
+            node = node->right.get();
+        }
+    }
+
+    std::vector<T> ToVector() const
+    {
+        std::vector<T> values;
+        values.reserve(size());
+        ForEach([&values](const T& value) { values.push_back(value); });
+        return values;
+    }
+
+    // Any vector whose elements compare with T, e.g. a list of strings against interned ids.
+    template <typename U>
+    friend bool operator==(const IndexedSequence& a, const std::vector<U>& b)
+    {
+        if (a.size() != b.size()) return false;
+
+        size_t index = 0;
+        bool equal = true;
+        a.ForEach([&](const T& value) { equal = equal && value == b[index++]; });
+        return equal;
+    }
+    friend bool operator==(const IndexedSequence& a, const IndexedSequence& b)
+    {
+        return a.SharesStorageWith(b) || (a.size() == b.size() && a == b.ToVector());
+    }
+
+private:
+    struct Node
+    {
+        T value;
+        NodePtr left;
+        NodePtr right;
+        uint32_t size = 1;
+        uint32_t priority = 0;
+    };
+
+    static uint32_t SizeOf(const NodePtr& node) { return node ? node->size : 0; }
+
+    static NodePtr Rebuild(const Node& node, NodePtr left, NodePtr right)
+    {
+        auto copy = std::make_shared<Node>();
+        copy->value = node.value;
+        copy->priority = node.priority;
+        copy->size = 1 + SizeOf(left) + SizeOf(right);
+        copy->left = std::move(left);
+        copy->right = std::move(right);
+        return copy;
+    }
+
+    uint32_t NextPriority()
+    {
+        // xorshift32 : suffisant pour équilibrer l'arbre
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        return m_seed;
+    }
+
+    NodePtr MakeLeaf(T&& value)
+    {
+        auto node = std::make_shared<Node>();
+        node->value = std::move(value);
+        node->priority = NextPriority();
+        return node;
+    }
+
+    // Linear-time construction along the right spine; nodes are not shared yet, so their
+    // links and sizes can still be written.
+    template <typename InputIt>
+    NodePtr Build(InputIt first, InputIt last)
+    {
+        std::vector<std::shared_ptr<Node>> spine;
+        for (; first != last; ++first)
+        {
+            auto node = std::make_shared<Node>();
+            node->value = *first;
+            node->priority = NextPriority();
+
+            std::shared_ptr<Node> popped;
+            while (!spine.empty() && spine.back()->priority < node->priority)
+            {
+                popped = spine.back();
+                spine.pop_back();
+            }
+            node->left = popped;
+            if (!spine.empty()) spine.back()->right = node;
+            spine.push_back(node);
+        }
+        if (spine.empty()) return nullptr;
+
+        // Spine nodes popped earlier keep stale sizes: recompute bottom-up.
+        std::shared_ptr<Node> root = spine.front();
+        std::vector<std::pair<Node*, bool>> stack{ { root.get(), false } };
+        while (!stack.empty())
+        {
+            auto [node, childrenDone] = stack.back();
+            stack.pop_back();
+            if (childrenDone)
+            {
+                node->size = 1 + SizeOf(node->left) + SizeOf(node->right);
+                continue;
+            }
+            stack.push_back({ node, true });
+            if (node->left)  stack.push_back({ const_cast<Node*>(node->left.get()), false });
+            if (node->right) stack.push_back({ const_cast<Node*>(node->right.get()), false });
+        }
+        return root;
+    }
+
+    const Node* Find(size_t index) const
+    {
+        const Node* node = m_root.get();
+        while (true)
+        {
+            const uint32_t leftSize = SizeOf(node->left);
+            if (index < leftSize)
+            {
+                node = node->left.get();
+            }
+            else if (index == leftSize)
+            {
+                return node;
+            }
+            else
+            {
+                index -= leftSize + 1;
+                node = node->right.get();
+            }
+        }
+    }
+
+    static NodePtr SetAt(const NodePtr& node, size_t index, T&& value)
+    {
+        const uint32_t leftSize = SizeOf(node->left);
+        if (index < leftSize) return Rebuild(*node, SetAt(node->left, index, std::move(value)), node->right);
+        if (index > leftSize) return Rebuild(*node, node->left, SetAt(node->right, index - leftSize - 1, std::move(value)));
+
+        auto copy = std::make_shared<Node>(*node);
+        copy->value = std::move(value);
+        return copy;
+    }
+
+    // First `count` elements go to the first tree, the rest to the second.
+    static std::pair<NodePtr, NodePtr> Split(const NodePtr& node, size_t count)
+    {
+        if (count == 0) return { nullptr, node };
+        if (count >= SizeOf(node)) return { node, nullptr };
+
+        const uint32_t leftSize = SizeOf(node->left);
+        if (count <= leftSize)
+        {
+            auto [left, right] = Split(node->left, count);
+            return { left, Rebuild(*node, right, node->right) };
+        }
+
+        auto [left, right] = Split(node->right, count - leftSize - 1);
+        return { Rebuild(*node, node->left, left), right };
+    }
+
+    static NodePtr Merge(const NodePtr& left, const NodePtr& right)
+    {
+        if (!left) return right;
+        if (!right) return left;
+
+        if (left->priority > right->priority)
+        {
+            return Rebuild(*left, left->left, Merge(left->right, right));
+        }
+        return Rebuild(*right, Merge(left, right->left), right->right);
+    }
+
+    NodePtr m_root;
+    uint32_t m_seed = 0x9E3779B9u;
+};
+
+} // namespace TSM
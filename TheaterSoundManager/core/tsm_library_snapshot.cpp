@@ -0,0 +1,428 @@
+// tsm_library_snapshot.cpp
+
+#include "tsm_library_snapshot.h"
+
+#include <spdlog/spdlog.h>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TSM
+{
+
+static_assert(std::endian::native == std::endian::little, "LibrarySnapshot is stored little-endian and mapped as is.");
+static_assert(sizeof(LibrarySnapshot::Header) == 72);
+static_assert(sizeof(LibrarySnapshot::TrackRecord) == 24);
+static_assert(sizeof(LibrarySnapshot::PlaylistRecord) == 32);
+
+static constexpr char SnapshotMagic[8] = { 'T', 'S', 'M', 'L', 'I', 'B', '\0', '\0' };
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// ---------------------------------------------------------------------------
+// MappedFile
+// ---------------------------------------------------------------------------
+
+bool MappedFile::Open(const std::string& filePath)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return false;
+
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = static_cast<size_t>(info.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (!m_data) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+    CloseHandle(static_cast<HANDLE>(m_fileHandle));
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+// ---------------------------------------------------------------------------
+// LibrarySnapshot
+// ---------------------------------------------------------------------------
+
+bool LibrarySnapshot::Open(const std::string& filePath)
+{
+    Close();
+
+    if (!m_file.Open(filePath))
+    {
+        return false;
+    }
+
+    if (m_file.GetSize() < sizeof(Header))
+    {
+        spdlog::error("Library snapshot '{}' is truncated.", filePath);
+        m_file.Close();
+        return false;
+    }
+
+    m_header = reinterpret_cast<const Header*>(m_file.GetData());
+    if (!Validate())
+    {
+        spdlog::error("Library snapshot '{}' is invalid or from an unsupported version.", filePath);
+        Close();
+        return false;
+    }
+
+    const uint8_t* base = m_file.GetData();
+    m_tracks = reinterpret_cast<const TrackRecord*>(base + m_header->tracksOffset);
+    m_playlists = reinterpret_cast<const PlaylistRecord*>(base + m_header->playlistsOffset);
+    m_entries = reinterpret_cast<const uint32_t*>(base + m_header->entriesOffset);
+    m_strings = reinterpret_cast<const char*>(base + m_header->stringsOffset);
+    return true;
+}
+
+void LibrarySnapshot::Close()
+{
+    m_header = nullptr;
+    m_tracks = nullptr;
+    m_playlists = nullptr;
+    m_entries = nullptr;
+    m_strings = nullptr;
+    m_file.Close();
+}
+
+bool LibrarySnapshot::Validate() const
+{
+    const Header& h = *m_header;
+    const uint64_t fileSize = m_file.GetSize();
+
+    if (std::memcmp(h.magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0) return false;
+    if (h.version == 0 || h.version > Version || h.headerSize != sizeof(Header)) return false;
+
+    auto sectionFits = [fileSize](uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t alignment) {
+        return offset % alignment == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+    };
+
+    if (!sectionFits(h.tracksOffset, h.trackCount, sizeof(TrackRecord), alignof(TrackRecord))) return false;
+    if (!sectionFits(h.playlistsOffset, h.playlistCount, sizeof(PlaylistRecord), alignof(PlaylistRecord))) return false;
+    if (!sectionFits(h.entriesOffset, h.entryCount, sizeof(uint32_t), alignof(uint32_t))) return false;
+    if (!sectionFits(h.stringsOffset, h.stringTableSize, 1, 1)) return false;
+
+    const uint8_t* base = m_file.GetData();
+    const auto* tracks = reinterpret_cast<const TrackRecord*>(base + h.tracksOffset);
+    const auto* playlists = reinterpret_cast<const PlaylistRecord*>(base + h.playlistsOffset);
+    const auto* entries = reinterpret_cast<const uint32_t*>(base + h.entriesOffset);
+
+    auto stringFits = [&h](uint32_t offset, uint32_t length) {
+        return uint64_t(offset) + length <= h.stringTableSize;
+    };
+
+    for (uint32_t i = 0; i < h.trackCount; i++)
+    {
+        if (!stringFits(tracks[i].idOffset, tracks[i].idLength)) return false;
+        if (!stringFits(tracks[i].pathOffset, tracks[i].pathLength)) return false;
+    }
+    for (uint32_t i = 0; i < h.playlistCount; i++)
+    {
+        if (!stringFits(playlists[i].nameOffset, playlists[i].nameLength)) return false;
+        if (uint64_t(playlists[i].firstEntry) + playlists[i].entryCount > h.entryCount) return false;
+    }
+    for (uint32_t i = 0; i < h.entryCount; i++)
+    {
+        if (entries[i] >= h.trackCount) return false;
+    }
+    return true;
+}
+
+std::string_view LibrarySnapshot::GetString(uint32_t offset, uint32_t length) const
+{
+    return std::string_view(m_strings + offset, length);
+}
+
+uint64_t LibrarySnapshot::GetSequence() const
+{
+    return m_header ? m_header->sequence : 0;
+}
+
+uint32_t LibrarySnapshot::GetTrackCount() const
+{
+    return m_header ? m_header->trackCount : 0;
+}
+
+std::string_view LibrarySnapshot::GetTrackId(uint32_t index) const
+{
+    return GetString(m_tracks[index].idOffset, m_tracks[index].idLength);
+}
+
+std::string_view LibrarySnapshot::GetTrackPath(uint32_t index) const
+{
+    return GetString(m_tracks[index].pathOffset, m_tracks[index].pathLength);
+}
+
+uint32_t LibrarySnapshot::GetTrackLengthMs(uint32_t index) const
+{
+    return m_tracks[index].lengthMs;
+}
+
+uint32_t LibrarySnapshot::GetPlaylistCount() const
+{
+    return m_header ? m_header->playlistCount : 0;
+}
+
+std::string_view LibrarySnapshot::GetPlaylistName(uint32_t index) const
+{
+    return GetString(m_playlists[index].nameOffset, m_playlists[index].nameLength);
+}
+
+PlaylistOptions LibrarySnapshot::GetPlaylistOptions(uint32_t index) const
+{
+    const PlaylistRecord& record = m_playlists[index];
+    PlaylistOptions options;
+    options.randomOrder = (record.flags & RandomOrder) != 0;
+    options.randomSegment = (record.flags & RandomSegment) != 0;
+    options.loopPlaylist = (record.flags & LoopPlaylist) != 0;
+    options.gapless = (record.flags & Gapless) != 0;
+    options.segmentDuration = record.segmentDuration;
+    options.crossfadeDuration = record.crossfadeDuration;
+    if (m_header->version >= 2)
+    {
+        const uint32_t curve = (record.flags & CrossfadeCurveMask) >> CrossfadeCurveShift;
+        if (curve <= static_cast<uint32_t>(CrossfadeCurve::Custom))
+        {
+            options.crossfadeCurve = static_cast<CrossfadeCurve>(curve);
+        }
+        options.crossfadeShape = record.crossfadeShape;
+    }
+    return options;
+}
+
+std::span<const uint32_t> LibrarySnapshot::GetPlaylistTracks(uint32_t index) const
+{
+    const PlaylistRecord& record = m_playlists[index];
+    return std::span<const uint32_t>(m_entries + record.firstEntry, record.entryCount);
+}
+
+// ---------------------------------------------------------------------------
+// LibrarySnapshotWriter
+// ---------------------------------------------------------------------------
+
+uint32_t LibrarySnapshotWriter::AddString(std::string_view value)
+{
+    const uint32_t offset = static_cast<uint32_t>(m_strings.size());
+    m_strings.append(value);
+    return offset;
+}
+
+uint32_t LibrarySnapshotWriter::AddTrack(std::string_view trackId, std::string_view filePath, uint32_t lengthMs)
+{
+    auto it = m_trackIndex.find(trackId);
+    if (it != m_trackIndex.end())
+    {
+        LibrarySnapshot::TrackRecord& record = m_tracks[it->second];
+        if (record.pathLength == 0 && !filePath.empty())
+        {
+            record.pathOffset = AddString(filePath);
+            record.pathLength = static_cast<uint32_t>(filePath.size());
+        }
+        if (record.lengthMs == 0)
+        {
+            record.lengthMs = lengthMs;
+        }
+        return it->second;
+    }
+
+    LibrarySnapshot::TrackRecord record{};
+    record.idOffset = AddString(trackId);
+    record.idLength = static_cast<uint32_t>(trackId.size());
+    record.pathOffset = AddString(filePath);
+    record.pathLength = static_cast<uint32_t>(filePath.size());
+    record.lengthMs = lengthMs;
+
+    const uint32_t index = static_cast<uint32_t>(m_tracks.size());
+    m_tracks.push_back(record);
+    m_trackIndex.emplace(std::string(trackId), index);
+    return index;
+}
+
+void LibrarySnapshotWriter::AddPlaylist(std::string_view name, const PlaylistOptions& options, const std::vector<TrackId>& trackIds)
+{
+    LibrarySnapshot::PlaylistRecord record{};
+    record.nameOffset = AddString(name);
+    record.nameLength = static_cast<uint32_t>(name.size());
+    record.firstEntry = static_cast<uint32_t>(m_entries.size());
+    record.entryCount = static_cast<uint32_t>(trackIds.size());
+    record.segmentDuration = options.segmentDuration;
+    record.crossfadeDuration = options.crossfadeDuration;
+    record.crossfadeShape = options.crossfadeShape;
+    record.flags = (options.randomOrder ? LibrarySnapshot::RandomOrder : 0u)
+                 | (options.randomSegment ? LibrarySnapshot::RandomSegment : 0u)
+                 | (options.loopPlaylist ? LibrarySnapshot::LoopPlaylist : 0u)
+                 | (options.gapless ? LibrarySnapshot::Gapless : 0u)
+                 | (static_cast<uint32_t>(options.crossfadeCurve) << LibrarySnapshot::CrossfadeCurveShift);
+
+    for (const auto& trackId : trackIds)
+    {
+        m_entries.push_back(AddTrack(trackId.str(), {}, 0));
+    }
+    m_playlists.push_back(record);
+}
+
+static bool SyncFile(std::FILE* file)
+{
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+static void SyncDirectory(const std::filesystem::path& directory)
+{
+#ifndef _WIN32
+    // Makes the rename itself durable; NTFS journals metadata on its own.
+    int fd = open(directory.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+#else
+    (void)directory;
+#endif
+}
+
+bool LibrarySnapshotWriter::WriteToFile(const std::string& filePath) const
+{
+    LibrarySnapshot::Header header{};
+    std::memcpy(header.magic, SnapshotMagic, sizeof(SnapshotMagic));
+    header.version = LibrarySnapshot::Version;
+    header.headerSize = sizeof(LibrarySnapshot::Header);
+    header.sequence = m_sequence;
+    header.trackCount = static_cast<uint32_t>(m_tracks.size());
+    header.playlistCount = static_cast<uint32_t>(m_playlists.size());
+    header.entryCount = static_cast<uint32_t>(m_entries.size());
+    header.stringTableSize = static_cast<uint32_t>(m_strings.size());
+    header.tracksOffset = AlignUp(sizeof(header), 8);
+    header.playlistsOffset = AlignUp(header.tracksOffset + m_tracks.size() * sizeof(LibrarySnapshot::TrackRecord), 8);
+    header.entriesOffset = AlignUp(header.playlistsOffset + m_playlists.size() * sizeof(LibrarySnapshot::PlaylistRecord), 8);
+    header.stringsOffset = AlignUp(header.entriesOffset + m_entries.size() * sizeof(uint32_t), 8);
+
+    const std::string tempPath = filePath + ".tmp";
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file)
+    {
+        spdlog::error("Cannot write library snapshot '{}'.", tempPath);
+        return false;
+    }
+
+    uint64_t written = 0;
+    bool ok = true;
+    auto writeAt = [&](uint64_t offset, const void* data, size_t size) {
+        static const char padding[8] = {};
+        if (offset > written)
+        {
+            ok = ok && std::fwrite(padding, 1, size_t(offset - written), file) == size_t(offset - written);
+            written = offset;
+        }
+        if (size > 0)
+        {
+            ok = ok && std::fwrite(data, 1, size, file) == size;
+            written += size;
+        }
+    };
+
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.tracksOffset, m_tracks.data(), m_tracks.size() * sizeof(LibrarySnapshot::TrackRecord));
+    writeAt(header.playlistsOffset, m_playlists.data(), m_playlists.size() * sizeof(LibrarySnapshot::PlaylistRecord));
+    writeAt(header.entriesOffset, m_entries.data(), m_entries.size() * sizeof(uint32_t));
+    writeAt(header.stringsOffset, m_strings.data(), m_strings.size());
+
+    ok = SyncFile(file) && ok;
+    std::fclose(file);
+
+    if (!ok)
+    {
+        spdlog::error("Failed to write library snapshot '{}'.", tempPath);
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, filePath, ec);
+    if (ec)
+    {
+        spdlog::error("Failed to replace library snapshot '{}': {}", filePath, ec.message());
+        return false;
+    }
+    SyncDirectory(std::filesystem::path(filePath).parent_path());
+
+    return true;
+}
+
+} // namespace TSM
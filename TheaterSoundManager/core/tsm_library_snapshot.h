@@ -0,0 +1,161 @@
+// tsm_library_snapshot.h
+#pragma once
+
+#include "tsm_playlist_manager.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+namespace TSM
+{
+
+// Read-only view of a whole file mapped in memory.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& filePath);
+    void Close();
+    bool IsOpen() const { return m_data != nullptr; }
+
+    const uint8_t* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_fileHandle = nullptr;
+    void* m_mappingHandle = nullptr;
+#endif
+};
+
+// Binary playlist/library snapshot, version 2 (little-endian):
+//   Header | TrackRecord[trackCount] | PlaylistRecord[playlistCount] | uint32 entries[entryCount] | strings
+// Every string lives once in the string table and is referenced by (offset, length);
+// playlist entries are indices into the track records, which carry the cached duration.
+// The file is used in place: nothing is parsed, only bounds-checked once by Open().
+class LibrarySnapshot
+{
+public:
+    static constexpr uint32_t Version = 2;   // 2 : crossfade curve and shape; version 1 files still open
+
+    LibrarySnapshot() = default;
+    LibrarySnapshot(const LibrarySnapshot&) = delete;
+    LibrarySnapshot& operator=(const LibrarySnapshot&) = delete;
+
+    bool Open(const std::string& filePath);
+    void Close();
+    bool IsOpen() const { return m_header != nullptr; }
+
+    uint64_t GetSequence() const;
+
+    uint32_t GetTrackCount() const;
+    std::string_view GetTrackId(uint32_t index) const;
+    std::string_view GetTrackPath(uint32_t index) const;
+    uint32_t GetTrackLengthMs(uint32_t index) const;
+
+    uint32_t GetPlaylistCount() const;
+    std::string_view GetPlaylistName(uint32_t index) const;
+    PlaylistOptions GetPlaylistOptions(uint32_t index) const;
+    std::span<const uint32_t> GetPlaylistTracks(uint32_t index) const;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint64_t sequence;          // journal sequence folded into this snapshot
+        uint32_t trackCount;
+        uint32_t playlistCount;
+        uint32_t entryCount;
+        uint32_t stringTableSize;
+        uint64_t tracksOffset;
+        uint64_t playlistsOffset;
+        uint64_t entriesOffset;
+        uint64_t stringsOffset;
+    };
+
+    struct TrackRecord
+    {
+        uint32_t idOffset;
+        uint32_t idLength;
+        uint32_t pathOffset;
+        uint32_t pathLength;
+        uint32_t lengthMs;          // 0 when unknown
+        uint32_t reserved;
+    };
+
+    enum PlaylistFlags : uint32_t
+    {
+        RandomOrder   = 1u << 0,
+        RandomSegment = 1u << 1,
+        LoopPlaylist  = 1u << 2,
+        Gapless       = 1u << 3,
+        CrossfadeCurveShift = 8,        // bits 8-15 : CrossfadeCurve
+        CrossfadeCurveMask  = 0xFFu << CrossfadeCurveShift
+    };
+
+    struct PlaylistRecord
+    {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t firstEntry;
+        uint32_t entryCount;
+        float segmentDuration;
+        float crossfadeDuration;
+        uint32_t flags;
+        float crossfadeShape;
+    };
+
+private:
+    bool Validate() const;
+    std::string_view GetString(uint32_t offset, uint32_t length) const;
+
+    MappedFile m_file;
+    const Header* m_header = nullptr;
+    const TrackRecord* m_tracks = nullptr;
+    const PlaylistRecord* m_playlists = nullptr;
+    const uint32_t* m_entries = nullptr;
+    const char* m_strings = nullptr;
+};
+
+// Builds a LibrarySnapshot file. Tracks are deduplicated by id, so each id and path is stored once.
+class LibrarySnapshotWriter
+{
+public:
+    uint32_t AddTrack(std::string_view trackId, std::string_view filePath, uint32_t lengthMs);
+    void AddPlaylist(std::string_view name, const PlaylistOptions& options, const std::vector<TrackId>& trackIds);
+    void SetSequence(uint64_t sequence) { m_sequence = sequence; }
+
+    // Written next to the target then renamed over it, so readers never see a partial file.
+    bool WriteToFile(const std::string& filePath) const;
+
+private:
+    uint32_t AddString(std::string_view value);
+
+    struct StringHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view value) const { return std::hash<std::string_view>{}(value); }
+    };
+
+    std::vector<LibrarySnapshot::TrackRecord> m_tracks;
+    std::vector<LibrarySnapshot::PlaylistRecord> m_playlists;
+    std::vector<uint32_t> m_entries;
+    std::string m_strings;
+    std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> m_trackIndex;
+    uint64_t m_sequence = 0;
+};
+
+} // namespace TSM
@@ -0,0 +1,390 @@
+// tsm_loop_renderer.cpp
+
+#include "tsm_loop_renderer.h"
+#include "tsm_crossfade_curve.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace TSM
+{
+
+namespace
+{
+    constexpr char LoopCacheMagic[8] = { 'T', 'S', 'M', 'L', 'O', 'O', 'P', '\0' };
+    constexpr uint32_t LoopCacheVersion = 1;
+
+    struct LoopCacheHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t channels;
+        uint32_t sampleRate;
+        uint32_t frames;
+        uint32_t sourceStart;
+        uint32_t sourceEnd;
+        float correlation;
+        uint32_t reserved;
+    };
+
+    // Analysis rate of the coarse search; the match is then refined on every sample.
+    constexpr size_t CoarseRate = 4000;
+
+    int BytesPerSample(FMOD_SOUND_FORMAT format)
+    {
+        switch (format)
+        {
+        case FMOD_SOUND_FORMAT_PCM8: return 1;
+        case FMOD_SOUND_FORMAT_PCM16: return 2;
+        case FMOD_SOUND_FORMAT_PCM24: return 3;
+        case FMOD_SOUND_FORMAT_PCM32:
+        case FMOD_SOUND_FORMAT_PCMFLOAT: return 4;
+        default: return 0;
+        }
+    }
+
+    float ReadSample(const char* p, FMOD_SOUND_FORMAT format)
+    {
+        switch (format)
+        {
+        case FMOD_SOUND_FORMAT_PCM8:
+            return static_cast<int8_t>(p[0]) / 128.0f;
+        case FMOD_SOUND_FORMAT_PCM16:
+        {
+            int16_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value / 32768.0f;
+        }
+        case FMOD_SOUND_FORMAT_PCM24:
+        {
+            const int32_t value = static_cast<uint8_t>(p[0]) | (static_cast<uint8_t>(p[1]) << 8) | (static_cast<int8_t>(p[2]) * 65536);
+            return value / 8388608.0f;
+        }
+        case FMOD_SOUND_FORMAT_PCM32:
+        {
+            int32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value / 2147483648.0f;
+        }
+        case FMOD_SOUND_FORMAT_PCMFLOAT:
+        {
+            float value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+        default:
+            return 0.0f;
+        }
+    }
+
+    int16_t ToPcm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    std::vector<float> MixDown(const PcmBuffer& source, int bytesPerSample, size_t first, size_t count)
+    {
+        std::vector<float> mono(count);
+        const size_t frameBytes = static_cast<size_t>(bytesPerSample) * source.channels;
+        for (size_t i = 0; i < count; i++)
+        {
+            const char* frame = source.data.data() + (first + i) * frameBytes;
+            float sum = 0.0f;
+            for (int c = 0; c < source.channels; c++)
+            {
+                sum += ReadSample(frame + c * bytesPerSample, source.format);
+            }
+            mono[i] = sum / source.channels;
+        }
+        return mono;
+    }
+
+    std::vector<float> Decimate(const std::vector<float>& samples, size_t factor)
+    {
+        std::vector<float> result(samples.size() / factor);
+        for (size_t i = 0; i < result.size(); i++)
+        {
+            float sum = 0.0f;
+            for (size_t j = 0; j < factor; j++) sum += samples[i * factor + j];
+            result[i] = sum / factor;
+        }
+        return result;
+    }
+
+    // Normalised cross-correlation: 1 for the same shape whatever the level, 0 for silence.
+    float Correlate(const float* a, const float* b, size_t count)
+    {
+        double dot = 0.0, energyA = 0.0, energyB = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            dot += double(a[i]) * b[i];
+            energyA += double(a[i]) * a[i];
+            energyB += double(b[i]) * b[i];
+        }
+        if (energyA < 1e-12 || energyB < 1e-12) return 0.0f;
+        return static_cast<float>(dot / std::sqrt(energyA * energyB));
+    }
+
+    uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+}
+
+bool LoopRenderer::Render(FMOD::System* system, const std::string& filePath, unsigned int leadInPcm, unsigned int tailPcm,
+                          const LoopRenderSettings& settings, RenderedLoop& loop)
+{
+    const std::string cachePath = GetCachePath(filePath, leadInPcm, tailPcm, settings);
+    if (!cachePath.empty() && ReadCache(cachePath, loop))
+    {
+        loop.fromCache = true;
+        spdlog::info("Seamless loop of '{}' read from '{}'.", filePath, cachePath);
+        return true;
+    }
+
+    std::shared_ptr<const PcmBuffer> source = PcmCache::GetInstance().Decode(system, filePath);
+    if (!source || !RenderBuffer(*source, leadInPcm, tailPcm, settings, loop))
+    {
+        spdlog::error("Cannot render a seamless loop of '{}'.", filePath);
+        return false;
+    }
+    spdlog::info("Seamless loop of '{}': frames {} to {}, correlation {:.2f}.", filePath, loop.sourceStart, loop.sourceEnd, loop.correlation);
+
+    if (!cachePath.empty())
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(m_cacheDirectory, ec);
+        WriteCache(cachePath, loop);
+    }
+    return true;
+}
+
+bool LoopRenderer::RenderBuffer(const PcmBuffer& source, unsigned int leadInPcm, unsigned int tailPcm,
+                                const LoopRenderSettings& settings, RenderedLoop& loop)
+{
+    const int bytesPerSample = BytesPerSample(source.format);
+    if (bytesPerSample == 0 || source.channels <= 0 || source.sampleRate <= 0)
+    {
+        spdlog::error("Loop rendering: unsupported sample format.");
+        return false;
+    }
+
+    const size_t channels = static_cast<size_t>(source.channels);
+    const size_t frameBytes = bytesPerSample * channels;
+    const size_t frames = source.data.size() / frameBytes;
+    const size_t rate = static_cast<size_t>(source.sampleRate);
+    const size_t crossfade = std::max<size_t>(1, static_cast<size_t>(settings.crossfadeSec * rate));
+    const size_t window = std::max<size_t>(1, static_cast<size_t>(settings.matchSec * rate));
+    const size_t search = static_cast<size_t>(std::max(settings.searchSec, 0.0f) * rate);
+
+    // La fin de boucle doit laisser derrière elle de quoi fondre et comparer
+    const size_t start = leadInPcm;
+    const size_t end = frames > tailPcm ? frames - tailPcm : 0;
+    const size_t margin = std::max(crossfade, window);
+    if (end < start + crossfade + window + margin + 1)
+    {
+        spdlog::warn("Loop rendering: {} frames are too short for a {} frame crossfade.", end - std::min(start, end), crossfade);
+        return false;
+    }
+    const size_t latest = end - margin;
+    const size_t earliest = std::max(start + crossfade + window, latest > search ? latest - search : 0);
+
+    const std::vector<float> head = MixDown(source, bytesPerSample, start, window);
+    const std::vector<float> region = MixDown(source, bytesPerSample, earliest, latest - earliest + window);
+    float correlation = 0.0f;
+    const size_t loopEnd = earliest + FindBestMatch(head, region, std::max<size_t>(1, rate / CoarseRate), correlation);
+
+    // Deux passages semblables s'additionnent en amplitude, deux passages différents en puissance
+    const CrossfadeTable table = GetCrossfadeTable(correlation >= 0.5f ? CrossfadeCurve::Linear : CrossfadeCurve::EqualPower);
+
+    auto pcm = std::make_shared<PcmBuffer>();
+    pcm->format = FMOD_SOUND_FORMAT_PCM16;
+    pcm->channels = source.channels;
+    pcm->sampleRate = source.sampleRate;
+
+    const size_t length = loopEnd - start;
+    pcm->data.resize(length * channels * sizeof(int16_t));
+    auto* out = reinterpret_cast<int16_t*>(pcm->data.data());
+    for (size_t i = 0; i < length; i++)
+    {
+        const char* frame = source.data.data() + (start + i) * frameBytes;
+        if (i < crossfade)
+        {
+            // Au début, c'est la suite du fichier après la fin de boucle qui joue
+            const CrossfadeGains gains = table(static_cast<float>(i) / crossfade);
+            const char* continuation = source.data.data() + (loopEnd + i) * frameBytes;
+            for (size_t c = 0; c < channels; c++)
+            {
+                const float value = gains.in * ReadSample(frame + c * bytesPerSample, source.format)
+                                  + gains.out * ReadSample(continuation + c * bytesPerSample, source.format);
+                out[i * channels + c] = ToPcm16(value);
+            }
+        }
+        else
+        {
+            for (size_t c = 0; c < channels; c++)
+            {
+                out[i * channels + c] = ToPcm16(ReadSample(frame + c * bytesPerSample, source.format));
+            }
+        }
+    }
+
+    loop.pcm = pcm;
+    loop.sourceStart = static_cast<unsigned int>(start);
+    loop.sourceEnd = static_cast<unsigned int>(loopEnd);
+    loop.correlation = correlation;
+    loop.fromCache = false;
+    return true;
+}
+
+size_t LoopRenderer::FindBestMatch(const std::vector<float>& head, const std::vector<float>& region, size_t decimation,
+                                   float& correlation)
+{
+    correlation = 0.0f;
+    const size_t window = head.size();
+    if (window == 0 || region.size() < window) return 0;
+    const size_t last = region.size() - window;
+
+    // D'abord sur des moyennes de `decimation` échantillons, puis à l'échantillon près autour
+    size_t coarseBest = 0;
+    size_t from = 0;
+    size_t to = last;
+    if (decimation > 1 && window >= decimation)
+    {
+        const std::vector<float> coarseHead = Decimate(head, decimation);
+        const std::vector<float> coarseRegion = Decimate(region, decimation);
+        float best = -2.0f;
+        for (size_t k = 0; k + coarseHead.size() <= coarseRegion.size(); k++)
+        {
+            const float c = Correlate(coarseHead.data(), coarseRegion.data() + k, coarseHead.size());
+            if (c > best)
+            {
+                best = c;
+                coarseBest = k * decimation;
+            }
+        }
+        from = coarseBest > decimation ? coarseBest - decimation : 0;
+        to = std::min(last, coarseBest + decimation);
+    }
+
+    size_t bestOffset = from;
+    float best = -2.0f;
+    for (size_t k = from; k <= to; k++)
+    {
+        const float c = Correlate(head.data(), region.data() + k, window);
+        if (c > best)
+        {
+            best = c;
+            bestOffset = k;
+        }
+    }
+    correlation = best;
+    return bestOffset;
+}
+
+std::string LoopRenderer::GetCachePath(const std::string& filePath, unsigned int leadInPcm, unsigned int tailPcm,
+                                       const LoopRenderSettings& settings) const
+{
+    std::error_code ec;
+    const uint64_t fileSize = std::filesystem::file_size(filePath, ec);
+    if (ec) return {};
+    const auto writeTime = std::filesystem::last_write_time(filePath, ec).time_since_epoch().count();
+    if (ec) return {};
+
+    // Le fichier change, ou les réglages : nouveau rendu
+    uint64_t key = Fnv1a(filePath.data(), filePath.size());
+    key = Fnv1a(&fileSize, sizeof(fileSize), key);
+    key = Fnv1a(&writeTime, sizeof(writeTime), key);
+    key = Fnv1a(&leadInPcm, sizeof(leadInPcm), key);
+    key = Fnv1a(&tailPcm, sizeof(tailPcm), key);
+    key = Fnv1a(&settings.crossfadeSec, sizeof(float), key);
+    key = Fnv1a(&settings.searchSec, sizeof(float), key);
+    key = Fnv1a(&settings.matchSec, sizeof(float), key);
+
+    const std::string name = fmt::format("{}-{:016x}.loop", std::filesystem::path(filePath).stem().string(), key);
+    return (std::filesystem::path(m_cacheDirectory) / name).string();
+}
+
+bool LoopRenderer::ReadCache(const std::string& cachePath, RenderedLoop& loop)
+{
+    std::ifstream file(cachePath, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    LoopCacheHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, LoopCacheMagic, sizeof(LoopCacheMagic)) != 0 ||
+        header.version != LoopCacheVersion || header.channels == 0 || header.sampleRate == 0)
+    {
+        spdlog::warn("Loop cache '{}' ignored: bad header.", cachePath);
+        return false;
+    }
+
+    auto pcm = std::make_shared<PcmBuffer>();
+    pcm->format = FMOD_SOUND_FORMAT_PCM16;
+    pcm->channels = static_cast<int>(header.channels);
+    pcm->sampleRate = static_cast<int>(header.sampleRate);
+    pcm->data.resize(static_cast<size_t>(header.frames) * header.channels * sizeof(int16_t));
+    if (!file.read(pcm->data.data(), pcm->data.size()))
+    {
+        spdlog::warn("Loop cache '{}' ignored: truncated.", cachePath);
+        return false;
+    }
+
+    loop.pcm = pcm;
+    loop.sourceStart = header.sourceStart;
+    loop.sourceEnd = header.sourceEnd;
+    loop.correlation = header.correlation;
+    return true;
+}
+
+bool LoopRenderer::WriteCache(const std::string& cachePath, const RenderedLoop& loop)
+{
+    LoopCacheHeader header{};
+    std::memcpy(header.magic, LoopCacheMagic, sizeof(LoopCacheMagic));
+    header.version = LoopCacheVersion;
+    header.channels = static_cast<uint32_t>(loop.pcm->channels);
+    header.sampleRate = static_cast<uint32_t>(loop.pcm->sampleRate);
+    header.frames = static_cast<uint32_t>(loop.pcm->data.size() / (header.channels * sizeof(int16_t)));
+    header.sourceStart = loop.sourceStart;
+    header.sourceEnd = loop.sourceEnd;
+    header.correlation = loop.correlation;
+
+    // Écrit à côté puis renommé : un rendu interrompu ne laisse pas de fichier tronqué
+    const std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            spdlog::error("Cannot write loop cache '{}'.", tempPath);
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(loop.pcm->data.data(), loop.pcm->data.size());
+        if (!file.good())
+        {
+            spdlog::error("Cannot write loop cache '{}'.", tempPath);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec)
+    {
+        spdlog::error("Cannot replace loop cache '{}': {}", cachePath, ec.message());
+        return false;
+    }
+    return true;
+}
+
+} // namespace TSM
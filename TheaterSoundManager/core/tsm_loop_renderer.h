@@ -0,0 +1,74 @@
+// tsm_loop_renderer.h
+#pragma once
+
+#include <fmod.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "tsm_pcm_cache.h"
+
+namespace TSM
+{
+
+struct LoopRenderSettings
+{
+    float crossfadeSec = 2.0f;      // head of the loop blended with the audio that follows its end
+    float searchSec = 8.0f;         // how far before the end of the file the loop may close
+    float matchSec = 0.5f;          // length of the windows compared at both ends
+};
+
+struct RenderedLoop
+{
+    std::shared_ptr<const PcmBuffer> pcm;   // PCM16, exactly one turn: the last frame leads into the first
+    unsigned int sourceStart = 0;           // frames of the source the loop runs between
+    unsigned int sourceEnd = 0;
+    float correlation = 0.0f;               // of the two windows joined by the crossfade, 1 = identical
+    bool fromCache = false;
+};
+
+// Turns an ambience bed into a buffer that loops without a seam. The loop closes where the
+// audio best matches its own start (normalised cross-correlation, coarse then per sample),
+// and its first crossfadeSec are blended with what follows that point in the file, so the
+// wrap plays the file's own continuation. The encoder padding is left out of the loop.
+// Rendering decodes the whole file; the result is kept in the cache directory, keyed by the
+// file's size, date and the settings.
+class LoopRenderer
+{
+public:
+    static LoopRenderer& GetInstance()
+    {
+        static LoopRenderer instance;
+        return instance;
+    }
+
+    void SetCacheDirectory(const std::string& directory) { m_cacheDirectory = directory; }
+    const std::string& GetCacheDirectory() const { return m_cacheDirectory; }
+
+    // Reads the cached loop, or decodes the file with `system` and renders it.
+    bool Render(FMOD::System* system, const std::string& filePath, unsigned int leadInPcm, unsigned int tailPcm,
+                const LoopRenderSettings& settings, RenderedLoop& loop);
+    static bool RenderBuffer(const PcmBuffer& source, unsigned int leadInPcm, unsigned int tailPcm,
+                             const LoopRenderSettings& settings, RenderedLoop& loop);
+
+    // Offset in `region` where a window of head.size() samples best matches `head`.
+    static size_t FindBestMatch(const std::vector<float>& head, const std::vector<float>& region, size_t decimation,
+                                float& correlation);
+
+    std::string GetCachePath(const std::string& filePath, unsigned int leadInPcm, unsigned int tailPcm,
+                             const LoopRenderSettings& settings) const;
+
+private:
+    LoopRenderer() = default;
+    LoopRenderer(const LoopRenderer&) = delete;
+    LoopRenderer& operator=(const LoopRenderer&) = delete;
+
+    static bool ReadCache(const std::string& cachePath, RenderedLoop& loop);
+    static bool WriteCache(const std::string& cachePath, const RenderedLoop& loop);
+
+    std::string m_cacheDirectory = "data/loops";
+};
+
+} // namespace TSM
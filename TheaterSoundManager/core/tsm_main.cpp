@@ -7,6 +7,11 @@
 #include "tsm_audio_manager.h"
 #include "tsm_announcement_manager.h"
 #include "tsm_playlist_manager.h"
+#include "tsm_playlist_journal.h"
+#include "tsm_playlist_import.h"
+#include "tsm_playback_checkpoint.h"
+#include "tsm_show_timeline.h"
+#include "tsm_cue_stack.h"
 #include "tsm_ui_manager.h"
 #include "tsm_logger.h"
 
@@ -32,6 +37,18 @@ int main()
         return -1;
     }
 
+    // Une zone par sortie supplémentaire (ampli de la terrasse...), du même nom
+    if (TSM::FModWrapper::GetInstance().LoadOutputs("data/outputs.json"))
+    {
+        auto& fmod = TSM::FModWrapper::GetInstance();
+        for (TSM::OutputId output = 1; output < fmod.GetOutputCount(); output++)
+        {
+            if (!fmod.GetSystem(output)) continue;
+            TSM::ZoneId zone = TSM::PlaylistManager::GetInstance().CreateZone(fmod.GetOutputName(output));
+            TSM::PlaylistManager::GetInstance().SetZoneOutput(zone, output);
+        }
+    }
+
     if (!TSM::UIManager::GetInstance().Init(1920, 1080))
     {
         spdlog::error("Failed to initialize GUI.");
@@ -41,9 +58,6 @@ int main()
 
     StartBluetoothServer();
 
-    const std::string preShowPlaylist = "playlist_PreShow";
-    TSM::PlaylistManager::GetInstance().CreatePlaylist(preShowPlaylist);
-
     TSM::AudioManager::GetInstance().LoadSound("temps_amour", "assets/musics/PreShowMariage/01_Bon_Entendeur_Le_temps_de_l_amour.mp3", true);
     TSM::AudioManager::GetInstance().LoadSound("fio_maravilha", "assets/musics/PreShowMariage/Nicoletta_FioMaravilha.mp3", true);
     TSM::AudioManager::GetInstance().LoadSound("helwa_ya_baladi", "assets/musics/PreShowMariage/DalidaHelwaYaBaladi_LinaSleibiCover.mp3", true);
@@ -56,21 +70,6 @@ int main()
     TSM::AudioManager::GetInstance().LoadSound("amour", "assets/musics/PreShowMariage/Mouloudji_Lamour.mp3", true);
     TSM::AudioManager::GetInstance().LoadSound("foule", "assets/musics/PreShowMariage/EdithPiaf_LaFoule.mp3", true);
 
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(preShowPlaylist, "temps_amour");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(preShowPlaylist, "fio_maravilha");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(preShowPlaylist, "helwa_ya_baladi");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(preShowPlaylist, "laisse_moi_taimer");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(preShowPlaylist, "yeux_emilie");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(preShowPlaylist, "bonnie_clyde");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(preShowPlaylist, "perche_ti_amo");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(preShowPlaylist, "emmenez_moi");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(preShowPlaylist, "boheme");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(preShowPlaylist, "amour");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(preShowPlaylist, "foule");
-
-    const std::string postShowPlaylist = "playlist_PostShow";
-    TSM::PlaylistManager::GetInstance().CreatePlaylist(postShowPlaylist);
-
     TSM::AudioManager::GetInstance().LoadSound("bon_voyage", "assets/musics/PostShow/BonVoyage.mp3", true);
     TSM::AudioManager::GetInstance().LoadSound("buddha_bar", "assets/musics/PostShow/BuddhaBarIII.mp3", true);
     TSM::AudioManager::GetInstance().LoadSound("jazz_port_orleans", "assets/musics/PostShow/JazzPortOrleans.mp3", true);
@@ -89,23 +88,59 @@ int main()
     TSM::AudioManager::GetInstance().LoadSound("tiana_palace", "assets/musics/PostShow/TianaPalace.mp3", true);
     TSM::AudioManager::GetInstance().LoadSound("town_center", "assets/musics/PostShow/TownCenter.mp3", true);
 
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "bon_voyage");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "buddha_bar");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "jazz_port_orleans");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "coffee_portofino");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "country_bear");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "fantasy_spring");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "forest_caffee");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "grand_avenue");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "hth");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "jazz_01");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "mmrr_exit_music");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "mmrr_lobby");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "bella_note");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "secret_love");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "agrabah_cafe_restaurant");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "tiana_palace");
-    TSM::PlaylistManager::GetInstance().AddToPlaylist(postShowPlaylist, "town_center");
+    // Les playlists modifiées depuis l'UI sont restaurées depuis le journal
+    auto& playlistJournal = TSM::PlaylistJournal::GetInstance();
+    if (playlistJournal.Open("data") && playlistJournal.HasRecoveredState())
+    {
+        playlistJournal.ApplyRecoveredState();
+    }
+    else
+    {
+        const std::string preShowPlaylist = "playlist_PreShow";
+        TSM::PlaylistManager::GetInstance().CreatePlaylist(preShowPlaylist);
+        TSM::PlaylistManager::GetInstance().AddTracksToPlaylist(preShowPlaylist, {
+            "temps_amour",
+            "fio_maravilha",
+            "helwa_ya_baladi",
+            "laisse_moi_taimer",
+            "yeux_emilie",
+            "bonnie_clyde",
+            "perche_ti_amo",
+            "emmenez_moi",
+            "boheme",
+            "amour",
+            "foule"
+        });
+
+        const std::string postShowPlaylist = "playlist_PostShow";
+        TSM::PlaylistManager::GetInstance().CreatePlaylist(postShowPlaylist);
+        TSM::PlaylistManager::GetInstance().AddTracksToPlaylist(postShowPlaylist, {
+            "bon_voyage",
+            "buddha_bar",
+            "jazz_port_orleans",
+            "coffee_portofino",
+            "country_bear",
+            "fantasy_spring",
+            "forest_caffee",
+            "grand_avenue",
+            "hth",
+            "jazz_01",
+            "mmrr_exit_music",
+            "mmrr_lobby",
+            "bella_note",
+            "secret_love",
+            "agrabah_cafe_restaurant",
+            "tiana_palace",
+            "town_center"
+        });
+    }
+    TSM::PlaylistManager::GetInstance().GetShuffleEngine().SetHistoryFile("data/shuffle_history.json");
+
+    // Le chargement initial ne doit pas pouvoir être annulé
+    TSM::PlaylistManager::GetInstance().ClearHistory();
+
+    const auto trackIdUsage = TSM::TrackIdPool::GetInstance().GetMemoryUsage();
+    spdlog::info("{} track ids interned ({} KiB).", trackIdUsage.count, trackIdUsage.Total() / 1024);
 
     TSM::AudioManager::GetInstance().LoadWeddingEntranceSound("assets/wedding/Entree_RunrigHeartsOfOldenGlory.mp3");
     TSM::AudioManager::GetInstance().LoadWeddingCeremonySound("assets/wedding/Loop_PortOrleanAmbience.mp3");
@@ -132,6 +167,9 @@ int main()
     TSM::AudioManager::GetInstance().LoadAnnouncement("announce_jeux_de_societer", "assets/annonces/Both/jeux_societer_01.mp3"); // 15h15
     TSM::AudioManager::GetInstance().LoadAnnouncement("announce_remerciements", "assets/annonces/Both/merci_01.mp3"); // 16h00
 
+    // Annonces composees a partir de fragments partages
+    TSM::AnnouncementManager::GetInstance().LoadPhraseLibrary("assets/annonces/phrases.json");
+
     // Programmation des annonces
     TSM::AnnouncementManager::GetInstance().ScheduleAnnouncement(12, 00, "announce_bienvenue_01");
     TSM::AnnouncementManager::GetInstance().ScheduleAnnouncement(12, 15, "announce_15min_cl");
@@ -173,6 +211,14 @@ int main()
 
     TSM::UIManager::GetInstance().UpdateWeddingFilePaths();
 
+    // Après un arrêt brutal, la musique et la phase du mariage reprennent où elles en étaient
+    auto& checkpoint = TSM::PlaybackCheckpoint::GetInstance();
+    if (checkpoint.Open("data") && checkpoint.HasRecoveredState())
+    {
+        checkpoint.ApplyRecoveredState();
+        TSM::PlaylistManager::GetInstance().ClearHistory();
+    }
+
     bool isRunning = true;
     auto lastTime = std::chrono::high_resolution_clock::now();
 
@@ -184,7 +230,11 @@ int main()
 
         TSM::AudioManager::GetInstance().Update(dt);
         TSM::AnnouncementManager::GetInstance().Update(dt);
+        TSM::PlaylistImporter::GetInstance().Update();
         TSM::PlaylistManager::GetInstance().Update(dt);
+        TSM::PlaybackCheckpoint::GetInstance().Update(dt);
+        TSM::ShowTimeline::GetInstance().Update(dt);
+        TSM::CueStack::GetInstance().Update(dt);
         TSM::UIManager::GetInstance().UpdateWeddingMode(dt);
 
         TSM::UIManager::GetInstance().HandleEvents();
@@ -198,6 +248,11 @@ int main()
         }
     }
 
+    TSM::PlaylistImporter::GetInstance().Cancel();
+    TSM::PlaylistJournal::GetInstance().Close();
+    TSM::PlaylistManager::GetInstance().GetShuffleEngine().FlushHistory();
+    TSM::PlaybackCheckpoint::GetInstance().Close();
+    TSM::CueStack::GetInstance().Disarm();
     TSM::AudioManager::GetInstance().StopAllSounds();
     TSM::UIManager::GetInstance().Shutdown();
     TSM::FModWrapper::GetInstance().Shutdown();
@@ -0,0 +1,102 @@
+// tsm_pcm_cache.cpp
+
+#include "tsm_pcm_cache.h"
+
+#include <fmod_errors.h>
+#include <spdlog/spdlog.h>
+#include <cstring>
+
+namespace TSM
+{
+
+std::shared_ptr<const PcmBuffer> PcmCache::Decode(FMOD::System* system, const std::string& filePath)
+{
+    auto it = m_buffers.find(filePath);
+    if (it != m_buffers.end())
+    {
+        if (auto cached = it->second.lock()) return cached;
+    }
+    if (!system) return nullptr;
+
+    FMOD::Sound* sound = nullptr;
+    FMOD_RESULT result = system->createSound(filePath.c_str(), FMOD_OPENONLY | FMOD_ACCURATETIME, nullptr, &sound);
+    if (result != FMOD_OK)
+    {
+        spdlog::error("Cannot decode '{}': {}", filePath, FMOD_ErrorString(result));
+        return nullptr;
+    }
+
+    auto pcm = std::make_shared<PcmBuffer>();
+    float frequency = 0.0f;
+    unsigned int lengthBytes = 0;
+    sound->getFormat(nullptr, &pcm->format, &pcm->channels, nullptr);
+    sound->getDefaults(&frequency, nullptr);
+    sound->getLength(&lengthBytes, FMOD_TIMEUNIT_PCMBYTES);
+    pcm->sampleRate = static_cast<int>(frequency);
+
+    pcm->data.resize(lengthBytes);
+    unsigned int total = 0;
+    while (total < lengthBytes)
+    {
+        unsigned int read = 0;
+        result = sound->readData(pcm->data.data() + total, lengthBytes - total, &read);
+        total += read;
+        if (result != FMOD_OK || read == 0) break;
+    }
+    sound->release();
+
+    if (total == 0 || pcm->channels <= 0 || pcm->sampleRate <= 0)
+    {
+        spdlog::error("Cannot decode '{}': no samples read.", filePath);
+        return nullptr;
+    }
+    pcm->data.resize(total);
+
+    // Les fichiers qui ne sont plus joués ne gardent pas d'entrée
+    std::erase_if(m_buffers, [](const auto& entry) { return entry.second.expired(); });
+    m_buffers[filePath] = pcm;
+    spdlog::debug("Decoded '{}' once for every output ({} KiB).", filePath, total / 1024);
+    return pcm;
+}
+
+FMOD::Sound* PcmCache::CreateSound(FMOD::System* system, const PcmBuffer& pcm, FMOD_MODE mode)
+{
+    FMOD_CREATESOUNDEXINFO exinfo;
+    std::memset(&exinfo, 0, sizeof(exinfo));
+    exinfo.cbsize = sizeof(exinfo);
+    exinfo.length = static_cast<unsigned int>(pcm.data.size());
+    exinfo.numchannels = pcm.channels;
+    exinfo.defaultfrequency = pcm.sampleRate;
+    exinfo.format = pcm.format;
+
+    FMOD::Sound* sound = nullptr;
+    FMOD_RESULT result = system->createSound(pcm.data.data(), mode | FMOD_OPENMEMORY_POINT | FMOD_OPENRAW | FMOD_CREATESAMPLE, &exinfo, &sound);
+    if (result != FMOD_OK)
+    {
+        spdlog::error("Cannot create a sound from shared samples: {}", FMOD_ErrorString(result));
+        return nullptr;
+    }
+    return sound;
+}
+
+size_t PcmCache::GetBufferCount() const
+{
+    size_t count = 0;
+    for (const auto& [path, buffer] : m_buffers)
+    {
+        if (!buffer.expired()) count++;
+    }
+    return count;
+}
+
+size_t PcmCache::GetBufferBytes() const
+{
+    size_t bytes = 0;
+    for (const auto& [path, buffer] : m_buffers)
+    {
+        if (auto pcm = buffer.lock()) bytes += pcm->data.size();
+    }
+    return bytes;
+}
+
+} // namespace TSM
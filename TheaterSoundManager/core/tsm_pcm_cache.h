@@ -0,0 +1,50 @@
+// tsm_pcm_cache.h
+#pragma once
+
+#include <fmod.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstddef>
+
+namespace TSM
+{
+
+struct PcmBuffer
+{
+    std::vector<char> data;
+    FMOD_SOUND_FORMAT format = FMOD_SOUND_FORMAT_NONE;
+    int channels = 0;
+    int sampleRate = 0;
+};
+
+// Samples decoded once and shared by every FMOD system that plays them: each system
+// points its own sound at the same buffer (FMOD_OPENMEMORY_POINT). A buffer lives as
+// long as one of those sounds holds it.
+class PcmCache
+{
+public:
+    static PcmCache& GetInstance()
+    {
+        static PcmCache instance;
+        return instance;
+    }
+
+    // Decodes with `system`, or returns the buffer already decoded for this file.
+    std::shared_ptr<const PcmBuffer> Decode(FMOD::System* system, const std::string& filePath);
+    // The sound must be released before the last reference to `pcm` goes away.
+    static FMOD::Sound* CreateSound(FMOD::System* system, const PcmBuffer& pcm, FMOD_MODE mode = FMOD_DEFAULT);
+
+    size_t GetBufferCount() const;
+    size_t GetBufferBytes() const;
+
+private:
+    PcmCache() = default;
+    PcmCache(const PcmCache&) = delete;
+    PcmCache& operator=(const PcmCache&) = delete;
+
+    std::unordered_map<std::string, std::weak_ptr<const PcmBuffer>> m_buffers;
+};
+
+} // namespace TSM
@@ -0,0 +1,427 @@
+// tsm_playback_checkpoint.cpp
+
+#include "tsm_playback_checkpoint.h"
+#include "tsm_playlist_manager.h"
+#include "tsm_announcement_manager.h"
+#include "tsm_ui_manager.h"
+
+#include <spdlog/spdlog.h>
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TSM
+{
+
+static_assert(sizeof(CheckpointZone) == 272);
+static_assert(sizeof(CheckpointState) == 48 + 64 + CheckpointState::MaxZones * sizeof(CheckpointZone));
+static_assert(sizeof(PlaybackCheckpoint::SlotHeader) + sizeof(CheckpointState) <= PlaybackCheckpoint::SlotSize);
+
+static constexpr char CheckpointMagic[8] = { 'T', 'S', 'M', 'C', 'K', 'P', 'T', '\0' };
+static constexpr size_t FileSize = 2 * PlaybackCheckpoint::SlotSize;
+
+static constexpr std::array<uint32_t, 256> MakeCrcTable()
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+        {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+static constexpr std::array<uint32_t, 256> CrcTable = MakeCrcTable();
+
+uint32_t PlaybackCheckpoint::Crc32(const void* data, size_t size, uint32_t crc)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = CrcTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t SlotCrc(uint64_t sequence, const CheckpointState& state)
+{
+    return PlaybackCheckpoint::Crc32(&state, sizeof(state), PlaybackCheckpoint::Crc32(&sequence, sizeof(sequence)));
+}
+
+template <size_t N>
+static bool CopyName(char (&field)[N], const std::string& value)
+{
+    if (value.size() >= N) return false;
+    std::memcpy(field, value.c_str(), value.size() + 1);
+    return true;
+}
+
+template <size_t N>
+static std::string ReadName(const char (&field)[N])
+{
+    return std::string(field, strnlen(field, N));
+}
+
+static int32_t GetToday()
+{
+    std::time_t t = std::time(nullptr);
+    std::tm localTm;
+#ifdef _WIN32
+    localtime_s(&localTm, &t);
+#else
+    localtime_r(&t, &localTm);
+#endif
+    return localTm.tm_year * 1000 + localTm.tm_yday;
+}
+
+static uint32_t GetScheduleFingerprint()
+{
+    uint32_t crc = 0;
+    for (const auto& entry : AnnouncementManager::GetInstance().GetScheduledAnnouncements())
+    {
+        const int32_t time[2] = { entry.hour, entry.minute };
+        crc = PlaybackCheckpoint::Crc32(time, sizeof(time), crc);
+        crc = PlaybackCheckpoint::Crc32(entry.announcementId.data(), entry.announcementId.size(), crc);
+    }
+    return crc;
+}
+
+bool PlaybackCheckpoint::Open(const std::string& directory)
+{
+    Close();
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    m_path = (std::filesystem::path(directory) / "playback.checkpoint").string();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(m_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        spdlog::error("Cannot open playback checkpoint '{}'.", m_path);
+        return false;
+    }
+
+    // La taille du mapping agrandit le fichier s'il vient d'être créé
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(FileSize), nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, FileSize) : nullptr;
+    if (!view)
+    {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        spdlog::error("Cannot map playback checkpoint '{}'.", m_path);
+        return false;
+    }
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+#else
+    int fd = open(m_path.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || (static_cast<size_t>(info.st_size) < FileSize && ftruncate(fd, FileSize) != 0))
+    {
+        if (fd >= 0) close(fd);
+        spdlog::error("Cannot open playback checkpoint '{}'.", m_path);
+        return false;
+    }
+
+    void* view = mmap(nullptr, FileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+    {
+        spdlog::error("Cannot map playback checkpoint '{}'.", m_path);
+        return false;
+    }
+#endif
+    m_view = static_cast<uint8_t*>(view);
+
+    m_hasRecoveredState = false;
+    m_sequence = 0;
+    for (size_t slot = 0; slot < 2; slot++)
+    {
+        uint64_t sequence = 0;
+        CheckpointState state;
+        if (ReadSlot(slot, sequence, state) && (!m_hasRecoveredState || sequence > m_sequence))
+        {
+            m_recovered = state;
+            m_sequence = sequence;
+            m_hasRecoveredState = true;
+        }
+    }
+
+    if (m_hasRecoveredState)
+    {
+        spdlog::info("Playback checkpoint {} recovered ({}).", m_sequence,
+                     (m_recovered.flags & CheckpointState::CleanExit) ? "clean exit" : "interrupted run");
+    }
+    m_timer = 0.0f;
+    return true;
+}
+
+bool PlaybackCheckpoint::ReadSlot(size_t slot, uint64_t& sequence, CheckpointState& state) const
+{
+    SlotHeader header;
+    std::memcpy(&header, m_view + slot * SlotSize, sizeof(header));
+    if (std::memcmp(header.magic, CheckpointMagic, sizeof(CheckpointMagic)) != 0) return false;
+    if (header.version != Version || header.stateSize != sizeof(CheckpointState)) return false;
+
+    std::memcpy(&state, m_view + slot * SlotSize + sizeof(SlotHeader), sizeof(state));
+    if (SlotCrc(header.sequence, state) != header.crc) return false;
+    if (state.zoneCount > CheckpointState::MaxZones) return false;
+
+    sequence = header.sequence;
+    return true;
+}
+
+void PlaybackCheckpoint::Close()
+{
+    if (!m_view) return;
+
+    Write(CheckpointState::CleanExit);
+#ifdef _WIN32
+    FlushViewOfFile(m_view, FileSize);
+    FlushFileBuffers(static_cast<HANDLE>(m_fileHandle));
+#else
+    msync(m_view, FileSize, MS_SYNC);
+#endif
+    Unmap();
+}
+
+void PlaybackCheckpoint::Unmap()
+{
+#ifdef _WIN32
+    UnmapViewOfFile(m_view);
+    CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+    CloseHandle(static_cast<HANDLE>(m_fileHandle));
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    munmap(m_view, FileSize);
+#endif
+    m_view = nullptr;
+}
+
+void PlaybackCheckpoint::Update(float deltaTime)
+{
+    if (!m_view) return;
+
+    m_timer += deltaTime;
+    if (m_timer < m_interval) return;
+    m_timer = 0.0f;
+    Write();
+}
+
+// Overwrites the older slot: until the copy is complete, the newer one stays valid.
+bool PlaybackCheckpoint::Write(uint32_t extraFlags)
+{
+    if (!m_view) return false;
+
+    CheckpointState state = Capture();
+    state.flags |= extraFlags;
+
+    const uint64_t sequence = m_sequence + 1;
+    uint8_t* slot = m_view + (sequence % 2) * SlotSize;
+
+    SlotHeader header{};
+    std::memcpy(header.magic, CheckpointMagic, sizeof(CheckpointMagic));
+    header.version = Version;
+    header.stateSize = sizeof(CheckpointState);
+    header.sequence = sequence;
+    header.crc = SlotCrc(sequence, state);
+
+    std::memcpy(slot + sizeof(SlotHeader), &state, sizeof(state));
+    std::memcpy(slot, &header, sizeof(header));
+    m_sequence = sequence;
+
+    // Write-back is only started here, the frame does not wait for the disk
+#ifdef _WIN32
+    FlushViewOfFile(slot, SlotSize);
+#else
+    msync(m_view, FileSize, MS_ASYNC);
+#endif
+    return true;
+}
+
+CheckpointState PlaybackCheckpoint::Capture()
+{
+    CheckpointState state{};
+    auto& ui = UIManager::GetInstance();
+    auto& announcements = AnnouncementManager::GetInstance();
+    auto& playlists = PlaylistManager::GetInstance();
+
+    state.flags = (ui.IsWeddingModeActive() ? CheckpointState::WeddingMode : 0u)
+                | (ui.IsTransitionToNormalMusicAfterWedding() ? CheckpointState::WeddingToNormal : 0u)
+                | (announcements.IsAnnouncing() ? CheckpointState::Announcing : 0u)
+                | (ui.IsMusicFadeInActive() ? CheckpointState::MusicFadeIn : 0u);
+    state.weddingPhase = ui.GetWeddingPhase();
+    state.masterVolume = ui.GetMasterVolume();
+    state.musicVolume = ui.GetMusicVolume();
+    state.announcementVolume = ui.GetAnnouncementVolume();
+    state.sfxVolume = ui.GetSFXVolume();
+    state.duckFactor = ui.GetDuckFactor();
+    CopyName(state.normalPlaylistAfterWedding, ui.GetNormalPlaylistAfterWedding());
+
+    state.scheduleDay = GetToday();
+    state.scheduleFingerprint = GetScheduleFingerprint();
+    const auto& schedule = announcements.GetScheduledAnnouncements();
+    for (size_t i = 0; i < schedule.size() && i < CheckpointState::MaxSchedules; i++)
+    {
+        if (schedule[i].triggered) state.firedSchedules |= uint64_t(1) << i;
+    }
+
+    const std::vector<std::string> zoneNames = playlists.GetZoneNames();
+    for (ZoneId zone = 0; zone < zoneNames.size() && state.zoneCount < CheckpointState::MaxZones; zone++)
+    {
+        const auto* playlist = playlists.GetActivePlaylist(zone);
+        if (zoneNames[zone].empty() || !playlist) continue;
+
+        CheckpointZone& entry = state.zones[state.zoneCount];
+        entry = CheckpointZone{};
+        if (!CopyName(entry.zone, zoneNames[zone]) || !CopyName(entry.playlist, playlist->name)) continue;
+
+        const PlaylistResumePoint point = playlists.GetResumePoint(playlist->name);
+        if (point.valid && CopyName(entry.track, point.track.str()))
+        {
+            entry.flags |= CheckpointZone::HasResumePoint;
+            entry.index = point.index;
+            entry.randomIndexPos = point.randomIndexPos;
+            entry.positionPcm = point.positionPcm;
+            entry.segmentTimer = point.segmentTimer;
+            entry.segmentMaxDuration = point.segmentMaxDuration;
+            entry.chosenStartTime = point.chosenStartTime;
+        }
+
+        const PlaylistOptions& options = playlist->playback;
+        entry.flags |= (playlist->isPlaying ? CheckpointZone::Playing : 0u)
+                     | (options.randomOrder ? CheckpointZone::RandomOrder : 0u)
+                     | (options.randomSegment ? CheckpointZone::RandomSegment : 0u)
+                     | (options.loopPlaylist ? CheckpointZone::LoopPlaylist : 0u)
+                     | (options.gapless ? CheckpointZone::Gapless : 0u);
+        entry.segmentDuration = options.segmentDuration;
+        entry.crossfadeDuration = options.crossfadeDuration;
+        entry.crossfadeCurve = static_cast<uint32_t>(options.crossfadeCurve);
+        entry.zoneVolume = playlists.GetZoneVolume(zone);
+        entry.zoneDuckFactor = playlists.GetZoneDuckFactor(zone);
+        state.zoneCount++;
+    }
+    return state;
+}
+
+void PlaybackCheckpoint::ApplyRecoveredState()
+{
+    if (!m_hasRecoveredState) return;
+
+    const CheckpointState& state = m_recovered;
+    const bool interrupted = (state.flags & CheckpointState::CleanExit) == 0;
+
+    // Un duck d'annonce ou de fondu n'a plus de raison d'être après le redémarrage
+    auto& ui = UIManager::GetInstance();
+    ui.SetMasterVolume(state.masterVolume);
+    ui.SetMusicVolume(state.musicVolume);
+    ui.SetAnnouncementVolume(state.announcementVolume);
+    ui.SetSFXVolume(state.sfxVolume);
+    const bool transientDuck = (state.flags & (CheckpointState::Announcing | CheckpointState::MusicFadeIn)) != 0;
+    ui.SetDuckFactor(transientDuck ? 1.0f : state.duckFactor);
+
+    auto& announcements = AnnouncementManager::GetInstance();
+    if (state.scheduleDay == GetToday() && state.scheduleFingerprint == GetScheduleFingerprint())
+    {
+        const size_t count = std::min<size_t>(announcements.GetScheduledAnnouncements().size(), CheckpointState::MaxSchedules);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (state.firedSchedules & (uint64_t(1) << i)) announcements.SetScheduleTriggered(i, true);
+        }
+    }
+    else if (state.firedSchedules != 0)
+    {
+        spdlog::info("Fired schedules from the checkpoint ignored: the day or the schedule changed.");
+    }
+
+    auto& playlists = PlaylistManager::GetInstance();
+    for (uint32_t i = 0; i < state.zoneCount; i++)
+    {
+        const CheckpointZone& entry = state.zones[i];
+        const std::string zoneName = ReadName(entry.zone);
+        const std::string playlistName = ReadName(entry.playlist);
+        if (!playlists.GetPlaylistByName(playlistName)) continue;
+
+        ZoneId zone = playlists.FindZone(zoneName);
+        if (zone == PlaylistManager::InvalidZone) zone = playlists.CreateZone(zoneName);
+        playlists.SetZoneVolume(zone, entry.zoneVolume);
+        playlists.SetZoneDuckFactor(zone, entry.zoneDuckFactor);
+
+        PlaylistOptions options = playlists.GetPlaylistByName(playlistName)->options;
+        options.randomOrder = (entry.flags & CheckpointZone::RandomOrder) != 0;
+        options.randomSegment = (entry.flags & CheckpointZone::RandomSegment) != 0;
+        options.loopPlaylist = (entry.flags & CheckpointZone::LoopPlaylist) != 0;
+        options.gapless = (entry.flags & CheckpointZone::Gapless) != 0;
+        options.segmentDuration = entry.segmentDuration;
+        options.crossfadeDuration = entry.crossfadeDuration;
+        if (entry.crossfadeCurve <= static_cast<uint32_t>(CrossfadeCurve::Custom))
+        {
+            options.crossfadeCurve = static_cast<CrossfadeCurve>(entry.crossfadeCurve);
+        }
+
+        if (entry.flags & CheckpointZone::HasResumePoint)
+        {
+            PlaylistResumePoint point;
+            point.track = TrackId(ReadName(entry.track));
+            point.index = entry.index;
+            point.randomIndexPos = entry.randomIndexPos;
+            point.positionPcm = entry.positionPcm;
+            point.segmentTimer = entry.segmentTimer;
+            point.segmentMaxDuration = entry.segmentMaxDuration;
+            point.chosenStartTime = entry.chosenStartTime;
+            point.options = options;
+            point.valid = true;
+            playlists.SetResumePoint(playlistName, point);
+        }
+
+        if (interrupted && (entry.flags & CheckpointZone::Playing))
+        {
+            if (!playlists.Resume(playlistName, zone))
+            {
+                playlists.Play(playlistName, options, zone);
+            }
+            spdlog::info("Playlist '{}' restored in zone '{}'.", playlistName, zoneName);
+        }
+    }
+
+    // L'entrée (phase 1) ne se rejoue pas au milieu de la cérémonie ; le tapis et la sortie si
+    if (interrupted && (state.flags & CheckpointState::WeddingMode))
+    {
+        const bool toNormal = (state.flags & CheckpointState::WeddingToNormal) != 0;
+        if (state.weddingPhase == 2)
+        {
+            ui.StartWeddingPhase2(toNormal);
+        }
+        else if (state.weddingPhase == 3)
+        {
+            ui.StartWeddingPhase3(toNormal, ReadName(state.normalPlaylistAfterWedding));
+        }
+        else
+        {
+            spdlog::warn("Wedding phase {} is not restarted after a crash.", state.weddingPhase);
+        }
+    }
+    ui.ForceUpdateAllVolumes();
+}
+
+} // namespace TSM
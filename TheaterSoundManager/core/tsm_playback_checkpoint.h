@@ -0,0 +1,143 @@
+// tsm_playback_checkpoint.h
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace TSM
+{
+
+// Fixed-layout copy of what is playing, written to a memory-mapped file so a restarted
+// process can pick the show up where it died:
+//   Slot A | Slot B, each one SlotSize bytes = SlotHeader | CheckpointState
+// Writes alternate between the slots and each carries a CRC-32 of its sequence and state,
+// so a copy torn by a crash is detected and the other slot is used.
+// Once copied into the mapping the data survives the process; the OS writes it back.
+struct CheckpointZone
+{
+    enum Flags : uint32_t
+    {
+        Playing       = 1u << 0,
+        RandomOrder   = 1u << 1,
+        RandomSegment = 1u << 2,
+        LoopPlaylist  = 1u << 3,
+        HasResumePoint = 1u << 4,
+        Gapless       = 1u << 5
+    };
+
+    char zone[32];
+    char playlist[64];
+    char track[128];
+    int32_t index;
+    int32_t randomIndexPos;
+    uint32_t positionPcm;
+    float segmentTimer;
+    float segmentMaxDuration;
+    float chosenStartTime;
+    float segmentDuration;
+    float crossfadeDuration;
+    float zoneVolume;
+    float zoneDuckFactor;
+    uint32_t flags;
+    uint32_t crossfadeCurve;
+};
+
+struct CheckpointState
+{
+    static constexpr uint32_t MaxZones = 8;
+    static constexpr uint32_t MaxSchedules = 64;
+
+    enum Flags : uint32_t
+    {
+        CleanExit           = 1u << 0,  // written by Close(): nothing to resume on the next launch
+        WeddingMode         = 1u << 1,
+        WeddingToNormal     = 1u << 2,
+        Announcing          = 1u << 3,  // the duck factor was an announcement's, not the operator's
+        MusicFadeIn         = 1u << 4
+    };
+
+    uint32_t flags;
+    int32_t weddingPhase;
+    float masterVolume;
+    float musicVolume;
+    float announcementVolume;
+    float sfxVolume;
+    float duckFactor;
+    int32_t scheduleDay;            // year * 1000 + day of the year the fired flags belong to
+    uint32_t scheduleFingerprint;   // CRC of the schedule, the flags are dropped if it changed
+    uint32_t zoneCount;
+    uint64_t firedSchedules;        // bit i : schedule entry i has fired
+    char normalPlaylistAfterWedding[64];
+    CheckpointZone zones[MaxZones];
+};
+
+class PlaybackCheckpoint
+{
+public:
+    static constexpr uint32_t Version = 2;   // 2 : crossfade curve per zone
+    static constexpr size_t SlotSize = 4096;
+
+    struct SlotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t stateSize;
+        uint64_t sequence;          // the slot with the highest valid sequence wins
+        uint32_t crc;               // over sequence and state
+        uint32_t reserved;
+    };
+
+    static PlaybackCheckpoint& GetInstance()
+    {
+        static PlaybackCheckpoint instance;
+        return instance;
+    }
+
+    // Maps <directory>/playback.checkpoint, creating it if needed, and reads the newest valid slot.
+    bool Open(const std::string& directory);
+    // Writes a last checkpoint marked as a clean exit, then unmaps the file.
+    void Close();
+    bool IsOpen() const { return m_view != nullptr; }
+
+    bool HasRecoveredState() const { return m_hasRecoveredState; }
+    const CheckpointState& GetRecoveredState() const { return m_recovered; }
+    // Volumes, fired schedules and resume points always; playback and the wedding phase
+    // only when the last run did not exit cleanly.
+    void ApplyRecoveredState();
+
+    void SetInterval(float seconds) { m_interval = seconds; }
+    void Update(float deltaTime);
+    bool Write(uint32_t extraFlags = 0);
+
+    static CheckpointState Capture();
+    uint64_t GetSequence() const { return m_sequence; }
+    const std::string& GetPath() const { return m_path; }
+
+    static uint32_t Crc32(const void* data, size_t size, uint32_t crc = 0);
+
+private:
+    PlaybackCheckpoint() = default;
+    ~PlaybackCheckpoint() { Close(); }
+    PlaybackCheckpoint(const PlaybackCheckpoint&) = delete;
+    PlaybackCheckpoint& operator=(const PlaybackCheckpoint&) = delete;
+
+    bool ReadSlot(size_t slot, uint64_t& sequence, CheckpointState& state) const;
+    void Unmap();
+
+    std::string m_path;
+    uint8_t* m_view = nullptr;
+#ifdef _WIN32
+    void* m_fileHandle = nullptr;
+    void* m_mappingHandle = nullptr;
+#endif
+
+    uint64_t m_sequence = 0;
+    float m_interval = 1.0f;
+    float m_timer = 0.0f;
+
+    CheckpointState m_recovered{};
+    bool m_hasRecoveredState = false;
+};
+
+} // namespace TSM
@@ -0,0 +1,794 @@
+// tsm_playlist_import.cpp
+
+#include "tsm_playlist_import.h"
+#include "tsm_playlist_manager.h"
+#include "tsm_audio_manager.h"
+#include "tsm_audio_probe.h"
+
+#include <spdlog/spdlog.h>
+#include <json/json.hpp>
+#include <fstream>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <unordered_set>
+
+namespace TSM
+{
+    using json = nlohmann::json;
+
+struct ImportedTrack
+{
+    std::string id;
+    std::string path;
+    AudioProbeResult probe;
+    bool probed = false;
+};
+
+struct ImportChunk
+{
+    enum class Kind { BeginPlaylist, Options, Tracks, EndPlaylist };
+
+    Kind kind = Kind::Tracks;
+    std::string playlistName;
+    PlaylistOptions options;
+    std::vector<ImportedTrack> tracks;
+};
+
+static PlaylistOptions DefaultImportOptions()
+{
+    // Options par défaut
+    PlaylistOptions options;
+    options.randomOrder = true;
+    options.randomSegment = true;
+    options.loopPlaylist = true;
+    options.segmentDuration = 900.0f;
+    return options;
+}
+
+static bool SameOptions(const PlaylistOptions& a, const PlaylistOptions& b)
+{
+    return a.randomOrder == b.randomOrder && a.randomSegment == b.randomSegment &&
+           a.loopPlaylist == b.loopPlaylist && a.segmentDuration == b.segmentDuration &&
+           a.crossfadeDuration == b.crossfadeDuration && a.crossfadeCurve == b.crossfadeCurve &&
+           a.crossfadeShape == b.crossfadeShape && a.gapless == b.gapless;
+}
+
+// Registers a sound from its probe result: headers already read, so FMOD only opens the
+// file on first playback. Formats the prober does not know still go through FMOD.
+static bool RegisterProbedSound(const std::string& soundId, const std::string& filePath, bool isStream, const AudioProbeResult& probe)
+{
+    auto& audioManager = AudioManager::GetInstance();
+
+    switch (probe.status)
+    {
+    case AudioProbeResult::Status::Valid:
+        audioManager.RegisterDeferredSound(soundId, filePath, probe.lengthMs, isStream);
+        audioManager.SetSoundMetadata(soundId, probe.title, probe.artist, probe.album);
+        return true;
+
+    case AudioProbeResult::Status::Unknown:
+        return audioManager.LoadSound(soundId, filePath, isStream);
+
+    default:
+        spdlog::warn("Audio file '{}' rejected: {}.", filePath, probe.error);
+        return false;
+    }
+}
+
+// Turns the SAX events of a playlist file into ImportChunks. Only the current playlist
+// header and one batch of tracks are held in memory at any time.
+class PlaylistSaxHandler : public nlohmann::json_sax<json>
+{
+public:
+    using Sink = std::function<bool(ImportChunk&&)>;
+
+    PlaylistSaxHandler(bool allPlaylists, const std::string& nameOverride, size_t batchSize, Sink sink)
+        : m_allPlaylists(allPlaylists), m_nameOverride(nameOverride), m_batchSize(batchSize), m_sink(std::move(sink))
+    {
+    }
+
+    const std::string& GetError() const { return m_error; }
+
+    bool null() override { return true; }
+
+    bool boolean(bool value) override
+    {
+        if (Top() == Frame::Options)
+        {
+            if (m_key == "randomOrder")        m_options.randomOrder = value;
+            else if (m_key == "randomSegment") m_options.randomSegment = value;
+            else if (m_key == "loopPlaylist")  m_options.loopPlaylist = value;
+            else if (m_key == "gapless")       m_options.gapless = value;
+        }
+        return true;
+    }
+
+    bool number_integer(number_integer_t value) override { return Number(static_cast<float>(value)); }
+    bool number_unsigned(number_unsigned_t value) override { return Number(static_cast<float>(value)); }
+    bool number_float(number_float_t value, const string_t&) override { return Number(static_cast<float>(value)); }
+
+    bool string(string_t& value) override
+    {
+        if (Top() == Frame::Playlist && m_key == "name")
+        {
+            if (m_nameOverride.empty() && !m_begun) m_name = std::move(value);
+        }
+        else if (Top() == Frame::Options && m_key == "crossfadeCurve")
+        {
+            if (!ParseCrossfadeCurve(value, m_options.crossfadeCurve))
+            {
+                spdlog::warn("Playlist import: unknown crossfade curve '{}'.", value);
+            }
+        }
+        else if (Top() == Frame::Track)
+        {
+            if (m_key == "id")        m_track.id = std::move(value);
+            else if (m_key == "path") m_track.path = std::move(value);
+        }
+        return true;
+    }
+
+    bool binary(binary_t&) override { return true; }
+
+    bool start_object(std::size_t) override
+    {
+        Frame frame = Frame::Other;
+        if (m_frames.empty())
+        {
+            if (m_allPlaylists) return Fail("expected an array of playlists");
+            frame = Frame::Playlist;
+        }
+        else if (Top() == Frame::RootArray)
+        {
+            frame = Frame::Playlist;
+        }
+        else if (Top() == Frame::Playlist && m_key == "options")
+        {
+            frame = Frame::Options;
+        }
+        else if (Top() == Frame::Tracks)
+        {
+            frame = Frame::Track;
+            m_track = ImportedTrack();
+        }
+
+        if (frame == Frame::Playlist)
+        {
+            m_name = m_nameOverride;
+            m_begun = false;
+            m_options = DefaultImportOptions();
+            m_optionsParsed = false;
+            m_batch.clear();
+        }
+
+        m_frames.push_back(frame);
+        return true;
+    }
+
+    bool end_object() override
+    {
+        const Frame frame = Top();
+        m_frames.pop_back();
+
+        switch (frame)
+        {
+        case Frame::Track:
+            if (m_track.id.empty()) return Fail("track without id");
+            m_batch.push_back(std::move(m_track));
+            return m_batch.size() >= m_batchSize ? FlushBatch() : true;
+
+        case Frame::Options:
+            m_optionsParsed = true;
+            return m_begun ? EmitOptions() : true;
+
+        case Frame::Playlist:
+        {
+            if (!Begin() || !FlushBatch()) return false;
+
+            ImportChunk chunk;
+            chunk.kind = ImportChunk::Kind::EndPlaylist;
+            chunk.playlistName = m_name;
+            return m_sink(std::move(chunk));
+        }
+
+        default:
+            return true;
+        }
+    }
+
+    bool key(string_t& value) override
+    {
+        m_key = std::move(value);
+        return true;
+    }
+
+    bool start_array(std::size_t) override
+    {
+        Frame frame = Frame::Other;
+        if (m_frames.empty())
+        {
+            if (!m_allPlaylists) return Fail("expected a playlist object");
+            frame = Frame::RootArray;
+        }
+        else if (Top() == Frame::Playlist && m_key == "tracks")
+        {
+            frame = Frame::Tracks;
+        }
+
+        m_frames.push_back(frame);
+        return true;
+    }
+
+    bool end_array() override
+    {
+        m_frames.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override
+    {
+        m_error = ex.what();
+        spdlog::error("Playlist import: parse error at byte {}: {}", position, ex.what());
+        return false;
+    }
+
+private:
+    enum class Frame { RootArray, Playlist, Options, Tracks, Track, Other };
+
+    Frame Top() const { return m_frames.empty() ? Frame::Other : m_frames.back(); }
+
+    bool Fail(const std::string& message)
+    {
+        m_error = message;
+        spdlog::error("Playlist import: {}.", message);
+        return false;
+    }
+
+    bool Number(float value)
+    {
+        if (Top() == Frame::Options)
+        {
+            if (m_key == "segmentDuration")        m_options.segmentDuration = value;
+            else if (m_key == "crossfadeDuration") m_options.crossfadeDuration = value;
+            else if (m_key == "crossfadeShape")    m_options.crossfadeShape = value;
+        }
+        return true;
+    }
+
+    // The name usually precedes the tracks; if it does not, tracks are held back until it is known.
+    bool Begin()
+    {
+        if (m_begun) return true;
+        if (m_name.empty()) return Fail("playlist without a name");
+
+        ImportChunk chunk;
+        chunk.kind = ImportChunk::Kind::BeginPlaylist;
+        chunk.playlistName = m_name;
+        if (!m_sink(std::move(chunk))) return false;
+
+        m_begun = true;
+        return m_optionsParsed ? EmitOptions() : true;
+    }
+
+    bool EmitOptions()
+    {
+        ImportChunk chunk;
+        chunk.kind = ImportChunk::Kind::Options;
+        chunk.playlistName = m_name;
+        chunk.options = m_options;
+        return m_sink(std::move(chunk));
+    }
+
+    bool FlushBatch()
+    {
+        if (m_batch.empty()) return true;
+        if (!m_begun)
+        {
+            if (m_name.empty()) return true;
+            if (!Begin()) return false;
+        }
+
+        ImportChunk chunk;
+        chunk.kind = ImportChunk::Kind::Tracks;
+        chunk.playlistName = m_name;
+        chunk.tracks = std::move(m_batch);
+        m_batch.clear();
+        m_batch.reserve(m_batchSize);
+        return m_sink(std::move(chunk));
+    }
+
+    const bool m_allPlaylists;
+    const std::string m_nameOverride;
+    const size_t m_batchSize;
+    Sink m_sink;
+
+    std::vector<Frame> m_frames;
+    std::string m_key;
+    std::string m_error;
+
+    std::string m_name;
+    bool m_begun = false;
+    PlaylistOptions m_options;
+    bool m_optionsParsed = false;
+    std::vector<ImportedTrack> m_batch;
+    ImportedTrack m_track;
+};
+
+struct PlaylistImporter::Job
+{
+    static constexpr size_t MaxQueuedChunks = 32;
+
+    bool allPlaylists = false;
+    std::string filePath;
+    std::string nameOverride;
+    size_t batchSize = 256;
+    bool reconcile = true;
+
+    std::ifstream file;
+    uint64_t fileSize = 0;
+
+    // Read by the parsing thread: the sounds that existed when the job started, so only
+    // new files are probed.
+    AudioProbePool* probePool = nullptr;
+    std::unordered_set<std::string> knownSounds;
+
+    // Shared with the worker thread.
+    std::mutex mutex;
+    std::condition_variable queueChanged;
+    std::deque<ImportChunk> queue;
+    std::atomic<bool> cancelRequested{ false };
+    std::atomic<float> progress{ 0.0f };
+    bool parseFinished = false;
+    bool parseSucceeded = false;
+
+    // Main thread only.
+    bool replacedExisting = false;
+    size_t importedTracks = 0;
+    size_t playlistCount = 0;
+
+    // An existing playlist is rebuilt off to the side and reconciled once its last track is read.
+    bool reconciling = false;
+    std::vector<std::string> reconciledTracks;
+    PlaylistOptions reconciledOptions;
+    std::unordered_set<std::string> importedNames;
+
+    bool Open()
+    {
+        file.open(filePath.c_str(), std::ios::binary);
+        if (!file.is_open())
+        {
+            spdlog::error("Failed to open file '{}' for reading.", filePath);
+            return false;
+        }
+        file.seekg(0, std::ios::end);
+        fileSize = static_cast<uint64_t>(file.tellg());
+        file.seekg(0, std::ios::beg);
+
+        for (const auto& [name, data] : AudioManager::GetInstance().GetAllSounds())
+        {
+            knownSounds.insert(name);
+        }
+        return true;
+    }
+
+    void ProbeTracks(ImportChunk& chunk)
+    {
+        if (chunk.kind != ImportChunk::Kind::Tracks || !probePool) return;
+
+        std::vector<size_t> indices;
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < chunk.tracks.size(); i++)
+        {
+            const ImportedTrack& track = chunk.tracks[i];
+            if (!track.path.empty() && knownSounds.find(track.id) == knownSounds.end())
+            {
+                indices.push_back(i);
+                paths.push_back(track.path);
+            }
+        }
+        if (paths.empty()) return;
+
+        std::vector<AudioProbeResult> results = probePool->ProbeAll(paths);
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            ImportedTrack& track = chunk.tracks[indices[i]];
+            track.probe = std::move(results[i]);
+            track.probed = true;
+        }
+    }
+
+    bool Parse(const PlaylistSaxHandler::Sink& sink)
+    {
+        PlaylistSaxHandler handler(allPlaylists, nameOverride, batchSize,
+            [this, &sink](ImportChunk&& chunk) {
+                if (cancelRequested) return false;
+                ProbeTracks(chunk);
+                if (fileSize > 0)
+                {
+                    std::streamoff position = file.tellg();
+                    if (position >= 0) progress = static_cast<float>(position) / static_cast<float>(fileSize);
+                }
+                return sink(std::move(chunk));
+            });
+
+        bool ok = json::sax_parse(file, &handler) && handler.GetError().empty();
+        if (ok) progress = 1.0f;
+        return ok;
+    }
+
+    void Apply(ImportChunk&& chunk)
+    {
+        auto& playlistManager = PlaylistManager::GetInstance();
+
+        switch (chunk.kind)
+        {
+        case ImportChunk::Kind::BeginPlaylist:
+            if (allPlaylists && !replacedExisting && !reconcile)
+            {
+                // Le fichier remplace toutes les playlists existantes
+                for (const auto& name : playlistManager.GetPlaylistNames())
+                {
+                    playlistManager.DeletePlaylist(name);
+                }
+                replacedExisting = true;
+            }
+
+            importedNames.insert(chunk.playlistName);
+            if (reconcile && playlistManager.GetPlaylistByName(chunk.playlistName))
+            {
+                reconciling = true;
+                reconciledTracks.clear();
+                reconciledOptions = DefaultImportOptions();
+                playlistCount++;
+                break;
+            }
+
+            if (playlistManager.GetPlaylistByName(chunk.playlistName))
+            {
+                spdlog::warn("Playlist '{}' already exists. It will be overwritten.", chunk.playlistName);
+                playlistManager.ClearPlaylist(chunk.playlistName);
+            }
+            else
+            {
+                playlistManager.CreatePlaylist(chunk.playlistName);
+            }
+            playlistManager.SetPlaylistOptions(chunk.playlistName, DefaultImportOptions());
+            playlistCount++;
+            break;
+
+        case ImportChunk::Kind::Options:
+            if (reconciling)
+            {
+                reconciledOptions = chunk.options;
+            }
+            else
+            {
+                playlistManager.SetPlaylistOptions(chunk.playlistName, chunk.options);
+            }
+            break;
+
+        case ImportChunk::Kind::Tracks:
+        {
+            auto& audioManager = AudioManager::GetInstance();
+            std::vector<std::string> tracks;
+            tracks.reserve(chunk.tracks.size());
+
+            for (auto& track : chunk.tracks)
+            {
+                if (!audioManager.HasSound(track.id) && !track.path.empty())
+                {
+                    if (track.probed)
+                    {
+                        RegisterProbedSound(track.id, track.path, true, track.probe);
+                    }
+                    else
+                    {
+                        audioManager.LoadSound(track.id, track.path, true);
+                    }
+                }
+
+                if (audioManager.HasSound(track.id))
+                {
+                    tracks.push_back(std::move(track.id));
+                }
+                else
+                {
+                    spdlog::warn("Track '{}' in playlist '{}' could not be loaded. Skipping.", track.id, chunk.playlistName);
+                }
+            }
+
+            importedTracks += tracks.size();
+            if (reconciling)
+            {
+                reconciledTracks.insert(reconciledTracks.end(),
+                    std::make_move_iterator(tracks.begin()), std::make_move_iterator(tracks.end()));
+            }
+            else
+            {
+                playlistManager.AddTracksToPlaylist(chunk.playlistName, tracks);
+            }
+            break;
+        }
+
+        case ImportChunk::Kind::EndPlaylist:
+            if (reconciling)
+            {
+                playlistManager.ReconcilePlaylist(chunk.playlistName, reconciledTracks);
+                const auto* playlist = playlistManager.GetPlaylistByName(chunk.playlistName);
+                if (playlist && !SameOptions(playlist->options, reconciledOptions))
+                {
+                    playlistManager.SetPlaylistOptions(chunk.playlistName, reconciledOptions);
+                }
+                reconciling = false;
+                reconciledTracks.clear();
+            }
+            spdlog::info("Playlist '{}' imported from '{}' with {} tracks.", chunk.playlistName, filePath,
+                         playlistManager.GetPlaylistTrackCount(chunk.playlistName));
+            break;
+        }
+    }
+
+    // A complete file replaces the whole set: playlists it does not list are dropped.
+    void Finish()
+    {
+        if (!allPlaylists || !reconcile) return;
+
+        auto& playlistManager = PlaylistManager::GetInstance();
+        for (const auto& name : playlistManager.GetPlaylistNames())
+        {
+            if (importedNames.find(name) == importedNames.end())
+            {
+                playlistManager.DeletePlaylist(name);
+            }
+        }
+    }
+};
+
+PlaylistImporter::PlaylistImporter() = default;
+
+PlaylistImporter::~PlaylistImporter()
+{
+    Cancel();
+}
+
+bool PlaylistImporter::ImportPlaylist(const std::string& filePath, const std::string& playlistName)
+{
+    auto job = std::make_unique<Job>();
+    job->filePath = filePath;
+    job->nameOverride = playlistName;
+    return RunSynchronously(std::move(job));
+}
+
+bool PlaylistImporter::LoadAllPlaylists(const std::string& filePath)
+{
+    auto job = std::make_unique<Job>();
+    job->allPlaylists = true;
+    job->filePath = filePath;
+    return RunSynchronously(std::move(job));
+}
+
+bool PlaylistImporter::StartImportPlaylist(const std::string& filePath, const std::string& playlistName)
+{
+    auto job = std::make_unique<Job>();
+    job->filePath = filePath;
+    job->nameOverride = playlistName;
+    return Start(std::move(job));
+}
+
+bool PlaylistImporter::StartLoadAllPlaylists(const std::string& filePath)
+{
+    auto job = std::make_unique<Job>();
+    job->allPlaylists = true;
+    job->filePath = filePath;
+    return Start(std::move(job));
+}
+
+size_t PlaylistImporter::ImportAudioFiles(const std::vector<AudioFileEntry>& files, const std::string& playlistName)
+{
+    std::vector<std::string> paths;
+    paths.reserve(files.size());
+    for (const auto& file : files)
+    {
+        paths.push_back(file.filePath);
+    }
+
+    // Les fichiers sont sondés en parallèle, puis enregistrés dans l'ordre de la sélection
+    std::vector<AudioProbeResult> results = GetProbePool().ProbeAll(paths);
+
+    auto& audioManager = AudioManager::GetInstance();
+    std::vector<std::string> tracks;
+    size_t registered = 0;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        const AudioFileEntry& file = files[i];
+        if (audioManager.HasSound(file.soundId))
+        {
+            spdlog::warn("Sound '{}' already exists. '{}' was not imported.", file.soundId, file.filePath);
+            continue;
+        }
+        if (!RegisterProbedSound(file.soundId, file.filePath, file.isStream, results[i]))
+        {
+            spdlog::error("Failed to import audio file: {}", file.filePath);
+            continue;
+        }
+
+        spdlog::info("Imported audio file '{}' as '{}'", file.filePath, file.soundId);
+        registered++;
+        if (file.addToPlaylist)
+        {
+            tracks.push_back(file.soundId);
+        }
+    }
+
+    if (!tracks.empty())
+    {
+        auto& playlistManager = PlaylistManager::GetInstance();
+        PlaylistManager::BatchScope batch;
+        if (!playlistManager.GetPlaylistByName(playlistName))
+        {
+            playlistManager.CreatePlaylist(playlistName);
+        }
+        playlistManager.AddTracksToPlaylist(playlistName, tracks);
+    }
+    return registered;
+}
+
+AudioProbePool& PlaylistImporter::GetProbePool()
+{
+    if (!m_probePool)
+    {
+        m_probePool = std::make_unique<AudioProbePool>();
+    }
+    return *m_probePool;
+}
+
+bool PlaylistImporter::RunSynchronously(std::unique_ptr<Job> job)
+{
+    job->batchSize = m_batchSize;
+    job->reconcile = m_reconcileExisting;
+    job->probePool = &GetProbePool();
+    if (!job->Open())
+    {
+        return false;
+    }
+
+    PlaylistManager::BatchScope batch;
+    bool ok = job->Parse([&job](ImportChunk&& chunk) {
+        job->Apply(std::move(chunk));
+        return true;
+    });
+    if (ok)
+    {
+        job->Finish();
+    }
+
+    if (!ok)
+    {
+        spdlog::error("Error importing playlists from '{}'.", job->filePath);
+        return false;
+    }
+    if (job->allPlaylists)
+    {
+        spdlog::info("Loaded {} playlists from '{}'.", job->playlistCount, job->filePath);
+    }
+    return true;
+}
+
+bool PlaylistImporter::Start(std::unique_ptr<Job> job)
+{
+    if (m_job)
+    {
+        spdlog::warn("A playlist import is already running.");
+        return false;
+    }
+
+    job->batchSize = m_batchSize;
+    job->reconcile = m_reconcileExisting;
+    job->probePool = &GetProbePool();
+    if (!job->Open())
+    {
+        return false;
+    }
+
+    m_job = std::move(job);
+    Job* running = m_job.get();
+    m_worker = std::thread([running]() {
+        bool ok = running->Parse([running](ImportChunk&& chunk) {
+            std::unique_lock<std::mutex> lock(running->mutex);
+            running->queueChanged.wait(lock, [running] {
+                return running->queue.size() < Job::MaxQueuedChunks || running->cancelRequested;
+            });
+            if (running->cancelRequested) return false;
+            running->queue.push_back(std::move(chunk));
+            return true;
+        });
+
+        std::lock_guard<std::mutex> lock(running->mutex);
+        running->parseFinished = true;
+        running->parseSucceeded = ok;
+    });
+
+    spdlog::info("Streaming playlist import started from '{}'.", m_job->filePath);
+    return true;
+}
+
+void PlaylistImporter::Update()
+{
+    if (!m_job) return;
+
+    std::deque<ImportChunk> chunks;
+    bool finished = false;
+    {
+        std::lock_guard<std::mutex> lock(m_job->mutex);
+        chunks.swap(m_job->queue);
+        finished = m_job->parseFinished;
+    }
+    m_job->queueChanged.notify_all();
+
+    if (!chunks.empty())
+    {
+        PlaylistManager::BatchScope batch;
+        for (auto& chunk : chunks)
+        {
+            m_job->Apply(std::move(chunk));
+        }
+    }
+
+    // The queue was drained after parseFinished was read, so nothing is left behind.
+    if (finished)
+    {
+        FinishJob();
+    }
+}
+
+void PlaylistImporter::FinishJob()
+{
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+
+    m_lastImportSucceeded = m_job->parseSucceeded;
+    if (m_lastImportSucceeded)
+    {
+        PlaylistManager::BatchScope batch;
+        m_job->Finish();
+        spdlog::info("Streaming import of '{}' finished: {} playlists, {} tracks.",
+                     m_job->filePath, m_job->playlistCount, m_job->importedTracks);
+    }
+    else
+    {
+        spdlog::error("Streaming import of '{}' stopped after {} tracks.", m_job->filePath, m_job->importedTracks);
+    }
+    m_job.reset();
+}
+
+void PlaylistImporter::Cancel()
+{
+    if (!m_job) return;
+
+    m_job->cancelRequested = true;
+    m_job->queueChanged.notify_all();
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+
+    spdlog::info("Playlist import of '{}' cancelled after {} tracks.", m_job->filePath, m_job->importedTracks);
+    m_lastImportSucceeded = false;
+    m_job.reset();
+}
+
+float PlaylistImporter::GetProgress() const
+{
+    return m_job ? m_job->progress.load() : 0.0f;
+}
+
+size_t PlaylistImporter::GetImportedTrackCount() const
+{
+    return m_job ? m_job->importedTracks : 0;
+}
+
+} // namespace TSM
@@ -0,0 +1,82 @@
+// tsm_playlist_import.h
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+
+namespace TSM
+{
+
+class AudioProbePool;
+
+// Streaming import of playlist JSON files, either a single exported playlist or the
+// array written by SavePlaylistsToFile. The file goes through a SAX parser, so no DOM
+// is built: tracks are handed over in batches as soon as they are read.
+class PlaylistImporter
+{
+public:
+    struct AudioFileEntry
+    {
+        std::string soundId;
+        std::string filePath;
+        bool isStream = true;
+        bool addToPlaylist = true;
+    };
+
+    static PlaylistImporter& GetInstance()
+    {
+        static PlaylistImporter instance;
+        return instance;
+    }
+
+    // Parses and applies batch by batch on the calling thread.
+    bool ImportPlaylist(const std::string& filePath, const std::string& playlistName = "");
+    bool LoadAllPlaylists(const std::string& filePath);
+
+    // Parses on a worker thread; Update() applies the batches read so far, so the first
+    // tracks can be played while the rest of the file is still being read.
+    bool StartImportPlaylist(const std::string& filePath, const std::string& playlistName = "");
+    bool StartLoadAllPlaylists(const std::string& filePath);
+    void Update();
+    void Cancel();
+
+    bool IsRunning() const { return m_job != nullptr; }
+    float GetProgress() const;
+    size_t GetImportedTrackCount() const;
+    bool LastImportSucceeded() const { return m_lastImportSucceeded; }
+
+    void SetBatchSize(size_t tracks) { m_batchSize = tracks > 0 ? tracks : 1; }
+    // When set (the default), a playlist that already exists is diffed against the file
+    // instead of being cleared and refilled, so it can keep playing during the import.
+    void SetReconcileExisting(bool enabled) { m_reconcileExisting = enabled; }
+
+    // Probes the files concurrently, then registers them and appends the playlist entries
+    // in the given order with a single change. Returns the number of sounds registered.
+    size_t ImportAudioFiles(const std::vector<AudioFileEntry>& files, const std::string& playlistName);
+
+private:
+    struct Job;
+
+    PlaylistImporter();
+    ~PlaylistImporter();
+    PlaylistImporter(const PlaylistImporter&) = delete;
+    PlaylistImporter& operator=(const PlaylistImporter&) = delete;
+
+    bool Start(std::unique_ptr<Job> job);
+    bool RunSynchronously(std::unique_ptr<Job> job);
+    void FinishJob();
+    AudioProbePool& GetProbePool();
+
+    std::unique_ptr<Job> m_job;
+    std::thread m_worker;
+    std::unique_ptr<AudioProbePool> m_probePool;
+    size_t m_batchSize = 256;
+    bool m_reconcileExisting = true;
+    bool m_lastImportSucceeded = false;
+};
+
+} // namespace TSM
@@ -0,0 +1,659 @@
+// tsm_playlist_journal.cpp
+
+#include "tsm_playlist_journal.h"
+#include "tsm_audio_manager.h"
+#include "tsm_library_snapshot.h"
+
+#include <spdlog/spdlog.h>
+#include <json/json.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace TSM
+{
+    using json = nlohmann::json;
+
+static bool SyncFile(std::FILE* file)
+{
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+static json OptionsToJson(const PlaylistOptions& options)
+{
+    json j;
+    j["randomOrder"] = options.randomOrder;
+    j["randomSegment"] = options.randomSegment;
+    j["segmentDuration"] = options.segmentDuration;
+    j["loopPlaylist"] = options.loopPlaylist;
+    j["crossfadeDuration"] = options.crossfadeDuration;
+    j["crossfadeCurve"] = GetCrossfadeCurveKey(options.crossfadeCurve);
+    j["crossfadeShape"] = options.crossfadeShape;
+    j["gapless"] = options.gapless;
+    return j;
+}
+
+static void OptionsFromJson(const json& j, PlaylistOptions& options)
+{
+    if (j.contains("randomOrder"))     options.randomOrder = j["randomOrder"].get<bool>();
+    if (j.contains("randomSegment"))   options.randomSegment = j["randomSegment"].get<bool>();
+    if (j.contains("segmentDuration")) options.segmentDuration = j["segmentDuration"].get<float>();
+    if (j.contains("loopPlaylist"))    options.loopPlaylist = j["loopPlaylist"].get<bool>();
+    if (j.contains("crossfadeDuration")) options.crossfadeDuration = j["crossfadeDuration"].get<float>();
+    if (j.contains("crossfadeCurve"))  ParseCrossfadeCurve(j["crossfadeCurve"].get<std::string>(), options.crossfadeCurve);
+    if (j.contains("crossfadeShape"))  options.crossfadeShape = j["crossfadeShape"].get<float>();
+    if (j.contains("gapless"))         options.gapless = j["gapless"].get<bool>();
+}
+
+// Journals written before the duration moved into the options kept it next to them.
+static void LegacyCrossfadeFromJson(const json& op, PlaylistOptions& options)
+{
+    if (op.contains("crossfadeDuration")) options.crossfadeDuration = op["crossfadeDuration"].get<float>();
+}
+
+template <typename TrackList>
+static json TracksToJson(const TrackList& tracks)
+{
+    const auto& audioManager = AudioManager::GetInstance();
+    const auto& allSounds = audioManager.GetAllSounds();
+
+    json j = json::array();
+    for (const std::string& trackId : tracks)
+    {
+        json track;
+        track["id"] = trackId;
+        auto soundIt = allSounds.find(trackId);
+        if (soundIt != allSounds.end())
+        {
+            track["path"] = soundIt->second.filePath;
+            track["lengthMs"] = audioManager.GetSoundLengthMs(trackId);
+        }
+        j.push_back(track);
+    }
+    return j;
+}
+
+static std::vector<TrackId> TracksFromJson(const json& j, std::map<TrackId, PlaylistJournal::TrackSource, std::less<>>& sources)
+{
+    std::vector<TrackId> tracks;
+    tracks.reserve(j.size());
+    for (const auto& track : j)
+    {
+        TrackId trackId = track["id"].get<std::string>();
+        if (track.contains("path"))
+        {
+            auto& source = sources[trackId];
+            source.path = track["path"].get<std::string>();
+            source.lengthMs = track.value("lengthMs", source.lengthMs);
+        }
+        tracks.push_back(trackId);
+    }
+    return tracks;
+}
+
+bool PlaylistJournal::Open(const std::string& directory)
+{
+    if (m_isOpen) return true;
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec)
+    {
+        spdlog::error("Cannot create playlist journal directory '{}': {}", directory, ec.message());
+        return false;
+    }
+
+    m_journalPath = (std::filesystem::path(directory) / "playlists.journal").string();
+    m_snapshotPath = (std::filesystem::path(directory) / "playlists.snapshot").string();
+
+    State state;
+    if (!LoadSnapshot(state))
+    {
+        return false;
+    }
+    const uint64_t snapshotSequence = state.sequence;
+    ReplayJournal(state);
+
+    m_recovered.clear();
+    for (const auto& name : state.order)
+    {
+        m_recovered.push_back(state.playlists[name]);
+    }
+    m_recoveredSources = state.trackSources;
+    m_hasRecoveredState = state.sequence > 0;
+
+    // Fold whatever was replayed into a fresh snapshot so the journal starts empty.
+    if (state.sequence != snapshotSequence && !WriteSnapshot(state))
+    {
+        return false;
+    }
+
+    m_journalFile = std::fopen(m_journalPath.c_str(), "wb");
+    if (!m_journalFile)
+    {
+        spdlog::error("Cannot open playlist journal '{}'.", m_journalPath);
+        return false;
+    }
+
+    m_state = std::move(state);
+    m_nextSequence = m_state.sequence + 1;
+    m_durableSequence = m_state.sequence;
+    m_operationsSinceSnapshot = 0;
+    m_pending.clear();
+    m_stopRequested = false;
+    m_flushRequested = false;
+
+    m_writer = std::thread(&PlaylistJournal::WriterLoop, this);
+    m_subscription = PlaylistManager::GetInstance().RegisterPlaylistChangeCallback(
+        [this](const std::vector<PlaylistChangeEvent>& events) { OnPlaylistChanges(events); });
+
+    m_isOpen = true;
+    spdlog::info("Playlist journal opened in '{}' ({} playlists recovered, sequence {}).",
+                 directory, m_recovered.size(), m_state.sequence);
+    return true;
+}
+
+void PlaylistJournal::Close()
+{
+    if (!m_isOpen) return;
+
+    PlaylistManager::GetInstance().UnregisterPlaylistChangeCallback(m_subscription);
+    m_subscription = 0;
+
+    StopWriter();
+    Compact();
+
+    if (m_journalFile)
+    {
+        std::fclose(m_journalFile);
+        m_journalFile = nullptr;
+    }
+
+    m_recovered.clear();
+    m_recoveredSources.clear();
+    m_hasRecoveredState = false;
+    m_isOpen = false;
+    spdlog::info("Playlist journal closed at sequence {}.", m_state.sequence);
+}
+
+void PlaylistJournal::StopWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_wakeWriter.notify_all();
+    if (m_writer.joinable())
+    {
+        m_writer.join();
+    }
+}
+
+void PlaylistJournal::ApplyRecoveredState()
+{
+    auto& playlistManager = PlaylistManager::GetInstance();
+    auto& audioManager = AudioManager::GetInstance();
+
+    // The recovered state is already on disk, so do not journal it a second time.
+    m_applyingRecovery = true;
+    {
+        PlaylistManager::BatchScope batch;
+
+        for (const auto& persisted : m_recovered)
+        {
+            if (playlistManager.GetPlaylistByName(persisted.name))
+            {
+                spdlog::warn("Playlist '{}' already exists, recovered copy ignored.", persisted.name);
+                continue;
+            }
+
+            std::vector<std::string> tracks;
+            tracks.reserve(persisted.tracks.size());
+            for (const auto& trackId : persisted.tracks)
+            {
+                // Files are only opened when a track is first played; the cached length
+                // is enough for the playlist view.
+                if (!audioManager.HasSound(trackId))
+                {
+                    auto sourceIt = m_recoveredSources.find(trackId);
+                    if (sourceIt != m_recoveredSources.end() && !sourceIt->second.path.empty())
+                    {
+                        audioManager.RegisterDeferredSound(trackId, sourceIt->second.path, sourceIt->second.lengthMs);
+                    }
+                }
+
+                if (audioManager.HasSound(trackId))
+                {
+                    tracks.push_back(trackId);
+                }
+                else
+                {
+                    spdlog::warn("Track '{}' in playlist '{}' could not be loaded. Skipping.", trackId.str(), persisted.name);
+                }
+            }
+
+            playlistManager.CreatePlaylist(persisted.name);
+            playlistManager.AddTracksToPlaylist(persisted.name, tracks);
+            playlistManager.SetPlaylistOptions(persisted.name, persisted.options);
+        }
+    }
+    m_applyingRecovery = false;
+}
+
+void PlaylistJournal::Flush()
+{
+    if (!m_isOpen) return;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const uint64_t target = m_nextSequence - 1;
+    m_flushRequested = true;
+    m_wakeWriter.notify_all();
+    m_durable.wait(lock, [&] { return m_durableSequence >= target || m_stopRequested; });
+}
+
+void PlaylistJournal::OnPlaylistChanges(const std::vector<PlaylistChangeEvent>& events)
+{
+    if (m_applyingRecovery) return;
+
+    auto& playlistManager = PlaylistManager::GetInstance();
+    std::vector<std::string> lines;
+    lines.reserve(events.size());
+
+    for (const auto& event : events)
+    {
+        json op;
+        switch (event.type)
+        {
+        case PlaylistChangeType::Created:
+        {
+            op["op"] = "create";
+            op["name"] = event.playlistName;
+            const auto* playlist = playlistManager.GetPlaylist(event.playlist);
+            op["options"] = OptionsToJson(playlist ? playlist->options : PlaylistOptions());
+            op["tracks"] = TracksToJson(event.tracks);
+            op["index"] = event.index;
+            break;
+        }
+        case PlaylistChangeType::Deleted:
+            op["op"] = "delete";
+            op["name"] = event.playlistName;
+            break;
+        case PlaylistChangeType::Renamed:
+            op["op"] = "rename";
+            op["from"] = event.previousName;
+            op["to"] = event.playlistName;
+            break;
+        case PlaylistChangeType::TracksInserted:
+            op["op"] = "insert";
+            op["name"] = event.playlistName;
+            op["index"] = event.index;
+            op["tracks"] = TracksToJson(event.tracks);
+            break;
+        case PlaylistChangeType::TracksRemoved:
+            op["op"] = "remove";
+            op["name"] = event.playlistName;
+            op["index"] = event.index;
+            op["count"] = event.tracks.size();
+            break;
+        case PlaylistChangeType::TrackMoved:
+            op["op"] = "move";
+            op["name"] = event.playlistName;
+            op["from"] = event.fromIndex;
+            op["to"] = event.toIndex;
+            break;
+        case PlaylistChangeType::TracksReplaced:
+            op["op"] = "replace";
+            op["name"] = event.playlistName;
+            op["tracks"] = TracksToJson(event.tracks);
+            break;
+        case PlaylistChangeType::OptionsChanged:
+        {
+            const auto* playlist = playlistManager.GetPlaylist(event.playlist);
+            if (!playlist) continue;
+            op["op"] = "options";
+            op["name"] = event.playlistName;
+            op["options"] = OptionsToJson(playlist->options);
+            break;
+        }
+        case PlaylistChangeType::Reloaded:
+        {
+            op["op"] = "reset";
+            op["playlists"] = json::array();
+            for (const auto* playlist : playlistManager.GetAllPlaylists())
+            {
+                json p;
+                p["name"] = playlist->name;
+                p["options"] = OptionsToJson(playlist->options);
+                p["tracks"] = TracksToJson(playlist->tracks);
+                op["playlists"].push_back(p);
+            }
+            break;
+        }
+        }
+
+        op["seq"] = m_nextSequence++;
+        lines.push_back(op.dump());
+    }
+
+    if (lines.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.insert(m_pending.end(), std::make_move_iterator(lines.begin()), std::make_move_iterator(lines.end()));
+    }
+    m_wakeWriter.notify_one();
+}
+
+void PlaylistJournal::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        m_wakeWriter.wait(lock, [&] { return m_stopRequested || !m_pending.empty(); });
+        if (m_pending.empty() && m_stopRequested) break;
+
+        // Let a burst of edits accumulate so they share one fsync.
+        if (!m_stopRequested && !m_flushRequested)
+        {
+            m_wakeWriter.wait_for(lock, GroupCommitWindow, [&] { return m_stopRequested || m_flushRequested; });
+        }
+
+        std::vector<std::string> lines;
+        lines.swap(m_pending);
+        m_flushRequested = false;
+        lock.unlock();
+
+        for (const auto& line : lines)
+        {
+            std::fwrite(line.data(), 1, line.size(), m_journalFile);
+            std::fputc('\n', m_journalFile);
+            ApplyOperation(m_state, line);
+        }
+
+        if (!SyncFile(m_journalFile))
+        {
+            spdlog::error("Failed to sync playlist journal '{}'.", m_journalPath);
+        }
+
+        m_operationsSinceSnapshot += lines.size();
+        if (m_operationsSinceSnapshot >= m_compactionThreshold)
+        {
+            Compact();
+        }
+
+        lock.lock();
+        m_durableSequence = m_state.sequence;
+        m_durable.notify_all();
+    }
+
+    m_durableSequence = m_state.sequence;
+    m_durable.notify_all();
+}
+
+bool PlaylistJournal::LoadSnapshot(State& state) const
+{
+    if (!std::filesystem::exists(m_snapshotPath))
+    {
+        return true;
+    }
+
+    LibrarySnapshot snapshot;
+    if (!snapshot.Open(m_snapshotPath))
+    {
+        spdlog::error("Playlist snapshot '{}' is unreadable.", m_snapshotPath);
+        return false;
+    }
+
+    state.sequence = snapshot.GetSequence();
+
+    std::vector<TrackId> trackIds(snapshot.GetTrackCount());
+    for (uint32_t i = 0; i < snapshot.GetTrackCount(); i++)
+    {
+        trackIds[i] = snapshot.GetTrackId(i);
+        auto& source = state.trackSources[trackIds[i]];
+        source.path = snapshot.GetTrackPath(i);
+        source.lengthMs = snapshot.GetTrackLengthMs(i);
+    }
+
+    for (uint32_t i = 0; i < snapshot.GetPlaylistCount(); i++)
+    {
+        PersistedPlaylist playlist;
+        playlist.name = snapshot.GetPlaylistName(i);
+        playlist.options = snapshot.GetPlaylistOptions(i);
+
+        auto entries = snapshot.GetPlaylistTracks(i);
+        playlist.tracks.reserve(entries.size());
+        for (uint32_t trackIndex : entries)
+        {
+            playlist.tracks.push_back(trackIds[trackIndex]);
+        }
+
+        state.order.push_back(playlist.name);
+        state.playlists[playlist.name] = std::move(playlist);
+    }
+    return true;
+}
+
+void PlaylistJournal::ReplayJournal(State& state) const
+{
+    std::ifstream file(m_journalPath.c_str(), std::ios::binary);
+    if (!file.is_open()) return;
+
+    size_t replayed = 0;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty()) continue;
+
+        if (!ApplyOperation(state, line))
+        {
+            // Only the last append can be torn; nothing after it was acknowledged.
+            spdlog::warn("Playlist journal '{}' ends with an incomplete record, ignored.", m_journalPath);
+            break;
+        }
+        replayed++;
+    }
+
+    spdlog::info("Replayed {} playlist journal records.", replayed);
+}
+
+bool PlaylistJournal::ApplyOperation(State& state, const std::string& line)
+{
+    json op = json::parse(line, nullptr, false);
+    if (op.is_discarded() || !op.contains("seq") || !op.contains("op"))
+    {
+        return false;
+    }
+
+    const uint64_t sequence = op["seq"].get<uint64_t>();
+    if (sequence <= state.sequence)
+    {
+        // Already folded into the snapshot.
+        return true;
+    }
+
+    try
+    {
+        const std::string type = op["op"].get<std::string>();
+
+        auto findPlaylist = [&state](const std::string& name) -> PersistedPlaylist* {
+            auto it = state.playlists.find(name);
+            return (it != state.playlists.end()) ? &it->second : nullptr;
+        };
+
+        if (type == "create")
+        {
+            PersistedPlaylist playlist;
+            playlist.name = op["name"].get<std::string>();
+            LegacyCrossfadeFromJson(op, playlist.options);
+            OptionsFromJson(op["options"], playlist.options);
+            playlist.tracks = TracksFromJson(op["tracks"], state.trackSources);
+
+            // Les anciens journaux n'ont pas de position : la playlist va à la fin
+            if (state.playlists.find(playlist.name) == state.playlists.end())
+            {
+                const size_t index = std::min(op.value("index", state.order.size()), state.order.size());
+                state.order.insert(state.order.begin() + index, playlist.name);
+            }
+            state.playlists[playlist.name] = std::move(playlist);
+        }
+        else if (type == "delete")
+        {
+            const std::string name = op["name"].get<std::string>();
+            state.playlists.erase(name);
+            state.order.erase(std::remove(state.order.begin(), state.order.end(), name), state.order.end());
+        }
+        else if (type == "rename")
+        {
+            const std::string from = op["from"].get<std::string>();
+            const std::string to = op["to"].get<std::string>();
+            auto it = state.playlists.find(from);
+            if (it != state.playlists.end())
+            {
+                PersistedPlaylist playlist = std::move(it->second);
+                state.playlists.erase(it);
+                playlist.name = to;
+                state.playlists[to] = std::move(playlist);
+                std::replace(state.order.begin(), state.order.end(), from, to);
+            }
+        }
+        else if (type == "insert")
+        {
+            if (auto* playlist = findPlaylist(op["name"].get<std::string>()))
+            {
+                auto tracks = TracksFromJson(op["tracks"], state.trackSources);
+                size_t index = std::min(op["index"].get<size_t>(), playlist->tracks.size());
+                playlist->tracks.insert(playlist->tracks.begin() + index, tracks.begin(), tracks.end());
+            }
+        }
+        else if (type == "remove")
+        {
+            if (auto* playlist = findPlaylist(op["name"].get<std::string>()))
+            {
+                size_t index = std::min(op["index"].get<size_t>(), playlist->tracks.size());
+                size_t count = std::min(op["count"].get<size_t>(), playlist->tracks.size() - index);
+                playlist->tracks.erase(playlist->tracks.begin() + index, playlist->tracks.begin() + index + count);
+            }
+        }
+        else if (type == "move")
+        {
+            if (auto* playlist = findPlaylist(op["name"].get<std::string>()))
+            {
+                size_t from = op["from"].get<size_t>();
+                size_t to = op["to"].get<size_t>();
+                if (from < playlist->tracks.size() && to < playlist->tracks.size())
+                {
+                    TrackId track = playlist->tracks[from];
+                    playlist->tracks.erase(playlist->tracks.begin() + from);
+                    playlist->tracks.insert(playlist->tracks.begin() + to, track);
+                }
+            }
+        }
+        else if (type == "replace")
+        {
+            if (auto* playlist = findPlaylist(op["name"].get<std::string>()))
+            {
+                playlist->tracks = TracksFromJson(op["tracks"], state.trackSources);
+            }
+        }
+        else if (type == "options")
+        {
+            if (auto* playlist = findPlaylist(op["name"].get<std::string>()))
+            {
+                LegacyCrossfadeFromJson(op, playlist->options);
+                OptionsFromJson(op["options"], playlist->options);
+            }
+        }
+        else if (type == "reset")
+        {
+            state.playlists.clear();
+            state.order.clear();
+            for (const auto& p : op["playlists"])
+            {
+                PersistedPlaylist playlist;
+                playlist.name = p["name"].get<std::string>();
+                LegacyCrossfadeFromJson(p, playlist.options);
+                OptionsFromJson(p["options"], playlist.options);
+                playlist.tracks = TracksFromJson(p["tracks"], state.trackSources);
+                state.order.push_back(playlist.name);
+                state.playlists[playlist.name] = std::move(playlist);
+            }
+        }
+        else
+        {
+            spdlog::warn("Unknown playlist journal operation '{}'.", type);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Invalid playlist journal record {}: {}", sequence, e.what());
+    }
+
+    state.sequence = sequence;
+    return true;
+}
+
+bool PlaylistJournal::WriteSnapshot(const State& state) const
+{
+    LibrarySnapshotWriter writer;
+    writer.SetSequence(state.sequence);
+
+    for (const auto& name : state.order)
+    {
+        auto it = state.playlists.find(name);
+        if (it == state.playlists.end()) continue;
+
+        // Only tracks still referenced by a playlist are kept.
+        const PersistedPlaylist& playlist = it->second;
+        for (const auto& trackId : playlist.tracks)
+        {
+            auto sourceIt = state.trackSources.find(trackId);
+            if (sourceIt != state.trackSources.end())
+            {
+                writer.AddTrack(trackId.str(), sourceIt->second.path, sourceIt->second.lengthMs);
+            }
+        }
+        writer.AddPlaylist(playlist.name, playlist.options, playlist.tracks);
+    }
+
+    return writer.WriteToFile(m_snapshotPath);
+}
+
+bool PlaylistJournal::Compact()
+{
+    if (!WriteSnapshot(m_state))
+    {
+        return false;
+    }
+
+    // A crash before the truncation is harmless: replay skips records already in the snapshot.
+    if (m_journalFile)
+    {
+        std::fclose(m_journalFile);
+    }
+    m_journalFile = std::fopen(m_journalPath.c_str(), "wb");
+    if (!m_journalFile)
+    {
+        spdlog::error("Cannot reopen playlist journal '{}'.", m_journalPath);
+        return false;
+    }
+
+    spdlog::debug("Playlist journal compacted at sequence {} ({} records folded).",
+                  m_state.sequence, m_operationsSinceSnapshot);
+    m_operationsSinceSnapshot = 0;
+    return true;
+}
+
+} // namespace TSM
@@ -0,0 +1,115 @@
+// tsm_playlist_journal.h
+#pragma once
+
+#include "tsm_playlist_manager.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+namespace TSM
+{
+
+// Append-only persistence for PlaylistManager. Each change event becomes one JSON
+// line in the journal; a background thread group-commits pending lines with a single
+// fsync and periodically folds the journal into a binary LibrarySnapshot replaced by
+// atomic rename.
+class PlaylistJournal
+{
+public:
+    struct PersistedPlaylist
+    {
+        std::string name;
+        PlaylistOptions options;
+        std::vector<TrackId> tracks;
+    };
+
+    struct TrackSource
+    {
+        std::string path;
+        uint32_t lengthMs = 0;
+    };
+
+    static PlaylistJournal& GetInstance()
+    {
+        static PlaylistJournal instance;
+        return instance;
+    }
+
+    bool Open(const std::string& directory);
+    void Close();
+    bool IsOpen() const { return m_isOpen; }
+
+    // State read back from disk by Open(), before any new edit.
+    bool HasRecoveredState() const { return m_hasRecoveredState; }
+    const std::vector<PersistedPlaylist>& GetRecoveredPlaylists() const { return m_recovered; }
+    void ApplyRecoveredState();
+
+    // Blocks until every edit made so far is on disk.
+    void Flush();
+
+    void SetCompactionThreshold(size_t operations) { m_compactionThreshold = operations; }
+    uint64_t GetLastSequence() const { return m_nextSequence - 1; }
+
+    const std::string& GetJournalPath() const { return m_journalPath; }
+    const std::string& GetSnapshotPath() const { return m_snapshotPath; }
+
+private:
+    PlaylistJournal() = default;
+    ~PlaylistJournal() { StopWriter(); }
+    PlaylistJournal(const PlaylistJournal&) = delete;
+    PlaylistJournal& operator=(const PlaylistJournal&) = delete;
+
+    struct State
+    {
+        std::map<std::string, PersistedPlaylist> playlists;
+        std::vector<std::string> order;
+        std::map<TrackId, TrackSource, std::less<>> trackSources;
+        uint64_t sequence = 0;
+    };
+
+    void OnPlaylistChanges(const std::vector<PlaylistChangeEvent>& events);
+    void WriterLoop();
+    void StopWriter();
+
+    bool LoadSnapshot(State& state) const;
+    void ReplayJournal(State& state) const;
+    bool WriteSnapshot(const State& state) const;
+    bool Compact();
+    static bool ApplyOperation(State& state, const std::string& line);
+
+    bool m_isOpen = false;
+    std::string m_journalPath;
+    std::string m_snapshotPath;
+    std::FILE* m_journalFile = nullptr;
+
+    State m_state;                                  // owned by the writer thread while open
+    std::vector<PersistedPlaylist> m_recovered;
+    std::map<TrackId, TrackSource, std::less<>> m_recoveredSources;
+    bool m_hasRecoveredState = false;
+    bool m_applyingRecovery = false;
+
+    PlaylistManager::SubscriptionToken m_subscription = 0;
+    uint64_t m_nextSequence = 1;
+    size_t m_operationsSinceSnapshot = 0;
+    size_t m_compactionThreshold = 1000;
+
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeWriter;
+    std::condition_variable m_durable;
+    std::vector<std::string> m_pending;
+    uint64_t m_durableSequence = 0;
+    bool m_flushRequested = false;
+    bool m_stopRequested = false;
+
+    static constexpr std::chrono::milliseconds GroupCommitWindow{ 50 };
+};
+
+} // namespace TSM
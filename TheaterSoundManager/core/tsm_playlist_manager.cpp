@@ -2,8 +2,10 @@
 
 #include "tsm_playlist_manager.h"
 #include "tsm_audio_manager.h"
+#include "tsm_announcement_manager.h"
 #include "tsm_fmod_wrapper.h"
 #include "tsm_ui_manager.h"
+#include "tsm_playlist_import.h"
 #include <fstream>
 #include <spdlog/spdlog.h>
 #include <json/json.hpp>
@@ -11,17 +13,45 @@
 #include <random>
 #include <ctime>
 #include <cmath>
+#include <string_view>
+#include <climits>
+#include <set>
 
 namespace TSM
 {
     using json = nlohmann::json;
 
+namespace
+{
+    // Prefix counts over positions 0..size-1, each update and query in O(log n).
+    class FenwickTree
+    {
+    public:
+        explicit FenwickTree(size_t size) : m_tree(size + 1, 0) {}
+
+        void Add(size_t position, int64_t delta)
+        {
+            for (size_t i = position + 1; i < m_tree.size(); i += i & (~i + 1)) m_tree[i] += delta;
+        }
+
+        // Sum of the positions before `end`.
+        size_t Prefix(size_t end) const
+        {
+            int64_t sum = 0;
+            for (size_t i = std::min(end, m_tree.size() - 1); i > 0; i -= i & (~i + 1)) sum += m_tree[i];
+            return static_cast<size_t>(sum);
+        }
+
+    private:
+        std::vector<int64_t> m_tree;
+    };
+}
+
 void PlaylistManager::CreatePlaylist(const std::string& playlistName)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
+    Playlist* playlist = GetPlaylistByName(playlistName);
 
-    if (it == m_playlists.end())
+    if (!playlist)
     {
         Playlist newPlaylist;
         newPlaylist.name = playlistName;
@@ -32,9 +62,14 @@ void PlaylistManager::CreatePlaylist(const std::string& playlistName)
         newPlaylist.options.loopPlaylist = true;
         newPlaylist.options.segmentDuration = 900.0f;
         
-        m_playlists.push_back(newPlaylist);
+        PlaylistChangeEvent event;
+        event.type = PlaylistChangeType::Created;
+        event.playlist = AllocatePlaylist(std::move(newPlaylist));
+        event.playlistName = playlistName;
+        event.index = m_playlistOrder.size() - 1;
+
         spdlog::info("Playlist '{}' created.", playlistName);
-        NotifyPlaylistChanged();
+        EmitChange(std::move(event));
     }
     else
     {
@@ -44,25 +79,21 @@ void PlaylistManager::CreatePlaylist(const std::string& playlistName)
 
 void PlaylistManager::DeletePlaylist(const std::string& playlistName)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
+    Playlist* playlist = GetPlaylistByName(playlistName);
 
-    if (it != m_playlists.end())
+    if (playlist)
     {
-        if (it->isPlaying)
+        if (playlist->isPlaying)
         {
             Stop(playlistName);
         }
         
-        m_playlists.erase(it);
-        
-        if (m_activePlaylistName == playlistName)
-        {
-            m_activePlaylistName = "";
-        }
+        PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::Deleted, playlistName);
+
+        ReleasePlaylist(event.playlist);
         
         spdlog::info("Playlist '{}' deleted.", playlistName);
-        NotifyPlaylistChanged();
+        EmitChange(std::move(event));
     }
     else
     {
@@ -74,29 +105,28 @@ void PlaylistManager::RenamePlaylist(const std::string& oldName, const std::stri
 {
     if (oldName == newName) return;
     
-    auto existingNew = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&newName](const Playlist& p) { return p.name == newName; });
+    Playlist* existingNew = GetPlaylistByName(newName);
 
-    if (existingNew != m_playlists.end())
+    if (existingNew)
     {
         spdlog::error("Cannot rename playlist. Target name '{}' already exists.", newName);
         return;
     }
     
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&oldName](const Playlist& p) { return p.name == oldName; });
+    Playlist* playlist = GetPlaylistByName(oldName);
 
-    if (it != m_playlists.end())
+    if (playlist)
     {
-        it->name = newName;
-        
-        if (m_activePlaylistName == oldName)
-        {
-            m_activePlaylistName = newName;
-        }
+        PlaylistHandle handle = m_nameIndex[oldName];
+        m_nameIndex.erase(oldName);
+        m_nameIndex[newName] = handle;
+        playlist->name = newName;
         
+        PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::Renamed, newName);
+        event.previousName = oldName;
+
         spdlog::info("Playlist renamed from '{}' to '{}'.", oldName, newName);
-        NotifyPlaylistChanged();
+        EmitChange(std::move(event));
     }
     else
     {
@@ -106,47 +136,73 @@ void PlaylistManager::RenamePlaylist(const std::string& oldName, const std::stri
 
 void PlaylistManager::DuplicatePlaylist(const std::string& sourceName, const std::string& destName)
 {
-    auto sourceIt = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&sourceName](const Playlist& p) { return p.name == sourceName; });
+    Playlist* source = GetPlaylistByName(sourceName);
 
-    if (sourceIt == m_playlists.end())
+    if (!source)
     {
         spdlog::error("Source playlist '{}' not found.", sourceName);
         return;
     }
     
-    auto destIt = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&destName](const Playlist& p) { return p.name == destName; });
+    Playlist* dest = GetPlaylistByName(destName);
 
-    if (destIt != m_playlists.end())
+    if (dest)
     {
         spdlog::error("Destination playlist '{}' already exists.", destName);
         return;
     }
     
-    Playlist newPlaylist = *sourceIt;
+    // Seules la liste et les options sont copiées : canaux, file gapless et reprise restent à la source
+    Playlist newPlaylist;
     newPlaylist.name = destName;
-    newPlaylist.isPlaying = false;
-    newPlaylist.currentChannel = nullptr;
-    newPlaylist.nextChannel = nullptr;
-    newPlaylist.isCrossfading = false;
+    newPlaylist.tracks = source->tracks;
+    newPlaylist.options = source->options;
     
-    m_playlists.push_back(newPlaylist);
+    PlaylistChangeEvent event;
+    event.type = PlaylistChangeType::Created;
+    event.playlistName = destName;
+    event.tracks = newPlaylist.tracks.ToVector();
+    event.playlist = AllocatePlaylist(std::move(newPlaylist));
+    event.index = m_playlistOrder.size() - 1;
     
     spdlog::info("Playlist '{}' duplicated to '{}'.", sourceName, destName);
-    NotifyPlaylistChanged();
+    EmitChange(std::move(event));
 }
 
 void PlaylistManager::AddToPlaylist(const std::string& playlistName, const std::string& soundName)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
+    Playlist* playlist = GetPlaylistByName(playlistName);
+
+    if (playlist)
+    {
+        playlist->tracks.push_back(soundName);
+        spdlog::log(IsInBatch() ? spdlog::level::debug : spdlog::level::info,
+                    "Added '{}' to playlist '{}'.", soundName, playlistName);
+
+        PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TracksInserted, playlistName);
+        event.index = playlist->tracks.size() - 1;
+        event.tracks.push_back(soundName);
+        EmitChange(std::move(event));
+    }
+    else
+    {
+        spdlog::error("Playlist '{}' not found.", playlistName);
+    }
+}
+
+void PlaylistManager::AddTracksToPlaylist(const std::string& playlistName, const std::vector<std::string>& soundNames)
+{
+    Playlist* playlist = GetPlaylistByName(playlistName);
 
-    if (it != m_playlists.end())
+    if (playlist)
     {
-        it->tracks.push_back(soundName);
-        spdlog::info("Added '{}' to playlist '{}'.", soundName, playlistName);
-        NotifyPlaylistChanged();
+        PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TracksInserted, playlistName);
+        event.index = playlist->tracks.size();
+        event.tracks.assign(soundNames.begin(), soundNames.end());
+
+        playlist->tracks.insert(playlist->tracks.size(), event.tracks.begin(), event.tracks.end());
+        spdlog::info("Added {} tracks to playlist '{}'.", soundNames.size(), playlistName);
+        EmitChange(std::move(event));
     }
     else
     {
@@ -156,19 +212,23 @@ void PlaylistManager::AddToPlaylist(const std::string& playlistName, const std::
 
 void PlaylistManager::RemoveFromPlaylist(const std::string& playlistName, const std::string& soundName)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
+    Playlist* playlist = GetPlaylistByName(playlistName);
 
-    if (it != m_playlists.end())
+    if (playlist)
     {
-        auto& tracks = it->tracks;
+        auto& tracks = playlist->tracks;
         auto trackIt = std::find(tracks.begin(), tracks.end(), soundName);
         
         if (trackIt != tracks.end())
         {
-            tracks.erase(trackIt);
-            spdlog::info("Removed '{}' from playlist '{}'.", soundName, playlistName);
-            NotifyPlaylistChanged();
+            PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TracksRemoved, playlistName);
+            event.index = static_cast<size_t>(trackIt - tracks.begin());
+            event.tracks.push_back(soundName);
+
+            tracks.erase(event.index);
+            spdlog::log(IsInBatch() ? spdlog::level::debug : spdlog::level::info,
+                        "Removed '{}' from playlist '{}'.", soundName, playlistName);
+            EmitChange(std::move(event));
         }
         else
         {
@@ -183,17 +243,20 @@ void PlaylistManager::RemoveFromPlaylist(const std::string& playlistName, const
 
 void PlaylistManager::RemoveFromPlaylistAtIndex(const std::string& playlistName, size_t index)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
+    Playlist* playlist = GetPlaylistByName(playlistName);
 
-    if (it != m_playlists.end())
+    if (playlist)
     {
-        if (index < it->tracks.size())
+        if (index < playlist->tracks.size())
         {
-            std::string trackName = it->tracks[index];
-            it->tracks.erase(it->tracks.begin() + index);
-            spdlog::info("Removed track at index {} from playlist '{}'.", index, playlistName);
-            NotifyPlaylistChanged();
+            PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TracksRemoved, playlistName);
+            event.index = index;
+            event.tracks.push_back(playlist->tracks[index]);
+
+            playlist->tracks.erase(index);
+            spdlog::log(IsInBatch() ? spdlog::level::debug : spdlog::level::info,
+                        "Removed track at index {} from playlist '{}'.", index, playlistName);
+            EmitChange(std::move(event));
         }
         else
         {
@@ -208,19 +271,22 @@ void PlaylistManager::RemoveFromPlaylistAtIndex(const std::string& playlistName,
 
 void PlaylistManager::ClearPlaylist(const std::string& playlistName)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
+    Playlist* playlist = GetPlaylistByName(playlistName);
 
-    if (it != m_playlists.end())
+    if (playlist)
     {
-        if (it->isPlaying)
+        if (playlist->isPlaying)
         {
             Stop(playlistName);
         }
         
-        it->tracks.clear();
+        PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TracksRemoved, playlistName);
+        event.index = 0;
+        event.tracks = playlist->tracks.ToVector();
+
+        playlist->tracks.clear();
         spdlog::info("Cleared all tracks from playlist '{}'.", playlistName);
-        NotifyPlaylistChanged();
+        EmitChange(std::move(event));
     }
     else
     {
@@ -228,12 +294,256 @@ void PlaylistManager::ClearPlaylist(const std::string& playlistName)
     }
 }
 
+bool PlaylistManager::ReconcilePlaylist(const std::string& playlistName, const std::vector<std::string>& tracks)
+{
+    Playlist* playlist = GetPlaylistByName(playlistName);
+    if (!playlist)
+    {
+        spdlog::error("Playlist '{}' not found.", playlistName);
+        return false;
+    }
+
+    IndexedSequence<TrackId>& current = playlist->tracks;
+    const std::vector<TrackId> previous = current.ToVector();
+    const size_t oldSize = previous.size();
+
+    // Each occurrence is its own entry: the n-th copy of a track in the old list matches
+    // the n-th copy in the new one.
+    std::unordered_map<TrackId, std::vector<size_t>> newPositions;
+    for (size_t i = 0; i < tracks.size(); i++)
+    {
+        newPositions[tracks[i]].push_back(i);
+    }
+
+    std::vector<int64_t> target(oldSize, -1);       // old index -> new index, -1 if removed
+    {
+        std::unordered_map<TrackId, size_t> occurrences;
+        for (size_t i = 0; i < oldSize; i++)
+        {
+            auto it = newPositions.find(previous[i]);
+            if (it == newPositions.end()) continue;
+            size_t& n = occurrences[it->first];
+            if (n < it->second.size()) target[i] = static_cast<int64_t>(it->second[n++]);
+        }
+    }
+
+    // Longest increasing run of targets: those entries are already in order and never move.
+    std::vector<bool> stays(oldSize, false);
+    {
+        std::vector<size_t> tails;                  // old index ending the best run of each length
+        std::vector<int64_t> previous(oldSize, -1);
+        for (size_t i = 0; i < oldSize; i++)
+        {
+            if (target[i] < 0) continue;
+            auto it = std::lower_bound(tails.begin(), tails.end(), target[i],
+                [&target](size_t index, int64_t value) { return target[index] < value; });
+            if (it != tails.begin()) previous[i] = static_cast<int64_t>(*(it - 1));
+            if (it == tails.end()) tails.push_back(i);
+            else *it = i;
+        }
+        for (int64_t i = tails.empty() ? -1 : static_cast<int64_t>(tails.back()); i >= 0; i = previous[i])
+        {
+            stays[i] = true;
+        }
+    }
+
+    const int playingIndex = playlist->isPlaying ? playlist->currentIndex : -1;
+    size_t removedCount = 0;
+    size_t movedCount = 0;
+    size_t insertedCount = 0;
+
+    BatchScope batch;
+
+    // 1. Removals, from the end so the indices of the events stay valid in order.
+    for (size_t end = oldSize; end > 0;)
+    {
+        if (target[end - 1] >= 0) { end--; continue; }
+
+        size_t begin = end - 1;
+        while (begin > 0 && target[begin - 1] < 0) begin--;
+
+        PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TracksRemoved, playlistName);
+        event.index = begin;
+        event.tracks.assign(previous.begin() + begin, previous.begin() + end);
+        current.erase(begin, end - begin);
+        removedCount += end - begin;
+        EmitChange(std::move(event));
+        end = begin;
+    }
+
+    // Survivors by their position once the removals are done.
+    std::vector<int64_t> targets;
+    std::vector<bool> placed;
+    targets.reserve(oldSize - removedCount);
+    placed.reserve(oldSize - removedCount);
+    for (size_t i = 0; i < oldSize; i++)
+    {
+        if (target[i] < 0) continue;
+        targets.push_back(target[i]);
+        placed.push_back(stays[i]);
+    }
+    const size_t survivors = targets.size();
+
+    // 2. Moves, by increasing destination: each entry goes right after the last placed entry
+    // that precedes it in the new list. Placed entries stay in destination order, and each
+    // sits right after the entry that stayed at or before it (its anchor), so positions are
+    // counted in O(log n): the waiting movers before a survivor position, the placed entries
+    // anchored before it, and the placed entries with a smaller destination.
+    std::vector<size_t> survivorAt(tracks.size(), 0);   // destination -> survivor position
+    std::vector<int64_t> anchorOf(tracks.size(), -1);   // destination -> anchor survivor position, -1 for the front
+    FenwickTree waiting(survivors);
+    FenwickTree anchored(survivors + 1);                 // shifted by one for the front
+    FenwickTree placedDestinations(tracks.size());
+    std::set<int64_t> placedSet;
+    std::vector<int64_t> movers;
+    for (size_t k = 0; k < survivors; k++)
+    {
+        survivorAt[targets[k]] = k;
+        if (placed[k])
+        {
+            anchorOf[targets[k]] = static_cast<int64_t>(k);
+            anchored.Add(k + 1, 1);
+            placedDestinations.Add(static_cast<size_t>(targets[k]), 1);
+            placedSet.insert(targets[k]);
+        }
+        else
+        {
+            waiting.Add(k, 1);
+            movers.push_back(targets[k]);
+        }
+    }
+    std::sort(movers.begin(), movers.end());
+
+    for (int64_t destination : movers)
+    {
+        const size_t k = survivorAt[destination];
+        const size_t from = waiting.Prefix(k) + anchored.Prefix(k + 1);
+        waiting.Add(k, -1);
+
+        auto after = placedSet.lower_bound(destination);
+        const int64_t anchor = after == placedSet.begin() ? -1 : anchorOf[*std::prev(after)];
+        const size_t to = (anchor < 0 ? 0 : waiting.Prefix(static_cast<size_t>(anchor))) +
+                          placedDestinations.Prefix(static_cast<size_t>(destination));
+
+        current.move(from, to);
+        anchorOf[destination] = anchor;
+        anchored.Add(static_cast<size_t>(anchor + 1), 1);
+        placedDestinations.Add(static_cast<size_t>(destination), 1);
+        placedSet.insert(destination);
+        movedCount++;
+
+        if (from != to)
+        {
+            PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TrackMoved, playlistName);
+            event.fromIndex = from;
+            event.toIndex = to;
+            EmitChange(std::move(event));
+        }
+    }
+
+    // 3. Inserts: the survivors are now in destination order and every entry before j is in
+    // place, so new tracks go straight to their index.
+    size_t nextSurvivor = 0;
+    auto survivorEnd = placedSet.begin();
+    for (size_t j = 0; j < tracks.size();)
+    {
+        if (nextSurvivor < survivors && *survivorEnd == static_cast<int64_t>(j))
+        {
+            ++survivorEnd;
+            nextSurvivor++;
+            j++;
+            continue;
+        }
+
+        // The run ends at the next surviving entry, or at the end of the list.
+        const size_t end = nextSurvivor < survivors ? static_cast<size_t>(*survivorEnd) : tracks.size();
+
+        PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TracksInserted, playlistName);
+        event.index = j;
+        event.tracks.assign(tracks.begin() + j, tracks.begin() + end);
+        current.insert(j, event.tracks.begin(), event.tracks.end());
+        insertedCount += end - j;
+        EmitChange(std::move(event));
+        j = end;
+    }
+
+    // The playing entry keeps its channel; only the indices pointing at it change.
+    if (playingIndex >= 0)
+    {
+        if (current.empty())
+        {
+            Stop(playlistName);
+        }
+        else
+        {
+            const bool playingKept = playingIndex < static_cast<int>(oldSize) && target[playingIndex] >= 0;
+            playlist->currentIndex = playingKept ? static_cast<int>(target[playingIndex]) : -1;
+
+            if (!playlist->randomIndices.empty())
+            {
+                std::vector<bool> scheduled(current.size(), false);
+                std::vector<int> order;
+                std::vector<int> upcoming;
+                for (size_t pos = 0; pos < playlist->randomIndices.size(); pos++)
+                {
+                    const int oldIndex = playlist->randomIndices[pos];
+                    if (oldIndex < 0 || oldIndex >= static_cast<int>(oldSize) || target[oldIndex] < 0) continue;
+
+                    const int mapped = static_cast<int>(target[oldIndex]);
+                    scheduled[mapped] = true;
+                    (static_cast<int>(pos) <= playlist->randomIndexPos ? order : upcoming).push_back(mapped);
+                }
+                for (size_t i = 0; i < current.size(); i++)
+                {
+                    if (!scheduled[i]) upcoming.push_back(static_cast<int>(i));
+                }
+                std::shuffle(upcoming.begin(), upcoming.end(), m_rng);
+
+                playlist->randomIndexPos = static_cast<int>(order.size()) - 1;
+                order.insert(order.end(), upcoming.begin(), upcoming.end());
+                playlist->randomIndices = std::move(order);
+            }
+
+            // Le morceau en cours a été retiré : il s'efface et celui qui le suivait démarre
+            if (!playingKept)
+            {
+                int following = -1;
+                if (playlist->playback.randomOrder && !playlist->randomIndices.empty())
+                {
+                    following = GetFollowingIndex(*playlist);
+                    if (following >= 0) playlist->randomIndexPos++;
+                }
+                else
+                {
+                    for (size_t i = static_cast<size_t>(playingIndex) + 1; i < oldSize && following < 0; i++)
+                    {
+                        if (target[i] >= 0) following = static_cast<int>(target[i]);
+                    }
+                    if (following < 0 && playlist->playback.loopPlaylist) following = 0;
+                }
+
+                if (following < 0)
+                {
+                    Stop(playlistName);
+                }
+                else
+                {
+                    SwitchPlayingTrack(*playlist, following);
+                }
+            }
+        }
+    }
+
+    spdlog::info("Reconciled playlist '{}': {} removed, {} moved, {} inserted, {} kept.",
+                 playlistName, removedCount, movedCount, insertedCount, oldSize - removedCount - movedCount);
+    return true;
+}
+
 bool PlaylistManager::ExportPlaylist(const std::string& playlistName, const std::string& filePath)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
+    Playlist* playlist = GetPlaylistByName(playlistName);
 
-    if (it == m_playlists.end())
+    if (!playlist)
     {
         spdlog::error("Playlist '{}' not found for export.", playlistName);
         return false;
@@ -242,17 +552,21 @@ bool PlaylistManager::ExportPlaylist(const std::string& playlistName, const std:
     try
     {
         json j;
-        j["name"] = it->name;
-        j["options"]["randomOrder"] = it->options.randomOrder;
-        j["options"]["randomSegment"] = it->options.randomSegment;
-        j["options"]["segmentDuration"] = it->options.segmentDuration;
-        j["options"]["loopPlaylist"] = it->options.loopPlaylist;
+        j["name"] = playlist->name;
+        j["options"]["randomOrder"] = playlist->options.randomOrder;
+        j["options"]["randomSegment"] = playlist->options.randomSegment;
+        j["options"]["segmentDuration"] = playlist->options.segmentDuration;
+        j["options"]["loopPlaylist"] = playlist->options.loopPlaylist;
+        j["options"]["crossfadeDuration"] = playlist->options.crossfadeDuration;
+        j["options"]["crossfadeCurve"] = GetCrossfadeCurveKey(playlist->options.crossfadeCurve);
+        j["options"]["crossfadeShape"] = playlist->options.crossfadeShape;
+        j["options"]["gapless"] = playlist->options.gapless;
         j["tracks"] = json::array();
         
         const auto& audioManager = AudioManager::GetInstance();
         const auto& allSounds = audioManager.GetAllSounds();
         
-        for (const auto& trackId : it->tracks)
+        for (const auto& trackId : playlist->tracks)
         {
             json track;
             track["id"] = trackId;
@@ -288,110 +602,110 @@ bool PlaylistManager::ExportPlaylist(const std::string& playlistName, const std:
 
 bool PlaylistManager::ImportPlaylist(const std::string& filePath, const std::string& playlistName)
 {
-    try
+    return PlaylistImporter::GetInstance().ImportPlaylist(filePath, playlistName);
+}
+
+PlaylistManager::Playlist* PlaylistManager::GetPlaylistByName(const std::string& name)
+{
+    return GetPlaylist(GetPlaylistHandle(name));
+}
+
+PlaylistHandle PlaylistManager::GetPlaylistHandle(const std::string& name) const
+{
+    auto found = m_nameIndex.find(name);
+    return (found != m_nameIndex.end()) ? found->second : PlaylistHandle{};
+}
+
+PlaylistManager::Playlist* PlaylistManager::GetPlaylist(PlaylistHandle handle)
+{
+    if (handle.index >= m_slots.size()) return nullptr;
+    PlaylistSlot& slot = m_slots[handle.index];
+    return (slot.occupied && slot.generation == handle.generation) ? &slot.playlist : nullptr;
+}
+
+const PlaylistManager::Playlist* PlaylistManager::GetPlaylist(PlaylistHandle handle) const
+{
+    if (handle.index >= m_slots.size()) return nullptr;
+    const PlaylistSlot& slot = m_slots[handle.index];
+    return (slot.occupied && slot.generation == handle.generation) ? &slot.playlist : nullptr;
+}
+
+std::vector<const PlaylistManager::Playlist*> PlaylistManager::GetAllPlaylists() const
+{
+    std::vector<const Playlist*> playlists;
+    playlists.reserve(m_playlistOrder.size());
+
+    for (const auto& handle : m_playlistOrder)
     {
-        std::ifstream file(filePath.c_str());
-        if (!file.is_open())
-        {
-            spdlog::error("Failed to open file '{}' for reading.", filePath);
-            return false;
-        }
-        
-        json j;
-        file >> j;
-        file.close();
-        
-        std::string importedName = playlistName.empty() ? j["name"].get<std::string>() : playlistName;
-        
-        auto existingIt = std::find_if(m_playlists.begin(), m_playlists.end(),
-            [&importedName](const Playlist& p) { return p.name == importedName; });
-            
-        if (existingIt != m_playlists.end())
-        {
-            spdlog::warn("Playlist '{}' already exists. It will be overwritten.", importedName);
-            existingIt->tracks.clear();
-        }
-        else
+        if (const Playlist* playlist = GetPlaylist(handle))
         {
-            CreatePlaylist(importedName);
-            existingIt = std::find_if(m_playlists.begin(), m_playlists.end(),
-                [&importedName](const Playlist& p) { return p.name == importedName; });
-        }
-        
-        if (existingIt != m_playlists.end())
-        {
-            // Options par défaut
-            existingIt->options.randomOrder = true;
-            existingIt->options.randomSegment = true;
-            existingIt->options.loopPlaylist = true;
-            existingIt->options.segmentDuration = 900.0f;
-            
-            // Remplacer par les options du fichier si elles existent
-            if (j.contains("options"))
-            {
-                const auto& options = j["options"];
-                if (options.contains("randomOrder"))
-                    existingIt->options.randomOrder = options["randomOrder"].get<bool>();
-                if (options.contains("randomSegment"))
-                    existingIt->options.randomSegment = options["randomSegment"].get<bool>();
-                if (options.contains("segmentDuration"))
-                    existingIt->options.segmentDuration = options["segmentDuration"].get<float>();
-                if (options.contains("loopPlaylist"))
-                    existingIt->options.loopPlaylist = options["loopPlaylist"].get<bool>();
-            }
-            
-            auto& audioManager = AudioManager::GetInstance();
-            
-            for (const auto& trackJson : j["tracks"])
-            {
-                std::string trackId = trackJson["id"].get<std::string>();
-                
-                if (!audioManager.GetSound(trackId) && trackJson.contains("path"))
-                {
-                    std::string trackPath = trackJson["path"].get<std::string>();
-                    audioManager.LoadSound(trackId, trackPath, true);
-                }
-                
-                if (audioManager.GetSound(trackId))
-                {
-                    existingIt->tracks.push_back(trackId);
-                }
-                else
-                {
-                    spdlog::warn("Track '{}' could not be loaded during import. Skipping.", trackId);
-                }
-            }
-            
-            spdlog::info("Playlist '{}' imported from '{}' with {} tracks.", 
-                        importedName, filePath, existingIt->tracks.size());
-            NotifyPlaylistChanged();
-            return true;
+            playlists.push_back(playlist);
         }
     }
-    catch(const std::exception& e)
+
+    return playlists;
+}
+
+PlaylistHandle PlaylistManager::AllocatePlaylist(Playlist&& playlist)
+{
+    uint32_t index;
+    if (!m_freeSlots.empty())
     {
-        spdlog::error("Error importing playlist: {}", e.what());
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
     }
-    
-    return false;
+    else
+    {
+        index = static_cast<uint32_t>(m_slots.size());
+        m_slots.emplace_back();
+    }
+
+    PlaylistSlot& slot = m_slots[index];
+    slot.playlist = std::move(playlist);
+    slot.occupied = true;
+
+    PlaylistHandle handle{ index, slot.generation };
+    m_nameIndex[slot.playlist.name] = handle;
+    slot.orderIndex = m_playlistOrder.size();
+    m_playlistOrder.push_back(handle);
+    return handle;
 }
 
-PlaylistManager::Playlist* PlaylistManager::GetPlaylistByName(const std::string& name)
+void PlaylistManager::ReleasePlaylist(PlaylistHandle handle)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&name](const Playlist& p) { return p.name == name; });
-    
-    return (it != m_playlists.end()) ? &(*it) : nullptr;
+    Playlist* playlist = GetPlaylist(handle);
+    if (!playlist) return;
+
+    PlaylistSlot& slot = m_slots[handle.index];
+    m_nameIndex.erase(playlist->name);
+    m_playlistOrder.erase(m_playlistOrder.begin() + slot.orderIndex);
+    for (size_t i = slot.orderIndex; i < m_playlistOrder.size(); i++)
+    {
+        m_slots[m_playlistOrder[i].index].orderIndex = i;
+    }
+
+    slot.playlist = Playlist();
+    slot.occupied = false;
+    slot.generation++;
+    m_freeSlots.push_back(handle.index);
+
+    for (auto& zone : m_zones)
+    {
+        if (zone.activePlaylist == handle)
+        {
+            zone.activePlaylist = PlaylistHandle{};
+        }
+    }
 }
 
 std::vector<std::string> PlaylistManager::GetPlaylistNames() const
 {
     std::vector<std::string> names;
-    names.reserve(m_playlists.size());
+    names.reserve(m_playlistOrder.size());
     
-    for (const auto& playlist : m_playlists)
+    for (const auto& handle : m_playlistOrder)
     {
-        names.push_back(playlist.name);
+        names.push_back(GetPlaylist(handle)->name);
     }
     
     return names;
@@ -399,32 +713,29 @@ std::vector<std::string> PlaylistManager::GetPlaylistNames() const
 
 bool PlaylistManager::IsPlaylistPlaying(const std::string& playlistName) const
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
+    const Playlist* playlist = GetPlaylistByName(playlistName);
     
-    return (it != m_playlists.end() && it->isPlaying);
+    return (playlist && playlist->isPlaying);
 }
 
 size_t PlaylistManager::GetPlaylistTrackCount(const std::string& playlistName) const
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
+    const Playlist* playlist = GetPlaylistByName(playlistName);
     
-    return (it != m_playlists.end()) ? it->tracks.size() : 0;
+    return playlist ? playlist->tracks.size() : 0;
 }
 
 void PlaylistManager::MoveTrackToPosition(const std::string& playlistName, int sourceIndex, int targetIndex)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
+    Playlist* playlist = GetPlaylistByName(playlistName);
     
-    if (it == m_playlists.end())
+    if (!playlist)
     {
         spdlog::error("Playlist '{}' not found.", playlistName);
         return;
     }
     
-    auto& tracks = it->tracks;
+    auto& tracks = playlist->tracks;
     
     if (sourceIndex < 0 || sourceIndex >= static_cast<int>(tracks.size()) ||
         targetIndex < 0 || targetIndex >= static_cast<int>(tracks.size()))
@@ -438,20 +749,17 @@ void PlaylistManager::MoveTrackToPosition(const std::string& playlistName, int s
         return;
     }
     
-    std::string trackToMove = tracks[sourceIndex];
-    
-    tracks.erase(tracks.begin() + sourceIndex);
-    
-    if (targetIndex > sourceIndex)
-    {
-        targetIndex--;
-    }
-    
-    tracks.insert(tracks.begin() + targetIndex, trackToMove);
+    // targetIndex is the position of the track once moved.
+    tracks.move(static_cast<size_t>(sourceIndex), static_cast<size_t>(targetIndex));
     
-    spdlog::info("Moved track from index {} to index {} in playlist '{}'.", 
+    spdlog::log(IsInBatch() ? spdlog::level::debug : spdlog::level::info,
+                "Moved track from index {} to index {} in playlist '{}'.", 
                 sourceIndex, targetIndex, playlistName);
-    NotifyPlaylistChanged();
+
+    PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TrackMoved, playlistName);
+    event.fromIndex = static_cast<size_t>(sourceIndex);
+    event.toIndex = static_cast<size_t>(targetIndex);
+    EmitChange(std::move(event));
 }
 
 bool PlaylistManager::SavePlaylistsToFile(const std::string& filePath)
@@ -460,14 +768,19 @@ bool PlaylistManager::SavePlaylistsToFile(const std::string& filePath)
     {
         json j = json::array();
         
-        for (const auto& playlist : m_playlists)
+        for (const Playlist* playlistPtr : GetAllPlaylists())
         {
+            const Playlist& playlist = *playlistPtr;
             json playlistJson;
             playlistJson["name"] = playlist.name;
             playlistJson["options"]["randomOrder"] = playlist.options.randomOrder;
             playlistJson["options"]["randomSegment"] = playlist.options.randomSegment;
             playlistJson["options"]["segmentDuration"] = playlist.options.segmentDuration;
             playlistJson["options"]["loopPlaylist"] = playlist.options.loopPlaylist;
+            playlistJson["options"]["crossfadeDuration"] = playlist.options.crossfadeDuration;
+            playlistJson["options"]["crossfadeCurve"] = GetCrossfadeCurveKey(playlist.options.crossfadeCurve);
+            playlistJson["options"]["crossfadeShape"] = playlist.options.crossfadeShape;
+            playlistJson["options"]["gapless"] = playlist.options.gapless;
             playlistJson["tracks"] = json::array();
             
             const auto& audioManager = AudioManager::GetInstance();
@@ -512,134 +825,652 @@ bool PlaylistManager::SavePlaylistsToFile(const std::string& filePath)
 
 bool PlaylistManager::LoadPlaylistsFromFile(const std::string& filePath)
 {
-    try
-    {
-        std::ifstream file(filePath.c_str());
-        if (!file.is_open())
-        {
-            spdlog::error("Failed to open file '{}' for reading.", filePath);
-            return false;
-        }
-        
-        json j;
-        file >> j;
-        file.close();
-        
-        std::vector<Playlist> newPlaylists;
-        
-        auto& audioManager = AudioManager::GetInstance();
-        
-        for (const auto& playlistJson : j)
-        {
-            Playlist playlist;
-            playlist.name = playlistJson["name"].get<std::string>();
-            
-            // Options par défaut
-            playlist.options.randomOrder = true;
-            playlist.options.randomSegment = true;
-            playlist.options.loopPlaylist = true;
-            playlist.options.segmentDuration = 900.0f;
-            
-            // Remplacer par les options du fichier si elles existent
-            if (playlistJson.contains("options"))
-            {
-                const auto& options = playlistJson["options"];
-                if (options.contains("randomOrder"))
-                    playlist.options.randomOrder = options["randomOrder"].get<bool>();
-                if (options.contains("randomSegment"))
-                    playlist.options.randomSegment = options["randomSegment"].get<bool>();
-                if (options.contains("segmentDuration"))
-                    playlist.options.segmentDuration = options["segmentDuration"].get<float>();
-                if (options.contains("loopPlaylist"))
-                    playlist.options.loopPlaylist = options["loopPlaylist"].get<bool>();
-            }
-            
-            for (const auto& trackJson : playlistJson["tracks"])
-            {
-                std::string trackId = trackJson["id"].get<std::string>();
-                
-                if (!audioManager.GetSound(trackId) && trackJson.contains("path"))
-                {
-                    std::string trackPath = trackJson["path"].get<std::string>();
-                    audioManager.LoadSound(trackId, trackPath, true);
-                }
-                
-                if (audioManager.GetSound(trackId))
-                {
-                    playlist.tracks.push_back(trackId);
-                }
-                else
-                {
-                    spdlog::warn("Track '{}' in playlist '{}' could not be loaded. Skipping.", 
-                                trackId, playlist.name);
-                }
-            }
-            
-            newPlaylists.push_back(playlist);
-        }
-        
-        m_playlists = newPlaylists;
-        m_activePlaylistName = "";
-        
-        spdlog::info("Loaded {} playlists from '{}'.", m_playlists.size(), filePath);
-        NotifyPlaylistChanged();
-        return true;
-    }
-    catch(const std::exception& e)
-    {
-        spdlog::error("Error loading playlists: {}", e.what());
-        return false;
-    }
+    return PlaylistImporter::GetInstance().LoadAllPlaylists(filePath);
 }
 
-void PlaylistManager::RegisterPlaylistChangeCallback(PlaylistChangeCallback callback)
+PlaylistManager::SubscriptionToken PlaylistManager::RegisterPlaylistChangeCallback(PlaylistChangeCallback callback)
 {
-    m_changeCallbacks.push_back(callback);
+    SubscriptionToken token = m_nextSubscriptionToken++;
+    m_changeCallbacks.emplace_back(token, std::move(callback));
+    return token;
 }
 
-void PlaylistManager::NotifyPlaylistChanged()
+void PlaylistManager::UnregisterPlaylistChangeCallback(SubscriptionToken token)
 {
-    for (const auto& callback : m_changeCallbacks)
-    {
-        callback();
-    }
+    m_changeCallbacks.erase(
+        std::remove_if(m_changeCallbacks.begin(), m_changeCallbacks.end(),
+            [token](const auto& entry) { return entry.first == token; }),
+        m_changeCallbacks.end());
 }
 
-void PlaylistManager::Play(const std::string& playlistName, const PlaylistOptions& options)
+void PlaylistManager::SetPlaylistOptions(const std::string& playlistName, const PlaylistOptions& options)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
-
-    if (it == m_playlists.end())
+    Playlist* playlist = GetPlaylistByName(playlistName);
+    if (!playlist)
     {
         spdlog::error("Playlist '{}' not found.", playlistName);
         return;
     }
 
-    Playlist& plist = *it;
-    if (plist.tracks.empty())
+    playlist->options = options;
+    EmitChange(MakeChangeEvent(PlaylistChangeType::OptionsChanged, playlistName));
+}
+
+void PlaylistManager::SetPlaylistCrossfadeDuration(const std::string& playlistName, float duration)
+{
+    Playlist* playlist = GetPlaylistByName(playlistName);
+    if (!playlist)
     {
-        spdlog::error("Playlist '{}' is empty.", playlistName);
+        spdlog::error("Playlist '{}' not found.", playlistName);
         return;
     }
 
-    Stop(m_activePlaylistName);
-    
-    m_activePlaylistName = playlistName;
-    plist.options = options;
-    plist.isPlaying = true;
+    playlist->options.crossfadeDuration = duration;
+    EmitChange(MakeChangeEvent(PlaylistChangeType::OptionsChanged, playlistName));
+}
 
-    if (options.randomOrder)
+void PlaylistManager::SetPlaylistCrossfadeCurve(const std::string& playlistName, CrossfadeCurve curve, float shape)
+{
+    Playlist* playlist = GetPlaylistByName(playlistName);
+    if (!playlist)
     {
-        PrepareRandomOrder(plist);
-        plist.randomIndexPos = 0;
-        plist.currentIndex = plist.randomIndices[0];
+        spdlog::error("Playlist '{}' not found.", playlistName);
+        return;
     }
-    else
+
+    playlist->options.crossfadeCurve = curve;
+    playlist->options.crossfadeShape = shape;
+    EmitChange(MakeChangeEvent(PlaylistChangeType::OptionsChanged, playlistName));
+}
+
+void PlaylistManager::BeginBatch()
+{
+    m_batchDepth++;
+}
+
+void PlaylistManager::EndBatch()
+{
+    if (m_batchDepth == 0)
+    {
+        spdlog::warn("EndBatch called without a matching BeginBatch.");
+        return;
+    }
+
+    if (--m_batchDepth > 0) return;
+
+    if (!m_pendingEvents.empty())
+    {
+        std::vector<PlaylistChangeEvent> events;
+        events.swap(m_pendingEvents);
+        CommitHistoryStep(events);
+        spdlog::debug("Playlist batch applied ({} events).", events.size());
+        DispatchChanges(events);
+    }
+}
+
+PlaylistChangeEvent PlaylistManager::MakeChangeEvent(PlaylistChangeType type, const std::string& playlistName) const
+{
+    PlaylistChangeEvent event;
+    event.type = type;
+    event.playlist = GetPlaylistHandle(playlistName);
+    event.playlistName = playlistName;
+    return event;
+}
+
+void PlaylistManager::EmitChange(PlaylistChangeEvent&& event)
+{
+    if (m_batchDepth == 0)
+    {
+        std::vector<PlaylistChangeEvent> events;
+        events.push_back(std::move(event));
+        CommitHistoryStep(events);
+        DispatchChanges(events);
+        return;
+    }
+
+    // Appends to the end of the same playlist extend the previous insert event.
+    if (!m_pendingEvents.empty() && event.type == PlaylistChangeType::TracksInserted)
+    {
+        PlaylistChangeEvent& last = m_pendingEvents.back();
+        if (last.type == PlaylistChangeType::TracksInserted && last.playlist == event.playlist &&
+            last.index + last.tracks.size() == event.index)
+        {
+            last.tracks.insert(last.tracks.end(),
+                std::make_move_iterator(event.tracks.begin()), std::make_move_iterator(event.tracks.end()));
+            return;
+        }
+    }
+
+    m_pendingEvents.push_back(std::move(event));
+}
+
+LibraryVersion PlaylistManager::CaptureVersion() const
+{
+    std::vector<PlaylistVersion> playlists;
+    playlists.reserve(m_playlistOrder.size());
+    for (const auto* playlist : GetAllPlaylists())
+    {
+        playlists.push_back({ playlist->name, playlist->tracks, playlist->options });
+    }
+    return LibraryVersion(playlists.begin(), playlists.end());
+}
+
+void PlaylistManager::CommitHistoryStep(const std::vector<PlaylistChangeEvent>& events)
+{
+    m_undoStack.push_back(m_committedVersion);
+    while (m_undoStack.size() > m_historyLimit)
+    {
+        m_undoStack.pop_front();
+    }
+    m_redoStack.clear();
+
+    // Les playlists créées ou supprimées décalent l'ordre : la version est refaite, comme
+    // m_playlistOrder. Sinon seules les playlists touchées par les événements sont recopiées.
+    const bool orderChanged = std::any_of(events.begin(), events.end(), [](const PlaylistChangeEvent& event) {
+        return event.type == PlaylistChangeType::Created || event.type == PlaylistChangeType::Deleted ||
+               event.type == PlaylistChangeType::Reloaded;
+    });
+    if (orderChanged)
+    {
+        m_committedVersion = CaptureVersion();
+        return;
+    }
+
+    std::vector<PlaylistHandle> touched;
+    for (const auto& event : events)
+    {
+        const Playlist* playlist = GetPlaylist(event.playlist);
+        if (!playlist || std::find(touched.begin(), touched.end(), event.playlist) != touched.end()) continue;
+
+        touched.push_back(event.playlist);
+        m_committedVersion.set(m_slots[event.playlist.index].orderIndex,
+                               { playlist->name, playlist->tracks, playlist->options });
+    }
+}
+
+bool PlaylistManager::Undo()
+{
+    if (IsInBatch())
+    {
+        spdlog::warn("Undo is not available while a batch of playlist edits is open.");
+        return false;
+    }
+    if (m_undoStack.empty()) return false;
+
+    LibraryVersion version = std::move(m_undoStack.back());
+    m_undoStack.pop_back();
+    m_redoStack.push_back(m_committedVersion);
+
+    RestoreVersion(version);
+    spdlog::info("Playlist edit undone ({} steps left).", m_undoStack.size());
+    return true;
+}
+
+bool PlaylistManager::Redo()
+{
+    if (IsInBatch())
+    {
+        spdlog::warn("Redo is not available while a batch of playlist edits is open.");
+        return false;
+    }
+    if (m_redoStack.empty()) return false;
+
+    LibraryVersion version = std::move(m_redoStack.back());
+    m_redoStack.pop_back();
+    m_undoStack.push_back(m_committedVersion);
+
+    RestoreVersion(version);
+    spdlog::info("Playlist edit redone ({} steps left).", m_redoStack.size());
+    return true;
+}
+
+void PlaylistManager::ClearHistory()
+{
+    m_undoStack.clear();
+    m_redoStack.clear();
+    m_committedVersion = CaptureVersion();
+}
+
+void PlaylistManager::SetHistoryLimit(size_t steps)
+{
+    m_historyLimit = steps;
+    while (m_undoStack.size() > m_historyLimit)
+    {
+        m_undoStack.pop_front();
+    }
+}
+
+// Listeners only get events for the playlists that differ between the two versions;
+// playlists the step did not touch share their tracks and options, and are left out.
+void PlaylistManager::RestoreVersion(const LibraryVersion& version)
+{
+    std::vector<const PlaylistVersion*> playlists;
+    std::unordered_map<std::string_view, const PlaylistVersion*> wanted;
+    playlists.reserve(version.size());
+    version.ForEach([&](const PlaylistVersion& playlist) {
+        playlists.push_back(&playlist);
+        wanted[playlist.name] = &playlist;
+    });
+
+    std::vector<PlaylistChangeEvent> events;
+    for (const auto& name : GetPlaylistNames())
+    {
+        if (wanted.find(name) == wanted.end())
+        {
+            StopPlaylist(*GetPlaylistByName(name));
+            events.push_back(MakeChangeEvent(PlaylistChangeType::Deleted, name));
+            ReleasePlaylist(events.back().playlist);
+        }
+    }
+
+    // Les playlists gardent leur ordre relatif d'une version à l'autre : recréées dans
+    // l'ordre, chacune reprend sa place
+    std::vector<PlaylistHandle> order;
+    for (const auto* playlistVersion : playlists)
+    {
+        const PlaylistVersion& saved = *playlistVersion;
+        Playlist* playlist = GetPlaylistByName(saved.name);
+        if (!playlist)
+        {
+            Playlist restored;
+            restored.name = saved.name;
+            restored.tracks = saved.tracks;
+            restored.options = saved.options;
+
+            PlaylistChangeEvent event;
+            event.type = PlaylistChangeType::Created;
+            event.playlistName = saved.name;
+            event.index = order.size();
+            event.tracks = saved.tracks.ToVector();
+            event.playlist = AllocatePlaylist(std::move(restored));
+            order.push_back(event.playlist);
+            events.push_back(std::move(event));
+            continue;
+        }
+
+        if (!(playlist->options == saved.options))
+        {
+            playlist->options = saved.options;
+            events.push_back(MakeChangeEvent(PlaylistChangeType::OptionsChanged, saved.name));
+        }
+
+        if (!playlist->tracks.SharesStorageWith(saved.tracks))
+        {
+            const IndexedSequence<TrackId> previous = playlist->tracks;
+            playlist->tracks = saved.tracks;
+
+            PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TracksReplaced, saved.name);
+            event.tracks = saved.tracks.ToVector();
+            events.push_back(std::move(event));
+
+            if (playlist->isPlaying)
+            {
+                FollowPlayingTrack(*playlist, previous);
+            }
+        }
+        order.push_back(GetPlaylistHandle(saved.name));
+    }
+    m_playlistOrder = std::move(order);
+    for (size_t i = 0; i < m_playlistOrder.size(); i++)
+    {
+        m_slots[m_playlistOrder[i].index].orderIndex = i;
+    }
+    m_committedVersion = version;
+
+    if (!events.empty())
+    {
+        DispatchChanges(events);
+    }
+}
+
+// The playing entry keeps its channel when the restored list still holds it, found by its
+// id like ReconcilePlaylist does; otherwise the entry that took its place starts. Indices
+// computed on the previous list (queued track, shuffle order) are rebuilt.
+void PlaylistManager::FollowPlayingTrack(Playlist& plist, const IndexedSequence<TrackId>& previous)
+{
+    if (plist.tracks.empty())
+    {
+        StopPlaylist(plist);
+        return;
+    }
+
+    const std::vector<TrackId> before = previous.ToVector();
+    const std::vector<TrackId> after = plist.tracks.ToVector();
+    const int oldIndex = plist.currentIndex;
+
+    // La n-ième copie du morceau dans l'ancienne liste est la n-ième dans la nouvelle
+    int index = -1;
+    if (oldIndex >= 0 && oldIndex < static_cast<int>(before.size()))
+    {
+        const TrackId playing = before[oldIndex];
+        const auto copiesBefore = std::count(before.begin(), before.begin() + oldIndex, playing);
+        std::ptrdiff_t copies = 0;
+        for (size_t i = 0; i < after.size(); i++)
+        {
+            if (after[i] != playing) continue;
+            index = static_cast<int>(i);
+            if (copies++ == copiesBefore) break;
+        }
+    }
+
+    if (plist.playback.randomOrder)
+    {
+        PrepareRandomOrder(plist);
+        plist.randomIndexPos = 0;
+        if (index >= 0)
+        {
+            auto it = std::find(plist.randomIndices.begin(), plist.randomIndices.end(), index);
+            std::iter_swap(plist.randomIndices.begin(), it);
+        }
+    }
+
+    if (index >= 0)
+    {
+        plist.currentIndex = index;
+        CancelQueuedTrack(plist);
+        if (!plist.isCrossfading && IsGapless(plist))
+        {
+            QueueFollowingTrack(plist);
+        }
+        return;
+    }
+
+    // Le morceau en cours n'est plus dans la liste : celui qui a pris sa place démarre
+    int following = -1;
+    if (plist.playback.randomOrder)
+    {
+        following = plist.randomIndices[0];
+    }
+    else if (oldIndex < static_cast<int>(after.size()))
+    {
+        following = std::max(oldIndex, 0);
+    }
+    else if (plist.playback.loopPlaylist)
+    {
+        following = 0;
+    }
+
+    if (following < 0)
+    {
+        StopPlaylist(plist);
+    }
+    else
+    {
+        SwitchPlayingTrack(plist, following);
+    }
+}
+
+// The playing channels fade out and `index` starts from its beginning.
+void PlaylistManager::SwitchPlayingTrack(Playlist& plist, int index)
+{
+    CancelQueuedTrack(plist);
+    FadeOutChannel(plist.currentChannel, StopFadeSeconds);
+    FadeOutChannel(plist.nextChannel, StopFadeSeconds);
+    plist.currentChannel = nullptr;
+    plist.nextChannel = nullptr;
+    plist.isCrossfading = false;
+    plist.currentIndex = index;
+    StartTrackAtIndex(plist, index);
+}
+
+void PlaylistManager::DispatchChanges(const std::vector<PlaylistChangeEvent>& events)
+{
+    InvalidateCuePlans();
+
+    // Copie : un listener peut se désinscrire pendant la notification.
+    auto callbacks = m_changeCallbacks;
+    for (const auto& [token, callback] : callbacks)
+    {
+        callback(events);
+    }
+}
+
+void PlaylistManager::Play(const std::string& playlistName, const PlaylistOptions& options, ZoneId zone)
+{
+    Playlist* playlist = GetPlaylistByName(playlistName);
+    if (!GetZone(zone))
+    {
+        spdlog::error("Zone {} not found.", zone);
+        return;
+    }
+
+    if (!playlist)
+    {
+        spdlog::error("Playlist '{}' not found.", playlistName);
+        return;
+    }
+
+    Playlist& plist = *playlist;
+    if (plist.tracks.empty())
+    {
+        spdlog::error("Playlist '{}' is empty.", playlistName);
+        return;
+    }
+
+    ActivateInZone(plist, zone);
+    ResetPlayback(plist, options);
+    if (options.randomOrder)
+    {
+        PrepareRandomOrder(plist);
+        plist.currentIndex = plist.randomIndices[0];
+    }
+
+    StartTrackAtIndex(plist, plist.currentIndex);
+
+    spdlog::info("Playlist '{}' started in zone '{}'.", playlistName, m_zones[zone].name);
+}
+
+bool PlaylistManager::TransitionToPlaylist(const std::string& playlistName, const PlaylistOptions& options,
+                                           const PlaylistTransition& transition, ZoneId zone)
+{
+    Zone* target = GetZone(zone);
+    if (!target)
+    {
+        spdlog::error("Zone {} not found.", zone);
+        return false;
+    }
+
+    Playlist* playlist = GetPlaylistByName(playlistName);
+    if (!playlist || playlist->tracks.empty())
+    {
+        spdlog::error("Playlist '{}' not found or empty.", playlistName);
+        return false;
+    }
+
+    Playlist* active = GetPlaylist(target->activePlaylist);
+    if (!active || !active->isPlaying || transition.duration <= 0.0f)
+    {
+        Play(playlistName, options, zone);
+        return playlist->isPlaying;
+    }
+
+    // Premier morceau ouvert avant de toucher à l'ancienne playlist
+    Playlist& plist = *playlist;
+    std::vector<int> order;
+    if (options.randomOrder) order = m_shuffle.BuildOrder(plist.tracks);
+    const int firstIndex = order.empty() ? 0 : order[0];
+    if (!AudioManager::GetInstance().PrefetchSound(plist.tracks[firstIndex], GetZoneOutput(zone)))
+    {
+        spdlog::error("Transition to '{}' cancelled, its first track cannot be opened.", playlistName);
+        return false;
+    }
+
+    // Les fondus d'une transition encore en cours repartent du volume atteint
+    ZoneTransition& fade = target->transition;
+    for (auto& fading : fade.outgoing)
+    {
+        fading.channel->getVolume(&fading.startVolume);
+    }
+    HandOver(*active, fade);
+    ActivateInZone(plist, zone);
+
+    ResetPlayback(plist, options);
+    if (options.randomOrder)
+    {
+        plist.randomIndices = std::move(order);
+        plist.currentIndex = firstIndex;
+    }
+    StartTrackAtIndex(plist, firstIndex, true);
+
+    fade.incoming = plist.currentChannel;
+    fade.timer = 0.0f;
+    fade.duration = transition.duration;
+    fade.table = GetCrossfadeTable(transition.curve, transition.shape);
+    fade.active = true;
+
+    spdlog::info("Transition to playlist '{}' in zone '{}' over {:.1f}s ({}).", playlistName, target->name,
+                 transition.duration, GetCrossfadeCurveName(transition.curve));
+    return true;
+}
+
+bool PlaylistManager::Resume(const std::string& playlistName, ZoneId zone)
+{
+    Playlist* playlist = GetPlaylistByName(playlistName);
+    if (!playlist || !GetZone(zone)) return false;
+
+    Playlist& plist = *playlist;
+    if (plist.isPlaying) SaveResumePoint(plist);
+    const PlaylistResumePoint point = plist.resume;
+    if (!point.valid) return false;
+
+    // Morceaux déplacés ou supprimés depuis l'arrêt : on le cherche par son id
+    int index = point.index;
+    if (index < 0 || index >= (int)plist.tracks.size() || plist.tracks[index] != point.track)
+    {
+        index = -1;
+        for (size_t i = 0; i < plist.tracks.size(); i++)
+        {
+            if (plist.tracks[i] == point.track)
+            {
+                index = static_cast<int>(i);
+                break;
+            }
+        }
+    }
+    if (index < 0)
+    {
+        spdlog::warn("Resume point of '{}' dropped, track '{}' left the playlist.", playlistName, point.track.str());
+        plist.resume = PlaylistResumePoint();
+        return false;
+    }
+    if (!AudioManager::GetInstance().PrefetchSound(point.track.str(), GetZoneOutput(zone)))
+    {
+        spdlog::error("Cannot resume '{}', track '{}' cannot be opened.", playlistName, point.track.str());
+        return false;
+    }
+
+    ActivateInZone(plist, zone);
+    const PlaylistOptions options = point.options;
+    ResetPlayback(plist, options);
+    if (options.randomOrder)
+    {
+        if (plist.randomIndices.size() != plist.tracks.size())
+        {
+            PrepareRandomOrder(plist);
+        }
+        plist.randomIndexPos = point.randomIndexPos;
+        if (plist.randomIndexPos >= (int)plist.randomIndices.size() || plist.randomIndices[plist.randomIndexPos] != index)
+        {
+            auto it = std::find(plist.randomIndices.begin(), plist.randomIndices.end(), index);
+            plist.randomIndexPos = static_cast<int>(it - plist.randomIndices.begin());
+        }
+    }
+    plist.currentIndex = index;
+    plist.segmentMaxDuration = point.segmentMaxDuration > 0.0f ? point.segmentMaxDuration : options.segmentDuration;
+
+    StartTrackAtIndex(plist, index, false, point.positionPcm);
+    if (point.positionPcm > 0)
+    {
+        plist.segmentTimer = point.segmentTimer;
+        plist.chosenStartTime = point.chosenStartTime;
+        if (plist.segmentModeActive && plist.currentChannel)
+        {
+            plist.segmentEndSec = GetSegmentEnd(plist, plist.currentChannel);
+        }
+    }
+
+    spdlog::info("Playlist '{}' resumed at track {} ({} samples in).", playlistName, index, point.positionPcm);
+    return plist.isPlaying && plist.currentChannel;
+}
+
+bool PlaylistManager::HasResumePoint(const std::string& playlistName) const
+{
+    const Playlist* plist = GetPlaylistByName(playlistName);
+    return plist && plist->resume.valid;
+}
+
+void PlaylistManager::ClearResumePoint(const std::string& playlistName)
+{
+    if (Playlist* plist = GetPlaylistByName(playlistName))
     {
-        plist.currentIndex = 0;
+        plist->resume = PlaylistResumePoint();
     }
+}
+
+PlaylistResumePoint PlaylistManager::GetResumePoint(const std::string& playlistName) const
+{
+    const Playlist* plist = GetPlaylistByName(playlistName);
+    if (!plist) return PlaylistResumePoint();
+    return plist->isPlaying ? MakeResumePoint(*plist) : plist->resume;
+}
+
+bool PlaylistManager::SetResumePoint(const std::string& playlistName, const PlaylistResumePoint& point)
+{
+    Playlist* plist = GetPlaylistByName(playlistName);
+    if (!plist || !point.valid) return false;
+    plist->resume = point;
+    return true;
+}
+
+void PlaylistManager::SaveResumePoint(Playlist& plist)
+{
+    PlaylistResumePoint point = MakeResumePoint(plist);
+    if (point.valid) plist.resume = point;
+}
+
+// During a crossfade the incoming track is the one that goes on.
+PlaylistResumePoint PlaylistManager::MakeResumePoint(const Playlist& plist) const
+{
+    PlaylistResumePoint point;
+    if (plist.currentIndex < 0 || plist.currentIndex >= (int)plist.tracks.size()) return point;
+
+    FMOD::Channel* channel = (plist.isCrossfading && plist.nextChannel) ? plist.nextChannel : plist.currentChannel;
+    bool isPlaying = false;
+    if (!channel || channel->isPlaying(&isPlaying) != FMOD_OK || !isPlaying) return point;
+
+    point.track = plist.tracks[plist.currentIndex];
+    point.index = plist.currentIndex;
+    point.randomIndexPos = plist.randomIndexPos;
+    channel->getPosition(&point.positionPcm, FMOD_TIMEUNIT_PCM);
+    point.segmentTimer = plist.segmentTimer;
+    point.segmentMaxDuration = plist.segmentMaxDuration;
+    point.chosenStartTime = plist.chosenStartTime;
+    point.options = plist.playback;
+    point.valid = true;
+    return point;
+}
+
+bool PlaylistManager::IsInTransition(ZoneId zone) const
+{
+    const Zone* target = GetZone(zone);
+    return target && target->transition.active;
+}
 
+float PlaylistManager::GetTransitionProgress(ZoneId zone) const
+{
+    const Zone* target = GetZone(zone);
+    if (!target || !target->transition.active || target->transition.duration <= 0.0f) return 0.0f;
+    return std::min(target->transition.timer / target->transition.duration, 1.0f);
+}
+
+void PlaylistManager::ResetPlayback(Playlist& plist, const PlaylistOptions& options)
+{
+    plist.playback = options;
+    plist.isPlaying = true;
+    plist.currentIndex = 0;
+    plist.randomIndexPos = 0;
+
+    CancelQueuedTrack(plist);
     plist.currentChannel = nullptr;
     plist.nextChannel = nullptr;
     plist.isCrossfading = false;
@@ -649,47 +1480,85 @@ void PlaylistManager::Play(const std::string& playlistName, const PlaylistOption
     plist.segmentMaxDuration = options.segmentDuration;
     plist.segmentTimer = 0.0f;
     plist.chosenStartTime = 0.0f;
+}
 
-    StartTrackAtIndex(plist, plist.currentIndex);
+// The playlist stops without touching its channels: the transition fades them out from
+// wherever they are, a crossfade in progress included.
+void PlaylistManager::HandOver(Playlist& plist, ZoneTransition& transition)
+{
+    if (!plist.isPlaying) return;
+    SaveResumePoint(plist);
+    CancelQueuedTrack(plist);
+
+    for (FMOD::Channel* channel : { plist.currentChannel, plist.nextChannel })
+    {
+        bool isPlaying = false;
+        if (!channel || channel->isPlaying(&isPlaying) != FMOD_OK || !isPlaying) continue;
+
+        float volume = 1.0f;
+        channel->getVolume(&volume);
+        transition.outgoing.push_back({ channel, volume });
+    }
+    if (transition.incoming == plist.currentChannel || transition.incoming == plist.nextChannel)
+    {
+        transition.incoming = nullptr;
+    }
+
+    plist.isPlaying = false;
+    plist.isCrossfading = false;
+    plist.currentChannel = nullptr;
+    plist.nextChannel = nullptr;
+}
 
-    spdlog::info("Playlist '{}' started.", playlistName);
+void PlaylistManager::UpdateTransition(Zone& zone, float deltaTime, float musicVolume)
+{
+    ZoneTransition& transition = zone.transition;
+    if (!transition.active) return;
+
+    transition.timer += deltaTime;
+    const float t = std::min(transition.timer / transition.duration, 1.0f);
+    const CrossfadeGains gains = transition.table(t);
+
+    for (const auto& fading : transition.outgoing)
+    {
+        fading.channel->setVolume(fading.startVolume * gains.out);
+    }
+
+    // The new playlist takes its channel back as soon as it crossfades or stops on its own.
+    const Playlist* plist = GetPlaylist(zone.activePlaylist);
+    if (transition.incoming && (!plist || !plist->isPlaying || plist->isCrossfading || plist->currentChannel != transition.incoming))
+    {
+        transition.incoming = nullptr;
+    }
+    if (transition.incoming)
+    {
+        transition.incoming->setVolume(musicVolume * gains.in);
+    }
+
+    if (t >= 1.0f)
+    {
+        EndTransition(transition);
+    }
+}
+
+void PlaylistManager::EndTransition(ZoneTransition& transition)
+{
+    for (const auto& fading : transition.outgoing)
+    {
+        fading.channel->stop();
+    }
+    transition = ZoneTransition();
 }
 
 void PlaylistManager::Stop(const std::string& playlistName)
 {
     if (playlistName.empty())
     {
-        for (auto& plist : m_playlists)
+        for (auto& slot : m_slots)
         {
-            if (plist.isPlaying)
+            if (slot.occupied)
             {
-                if (plist.currentChannel)
-                {
-                    bool isPlaying = false;
-                    plist.currentChannel->isPlaying(&isPlaying);
-                    if (isPlaying)
-                    {
-                        std::string currentTrack = plist.tracks[plist.currentIndex];
-                        AudioManager::GetInstance().StopSoundWithFadeOut(currentTrack);
-                    }
-                }
-                
-                if (plist.nextChannel)
-                {
-                    bool isPlaying = false;
-                    plist.nextChannel->isPlaying(&isPlaying);
-                    if (isPlaying)
-                    {
-                        int nextIndex = (plist.currentIndex + 1) % plist.tracks.size();
-                        std::string nextTrack = plist.tracks[nextIndex];
-                        AudioManager::GetInstance().StopSoundWithFadeOut(nextTrack);
-                    }
-                }
-                
-                plist.isPlaying = false;
-                plist.isCrossfading = false;
-                plist.currentChannel = nullptr;
-                plist.nextChannel = nullptr;
+                StopPlaylist(slot.playlist);
             }
         }
         
@@ -697,171 +1566,150 @@ void PlaylistManager::Stop(const std::string& playlistName)
     }
     else
     {
-        for (auto& plist : m_playlists)
+        Playlist* plist = GetPlaylistByName(playlistName);
+        if (plist && plist->isPlaying)
         {
-            if (plist.name == playlistName && plist.isPlaying)
-            {
-                if (plist.currentChannel)
-                {
-                    bool isPlaying = false;
-                    plist.currentChannel->isPlaying(&isPlaying);
-                    if (isPlaying)
-                    {
-                        std::string currentTrack = plist.tracks[plist.currentIndex];
-                        AudioManager::GetInstance().StopSoundWithFadeOut(currentTrack);
-                    }
-                }
-                
-                if (plist.nextChannel)
-                {
-                    bool isPlaying = false;
-                    plist.nextChannel->isPlaying(&isPlaying);
-                    if (isPlaying)
-                    {
-                        int nextIndex = (plist.currentIndex + 1) % plist.tracks.size();
-                        std::string nextTrack = plist.tracks[nextIndex];
-                        AudioManager::GetInstance().StopSoundWithFadeOut(nextTrack);
-                    }
-                }
-                
-                plist.isPlaying = false;
-                plist.isCrossfading = false;
-                plist.currentChannel = nullptr;
-                plist.nextChannel = nullptr;
-                
-                spdlog::info("Playlist '{}' stopped with fade-out", playlistName);
-                break;
-            }
+            StopPlaylist(*plist);
+            spdlog::info("Playlist '{}' stopped with fade-out", playlistName);
         }
     }
 }
 
+void PlaylistManager::StopZone(ZoneId zone)
+{
+    const Zone* target = GetZone(zone);
+    if (!target) return;
+
+    if (Playlist* plist = GetPlaylist(target->activePlaylist))
+    {
+        StopPlaylist(*plist);
+        spdlog::info("Zone '{}' stopped with fade-out", target->name);
+    }
+}
+
+void PlaylistManager::StopPlaylist(Playlist& plist)
+{
+    if (!plist.isPlaying) return;
+    SaveResumePoint(plist);
+    CancelQueuedTrack(plist);
+
+    if (Zone* zone = GetZone(plist.zone); zone && zone->transition.incoming == plist.currentChannel)
+    {
+        zone->transition.incoming = nullptr;
+    }
+
+    // Les canaux de cette playlist seulement : un même morceau peut jouer dans une autre zone
+    FadeOutChannel(plist.currentChannel, StopFadeSeconds);
+    FadeOutChannel(plist.nextChannel, StopFadeSeconds);
+    
+    plist.isPlaying = false;
+    plist.isCrossfading = false;
+    plist.currentChannel = nullptr;
+    plist.nextChannel = nullptr;
+}
+
+// The fade and the stop are set on the channel's DSP clock, so every zone fades on its
+// own and nothing has to be updated per frame.
+void PlaylistManager::FadeOutChannel(FMOD::Channel* channel, float seconds)
+{
+    bool isPlaying = false;
+    if (!channel || channel->isPlaying(&isPlaying) != FMOD_OK || !isPlaying) return;
+
+    unsigned long long clock = 0;
+    FMOD::System* system = nullptr;
+    int sampleRate = 48000;
+    if (channel->getDSPClock(nullptr, &clock) != FMOD_OK || channel->getSystemObject(&system) != FMOD_OK)
+    {
+        channel->stop();
+        return;
+    }
+    system->getSoftwareFormat(&sampleRate, nullptr, nullptr);
+
+    const unsigned long long endClock = clock + static_cast<unsigned long long>(std::max(seconds, 0.0f) * sampleRate);
+    channel->removeFadePoints(0, ULLONG_MAX);
+    channel->addFadePoint(clock, 1.0f);
+    channel->addFadePoint(endClock, 0.0f);
+    channel->setDelay(0, endClock, true);
+}
+
 void PlaylistManager::Update(float deltaTime)
 {
-    for (auto& plist : m_playlists)
+    // Le volume et le duck propres à chaque zone sont appliqués par son channel group
+    const float baseMusicVol = UIManager::GetInstance().GetMasterVolume() 
+                             * UIManager::GetInstance().GetMusicVolume()
+                             * UIManager::GetInstance().GetDuckFactor();
+    const uint64_t scheduleRevision = AnnouncementManager::GetInstance().GetScheduleRevision();
+
+    // Seules les playlists dont un canal vient de finir sont touchées ; les autres images
+    // n'appellent pas FMOD
+    if (m_channelEnds.HasEvents())
+    {
+        m_channelEnds.Drain(m_endedChannels);
+        for (const auto& ended : m_endedChannels)
+        {
+            Zone* zone = GetZone(ended.tag);
+            Playlist* playlist = zone ? GetPlaylist(zone->activePlaylist) : nullptr;
+            if (playlist && playlist->isPlaying)
+            {
+                OnChannelEnded(*playlist, ended.channel);
+            }
+        }
+    }
+
+    for (auto& zone : m_zones)
     {
-        if (!plist.isPlaying) continue;
+        if (!zone.occupied) continue;
+        UpdateTransition(zone, deltaTime, baseMusicVol);
+
+        Playlist* playlist = GetPlaylist(zone.activePlaylist);
+        if (!playlist || !playlist->isPlaying) continue;
+        Playlist& plist = *playlist;
 
-        float baseMusicVol = UIManager::GetInstance().GetMasterVolume() 
-                           * UIManager::GetInstance().GetMusicVolume()
-                           * UIManager::GetInstance().GetDuckFactor();
+        plist.trackElapsed += deltaTime;
+        if (!plist.isCrossfading && plist.currentChannel &&
+            (plist.cuePlanDirty || plist.cuePlanRevision != scheduleRevision))
+        {
+            PlanToNextCue(plist);
+        }
 
         if (plist.isCrossfading)
         {
             plist.crossfadeTimer += deltaTime;
-            float t = plist.crossfadeTimer / plist.crossfadeDuration;
+            float t = plist.crossfadeTimer / plist.playback.crossfadeDuration;
             if (t > 1.0f) t = 1.0f;
+            const CrossfadeGains gains = plist.crossfadeTable(t);
 
-            bool currentChannelValid = false;
-            bool nextChannelValid    = false;
-
+            // Un canal fini est déjà retiré par OnChannelEnded
             if (plist.currentChannel)
             {
-                bool isPlaying = false;
-                FMOD_RESULT result = plist.currentChannel->isPlaying(&isPlaying);
-                currentChannelValid = (result == FMOD_OK && isPlaying);
-                
-                if (currentChannelValid) {
-                    float volOld = (1.0f - t) * baseMusicVol;
-                    plist.currentChannel->setVolume(volOld);
-                }
+                plist.currentChannel->setVolume(gains.out * baseMusicVol);
             }
-
             if (plist.nextChannel)
             {
-                bool isPlaying = false;
-                FMOD_RESULT result = plist.nextChannel->isPlaying(&isPlaying);
-                nextChannelValid = (result == FMOD_OK && isPlaying);
-                
-                if (nextChannelValid) {
-                    
-                    float volNext = t * baseMusicVol;
-                    plist.nextChannel->setVolume(volNext);
-                }
+                plist.nextChannel->setVolume(gains.in * baseMusicVol);
             }
 
-            if (t >= 1.0f || (!currentChannelValid && !nextChannelValid))
+            if (t >= 1.0f || (!plist.currentChannel && !plist.nextChannel))
             {
                 FinishCrossfade(plist);
             }
         }
         else if (plist.currentChannel)
         {
-            bool isPlaying = false;
-            FMOD_RESULT result = plist.currentChannel->isPlaying(&isPlaying);
-            
-            if (result != FMOD_OK)
+            if (plist.plannedStopSec >= 0.0f && plist.trackElapsed >= plist.plannedStopSec && plist.tracks.size() > 1)
             {
-                spdlog::error("Channel state check failed, restarting track");
-                StartTrackAtIndex(plist, plist.currentIndex);
-                continue;
-            }
-
-            if (!isPlaying && !plist.segmentModeActive)
-            {
-                if (plist.options.loopPlaylist && plist.tracks.size() == 1)
-                {
-                    StartTrackAtIndex(plist, plist.currentIndex);
-                }
-                else if (plist.options.loopPlaylist || plist.tracks.size() > 1)
-                {
-                    StartNextTrack(plist);
-                }
-                else
-                {
-                    plist.isPlaying = false;
-                    spdlog::info("Playlist '{}' finished playing (no loop option).", plist.name);
-                }
+                StartNextTrack(plist);
                 continue;
             }
 
+            // La fin du segment a été calculée au départ du morceau ; la fin naturelle arrive par OnChannelEnded
             if (plist.segmentModeActive)
             {
-                FMOD::Sound* sound = nullptr;
-                result = plist.currentChannel->getCurrentSound(&sound);
-                if (result == FMOD_OK && sound)
+                plist.segmentTimer += deltaTime;
+                if (plist.segmentEndSec >= 0.0f && plist.segmentTimer >= plist.segmentEndSec)
                 {
-                    unsigned int lengthMs = 0;
-                    if (sound->getLength(&lengthMs, FMOD_TIMEUNIT_MS) == FMOD_OK)
-                    {
-                        float lengthSec = lengthMs / 1000.0f;
-                        float effectiveSegmentDuration = std::min(plist.segmentMaxDuration, lengthSec);
-                        
-                        unsigned int positionMs = 0;
-                        bool trackFinished = false;
-                        if (plist.currentChannel->getPosition(&positionMs, FMOD_TIMEUNIT_MS) == FMOD_OK) {
-                         
-                            if (lengthMs > 0 && (lengthMs - positionMs) < 500) { // 500ms threshold
-                                trackFinished = true;
-                            }
-                        }
-                        
-                        plist.segmentTimer += deltaTime;
-                        if (trackFinished || !isPlaying) {
-                            // If track finished naturally, move to next one
-                            if (plist.tracks.size() == 1)
-                            {
-                                StartTrackAtIndex(plist, plist.currentIndex);
-                            }
-                            else
-                            {
-                                StartNextTrack(plist);
-                            }
-                            continue;
-                        }
-                        else if (plist.segmentTimer >= effectiveSegmentDuration && lengthSec > effectiveSegmentDuration) {
-                            // Only switch based on segment timer if the track is actually longer than segment duration
-                            if (plist.tracks.size() == 1)
-                            {
-                                StartTrackAtIndex(plist, plist.currentIndex);
-                            }
-                            else
-                            {
-                                StartNextTrack(plist);
-                            }
-                            continue;
-                        }
-                    }
+                    OnTrackEnded(plist);
+                    continue;
                 }
             }
         }
@@ -871,11 +1719,13 @@ void PlaylistManager::Update(float deltaTime)
             StartTrackAtIndex(plist, plist.currentIndex);
         }
     }
+
+    m_shuffle.Update(deltaTime);
 }
 
-std::string PlaylistManager::GetCurrentTrackName() const
+std::string PlaylistManager::GetCurrentTrackName(ZoneId zone) const
 {
-    auto* activePlaylist = GetActivePlaylist();
+    auto* activePlaylist = GetActivePlaylist(zone);
     if (!activePlaylist || !activePlaylist->isPlaying) return "";
     if (activePlaylist->currentIndex < 0 || 
         activePlaylist->currentIndex >= (int)activePlaylist->tracks.size()) 
@@ -883,9 +1733,9 @@ std::string PlaylistManager::GetCurrentTrackName() const
     return activePlaylist->tracks[activePlaylist->currentIndex];
 }
 
-float PlaylistManager::GetTrackProgress() const
+float PlaylistManager::GetTrackProgress(ZoneId zone) const
 {
-    auto* activePlaylist = GetActivePlaylist();
+    auto* activePlaylist = GetActivePlaylist(zone);
     if (!activePlaylist || !activePlaylist->currentChannel) 
         return 0.0f;
 
@@ -899,101 +1749,309 @@ float PlaylistManager::GetTrackProgress() const
     result = activePlaylist->currentChannel->getCurrentSound(&sound);
     if (result != FMOD_OK || !sound) return 0.0f;
 
-    result = sound->getLength(&lengthMs, FMOD_TIMEUNIT_MS);
-    if (result != FMOD_OK || lengthMs == 0) return 0.0f;
+    result = sound->getLength(&lengthMs, FMOD_TIMEUNIT_MS);
+    if (result != FMOD_OK || lengthMs == 0) return 0.0f;
+
+    return static_cast<float>(positionMs) / static_cast<float>(lengthMs);
+}
+
+float PlaylistManager::GetSegmentProgress(ZoneId zone) const
+{
+    auto* activePlaylist = GetActivePlaylist(zone);
+    if (!activePlaylist || !activePlaylist->segmentModeActive) return 0.0f;
+    if (activePlaylist->segmentMaxDuration <= 0.0f) return 0.0f;
+    return activePlaylist->segmentTimer / activePlaylist->segmentMaxDuration;
+}
+
+void PlaylistManager::SetCrossfadeDuration(float duration, ZoneId zone)
+{
+    if (Playlist* activePlaylist = GetActivePlaylist(zone)) {
+        activePlaylist->playback.crossfadeDuration = duration;
+    }
+}
+
+FMOD::Channel* PlaylistManager::GetCurrentChannel(ZoneId zone) const
+{
+    auto* activePlaylist = GetActivePlaylist(zone);
+    return activePlaylist ? activePlaylist->currentChannel : nullptr;
+}
+
+bool PlaylistManager::IsInCrossfade(ZoneId zone) const
+{
+    auto* activePlaylist = GetActivePlaylist(zone);
+    return activePlaylist ? activePlaylist->isCrossfading : false;
+}
+
+float PlaylistManager::GetCrossfadeProgress(ZoneId zone) const
+{
+    auto* activePlaylist = GetActivePlaylist(zone);
+    if (!activePlaylist || !activePlaylist->isCrossfading) return 0.0f;
+    return activePlaylist->crossfadeTimer / activePlaylist->playback.crossfadeDuration;
+}
+
+FMOD::Channel* PlaylistManager::GetNextChannel(ZoneId zone) const
+{
+    auto* activePlaylist = GetActivePlaylist(zone);
+    return activePlaylist ? activePlaylist->nextChannel : nullptr;
+}
+
+FMOD::Channel* PlaylistManager::GetQueuedChannel(ZoneId zone) const
+{
+    auto* activePlaylist = GetActivePlaylist(zone);
+    return activePlaylist ? activePlaylist->queuedChannel : nullptr;
+}
+
+PlaylistHandle PlaylistManager::GetActivePlaylistHandle(ZoneId zone) const
+{
+    const Zone* target = GetZone(zone);
+    return target ? target->activePlaylist : PlaylistHandle{};
+}
+
+const PlaylistManager::Playlist* PlaylistManager::GetActivePlaylist(ZoneId zone) const
+{
+    return GetPlaylist(GetActivePlaylistHandle(zone));
+}
+
+PlaylistManager::Playlist* PlaylistManager::GetActivePlaylist(ZoneId zone)
+{
+    return GetPlaylist(GetActivePlaylistHandle(zone));
+}
+
+PlaylistManager::Zone* PlaylistManager::GetZone(ZoneId zone)
+{
+    return (zone < m_zones.size() && m_zones[zone].occupied) ? &m_zones[zone] : nullptr;
+}
+
+const PlaylistManager::Zone* PlaylistManager::GetZone(ZoneId zone) const
+{
+    return (zone < m_zones.size() && m_zones[zone].occupied) ? &m_zones[zone] : nullptr;
+}
+
+ZoneId PlaylistManager::CreateZone(const std::string& name)
+{
+    if (name.empty())
+    {
+        spdlog::error("A zone needs a name.");
+        return InvalidZone;
+    }
+
+    ZoneId existing = FindZone(name);
+    if (existing != InvalidZone) return existing;
+
+    ZoneId id = 0;
+    while (id < m_zones.size() && m_zones[id].occupied) id++;
+    if (id == m_zones.size()) m_zones.emplace_back();
+
+    Zone& zone = m_zones[id];
+    zone = Zone();
+    zone.name = name;
+    zone.occupied = true;
+
+    spdlog::info("Zone '{}' created.", name);
+    return id;
+}
+
+bool PlaylistManager::RemoveZone(ZoneId id)
+{
+    Zone* zone = GetZone(id);
+    if (!zone || id == MainZone)
+    {
+        spdlog::error("Zone {} cannot be removed.", id);
+        return false;
+    }
+
+    StopZone(id);
+    EndTransition(zone->transition);
+    if (zone->group)
+    {
+        zone->group->stop();
+        zone->group->release();
+    }
+    spdlog::info("Zone '{}' removed.", zone->name);
+    *zone = Zone();
+    return true;
+}
+
+ZoneId PlaylistManager::FindZone(const std::string& name) const
+{
+    for (size_t i = 0; i < m_zones.size(); i++)
+    {
+        if (m_zones[i].occupied && m_zones[i].name == name) return static_cast<ZoneId>(i);
+    }
+    return InvalidZone;
+}
+
+std::vector<std::string> PlaylistManager::GetZoneNames() const
+{
+    std::vector<std::string> names;
+    names.reserve(m_zones.size());
+    for (const auto& zone : m_zones)
+    {
+        names.push_back(zone.name);
+    }
+    return names;
+}
 
-    return static_cast<float>(positionMs) / static_cast<float>(lengthMs);
+void PlaylistManager::SetZoneVolume(ZoneId id, float volume)
+{
+    if (Zone* zone = GetZone(id))
+    {
+        zone->volume = std::clamp(volume, 0.0f, 1.0f);
+        ApplyZoneVolume(*zone);
+    }
 }
 
-float PlaylistManager::GetSegmentProgress() const
+float PlaylistManager::GetZoneVolume(ZoneId id) const
 {
-    auto* activePlaylist = GetActivePlaylist();
-    if (!activePlaylist || !activePlaylist->segmentModeActive) return 0.0f;
-    if (activePlaylist->segmentMaxDuration <= 0.0f) return 0.0f;
-    return activePlaylist->segmentTimer / activePlaylist->segmentMaxDuration;
+    const Zone* zone = GetZone(id);
+    return zone ? zone->volume : 0.0f;
 }
 
-void PlaylistManager::SetCrossfadeDuration(float duration)
+void PlaylistManager::SetZoneDuckFactor(ZoneId id, float factor)
 {
-    if (m_currentPlaylist) {
-        m_currentPlaylist->crossfadeDuration = duration;
+    if (Zone* zone = GetZone(id))
+    {
+        zone->duckFactor = std::clamp(factor, 0.0f, 1.0f);
+        ApplyZoneVolume(*zone);
     }
 }
 
-FMOD::Channel* PlaylistManager::GetCurrentChannel() const
+float PlaylistManager::GetZoneDuckFactor(ZoneId id) const
 {
-    auto* activePlaylist = GetActivePlaylist();
-    return activePlaylist ? activePlaylist->currentChannel : nullptr;
+    const Zone* zone = GetZone(id);
+    return zone ? zone->duckFactor : 0.0f;
 }
 
-bool PlaylistManager::IsInCrossfade() const
+FMOD::ChannelGroup* PlaylistManager::GetZoneChannelGroup(ZoneId id) const
 {
-    auto* activePlaylist = GetActivePlaylist();
-    return activePlaylist ? activePlaylist->isCrossfading : false;
+    const Zone* zone = GetZone(id);
+    return zone ? zone->group : nullptr;
 }
 
-float PlaylistManager::GetCrossfadeProgress() const
+bool PlaylistManager::SetZoneOutput(ZoneId id, OutputId output)
 {
-    auto* activePlaylist = GetActivePlaylist();
-    if (!activePlaylist || !activePlaylist->isCrossfading) return 0.0f;
-    return activePlaylist->crossfadeTimer / activePlaylist->crossfadeDuration;
+    Zone* zone = GetZone(id);
+    if (!zone || !FModWrapper::GetInstance().GetSystem(output))
+    {
+        spdlog::error("Cannot route zone {} to output {}.", id, output);
+        return false;
+    }
+    if (zone->output == output) return true;
+
+    // Le groupe appartient au système de l'ancienne sortie
+    if (zone->group)
+    {
+        zone->group->release();
+        zone->group = nullptr;
+    }
+    zone->output = output;
+    spdlog::info("Zone '{}' routed to output '{}'.", zone->name, FModWrapper::GetInstance().GetOutputName(output));
+    return true;
 }
 
-FMOD::Channel* PlaylistManager::GetNextChannel() const
+OutputId PlaylistManager::GetZoneOutput(ZoneId id) const
 {
-    auto* activePlaylist = GetActivePlaylist();
-    return activePlaylist ? activePlaylist->nextChannel : nullptr;
+    const Zone* zone = GetZone(id);
+    if (!zone) return FModWrapper::InvalidOutput;
+    return FModWrapper::GetInstance().GetSystem(zone->output) ? zone->output : FModWrapper::MainOutput;
 }
 
-const PlaylistManager::Playlist* PlaylistManager::GetActivePlaylist() const
+void PlaylistManager::ApplyZoneVolume(Zone& zone)
 {
-    if (m_activePlaylistName.empty()) return nullptr;
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [this](const Playlist& p) { return p.name == m_activePlaylistName; });
-    return (it != m_playlists.end()) ? &(*it) : nullptr;
+    if (zone.group)
+    {
+        zone.group->setVolume(zone.volume * zone.duckFactor);
+    }
 }
 
-PlaylistManager::Playlist* PlaylistManager::GetActivePlaylist()
+void PlaylistManager::ActivateInZone(Playlist& plist, ZoneId id)
 {
-    if (m_activePlaylistName.empty()) return nullptr;
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [this](Playlist& p) { return p.name == m_activePlaylistName; });
-    return (it != m_playlists.end()) ? &(*it) : nullptr;
+    const PlaylistHandle handle = GetPlaylistHandle(plist.name);
+
+    Zone& zone = m_zones[id];
+    if (Playlist* active = GetPlaylist(zone.activePlaylist))
+    {
+        StopPlaylist(*active);
+    }
+    StopPlaylist(plist);
+    if (Zone* previous = GetZone(plist.zone); previous && previous->activePlaylist == handle)
+    {
+        previous->activePlaylist = PlaylistHandle{};
+    }
+
+    zone.activePlaylist = handle;
+    plist.zone = id;
 }
 
-void PlaylistManager::StartNextTrack(Playlist& plist)
+void PlaylistManager::RouteToZone(const Playlist& plist, FMOD::Channel* channel)
 {
-    int nextIndex = 0;
-    if (plist.options.randomOrder)
+    Zone* zone = GetZone(plist.zone);
+    if (!zone || !channel) return;
+
+    // Sortie fermée : la zone revient sur la sortie principale, son groupe est parti avec
+    if (zone->output != FModWrapper::MainOutput && !FModWrapper::GetInstance().GetSystem(zone->output))
     {
-        plist.randomIndexPos++;
-        if (plist.randomIndexPos >= (int)plist.randomIndices.size())
+        zone->output = FModWrapper::MainOutput;
+        zone->group = nullptr;
+    }
+
+    // Créé à la première lecture : le système FMOD n'existe pas encore quand la zone est créée
+    if (!zone->group)
+    {
+        FMOD::System* system = FModWrapper::GetInstance().GetSystem(zone->output);
+        if (!system || system->createChannelGroup(zone->name.c_str(), &zone->group) != FMOD_OK)
         {
-            if (plist.options.loopPlaylist) {
-                plist.randomIndexPos = 0;
-            } else {
-                plist.isPlaying = false;
-                return;
-            }
+            zone->group = nullptr;
+            return;
         }
-        nextIndex = plist.randomIndices[plist.randomIndexPos];
+        ApplyZoneVolume(*zone);
     }
-    else
+    channel->setChannelGroup(zone->group);
+}
+
+// The index StartNextTrack will play, -1 at the end of a playlist that does not loop.
+// A random order that runs out is drawn again here, so peeking and playing agree.
+int PlaylistManager::GetFollowingIndex(Playlist& plist)
+{
+    if (plist.playback.randomOrder)
     {
-        nextIndex = plist.currentIndex + 1;
-        if (nextIndex >= (int)plist.tracks.size())
+        if (plist.randomIndexPos + 1 >= (int)plist.randomIndices.size())
         {
-            if (plist.options.loopPlaylist) {
-                nextIndex = 0;
-            } else {
-                plist.isPlaying = false;
-                return;
-            }
+            if (!plist.playback.loopPlaylist) return -1;
+            // Nouveau cycle : il tient compte de ce qui vient d'être joué
+            PrepareRandomOrder(plist);
+            plist.randomIndexPos = -1;
         }
+        return plist.randomIndices[plist.randomIndexPos + 1];
+    }
+
+    const int nextIndex = plist.currentIndex + 1;
+    if (nextIndex >= (int)plist.tracks.size())
+    {
+        return plist.playback.loopPlaylist ? 0 : -1;
+    }
+    return nextIndex;
+}
+
+void PlaylistManager::StartNextTrack(Playlist& plist)
+{
+    CancelQueuedTrack(plist);
+
+    const int nextIndex = GetFollowingIndex(plist);
+    if (nextIndex < 0)
+    {
+        plist.isPlaying = false;
+        plist.resume = PlaylistResumePoint();
+        return;
+    }
+    if (plist.playback.randomOrder)
+    {
+        plist.randomIndexPos++;
     }
 
     plist.isCrossfading   = true;
     plist.crossfadeTimer  = 0.0f;
+    plist.crossfadeTable  = GetCrossfadeTable(plist.playback.crossfadeCurve, plist.playback.crossfadeShape);
 
     plist.oldChannelVolume = 1.0f;
     if (plist.currentChannel)
@@ -1008,11 +2066,26 @@ void PlaylistManager::StartNextTrack(Playlist& plist)
     plist.nextTargetVolume = userVolume;
 
     std::string nextTrack = plist.tracks[nextIndex];
-    FMOD::Channel* ch = AudioManager::GetInstance().PlaySound(nextTrack, false, 0.0f);
+    FMOD::Channel* ch = AudioManager::GetInstance().PlaySound(nextTrack, false, 0.0f, 1.0f, GetZoneOutput(plist.zone));
     plist.nextChannel = ch;
+    RouteToZone(plist, ch);
+    if (ch)
+    {
+        m_shuffle.RecordPlay(plist.tracks[nextIndex]);
+        m_channelEnds.Watch(ch, plist.zone);
+    }
 
     plist.currentIndex = nextIndex;
 
+    plist.trackElapsed = 0.0f;
+    plist.plannedStopSec = -1.0f;
+    if (!plist.plannedDurations.empty())
+    {
+        plist.plannedStopSec = plist.plannedDurations.front();
+        plist.plannedDurations.pop_front();
+    }
+    plist.cuePlanDirty = true;
+
     plist.segmentTimer = 0.0f;
     if (plist.segmentModeActive && ch)
     {
@@ -1033,24 +2106,43 @@ void PlaylistManager::StartNextTrack(Playlist& plist)
             ch->setPosition((unsigned int)(plist.chosenStartTime * 1000.0f), FMOD_TIMEUNIT_MS);
         }
     }
+    plist.segmentEndSec = (plist.segmentModeActive && ch) ? GetSegmentEnd(plist, ch) : -1.0f;
 }
 
-void PlaylistManager::StartTrackAtIndex(Playlist& plist, int index)
+void PlaylistManager::StartTrackAtIndex(Playlist& plist, int index, bool silent, unsigned int startPcm)
 {
     if (index < 0 || index >= (int)plist.tracks.size()) return;
 
     std::string track = plist.tracks[index];
 
-    float userVolume = UIManager::GetInstance().GetMasterVolume() 
-                     * UIManager::GetInstance().GetMusicVolume();
+    float userVolume = silent ? 0.0f
+                     : UIManager::GetInstance().GetMasterVolume() * UIManager::GetInstance().GetMusicVolume();
 
-    bool doLoop = (!plist.options.randomSegment && plist.options.loopPlaylist && plist.tracks.size() == 1);
-    
-    FMOD::Channel* ch = AudioManager::GetInstance().PlaySound(track, doLoop, userVolume);
+    bool doLoop = (!plist.playback.randomSegment && plist.playback.loopPlaylist && plist.tracks.size() == 1);
+    CancelQueuedTrack(plist);
+
+    // Gapless : départ sur l'horloge DSP, un peu devant le mixeur, pour connaître l'échantillon de fin
+    const bool gapless = IsGapless(plist) && !doLoop;
+    unsigned long long endClock = 0;
+    FMOD::Channel* ch = nullptr;
+    if (gapless)
+    {
+        auto& audioManager = AudioManager::GetInstance();
+        const OutputId output = GetZoneOutput(plist.zone);
+        const unsigned long long startClock = audioManager.GetMasterDSPClock(output) + audioManager.GetOutputSampleRate(output) / 20;
+        ch = PlayGapless(plist, index, startClock, startPcm, userVolume, endClock);
+    }
+    else
+    {
+        ch = AudioManager::GetInstance().PlaySound(track, doLoop, userVolume, 1.0f, GetZoneOutput(plist.zone), startPcm);
+    }
     if (!ch) {
         spdlog::error("Failed to start track at index {}", index);
         return;
     }
+    RouteToZone(plist, ch);
+    m_shuffle.RecordPlay(plist.tracks[index]);
+    m_channelEnds.Watch(ch, plist.zone);
 
     if (plist.currentChannel) {
         bool isPlaying = false;
@@ -1061,6 +2153,12 @@ void PlaylistManager::StartTrackAtIndex(Playlist& plist, int index)
     }
 
     plist.currentChannel = ch;
+    plist.currentEndClock = endClock;
+
+    plist.trackElapsed = 0.0f;
+    plist.plannedStopSec = -1.0f;
+    plist.plannedDurations.clear();
+    plist.cuePlanDirty = true;
 
     bool isPlaying = false;
     FMOD_RESULT result = plist.currentChannel->isPlaying(&isPlaying);
@@ -1071,7 +2169,12 @@ void PlaylistManager::StartTrackAtIndex(Playlist& plist, int index)
 
     plist.segmentTimer = 0.0f;
     
-    if (plist.options.randomSegment && ch)
+    if (plist.playback.randomSegment && ch && startPcm > 0)
+    {
+        // Reprise : le segment continue là où il en était
+        plist.segmentModeActive = true;
+    }
+    else if (plist.playback.randomSegment && ch)
     {
         plist.segmentModeActive = true;
         
@@ -1083,8 +2186,8 @@ void PlaylistManager::StartTrackAtIndex(Playlist& plist, int index)
             sound->getLength(&lengthMs, FMOD_TIMEUNIT_MS);
             float lengthSec = lengthMs / 1000.0f;
 
-            float maxStart = (lengthSec > plist.options.segmentDuration)
-                             ? (lengthSec - plist.options.segmentDuration)
+            float maxStart = (lengthSec > plist.playback.segmentDuration)
+                             ? (lengthSec - plist.playback.segmentDuration)
                              : 0.0f;
             
             std::uniform_real_distribution<float> dist(0.0f, maxStart);
@@ -1092,13 +2195,19 @@ void PlaylistManager::StartTrackAtIndex(Playlist& plist, int index)
             
             ch->setPosition((unsigned int)(plist.chosenStartTime * 1000.0f), FMOD_TIMEUNIT_MS);
             
-            plist.segmentMaxDuration = plist.options.segmentDuration;
+            plist.segmentMaxDuration = plist.playback.segmentDuration;
         }
     }
     else
     {
         plist.segmentModeActive = false;
     }
+    plist.segmentEndSec = plist.segmentModeActive ? GetSegmentEnd(plist, ch) : -1.0f;
+
+    if (gapless)
+    {
+        QueueFollowingTrack(plist);
+    }
 }
 
 void PlaylistManager::FinishCrossfade(Playlist& plist)
@@ -1117,6 +2226,7 @@ void PlaylistManager::FinishCrossfade(Playlist& plist)
     plist.nextChannel    = nullptr;
     plist.isCrossfading  = false;
     plist.crossfadeTimer = 0.0f;
+    plist.currentEndClock = 0;
 
     if (plist.currentChannel)
     {
@@ -1127,67 +2237,446 @@ void PlaylistManager::FinishCrossfade(Playlist& plist)
             spdlog::warn("New current channel invalid after crossfade, restarting track");
             StartTrackAtIndex(plist, plist.currentIndex);
         }
+        else if (IsGapless(plist))
+        {
+            QueueFollowingTrack(plist);
+        }
+    }
+}
+
+void PlaylistManager::OnChannelEnded(Playlist& plist, FMOD::Channel* channel)
+{
+    if (plist.isCrossfading)
+    {
+        // Le fondu continue avec le canal restant
+        if (channel == plist.currentChannel) plist.currentChannel = nullptr;
+        else if (channel == plist.nextChannel) plist.nextChannel = nullptr;
+        return;
+    }
+
+    if (channel == plist.queuedChannel)
+    {
+        plist.queuedChannel = nullptr;
+        return;
+    }
+
+    if (channel == plist.currentChannel)
+    {
+        // Gapless : le suivant joue déjà depuis l'échantillon de coupure
+        if (plist.queuedChannel && !plist.tracks.empty())
+        {
+            PromoteQueuedTrack(plist);
+        }
+        else
+        {
+            OnTrackEnded(plist);
+        }
+    }
+}
+
+void PlaylistManager::OnTrackEnded(Playlist& plist)
+{
+    if (plist.segmentModeActive)
+    {
+        if (plist.tracks.size() == 1)
+        {
+            StartTrackAtIndex(plist, plist.currentIndex);
+        }
+        else
+        {
+            StartNextTrack(plist);
+        }
+    }
+    else if (plist.playback.loopPlaylist && plist.tracks.size() == 1)
+    {
+        StartTrackAtIndex(plist, plist.currentIndex);
+    }
+    else if (plist.playback.loopPlaylist || plist.tracks.size() > 1)
+    {
+        StartNextTrack(plist);
+    }
+    else
+    {
+        plist.isPlaying = false;
+        plist.currentChannel = nullptr;
+        plist.resume = PlaylistResumePoint();
+        spdlog::info("Playlist '{}' finished playing (no loop option).", plist.name);
+    }
+}
+
+// Read once per track: the rest of the segment is then counted on the frame clock.
+float PlaylistManager::GetSegmentEnd(const Playlist& plist, FMOD::Channel* channel) const
+{
+    FMOD::Sound* sound = nullptr;
+    unsigned int lengthMs = 0;
+    unsigned int positionMs = 0;
+    if (channel->getCurrentSound(&sound) != FMOD_OK || !sound ||
+        sound->getLength(&lengthMs, FMOD_TIMEUNIT_MS) != FMOD_OK || lengthMs == 0)
+    {
+        return -1.0f;
+    }
+    channel->getPosition(&positionMs, FMOD_TIMEUNIT_MS);
+
+    // Un morceau plus court que le segment passe la main une demi-seconde avant sa fin
+    const float remaining = (lengthMs > positionMs ? lengthMs - positionMs : 0) / 1000.0f - 0.5f;
+    return std::min(plist.segmentMaxDuration, plist.segmentTimer + std::max(0.0f, remaining));
+}
+
+bool PlaylistManager::IsGapless(const Playlist& plist) const
+{
+    return !plist.playback.randomSegment && (plist.playback.gapless || plist.playback.crossfadeDuration <= 0.0f);
+}
+
+// Clock of the output's mixer at which `channel`, `positionPcm` into its sound at `clock`,
+// reaches the end of the audio, the last `tailPcm` samples excluded. 0 if the sound cannot tell.
+unsigned long long PlaylistManager::GetClockAtTrackEnd(const Playlist& plist, FMOD::Channel* channel, unsigned long long clock,
+                                                       unsigned int positionPcm, unsigned int tailPcm) const
+{
+    FMOD::Sound* sound = nullptr;
+    unsigned int lengthPcm = 0;
+    float frequency = 0.0f;
+    if (channel->getCurrentSound(&sound) != FMOD_OK || !sound ||
+        sound->getLength(&lengthPcm, FMOD_TIMEUNIT_PCM) != FMOD_OK ||
+        channel->getFrequency(&frequency) != FMOD_OK || frequency <= 0.0f ||
+        lengthPcm <= positionPcm + tailPcm)
+    {
+        return 0;
+    }
+
+    const int outputRate = AudioManager::GetInstance().GetOutputSampleRate(GetZoneOutput(plist.zone));
+    const double outputSamples = double(lengthPcm - tailPcm - positionPcm) * outputRate / frequency;
+    return clock + static_cast<unsigned long long>(std::llround(outputSamples));
+}
+
+// The channel starts on `startClock` and is cut where its audio ends, so the next one can
+// start on that very sample. The encoder delay is skipped.
+FMOD::Channel* PlaylistManager::PlayGapless(Playlist& plist, int index, unsigned long long startClock, unsigned int startPcm,
+                                            float volume, unsigned long long& endClock)
+{
+    auto& audioManager = AudioManager::GetInstance();
+    const std::string track = plist.tracks[index];
+
+    unsigned int leadInPcm = 0;
+    unsigned int tailPcm = 0;
+    audioManager.GetGaplessTrim(track, leadInPcm, tailPcm);
+    startPcm = std::max(startPcm, leadInPcm);
+
+    FMOD::Channel* ch = audioManager.PlaySoundScheduled(track, startClock, volume, GetZoneOutput(plist.zone), startPcm);
+    if (!ch) return nullptr;
+
+    endClock = GetClockAtTrackEnd(plist, ch, startClock, startPcm, tailPcm);
+    if (endClock > 0)
+    {
+        ch->setDelay(startClock, endClock, true);
+    }
+    return ch;
+}
+
+void PlaylistManager::QueueFollowingTrack(Playlist& plist)
+{
+    if (!plist.currentChannel || plist.queuedChannel) return;
+
+    const int index = GetFollowingIndex(plist);
+    if (index < 0) return;
+    // Un flux ne se joue que sur un canal : le même morceau à la suite repart à la fin du premier
+    if (plist.tracks[index] == plist.tracks[plist.currentIndex]) return;
+
+    // Après un fondu, le morceau courant n'a pas encore de fin sur l'horloge
+    if (plist.currentEndClock == 0)
+    {
+        unsigned long long clock = 0;
+        unsigned int positionPcm = 0;
+        unsigned int leadInPcm = 0;
+        unsigned int tailPcm = 0;
+        if (plist.currentChannel->getDSPClock(nullptr, &clock) != FMOD_OK ||
+            plist.currentChannel->getPosition(&positionPcm, FMOD_TIMEUNIT_PCM) != FMOD_OK)
+        {
+            return;
+        }
+        AudioManager::GetInstance().GetGaplessTrim(plist.tracks[plist.currentIndex].str(), leadInPcm, tailPcm);
+        plist.currentEndClock = GetClockAtTrackEnd(plist, plist.currentChannel, clock, positionPcm, tailPcm);
+        if (plist.currentEndClock == 0) return;
+        plist.currentChannel->setDelay(0, plist.currentEndClock, true);
+    }
+
+    const float userVolume = UIManager::GetInstance().GetMasterVolume() * UIManager::GetInstance().GetMusicVolume();
+    unsigned long long endClock = 0;
+    FMOD::Channel* ch = PlayGapless(plist, index, plist.currentEndClock, 0, userVolume, endClock);
+    if (!ch) return;
+
+    RouteToZone(plist, ch);
+    m_channelEnds.Watch(ch, plist.zone);
+    plist.queuedChannel = ch;
+    plist.queuedIndex = index;
+    plist.queuedTrack = plist.tracks[index];
+    plist.queuedEndClock = endClock;
+}
+
+// The queued channel is already audible; only the bookkeeping of StartNextTrack is left.
+void PlaylistManager::PromoteQueuedTrack(Playlist& plist)
+{
+    int index = plist.queuedIndex;
+    if (index < 0 || index >= (int)plist.tracks.size() || plist.tracks[index] != plist.queuedTrack)
+    {
+        // La playlist a été modifiée entre-temps
+        index = std::clamp(index, 0, (int)plist.tracks.size() - 1);
+        for (size_t i = 0; i < plist.tracks.size(); i++)
+        {
+            if (plist.tracks[i] == plist.queuedTrack)
+            {
+                index = static_cast<int>(i);
+                break;
+            }
+        }
+    }
+    if (plist.playback.randomOrder)
+    {
+        plist.randomIndexPos++;
+    }
+
+    plist.currentChannel = plist.queuedChannel;
+    plist.currentIndex = index;
+    plist.currentEndClock = plist.queuedEndClock;
+    plist.queuedChannel = nullptr;
+    plist.queuedIndex = -1;
+    plist.queuedEndClock = 0;
+    m_shuffle.RecordPlay(plist.tracks[index]);
+
+    plist.trackElapsed = 0.0f;
+    plist.plannedStopSec = -1.0f;
+    if (!plist.plannedDurations.empty())
+    {
+        plist.plannedStopSec = plist.plannedDurations.front();
+        plist.plannedDurations.pop_front();
+    }
+    plist.cuePlanDirty = true;
+
+    QueueFollowingTrack(plist);
+}
+
+void PlaylistManager::CancelQueuedTrack(Playlist& plist)
+{
+    if (plist.queuedChannel)
+    {
+        plist.queuedChannel->stop();
+        plist.queuedChannel = nullptr;
     }
+    plist.queuedIndex = -1;
+    plist.queuedEndClock = 0;
+    plist.currentEndClock = 0;
 }
 
 void PlaylistManager::PrepareRandomOrder(Playlist& plist)
 {
-    int size = (int)plist.tracks.size();
-    plist.randomIndices.resize(size);
-    for (int i = 0; i < size; i++)
-        plist.randomIndices[i] = i;
+    plist.randomIndices = m_shuffle.BuildOrder(plist.tracks);
+}
+
+void PlaylistManager::SetCuePlanningEnabled(bool enabled)
+{
+    m_cuePlanningEnabled = enabled;
+    InvalidateCuePlans();
+}
 
-    std::shuffle(plist.randomIndices.begin(), plist.randomIndices.end(), m_rng);
+void PlaylistManager::SetCuePlanMaxTrim(float seconds)
+{
+    m_cuePlanMaxTrim = std::max(0.0f, seconds);
+    InvalidateCuePlans();
 }
 
-const PlaylistManager::Playlist* PlaylistManager::GetPlaylistByName(const std::string& name) const
+void PlaylistManager::InvalidateCuePlans()
+{
+    for (auto& slot : m_slots)
+    {
+        slot.playlist.cuePlanDirty = true;
+    }
+}
+
+bool PlaylistManager::HasCuePlan(ZoneId zone) const
+{
+    const Playlist* activePlaylist = GetActivePlaylist(zone);
+    return activePlaylist && activePlaylist->isPlaying && activePlaylist->plannedStopSec >= 0.0f;
+}
+
+CuePlanItem PlaylistManager::GetCuePlanItem(const Playlist& plist, unsigned int lengthMs, bool crossfadeIn) const
+{
+    // Temps entre le début du morceau et la transition suivante, tel que Update le mesure
+    const float crossfade = crossfadeIn ? plist.playback.crossfadeDuration : 0.0f;
+    const float lengthSec = lengthMs / 1000.0f;
+
+    float longest = lengthSec;
+    float shortest = lengthSec - std::min(m_cuePlanMaxTrim, lengthSec * 0.5f);
+    if (plist.segmentModeActive)
+    {
+        if (lengthSec > plist.segmentMaxDuration)
+        {
+            longest = crossfade + plist.segmentMaxDuration;
+            shortest = longest - std::min(m_cuePlanMaxTrim, plist.segmentMaxDuration * 0.5f);
+        }
+        else
+        {
+            longest = std::max(0.0f, lengthSec - 0.5f);
+        }
+    }
+    // Planned stops are only checked once the crossfade is over.
+    shortest = std::min(longest, std::max(shortest, crossfade + 0.5f));
+
+    CuePlanItem item;
+    item.maxMs = static_cast<uint32_t>(longest * 1000.0f);
+    item.minMs = static_cast<uint32_t>(shortest * 1000.0f);
+    return item;
+}
+
+void PlaylistManager::PlanToNextCue(Playlist& plist)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&name](const Playlist& p){ return p.name == name; });
-    if (it != m_playlists.end()) {
-        return &(*it);
+    plist.cuePlanDirty = false;
+    plist.cuePlanRevision = AnnouncementManager::GetInstance().GetScheduleRevision();
+    plist.plannedStopSec = -1.0f;
+    plist.plannedDurations.clear();
+
+    if (!m_cuePlanningEnabled || plist.tracks.size() < 2) return;
+
+    const float cueIn = AnnouncementManager::GetInstance().GetSecondsUntilNextSchedule();
+    if (cueIn <= 0.0f || cueIn > m_cuePlanHorizon) return;
+
+    FMOD::Sound* sound = nullptr;
+    unsigned int lengthMs = 0;
+    unsigned int positionMs = 0;
+    if (plist.currentChannel->getCurrentSound(&sound) != FMOD_OK || !sound ||
+        sound->getLength(&lengthMs, FMOD_TIMEUNIT_MS) != FMOD_OK || lengthMs == 0)
+    {
+        return;
+    }
+    plist.currentChannel->getPosition(&positionMs, FMOD_TIMEUNIT_MS);
+
+    // Ce qui reste du morceau courant, avec la même marge de coupe que les suivants
+    float remaining = (lengthMs > positionMs ? lengthMs - positionMs : 0) / 1000.0f;
+    if (plist.segmentModeActive)
+    {
+        remaining = (lengthMs / 1000.0f > plist.segmentMaxDuration)
+                    ? plist.segmentMaxDuration - plist.segmentTimer
+                    : remaining - 0.5f;
+    }
+    const CuePlanItem whole = GetCuePlanItem(plist, lengthMs, false);
+    const float cut = (whole.maxMs - whole.minMs) / 1000.0f;
+
+    CuePlanRequest request;
+    request.current.maxMs = static_cast<uint32_t>(std::max(0.0f, remaining) * 1000.0f);
+    request.current.minMs = static_cast<uint32_t>(std::max(0.0f, remaining - cut) * 1000.0f);
+    request.cueInMs = static_cast<uint32_t>(cueIn * 1000.0f);
+    request.reorder = plist.playback.randomOrder;
+
+    const size_t MaxUpcoming = 64;
+    std::vector<int> upcoming;
+    if (plist.playback.randomOrder)
+    {
+        for (int pos = plist.randomIndexPos + 1; pos < (int)plist.randomIndices.size() && upcoming.size() < MaxUpcoming; pos++)
+        {
+            upcoming.push_back(plist.randomIndices[pos]);
+        }
+    }
+    else
+    {
+        for (int offset = 1; offset < (int)plist.tracks.size() && upcoming.size() < MaxUpcoming; offset++)
+        {
+            int index = plist.currentIndex + offset;
+            if (index >= (int)plist.tracks.size())
+            {
+                if (!plist.playback.loopPlaylist) break;
+                index -= (int)plist.tracks.size();
+            }
+            upcoming.push_back(index);
+        }
+    }
+
+    auto& audioManager = AudioManager::GetInstance();
+    for (int index : upcoming)
+    {
+        const unsigned int trackLengthMs = audioManager.GetSoundLengthMs(plist.tracks[index]);
+        request.upcoming.push_back(trackLengthMs > 0 ? GetCuePlanItem(plist, trackLengthMs, true) : CuePlanItem());
+    }
+
+    CuePlan plan = PlanToCue(request);
+    if (!plan.found)
+    {
+        spdlog::debug("Playlist '{}': no track boundary can land on the announcement in {:.1f}s.", plist.name, cueIn);
+        return;
+    }
+
+    if (request.reorder)
+    {
+        std::vector<int> reordered;
+        std::vector<bool> chosen(upcoming.size(), false);
+        for (size_t entry : plan.order)
+        {
+            reordered.push_back(upcoming[entry]);
+            chosen[entry] = true;
+        }
+        for (size_t entry = 0; entry < upcoming.size(); entry++)
+        {
+            if (!chosen[entry]) reordered.push_back(upcoming[entry]);
+        }
+        std::copy(reordered.begin(), reordered.end(), plist.randomIndices.begin() + plist.randomIndexPos + 1);
+    }
+
+    plist.plannedStopSec = plist.trackElapsed + plan.currentMs / 1000.0f;
+    for (uint32_t durationMs : plan.durationsMs)
+    {
+        plist.plannedDurations.push_back(durationMs / 1000.0f);
     }
-    return nullptr;
+
+    spdlog::debug("Playlist '{}': {} track change(s) planned so the announcement in {:.1f}s starts on a boundary.",
+                 plist.name, plan.order.size() + 1, cueIn);
+}
+
+const PlaylistManager::Playlist* PlaylistManager::GetPlaylistByName(const std::string& name) const
+{
+    return GetPlaylist(GetPlaylistHandle(name));
 }
 
 void PlaylistManager::MoveTrackUp(const std::string& playlistName, int index)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p){ return p.name == playlistName; });
-    if (it == m_playlists.end()) return;
-    auto& plist = *it;
+    Playlist* playlist = GetPlaylistByName(playlistName);
+    if (!playlist) return;
+    auto& plist = *playlist;
     if (index <= 0 || index >= (int)plist.tracks.size()) return;
 
-    std::swap(plist.tracks[index], plist.tracks[index-1]);
+    plist.tracks.move(index, index - 1);
+
+    PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TrackMoved, playlistName);
+    event.fromIndex = static_cast<size_t>(index);
+    event.toIndex = static_cast<size_t>(index - 1);
+    EmitChange(std::move(event));
 }
 
 void PlaylistManager::MoveTrackDown(const std::string& playlistName, int index)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p){ return p.name == playlistName; });
-    if (it == m_playlists.end()) return;
-    auto& plist = *it;
+    Playlist* playlist = GetPlaylistByName(playlistName);
+    if (!playlist) return;
+    auto& plist = *playlist;
     if (index < 0 || index >= (int)plist.tracks.size() - 1) return;
 
-    std::swap(plist.tracks[index], plist.tracks[index+1]);
+    plist.tracks.move(index, index + 1);
+
+    PlaylistChangeEvent event = MakeChangeEvent(PlaylistChangeType::TrackMoved, playlistName);
+    event.fromIndex = static_cast<size_t>(index);
+    event.toIndex = static_cast<size_t>(index + 1);
+    EmitChange(std::move(event));
 }
 
 void PlaylistManager::PlayFromIndex(const std::string& playlistName, int index)
 {
     Stop(playlistName);
 
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p){ return p.name == playlistName; });
-    if (it == m_playlists.end()) return;
+    Playlist* playlist = GetPlaylistByName(playlistName);
+    if (!playlist) return;
 
-    Playlist& plist = *it;
+    Playlist& plist = *playlist;
     if (index < 0 || index >= (int)plist.tracks.size()) return;
 
-    if (!plist.isPlaying) {
-        PlaylistOptions opts;
-        plist.options = opts;
-    }
-    
+    // Reprend la zone où la playlist a joué en dernier
+    ActivateInZone(plist, GetZone(plist.zone) ? plist.zone : MainZone);
+
+    plist.playback = plist.options;
     plist.isPlaying = true;
     plist.currentIndex = index;
     plist.currentChannel = nullptr;
@@ -1195,38 +2684,37 @@ void PlaylistManager::PlayFromIndex(const std::string& playlistName, int index)
     plist.isCrossfading = false;
     plist.crossfadeTimer = 0.0f;
 
-    plist.segmentModeActive = plist.options.randomSegment;
+    plist.segmentModeActive = plist.playback.randomSegment;
     plist.segmentTimer = 0.0f;
 
     StartTrackAtIndex(plist, index);
 }
 
-std::string PlaylistManager::GetTrackName(int index) const
+std::string PlaylistManager::GetTrackName(int index, ZoneId zone) const
 {
-    auto* activePlaylist = GetActivePlaylist();
+    auto* activePlaylist = GetActivePlaylist(zone);
     if (!activePlaylist || index < 0 || index >= (int)activePlaylist->tracks.size()) return "";
     return activePlaylist->tracks[index];
 }
 
-std::string PlaylistManager::GetTrackDuration(int index) const
+std::string PlaylistManager::GetTrackDuration(int index, ZoneId zone) const
 {
-    auto* activePlaylist = GetActivePlaylist();
+    auto* activePlaylist = GetActivePlaylist(zone);
     if (!activePlaylist || index < 0 || index >= (int)activePlaylist->tracks.size()) return "";
     return activePlaylist->tracks[index];
 }
 
 void PlaylistManager::SkipToNextTrack(const std::string& playlistName)
 {
-    auto it = std::find_if(m_playlists.begin(), m_playlists.end(),
-        [&playlistName](const Playlist& p) { return p.name == playlistName; });
+    Playlist* playlist = GetPlaylistByName(playlistName);
 
-    if (it == m_playlists.end() || !it->isPlaying)
+    if (!playlist || !playlist->isPlaying)
     {
         spdlog::error("Playlist '{}' not found or not playing.", playlistName);
         return;
     }
 
-    Playlist& plist = *it;
+    Playlist& plist = *playlist;
     
     if (plist.isCrossfading)
     {
@@ -2,10 +2,20 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <unordered_map>
 #include <random>
 #include <fmod.hpp>
 #include <map>
 #include <functional>
+#include <cstdint>
+#include "tsm_indexed_sequence.h"
+#include "tsm_track_id.h"
+#include "tsm_shuffle_engine.h"
+#include "tsm_cue_planner.h"
+#include "tsm_fmod_wrapper.h"
+#include "tsm_crossfade_curve.h"
+#include "tsm_channel_end_queue.h"
 
 namespace TSM
 {
@@ -16,8 +26,93 @@ struct PlaylistOptions
     bool randomSegment = false;  
     float segmentDuration = 30.0f; 
     bool loopPlaylist = false;  
+    float crossfadeDuration = 10.0f;
+    CrossfadeCurve crossfadeCurve = CrossfadeCurve::EqualPower;
+    float crossfadeShape = 2.0f;        // exponent of CrossfadeCurve::Custom
+    bool gapless = false;               // tracks join on the sample; also when crossfadeDuration is 0
+
+    bool operator==(const PlaylistOptions& other) const = default;
+};
+
+// Stable reference to a playlist. The generation is bumped every time a slot is
+// released, so a handle to a deleted playlist never resolves to its successor.
+struct PlaylistHandle
+{
+    static constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+    uint32_t index = InvalidIndex;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != InvalidIndex; }
+    bool operator==(const PlaylistHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const PlaylistHandle& other) const { return !(*this == other); }
+};
+
+// Hand-over from the playlist playing in a zone to another one.
+struct PlaylistTransition
+{
+    float duration = 4.0f;
+    CrossfadeCurve curve = CrossfadeCurve::EqualPower;
+    float shape = 2.0f;                 // CrossfadeCurve::Custom
+};
+
+// Where a playlist was when it stopped, and where Resume starts it again.
+struct PlaylistResumePoint
+{
+    TrackId track;                      // checked on resume, the playlist may have been edited
+    int index = -1;
+    int randomIndexPos = 0;
+    unsigned int positionPcm = 0;
+    float segmentTimer = 0.0f;
+    float segmentMaxDuration = 0.0f;
+    float chosenStartTime = 0.0f;
+    PlaylistOptions options;            // the stopped run's, Resume plays with them again
+    bool valid = false;
+};
+
+// Index of a playback zone; ids of removed zones are given to the next zone created.
+using ZoneId = uint32_t;
+
+enum class PlaylistChangeType
+{
+    Created,
+    Deleted,
+    Renamed,
+    TracksInserted,
+    TracksRemoved,
+    TrackMoved,
+    OptionsChanged,
+    TracksReplaced, // the whole track list changed at once (undo / redo)
+    Reloaded        // every playlist was replaced, listeners must rescan
 };
 
+struct PlaylistChangeEvent
+{
+    PlaylistChangeType type = PlaylistChangeType::Reloaded;
+    PlaylistHandle playlist;
+    std::string playlistName;
+    std::string previousName;           // Renamed
+
+    size_t index = 0;                   // TracksInserted / TracksRemoved : first affected index ; Created : position in the library
+    std::vector<TrackId> tracks;        // TracksInserted / TracksRemoved / Created / TracksReplaced : affected tracks
+
+    size_t fromIndex = 0;               // TrackMoved
+    size_t toIndex = 0;
+};
+
+// Immutable copy of one playlist. The tracks share their storage with the live playlist
+// until one of the two is edited.
+struct PlaylistVersion
+{
+    std::string name;
+    IndexedSequence<TrackId> tracks;
+    PlaylistOptions options;
+};
+
+// Playlists in library order. Versions share the entries of the playlists that did not
+// change between them, so each step costs only the playlists it touched.
+using LibraryVersion = IndexedSequence<PlaylistVersion>;
+
 class PlaylistManager
 {
 public:
@@ -27,47 +122,109 @@ public:
         return instance;
     }
 
+    static constexpr ZoneId MainZone = 0;
+    static constexpr ZoneId InvalidZone = 0xFFFFFFFFu;
+
     void CreatePlaylist(const std::string& playlistName);
     void DeletePlaylist(const std::string& playlistName);
     void RenamePlaylist(const std::string& oldName, const std::string& newName);
     void DuplicatePlaylist(const std::string& sourceName, const std::string& destName);
     
     void AddToPlaylist(const std::string& playlistName, const std::string& soundName);
+    void AddTracksToPlaylist(const std::string& playlistName, const std::vector<std::string>& soundNames);
     void RemoveFromPlaylist(const std::string& playlistName, const std::string& soundName);
     void RemoveFromPlaylistAtIndex(const std::string& playlistName, size_t index);
     void ClearPlaylist(const std::string& playlistName);
+    // Turns the playlist into `tracks` with removals, moves and inserts only: entries present
+    // in both lists stay untouched, so a playing playlist keeps its current track and channel.
+    bool ReconcilePlaylist(const std::string& playlistName, const std::vector<std::string>& tracks);
     
     bool ExportPlaylist(const std::string& playlistName, const std::string& filePath);
     bool ImportPlaylist(const std::string& filePath, const std::string& playlistName = "");
 
-    void Play(const std::string& playlistName, const PlaylistOptions& options);
+    // A playlist plays in one zone at a time; starting it elsewhere moves it. `options` only
+    // drive this run, the stored ones change through SetPlaylistOptions.
+    void Play(const std::string& playlistName, const PlaylistOptions& options, ZoneId zone = MainZone);
     void Stop(const std::string& playlistName);
+    void StopZone(ZoneId zone);
+    // Every stop remembers the track, its sample offset, the shuffle position and the
+    // segment timer; Resume starts the playlist again from there, pre-seeked before it is
+    // heard. False, and nothing stopped, when there is no usable resume point.
+    bool Resume(const std::string& playlistName, ZoneId zone = MainZone);
+    bool HasResumePoint(const std::string& playlistName) const;
+    void ClearResumePoint(const std::string& playlistName);
+    // The live position while the playlist plays, the saved point otherwise.
+    PlaylistResumePoint GetResumePoint(const std::string& playlistName) const;
+    bool SetResumePoint(const std::string& playlistName, const PlaylistResumePoint& point);
+    // Crossfades the zone's current channel straight into the first track of `playlistName`,
+    // which is opened before the old playlist is touched: if it cannot be, nothing changes.
+    // Falls back to Play when the zone is silent.
+    bool TransitionToPlaylist(const std::string& playlistName, const PlaylistOptions& options,
+                              const PlaylistTransition& transition = {}, ZoneId zone = MainZone);
+    bool IsInTransition(ZoneId zone = MainZone) const;
+    float GetTransitionProgress(ZoneId zone = MainZone) const;
 
     void Update(float deltaTime);
 
-    std::string GetCurrentTrackName() const;
-    std::string GetTrackName(int index) const;
+    // Zones (lobby, terrace, hall...) each play their own playlist at the same time, with
+    // their own crossfades, volume and ducking, through their own FMOD channel group.
+    // The main zone always exists and is the one used when no zone is given.
+    ZoneId CreateZone(const std::string& name);
+    bool RemoveZone(ZoneId zone);
+    ZoneId FindZone(const std::string& name) const;
+    std::vector<std::string> GetZoneNames() const;     // indexed by ZoneId, "" for free ids
+    void SetZoneVolume(ZoneId zone, float volume);
+    float GetZoneVolume(ZoneId zone) const;
+    void SetZoneDuckFactor(ZoneId zone, float factor);
+    float GetZoneDuckFactor(ZoneId zone) const;
+    FMOD::ChannelGroup* GetZoneChannelGroup(ZoneId zone) const;
+    // Tracks started after the change play on that output; the current one finishes where it is.
+    bool SetZoneOutput(ZoneId zone, OutputId output);
+    OutputId GetZoneOutput(ZoneId zone) const;
+
+    std::string GetCurrentTrackName(ZoneId zone = MainZone) const;
+    std::string GetTrackName(int index, ZoneId zone = MainZone) const;
     std::string GetCurrentTrackDuration() const;
-    std::string GetTrackDuration(int index) const;
+    std::string GetTrackDuration(int index, ZoneId zone = MainZone) const;
     
     std::vector<std::string> GetPlaylistNames() const;
     bool IsPlaylistPlaying(const std::string& playlistName) const;
     size_t GetPlaylistTrackCount(const std::string& playlistName) const;
 
-    float GetTrackProgress() const;   
-    float GetSegmentProgress() const; 
+    float GetTrackProgress(ZoneId zone = MainZone) const;   
+    float GetSegmentProgress(ZoneId zone = MainZone) const; 
 
-    void SetCrossfadeDuration(float duration);
+    // Current run only, like the options given to Play.
+    void SetCrossfadeDuration(float duration, ZoneId zone = MainZone);
 
-    FMOD::Channel* GetCurrentChannel() const;
-    bool IsInCrossfade() const;
-    float GetCrossfadeProgress() const;
-    FMOD::Channel* GetNextChannel() const;
+    FMOD::Channel* GetCurrentChannel(ZoneId zone = MainZone) const;
+    bool IsInCrossfade(ZoneId zone = MainZone) const;
+    float GetCrossfadeProgress(ZoneId zone = MainZone) const;
+    FMOD::Channel* GetNextChannel(ZoneId zone = MainZone) const;
+    // Gapless: the following track, waiting on the DSP clock for the current one to end.
+    FMOD::Channel* GetQueuedChannel(ZoneId zone = MainZone) const;
     
     void SkipToNextTrack(const std::string& playlistName);
 
+    // Orders shuffled playlists and keeps the play history they are spread against.
+    ShuffleEngine& GetShuffleEngine() { return m_shuffle; }
+
+    // Lands a track boundary on the next scheduled announcement by cutting track ends
+    // (or segments) short, up to maxTrimSec each; shuffled playlists may also pick which
+    // of the coming tracks play before it. Re-planned on every track start, playlist
+    // edit and schedule change.
+    void SetCuePlanningEnabled(bool enabled);
+    bool IsCuePlanningEnabled() const { return m_cuePlanningEnabled; }
+    void SetCuePlanMaxTrim(float seconds);
+    bool HasCuePlan(ZoneId zone = MainZone) const;
+
 private:
-    PlaylistManager() : m_rng(std::random_device{}()) {}
+    PlaylistManager() : m_rng(std::random_device{}())
+    {
+        m_zones.resize(1);
+        m_zones[MainZone].name = "main";
+        m_zones[MainZone].occupied = true;
+    }
     ~PlaylistManager() = default;
     PlaylistManager(const PlaylistManager&) = delete;
     PlaylistManager& operator=(const PlaylistManager&) = delete;
@@ -75,11 +232,13 @@ private:
     struct Playlist
     {
         std::string name;
-        std::vector<std::string> tracks;
+        IndexedSequence<TrackId> tracks;
         bool isPlaying = false;
 
         PlaylistOptions options;
+        PlaylistOptions playback;           // the current run's: Play's, never saved or journaled
 
+        ZoneId zone = MainZone;
         int currentIndex = -1;
         std::vector<int> randomIndices;
         int randomIndexPos = 0;
@@ -87,7 +246,15 @@ private:
         FMOD::Channel* currentChannel = nullptr;
         FMOD::Channel* nextChannel = nullptr;
 
-        float crossfadeDuration = 10.0f;
+        // Gapless : the following track is already playing on the DSP clock, delayed to the
+        // sample where the current one is cut.
+        FMOD::Channel* queuedChannel = nullptr;
+        int queuedIndex = -1;
+        TrackId queuedTrack;
+        unsigned long long currentEndClock = 0; // 0 while the current track is not cut on the clock
+        unsigned long long queuedEndClock = 0;
+
+        CrossfadeTable crossfadeTable;      // options' curve, taken when the crossfade starts
         float crossfadeTimer = 0.0f;
         bool isCrossfading = false;
 
@@ -98,19 +265,112 @@ private:
         float segmentMaxDuration = 0.0f;
         bool segmentModeActive = false;
         float chosenStartTime = 0.0f;
+
+        float trackElapsed = 0.0f;          // since the current track started, crossfade included
+        float plannedStopSec = -1.0f;       // when to move on, -1 if the track plays out
+        float segmentEndSec = -1.0f;        // segment time at which the segment gives way, -1 outside segment mode
+        std::deque<float> plannedDurations; // same for the tracks that follow, in order
+        bool cuePlanDirty = true;
+        uint64_t cuePlanRevision = 0;       // schedule revision the plan was made for
+
+        PlaylistResumePoint resume;
+    };
+
+    struct PlaylistSlot
+    {
+        Playlist playlist;
+        uint32_t generation = 0;
+        bool occupied = false;
+        size_t orderIndex = 0;              // position in m_playlistOrder
+    };
+
+    static constexpr float StopFadeSeconds = 1.5f;
+
+    struct FadingChannel
+    {
+        FMOD::Channel* channel = nullptr;
+        float startVolume = 1.0f;
+    };
+
+    struct ZoneTransition
+    {
+        std::vector<FadingChannel> outgoing;    // channels of the playlists handed over
+        FMOD::Channel* incoming = nullptr;      // first track of the new playlist
+        float timer = 0.0f;
+        float duration = 0.0f;
+        CrossfadeTable table;
+        bool active = false;
     };
 
-    Playlist* m_currentPlaylist = nullptr;
-    std::string m_activePlaylistName;
+    struct Zone
+    {
+        std::string name;
+        PlaylistHandle activePlaylist;
+        FMOD::ChannelGroup* group = nullptr;
+        OutputId output = FModWrapper::MainOutput;
+        float volume = 1.0f;
+        float duckFactor = 1.0f;
+        ZoneTransition transition;
+        bool occupied = false;
+    };
 
+    Zone* GetZone(ZoneId zone);
+    const Zone* GetZone(ZoneId zone) const;
+    void ActivateInZone(Playlist& plist, ZoneId zone);
+    void ApplyZoneVolume(Zone& zone);
+    void RouteToZone(const Playlist& plist, FMOD::Channel* channel);
+    void HandOver(Playlist& plist, ZoneTransition& transition);
+    void UpdateTransition(Zone& zone, float deltaTime, float musicVolume);
+    void EndTransition(ZoneTransition& transition);
+
+    // Update ne parcourt que ce tableau, pas toutes les playlists
+    std::vector<Zone> m_zones;
 
     void StartNextTrack(Playlist& plist);
-    void StartTrackAtIndex(Playlist& plist, int index);
+    void StartTrackAtIndex(Playlist& plist, int index, bool silent = false, unsigned int startPcm = 0);
+    void SaveResumePoint(Playlist& plist);
+    PlaylistResumePoint MakeResumePoint(const Playlist& plist) const;
+    void ResetPlayback(Playlist& plist, const PlaylistOptions& options);
     void PrepareRandomOrder(Playlist& plist);
     void FinishCrossfade(Playlist& plist);
+    void OnChannelEnded(Playlist& plist, FMOD::Channel* channel);
+    void OnTrackEnded(Playlist& plist);
+    float GetSegmentEnd(const Playlist& plist, FMOD::Channel* channel) const;
+    bool IsGapless(const Playlist& plist) const;
+    int GetFollowingIndex(Playlist& plist);
+    FMOD::Channel* PlayGapless(Playlist& plist, int index, unsigned long long startClock, unsigned int startPcm,
+                               float volume, unsigned long long& endClock);
+    unsigned long long GetClockAtTrackEnd(const Playlist& plist, FMOD::Channel* channel, unsigned long long clock,
+                                          unsigned int positionPcm, unsigned int tailPcm) const;
+    void QueueFollowingTrack(Playlist& plist);
+    void PromoteQueuedTrack(Playlist& plist);
+    void CancelQueuedTrack(Playlist& plist);
+    void FollowPlayingTrack(Playlist& plist, const IndexedSequence<TrackId>& previous);
+    void SwitchPlayingTrack(Playlist& plist, int index);
+    void StopPlaylist(Playlist& plist);
+    static void FadeOutChannel(FMOD::Channel* channel, float seconds);
+    void PlanToNextCue(Playlist& plist);
+    void InvalidateCuePlans();
+    CuePlanItem GetCuePlanItem(const Playlist& plist, unsigned int lengthMs, bool crossfadeIn) const;
+
+    PlaylistHandle AllocatePlaylist(Playlist&& playlist);
+    void ReleasePlaylist(PlaylistHandle handle);
 
-    std::vector<Playlist> m_playlists;
+    // std::deque never relocates existing elements on push_back, so Playlist* stay valid.
+    std::deque<PlaylistSlot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    std::unordered_map<std::string, PlaylistHandle> m_nameIndex;
+    std::vector<PlaylistHandle> m_playlistOrder;
     std::mt19937 m_rng;
+    ShuffleEngine m_shuffle;
+
+    // Fins de morceau signalées par FMOD, taguées par zone
+    ChannelEndQueue m_channelEnds;
+    std::vector<ChannelEndEvent> m_endedChannels;
+
+    bool m_cuePlanningEnabled = true;
+    float m_cuePlanMaxTrim = 30.0f;
+    float m_cuePlanHorizon = 3600.0f;
 
 public:
     void MoveTrackUp(const std::string& playlistName, int index);
@@ -122,19 +382,73 @@ public:
     bool SavePlaylistsToFile(const std::string& filePath);
     bool LoadPlaylistsFromFile(const std::string& filePath);
     
-    using PlaylistChangeCallback = std::function<void()>;
-    void RegisterPlaylistChangeCallback(PlaylistChangeCallback callback);
+    using PlaylistChangeCallback = std::function<void(const std::vector<PlaylistChangeEvent>&)>;
+    using SubscriptionToken = uint64_t;
+    SubscriptionToken RegisterPlaylistChangeCallback(PlaylistChangeCallback callback);
+    void UnregisterPlaylistChangeCallback(SubscriptionToken token);
+
+    void SetPlaylistOptions(const std::string& playlistName, const PlaylistOptions& options);
+    void SetPlaylistCrossfadeDuration(const std::string& playlistName, float duration);
+    void SetPlaylistCrossfadeCurve(const std::string& playlistName, CrossfadeCurve curve, float shape = 2.0f);
+
+    // Edits made between BeginBatch/EndBatch are delivered as one list of events
+    // when the outermost batch ends. Batches may be nested.
+    void BeginBatch();
+    void EndBatch();
+    bool IsInBatch() const { return m_batchDepth > 0; }
+
+    class BatchScope
+    {
+    public:
+        BatchScope() { PlaylistManager::GetInstance().BeginBatch(); }
+        ~BatchScope() { PlaylistManager::GetInstance().EndBatch(); }
+        BatchScope(const BatchScope&) = delete;
+        BatchScope& operator=(const BatchScope&) = delete;
+    };
+
+    // Each change made outside a batch, and each outermost batch, is one undo step.
+    // Steps only hold the playlists as they were: unchanged tracks are shared, not copied.
+    bool Undo();
+    bool Redo();
+    bool CanUndo() const { return !m_undoStack.empty(); }
+    bool CanRedo() const { return !m_redoStack.empty(); }
+    void ClearHistory();
+    void SetHistoryLimit(size_t steps);
+
+    // Playlists as of the last completed change; a batch in progress is not visible.
+    const LibraryVersion& GetLibraryVersion() const { return m_committedVersion; }
+
+    PlaylistHandle GetPlaylistHandle(const std::string& name) const;
+    Playlist* GetPlaylist(PlaylistHandle handle);
+    const Playlist* GetPlaylist(PlaylistHandle handle) const;
+    bool IsValidHandle(PlaylistHandle handle) const { return GetPlaylist(handle) != nullptr; }
 
     Playlist* GetPlaylistByName(const std::string& name);
     const Playlist* GetPlaylistByName(const std::string& name) const;
-    const std::vector<Playlist>& GetAllPlaylists() const { return m_playlists; }
+    std::vector<const Playlist*> GetAllPlaylists() const;
+    PlaylistHandle GetActivePlaylistHandle(ZoneId zone = MainZone) const;
 
-    const Playlist* GetActivePlaylist() const;
-    Playlist* GetActivePlaylist();
+    const Playlist* GetActivePlaylist(ZoneId zone = MainZone) const;
+    Playlist* GetActivePlaylist(ZoneId zone = MainZone);
     
 private:
-    std::vector<PlaylistChangeCallback> m_changeCallbacks;
-    void NotifyPlaylistChanged();
+    std::vector<std::pair<SubscriptionToken, PlaylistChangeCallback>> m_changeCallbacks;
+    SubscriptionToken m_nextSubscriptionToken = 1;
+    PlaylistChangeEvent MakeChangeEvent(PlaylistChangeType type, const std::string& playlistName) const;
+    void EmitChange(PlaylistChangeEvent&& event);
+    void DispatchChanges(const std::vector<PlaylistChangeEvent>& events);
+
+    int m_batchDepth = 0;
+    std::vector<PlaylistChangeEvent> m_pendingEvents;
+
+    LibraryVersion CaptureVersion() const;
+    void CommitHistoryStep(const std::vector<PlaylistChangeEvent>& events);
+    void RestoreVersion(const LibraryVersion& version);
+
+    std::deque<LibraryVersion> m_undoStack;
+    std::deque<LibraryVersion> m_redoStack;
+    LibraryVersion m_committedVersion;
+    size_t m_historyLimit = 100;
 };
 
 } // namespace TSM
\ No newline at end of file
@@ -0,0 +1,595 @@
+// tsm_show_timeline.cpp
+
+#include "tsm_show_timeline.h"
+#include "tsm_audio_manager.h"
+#include "tsm_playlist_manager.h"
+
+#include <spdlog/spdlog.h>
+#include <json/json.hpp>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace TSM
+{
+    using json = nlohmann::json;
+
+namespace
+{
+    struct PendingTarget
+    {
+        uint32_t step;
+        bool isElse;
+        std::string name;
+    };
+
+    bool StopsTimeline(ShowStepType type)
+    {
+        return type == ShowStepType::Fade || type == ShowStepType::Wait || type == ShowStepType::WaitForEnd;
+    }
+
+    uint32_t Intern(std::vector<std::string>& table, const std::string& name)
+    {
+        auto it = std::find(table.begin(), table.end(), name);
+        if (it != table.end()) return static_cast<uint32_t>(it - table.begin());
+        table.push_back(name);
+        return static_cast<uint32_t>(table.size() - 1);
+    }
+
+    // Sounds the steps from `from` up to the next stop may play, both ways of every branch.
+    void CollectPreloads(const std::vector<ShowStep>& steps, uint32_t from, std::vector<uint32_t>& sounds)
+    {
+        std::vector<bool> visited(steps.size(), false);
+        std::vector<uint32_t> pending{ from };
+        while (!pending.empty())
+        {
+            const uint32_t index = pending.back();
+            pending.pop_back();
+            if (index >= steps.size() || visited[index]) continue;
+            visited[index] = true;
+
+            const ShowStep& step = steps[index];
+            if (StopsTimeline(step.type) || step.type == ShowStepType::End) continue;
+            if (step.type == ShowStepType::Play && std::find(sounds.begin(), sounds.end(), step.sound) == sounds.end())
+            {
+                sounds.push_back(step.sound);
+            }
+
+            if (step.type == ShowStepType::Branch)
+            {
+                pending.push_back(step.target);
+                if (step.name != ShowNoIndex) pending.push_back(step.elseTarget);
+            }
+            else
+            {
+                pending.push_back(index + 1);
+            }
+        }
+    }
+}
+
+bool ShowTimeline::LoadFile(const std::string& filePath)
+{
+    std::ifstream file(filePath.c_str());
+    if (!file.is_open())
+    {
+        spdlog::debug("No show file at '{}'.", filePath);
+        return false;
+    }
+
+    std::stringstream text;
+    text << file.rdbuf();
+    return LoadString(text.str(), filePath);
+}
+
+bool ShowTimeline::LoadString(const std::string& text, const std::string& sourceName)
+{
+    std::string showName;
+    std::vector<ShowSequence> sequences;
+    std::vector<ShowStep> steps;
+    std::vector<std::string> soundNames;
+    std::vector<std::string> names;
+    std::vector<std::string> parameterNames;
+    std::vector<float> parameters;
+    std::vector<uint32_t> preloads;
+
+    try
+    {
+        const json j = json::parse(text);
+        showName = j.value("name", sourceName);
+
+        auto parameterIndex = [&](const std::string& name) {
+            const uint32_t index = Intern(parameterNames, name);
+            if (index == parameters.size()) parameters.push_back(0.0f);
+            return index;
+        };
+        auto readValue = [&](const json& step, const char* key, float fallback) {
+            ShowValue value;
+            value.constant = fallback;
+            auto it = step.find(key);
+            if (it == step.end()) return value;
+            if (it->is_string()) value.parameter = parameterIndex(it->get<std::string>());
+            else value.constant = it->get<float>();
+            return value;
+        };
+
+        const json declared = j.value("parameters", json::object());
+        for (const auto& [name, value] : declared.items())
+        {
+            const uint32_t index = parameterIndex(name);
+            parameters[index] = value.is_boolean() ? (value.get<bool>() ? 1.0f : 0.0f) : value.get<float>();
+        }
+
+        // Les noms de séquence et les "id" d'étape sont des cibles de branchement
+        std::map<std::string, uint32_t> targets;
+        std::vector<PendingTarget> pendingTargets;
+        auto addTarget = [&](const std::string& name, uint32_t step) {
+            if (!targets.emplace(name, step).second) throw std::runtime_error("'" + name + "' is defined twice");
+        };
+
+        for (const auto& entry : j.at("sequences"))
+        {
+            ShowSequence sequence;
+            sequence.name = entry.at("name").get<std::string>();
+            sequence.label = entry.value("label", "");
+            sequence.firstStep = static_cast<uint32_t>(steps.size());
+            addTarget(sequence.name, sequence.firstStep);
+
+            uint32_t lastSound = ShowNoIndex;
+            const json items = entry.value("steps", json::array());
+            for (const auto& item : items)
+            {
+                const uint32_t index = static_cast<uint32_t>(steps.size());
+                const std::string type = item.at("type").get<std::string>();
+                ShowStep step;
+
+                if (item.contains("id")) addTarget(item["id"].get<std::string>(), index);
+
+                if (type == "fade" || type == "duck")
+                {
+                    step.type = type == "fade" ? ShowStepType::Fade : ShowStepType::Duck;
+                    step.level = readValue(item, "to", 1.0f);
+                    step.seconds = readValue(item, "seconds", 0.0f);
+                }
+                else if (type == "wait")
+                {
+                    step.type = ShowStepType::Wait;
+                    step.seconds = readValue(item, "seconds", 0.0f);
+                }
+                else if (type == "play")
+                {
+                    step.type = ShowStepType::Play;
+                    step.sound = lastSound = Intern(soundNames, item.at("sound").get<std::string>());
+                    step.bus = item.value("bus", "music") == "sfx" ? ShowBus::Sfx : ShowBus::Music;
+                    step.loop = item.value("loop", false);
+                }
+                else if (type == "stop")
+                {
+                    step.type = ShowStepType::Stop;
+                    if (item.contains("sound")) step.sound = Intern(soundNames, item["sound"].get<std::string>());
+                }
+                else if (type == "waitForEnd")
+                {
+                    step.type = ShowStepType::WaitForEnd;
+                    step.sound = item.contains("sound") ? Intern(soundNames, item["sound"].get<std::string>()) : lastSound;
+                    if (step.sound == ShowNoIndex) throw std::runtime_error("waitForEnd in '" + sequence.name + "' has no sound to wait for");
+                    step.seconds = readValue(item, "before", 0.0f);
+                }
+                else if (type == "branch" || type == "goto")
+                {
+                    step.type = ShowStepType::Branch;
+                    step.target = step.elseTarget = index + 1;
+                    if (item.contains("if")) step.name = parameterIndex(item["if"].get<std::string>());
+                    if (item.contains("then")) pendingTargets.push_back({ index, false, item["then"].get<std::string>() });
+                    if (item.contains("else")) pendingTargets.push_back({ index, true, item["else"].get<std::string>() });
+                }
+                else if (type == "playlist")
+                {
+                    step.type = ShowStepType::Playlist;
+                    if (item.contains("name")) step.name = Intern(names, item["name"].get<std::string>());
+                }
+                else if (type == "end")
+                {
+                    step.type = ShowStepType::End;
+                }
+                else
+                {
+                    throw std::runtime_error("unknown step type '" + type + "'");
+                }
+                steps.push_back(step);
+            }
+
+            // Une séquence ne déborde jamais sur la suivante
+            steps.push_back(ShowStep{});
+            sequences.push_back(sequence);
+        }
+        if (sequences.empty()) throw std::runtime_error("no sequence");
+
+        for (const PendingTarget& pending : pendingTargets)
+        {
+            auto it = targets.find(pending.name);
+            if (it == targets.end()) throw std::runtime_error("unknown branch target '" + pending.name + "'");
+            (pending.isElse ? steps[pending.step].elseTarget : steps[pending.step].target) = it->second;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Error loading show '{}': {}", sourceName, e.what());
+        return false;
+    }
+
+    std::vector<uint32_t> sounds;
+    for (ShowSequence& sequence : sequences)
+    {
+        sounds.clear();
+        CollectPreloads(steps, sequence.firstStep, sounds);
+        sequence.preloadFirst = static_cast<uint32_t>(preloads.size());
+        sequence.preloadCount = static_cast<uint32_t>(sounds.size());
+        preloads.insert(preloads.end(), sounds.begin(), sounds.end());
+    }
+    for (uint32_t i = 0; i < steps.size(); i++)
+    {
+        if (!StopsTimeline(steps[i].type)) continue;
+        sounds.clear();
+        CollectPreloads(steps, i + 1, sounds);
+        steps[i].preloadFirst = static_cast<uint32_t>(preloads.size());
+        steps[i].preloadCount = static_cast<uint32_t>(sounds.size());
+        preloads.insert(preloads.end(), sounds.begin(), sounds.end());
+    }
+
+    Stop();
+    m_showName = std::move(showName);
+    m_sequences = std::move(sequences);
+    m_steps = std::move(steps);
+    m_soundNames = std::move(soundNames);
+    m_names = std::move(names);
+    m_parameterNames = std::move(parameterNames);
+    m_parameters = std::move(parameters);
+    m_preloads = std::move(preloads);
+    m_channels.assign(m_soundNames.size(), nullptr);
+
+    spdlog::info("Show '{}' loaded from '{}': {} sequences, {} steps.", m_showName, sourceName, m_sequences.size(), m_steps.size());
+    return true;
+}
+
+int ShowTimeline::FindSequence(const std::string& name) const
+{
+    for (size_t i = 0; i < m_sequences.size(); i++)
+    {
+        if (m_sequences[i].name == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+std::vector<std::string> ShowTimeline::GetMissingSounds() const
+{
+    std::vector<std::string> missing;
+    for (const auto& sound : m_soundNames)
+    {
+        if (!AudioManager::GetInstance().HasSound(sound)) missing.push_back(sound);
+    }
+    return missing;
+}
+
+bool ShowTimeline::SetParameter(const std::string& name, float value)
+{
+    auto it = std::find(m_parameterNames.begin(), m_parameterNames.end(), name);
+    if (it == m_parameterNames.end()) return false;
+    m_parameters[it - m_parameterNames.begin()] = value;
+    return true;
+}
+
+float ShowTimeline::GetParameter(const std::string& name) const
+{
+    auto it = std::find(m_parameterNames.begin(), m_parameterNames.end(), name);
+    return it == m_parameterNames.end() ? 0.0f : m_parameters[it - m_parameterNames.begin()];
+}
+
+bool ShowTimeline::Start(const std::string& sequence)
+{
+    const int index = FindSequence(sequence);
+    if (index < 0)
+    {
+        spdlog::error("Show '{}' has no sequence '{}'.", m_showName, sequence);
+        return false;
+    }
+    return Start(index);
+}
+
+bool ShowTimeline::Start(int sequenceIndex)
+{
+    if (sequenceIndex < 0 || sequenceIndex >= static_cast<int>(m_sequences.size()))
+    {
+        spdlog::error("Show '{}' has no sequence {}.", m_showName, sequenceIndex);
+        return false;
+    }
+
+    Stop();
+    const ShowSequence& sequence = m_sequences[sequenceIndex];
+    m_running = true;
+    m_currentSequence = sequenceIndex;
+    m_pc = sequence.firstStep;
+    spdlog::info("Show '{}': sequence '{}' started.", m_showName, sequence.name);
+
+    Preload(sequence.preloadFirst, sequence.preloadCount);
+    Run();
+    return true;
+}
+
+void ShowTimeline::Stop()
+{
+    m_running = false;
+    m_wait = WaitKind::None;
+    m_deadline = -1.0;
+    m_awaitedChannel = nullptr;
+    m_fading = false;
+}
+
+bool ShowTimeline::PrefetchSequence(const std::string& sequence)
+{
+    const int index = FindSequence(sequence);
+    if (index < 0) return false;
+    Preload(m_sequences[index].preloadFirst, m_sequences[index].preloadCount);
+    return true;
+}
+
+void ShowTimeline::Skip()
+{
+    if (!m_running) return;
+
+    switch (m_wait)
+    {
+    case WaitKind::Fade:
+        m_fading = false;
+        if (m_host.setLevel) m_host.setLevel(m_fadeTo);
+        Advance();
+        break;
+    case WaitKind::Time:
+        Advance();
+        break;
+    case WaitKind::ChannelEnd:
+    {
+        // Avec une marge, le son continue depuis l'endroit où l'étape se serait terminée
+        const float margin = Resolve(m_steps[m_pc].seconds);
+        if (margin > 0.0f) SeekBeforeEnd(margin);
+        else if (m_awaitedChannel) m_awaitedChannel->stop();
+        Advance();
+        break;
+    }
+    case WaitKind::None:
+        break;
+    }
+}
+
+bool ShowTimeline::SeekBeforeEnd(float seconds)
+{
+    if (!IsPlaying(m_awaitedChannel)) return false;
+
+    FMOD::Sound* sound = nullptr;
+    unsigned int lengthMs = 0;
+    if (m_awaitedChannel->getCurrentSound(&sound) != FMOD_OK || !sound || sound->getLength(&lengthMs, FMOD_TIMEUNIT_MS) != FMOD_OK)
+    {
+        return false;
+    }
+
+    const unsigned int beforeMs = static_cast<unsigned int>(std::max(seconds, 0.0f) * 1000.0f);
+    const unsigned int positionMs = lengthMs > beforeMs ? lengthMs - beforeMs : 0;
+    if (m_awaitedChannel->setPosition(positionMs, FMOD_TIMEUNIT_MS) != FMOD_OK) return false;
+
+    if (m_wait == WaitKind::ChannelEnd) ScheduleEndMargin();
+    spdlog::info("Show '{}': moved to {} ms of {} ms.", m_showName, positionMs, lengthMs);
+    return true;
+}
+
+void ShowTimeline::Update(float deltaTime)
+{
+    m_clock += deltaTime;
+
+    if (m_channelEnds.HasEvents())
+    {
+        m_channelEnds.Drain(m_endedChannels);
+        for (const ChannelEndEvent& ended : m_endedChannels)
+        {
+            if (ended.tag < m_channels.size() && m_channels[ended.tag] == ended.channel) m_channels[ended.tag] = nullptr;
+            if (m_running && m_wait == WaitKind::ChannelEnd && ended.channel == m_awaitedChannel) Advance();
+        }
+    }
+    if (!m_running) return;
+
+    if (m_fading)
+    {
+        const float t = std::min(static_cast<float>((m_clock - m_fadeStart) / m_fadeSeconds), 1.0f);
+        if (m_host.setLevel) m_host.setLevel(m_fadeFrom + (m_fadeTo - m_fadeFrom) * t);
+        if (t >= 1.0f)
+        {
+            m_fading = false;
+            if (m_wait == WaitKind::Fade) Advance();
+        }
+    }
+
+    if ((m_wait == WaitKind::Time || m_wait == WaitKind::ChannelEnd) && m_deadline >= 0.0 && m_clock >= m_deadline)
+    {
+        Advance();
+    }
+}
+
+const char* ShowTimeline::GetStepTypeName(ShowStepType type)
+{
+    switch (type)
+    {
+    case ShowStepType::Fade: return "Fade";
+    case ShowStepType::Duck: return "Duck";
+    case ShowStepType::Wait: return "Wait";
+    case ShowStepType::Play: return "Play";
+    case ShowStepType::Stop: return "Stop";
+    case ShowStepType::WaitForEnd: return "Wait for end";
+    case ShowStepType::Branch: return "Branch";
+    case ShowStepType::Playlist: return "Playlist";
+    case ShowStepType::End:
+    default: return "End";
+    }
+}
+
+float ShowTimeline::Resolve(const ShowValue& value) const
+{
+    return value.parameter != ShowNoIndex ? m_parameters[value.parameter] : value.constant;
+}
+
+void ShowTimeline::Run()
+{
+    // Un branchement qui boucle sans jamais attendre bloquerait le moteur
+    size_t budget = m_steps.size() + 1;
+
+    while (m_running && m_wait == WaitKind::None)
+    {
+        if (budget-- == 0)
+        {
+            spdlog::error("Show '{}': step {} loops without waiting, stopped.", m_showName, m_pc);
+            Stop();
+            return;
+        }
+
+        const ShowStep& step = m_steps[m_pc];
+        switch (step.type)
+        {
+        case ShowStepType::Fade:
+        case ShowStepType::Duck:
+            StartFade(Resolve(step.level), Resolve(step.seconds));
+            if (step.type == ShowStepType::Fade && m_fading) m_wait = WaitKind::Fade;
+            else m_pc++;
+            break;
+
+        case ShowStepType::Wait:
+            m_deadline = m_clock + std::max(Resolve(step.seconds), 0.0f);
+            m_wait = WaitKind::Time;
+            break;
+
+        case ShowStepType::Play:
+        {
+            const std::string& sound = m_soundNames[step.sound];
+            const float volume = m_host.getVolume ? m_host.getVolume(step.bus) : 1.0f;
+            FMOD::Channel* channel = AudioManager::GetInstance().PlaySound(sound, step.loop, volume, 1.0f, m_output);
+            if (channel) m_channelEnds.Watch(channel, step.sound);
+            else spdlog::error("Show '{}': cannot play '{}'.", m_showName, sound);
+            m_channels[step.sound] = channel;
+            m_pc++;
+            break;
+        }
+
+        case ShowStepType::Stop:
+            if (step.sound == ShowNoIndex)
+            {
+                PlaylistManager::GetInstance().Stop("");
+                AudioManager::GetInstance().StopAllSounds();
+            }
+            else
+            {
+                AudioManager::GetInstance().StopSound(m_soundNames[step.sound]);
+            }
+            m_pc++;
+            break;
+
+        case ShowStepType::WaitForEnd:
+            m_awaitedChannel = m_channels[step.sound];
+            if (!IsPlaying(m_awaitedChannel))
+            {
+                m_awaitedChannel = nullptr;
+                m_pc++;
+                break;
+            }
+            m_wait = WaitKind::ChannelEnd;
+            ScheduleEndMargin();
+            break;
+
+        case ShowStepType::Branch:
+            m_pc = (step.name == ShowNoIndex || m_parameters[step.name] != 0.0f) ? step.target : step.elseTarget;
+            break;
+
+        case ShowStepType::Playlist:
+            m_pc++;
+            if (m_host.startPlaylist) m_host.startPlaylist(step.name != ShowNoIndex ? m_names[step.name] : std::string());
+            break;
+
+        case ShowStepType::End:
+            spdlog::info("Show '{}': sequence '{}' finished.", m_showName, m_sequences[m_currentSequence].name);
+            Stop();
+            return;
+        }
+    }
+
+    if (m_running && m_wait != WaitKind::None)
+    {
+        const ShowStep& step = m_steps[m_pc];
+        spdlog::debug("Show '{}': step {} ({}) waiting.", m_showName, m_pc, GetStepTypeName(step.type));
+        Preload(step.preloadFirst, step.preloadCount);
+    }
+}
+
+void ShowTimeline::Advance()
+{
+    m_wait = WaitKind::None;
+    m_deadline = -1.0;
+    m_awaitedChannel = nullptr;
+    m_pc++;
+    Run();
+}
+
+void ShowTimeline::Preload(uint32_t first, uint32_t count)
+{
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        const std::string& sound = m_soundNames[m_preloads[i]];
+        if (!AudioManager::GetInstance().PrefetchSound(sound, m_output))
+        {
+            spdlog::warn("Show '{}': '{}' could not be opened ahead.", m_showName, sound);
+        }
+    }
+}
+
+void ShowTimeline::StartFade(float level, float seconds)
+{
+    if (seconds <= 0.0f)
+    {
+        m_fading = false;
+        m_fadeTo = level;
+        if (m_host.setLevel) m_host.setLevel(level);
+        return;
+    }
+
+    m_fading = true;
+    m_fadeFrom = m_host.getLevel ? m_host.getLevel() : m_fadeTo;
+    m_fadeTo = level;
+    m_fadeStart = m_clock;
+    m_fadeSeconds = seconds;
+}
+
+bool ShowTimeline::ScheduleEndMargin()
+{
+    m_deadline = -1.0;
+    const float margin = Resolve(m_steps[m_pc].seconds);
+    if (margin <= 0.0f || !m_awaitedChannel) return false;
+
+    FMOD::Sound* sound = nullptr;
+    unsigned int lengthMs = 0;
+    unsigned int positionMs = 0;
+    if (m_awaitedChannel->getCurrentSound(&sound) != FMOD_OK || !sound ||
+        sound->getLength(&lengthMs, FMOD_TIMEUNIT_MS) != FMOD_OK ||
+        m_awaitedChannel->getPosition(&positionMs, FMOD_TIMEUNIT_MS) != FMOD_OK)
+    {
+        return false;
+    }
+
+    const double remaining = lengthMs > positionMs ? (lengthMs - positionMs) / 1000.0 : 0.0;
+    m_deadline = m_clock + std::max(remaining - margin, 0.0);
+    return true;
+}
+
+bool ShowTimeline::IsPlaying(FMOD::Channel* channel) const
+{
+    bool isPlaying = false;
+    return channel && channel->isPlaying(&isPlaying) == FMOD_OK && isPlaying;
+}
+
+} // namespace TSM
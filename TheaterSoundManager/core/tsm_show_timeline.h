@@ -0,0 +1,196 @@
+// tsm_show_timeline.h
+#pragma once
+
+#include <fmod.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "tsm_channel_end_queue.h"
+#include "tsm_fmod_wrapper.h"
+
+namespace TSM
+{
+
+enum class ShowStepType : uint8_t
+{
+    Fade,           // moves the show level to `level` in `seconds` and waits until it gets there
+    Duck,           // same move, but the timeline carries on while it happens
+    Wait,
+    Play,
+    Stop,           // one sound, or every sound and playlist when none is named
+    WaitForEnd,     // until the sound ends, or until `seconds` before its end
+    Branch,         // to `target` when the parameter is set (or always without one), `elseTarget` otherwise
+    Playlist,       // hands the music back to a playlist; without a name the host picks it
+    End
+};
+
+enum class ShowBus : uint8_t
+{
+    Music,
+    Sfx
+};
+
+inline constexpr uint32_t ShowNoIndex = 0xFFFFFFFFu;
+
+// A number written in the show file, or the name of a parameter the operator can change.
+struct ShowValue
+{
+    float constant = 0.0f;
+    uint32_t parameter = ShowNoIndex;
+};
+
+struct ShowStep
+{
+    ShowStepType type = ShowStepType::End;
+    ShowBus bus = ShowBus::Music;
+    bool loop = false;
+    uint32_t sound = ShowNoIndex;       // in GetSoundNames()
+    uint32_t name = ShowNoIndex;        // playlist name, or the parameter a branch tests
+    ShowValue level;
+    ShowValue seconds;
+    uint32_t target = 0;
+    uint32_t elseTarget = 0;
+    uint32_t preloadFirst = 0;          // sounds opened while the timeline stops on this step
+    uint32_t preloadCount = 0;
+};
+
+struct ShowSequence
+{
+    std::string name;
+    std::string label;                  // operator button; sequences without one are only reached by branches
+    uint32_t firstStep = 0;
+    uint32_t preloadFirst = 0;
+    uint32_t preloadCount = 0;
+};
+
+// What the timeline asks of the application: the show level is the music level the fades
+// move (the UI's duck factor), and the volumes are those a sound starts at on each bus.
+struct ShowTimelineHost
+{
+    std::function<float()> getLevel;
+    std::function<void(float)> setLevel;
+    std::function<float(ShowBus)> getVolume;
+    std::function<void(const std::string&)> startPlaylist;
+};
+
+// Runs a show described in a JSON file instead of code. The sequences are compiled into one
+// flat table of steps, branch targets resolved to step indices and, for every step the
+// timeline can stop on, the list of sounds the steps up to the next stop will play; they
+// are opened while it waits. The timeline moves on events: a channel END callback, a
+// deadline on its own clock or the end of a fade, never by asking FMOD each frame.
+//
+// {
+//   "name": "Wedding",
+//   "parameters": { "autoAdvance": 1, "ceremonyLevel": 0.05 },
+//   "sequences": [
+//     { "name": "entrance", "label": "Phase 1", "steps": [
+//       { "type": "fade", "to": 0, "seconds": 5 },
+//       { "type": "stop" },
+//       { "type": "play", "sound": "sfx_shine", "bus": "sfx" },
+//       { "type": "waitForEnd", "sound": "sfx_shine" },
+//       { "type": "branch", "if": "autoAdvance", "then": "ceremony", "else": "hold" },
+//       { "id": "hold", "type": "wait", "seconds": 6 } ] } ]
+// }
+class ShowTimeline
+{
+public:
+    static ShowTimeline& GetInstance()
+    {
+        static ShowTimeline instance;
+        return instance;
+    }
+
+    // Replaces the show; a show that does not compile leaves the previous one in place.
+    bool LoadFile(const std::string& filePath);
+    bool LoadString(const std::string& text, const std::string& sourceName);
+
+    const std::string& GetShowName() const { return m_showName; }
+    const std::vector<ShowSequence>& GetSequences() const { return m_sequences; }
+    const std::vector<ShowStep>& GetSteps() const { return m_steps; }
+    const std::vector<std::string>& GetSoundNames() const { return m_soundNames; }
+    int FindSequence(const std::string& name) const;
+    // Sounds the show plays that are not registered with the AudioManager yet.
+    std::vector<std::string> GetMissingSounds() const;
+
+    void SetHost(const ShowTimelineHost& host) { m_host = host; }
+    void SetOutput(OutputId output) { m_output = output; }
+
+    bool SetParameter(const std::string& name, float value);
+    float GetParameter(const std::string& name) const;
+
+    // Stops what was running and starts the sequence.
+    bool Start(const std::string& sequence);
+    bool Start(int sequenceIndex);
+    void Stop();
+    // Opens the sounds the sequence plays before it first waits.
+    bool PrefetchSequence(const std::string& sequence);
+    // Ends the current step now; a wait for the end of a sound jumps to its margin, or stops it.
+    void Skip();
+    // Moves the awaited sound to `seconds` before its end.
+    bool SeekBeforeEnd(float seconds);
+
+    void Update(float deltaTime);
+
+    bool IsRunning() const { return m_running; }
+    int GetCurrentSequence() const { return m_running ? m_currentSequence : -1; }
+    uint32_t GetCurrentStep() const { return m_pc; }
+    FMOD::Channel* GetAwaitedChannel() const { return m_awaitedChannel; }
+
+    static const char* GetStepTypeName(ShowStepType type);
+
+private:
+    enum class WaitKind : uint8_t
+    {
+        None,
+        Fade,
+        Time,
+        ChannelEnd
+    };
+
+    ShowTimeline() = default;
+    ShowTimeline(const ShowTimeline&) = delete;
+    ShowTimeline& operator=(const ShowTimeline&) = delete;
+
+    float Resolve(const ShowValue& value) const;
+    void Run();
+    void Advance();
+    void Preload(uint32_t first, uint32_t count);
+    void StartFade(float level, float seconds);
+    bool ScheduleEndMargin();
+    bool IsPlaying(FMOD::Channel* channel) const;
+
+    // Compiled show
+    std::string m_showName;
+    std::vector<ShowSequence> m_sequences;
+    std::vector<ShowStep> m_steps;
+    std::vector<std::string> m_soundNames;
+    std::vector<std::string> m_names;
+    std::vector<std::string> m_parameterNames;
+    std::vector<float> m_parameters;
+    std::vector<uint32_t> m_preloads;
+
+    ShowTimelineHost m_host;
+    OutputId m_output = FModWrapper::MainOutput;
+
+    // Playback
+    bool m_running = false;
+    int m_currentSequence = -1;
+    uint32_t m_pc = 0;
+    double m_clock = 0.0;
+    WaitKind m_wait = WaitKind::None;
+    double m_deadline = -1.0;                   // on m_clock, -1 when the step has none
+    FMOD::Channel* m_awaitedChannel = nullptr;
+    std::vector<FMOD::Channel*> m_channels;     // last channel of each sound
+    ChannelEndQueue m_channelEnds;
+    std::vector<ChannelEndEvent> m_endedChannels;
+
+    bool m_fading = false;
+    float m_fadeFrom = 0.0f;
+    float m_fadeTo = 0.0f;
+    double m_fadeStart = 0.0;
+    float m_fadeSeconds = 0.0f;
+};
+
+} // namespace TSM
@@ -0,0 +1,443 @@
+// tsm_shuffle_engine.cpp
+
+#include "tsm_shuffle_engine.h"
+#include "tsm_audio_manager.h"
+
+#include <spdlog/spdlog.h>
+#include <json/json.hpp>
+#include <algorithm>
+#include <numeric>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <cmath>
+
+namespace TSM
+{
+
+using json = nlohmann::json;
+
+namespace
+{
+
+// Candidates a slot looks at before it gives up on the artist and album spread; keeps
+// a cycle linear even when one artist fills most of the playlist.
+constexpr size_t DeferredScanLimit = 32;
+
+template <typename Key>
+bool PlayedWithin(const std::unordered_map<Key, uint64_t>& lastPlay, const Key& key, uint64_t sequence, size_t spacing)
+{
+    auto it = lastPlay.find(key);
+    return it != lastPlay.end() && sequence - it->second <= spacing;
+}
+
+} // namespace
+
+ShuffleEngine::ShuffleEngine()
+    : m_rng(std::random_device{}())
+{
+    m_history.reserve(m_settings.historySize);
+}
+
+ShuffleEngine::~ShuffleEngine()
+{
+    FlushHistory();
+}
+
+void ShuffleEngine::SetSettings(const ShuffleSettings& settings)
+{
+    std::vector<TrackId> history = GetHistory();
+    m_settings = settings;
+    // The history must reach back further than any spacing it is used to check.
+    m_settings.historySize = std::max({ m_settings.historySize, m_settings.minRepeatDistance + 1,
+                                        m_settings.artistSpacing + 1, m_settings.albumSpacing + 1 });
+
+    if (history.size() > m_settings.historySize)
+    {
+        history.erase(history.begin(), history.end() - m_settings.historySize);
+    }
+    m_history = std::move(history);
+    m_historyStart = 0;
+    PruneHistory();
+}
+
+void ShuffleEngine::SetTrackWeight(const TrackId& track, float weight)
+{
+    m_historyDirty = !m_historyFile.empty();
+    if (weight == 1.0f)
+    {
+        m_weights.erase(track);
+        return;
+    }
+    m_weights[track] = std::max(weight, 0.001f);
+}
+
+float ShuffleEngine::GetTrackWeight(const TrackId& track) const
+{
+    auto it = m_weights.find(track);
+    return it != m_weights.end() ? it->second : 1.0f;
+}
+
+ShuffleEngine::Tags ShuffleEngine::GetTags(const TrackId& track)
+{
+    const auto& allSounds = AudioManager::GetInstance().GetAllSounds();
+    auto it = allSounds.find(track);
+    if (it == allSounds.end()) return {};
+    return { it->second.artist, it->second.album };
+}
+
+std::vector<int> ShuffleEngine::BuildOrder(const IndexedSequence<TrackId>& tracks)
+{
+    struct Entry
+    {
+        TrackId id;
+        Tags tags;
+    };
+
+    std::vector<Entry> entries;
+    entries.reserve(tracks.size());
+    tracks.ForEach([&entries](const TrackId& id) { entries.push_back({ id, GetTags(id) }); });
+    const size_t size = entries.size();
+
+    // A spacing the playlist cannot honour would only push every track to the fallback.
+    size_t distinctTracks = 0, distinctArtists = 0, distinctAlbums = 0;
+    std::unordered_map<std::string, std::vector<int>> artistTracks;
+    {
+        std::unordered_map<TrackId, bool> seenTracks;
+        std::unordered_map<std::string, bool> seenAlbums;
+        for (size_t i = 0; i < size; i++)
+        {
+            const Entry& entry = entries[i];
+            distinctTracks += seenTracks.emplace(entry.id, true).second;
+            if (!entry.tags.artist.empty()) artistTracks[entry.tags.artist].push_back(static_cast<int>(i));
+            if (!entry.tags.album.empty())  distinctAlbums += seenAlbums.emplace(entry.tags.album, true).second;
+        }
+        distinctArtists = artistTracks.size();
+    }
+    const size_t trackSpacing = std::min(m_settings.minRepeatDistance, distinctTracks / 2);
+    const size_t artistSpacing = std::min(m_settings.artistSpacing, distinctArtists > 0 ? distinctArtists - 1 : 0);
+    const size_t albumSpacing = std::min(m_settings.albumSpacing, distinctAlbums > 0 ? distinctAlbums - 1 : 0);
+
+    std::vector<int> candidates(size);
+    std::iota(candidates.begin(), candidates.end(), 0);
+
+    bool weighted = false;
+    for (const auto& entry : entries)
+    {
+        weighted = weighted || m_weights.count(entry.id) > 0;
+    }
+
+    if (!weighted && artistSpacing == 0)
+    {
+        std::shuffle(candidates.begin(), candidates.end(), m_rng);
+    }
+    else
+    {
+        // Position in the cycle, in [0, 1). 1 - u^(1/w) is distributed as the first of w
+        // uniform draws, so a track of weight w is w times as likely to come first.
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        std::vector<double> position(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            position[i] = 1.0 - std::pow(uniform(m_rng), 1.0 / GetTrackWeight(entries[i].id));
+        }
+
+        // Chaque artiste est réparti régulièrement sur le cycle, avec un décalage aléatoire ;
+        // les poids ne décident plus que de l'ordre entre ses morceaux.
+        if (artistSpacing > 0)
+        {
+            for (auto& [artist, group] : artistTracks)
+            {
+                if (group.size() < 2) continue;
+
+                std::sort(group.begin(), group.end(), [&position](int a, int b) { return position[a] < position[b]; });
+                const double offset = uniform(m_rng);
+                for (size_t k = 0; k < group.size(); k++)
+                {
+                    position[group[k]] = (k + offset) / group.size();
+                }
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [&position](int a, int b) { return position[a] < position[b]; });
+    }
+
+    // Last plays, extended with the slots already planned.
+    std::unordered_map<TrackId, uint64_t> lastTrack = m_lastTrackPlay;
+    std::unordered_map<std::string, uint64_t> lastArtist = m_lastArtistPlay;
+    std::unordered_map<std::string, uint64_t> lastAlbum = m_lastAlbumPlay;
+
+    auto fits = [&](int index, uint64_t sequence, bool spreadTags) {
+        const Entry& entry = entries[index];
+        if (PlayedWithin(lastTrack, entry.id, sequence, trackSpacing)) return false;
+        if (!spreadTags) return true;
+        if (!entry.tags.artist.empty() && PlayedWithin(lastArtist, entry.tags.artist, sequence, artistSpacing)) return false;
+        if (!entry.tags.album.empty() && PlayedWithin(lastAlbum, entry.tags.album, sequence, albumSpacing)) return false;
+        return true;
+    };
+
+    // Candidates are taken in shuffled order; those that do not fit yet wait in `deferred`
+    // and get the next slots they fit in.
+    std::vector<int> order;
+    order.reserve(size);
+    std::vector<int> deferred;
+    size_t next = 0;
+
+    auto takeDeferred = [&deferred](size_t limit, auto&& accept) {
+        const size_t count = std::min(limit, deferred.size());
+        for (size_t i = 0; i < count; i++)
+        {
+            if (accept(deferred[i]))
+            {
+                const int index = deferred[i];
+                deferred.erase(deferred.begin() + i);
+                return index;
+            }
+        }
+        return -1;
+    };
+
+    for (size_t slot = 0; slot < size; slot++)
+    {
+        const uint64_t sequence = m_playCount + slot + 1;
+        auto spread = [&](int index) { return fits(index, sequence, true); };
+        auto distinct = [&](int index) { return fits(index, sequence, false); };
+
+        int chosen = takeDeferred(DeferredScanLimit, spread);
+        while (chosen < 0 && next < size && deferred.size() < DeferredScanLimit)
+        {
+            const int candidate = candidates[next++];
+            if (spread(candidate)) chosen = candidate;
+            else deferred.push_back(candidate);
+        }
+
+        // The spread cannot be met here: keep only the repeat distance.
+        if (chosen < 0) chosen = takeDeferred(deferred.size(), distinct);
+        while (chosen < 0 && next < size)
+        {
+            const int candidate = candidates[next++];
+            if (distinct(candidate)) chosen = candidate;
+            else deferred.push_back(candidate);
+        }
+        if (chosen < 0)
+        {
+            chosen = deferred.front();
+            deferred.erase(deferred.begin());
+        }
+
+        const Entry& entry = entries[chosen];
+        lastTrack[entry.id] = sequence;
+        if (!entry.tags.artist.empty()) lastArtist[entry.tags.artist] = sequence;
+        if (!entry.tags.album.empty())  lastAlbum[entry.tags.album] = sequence;
+        order.push_back(chosen);
+    }
+
+    return order;
+}
+
+void ShuffleEngine::Remember(const TrackId& track, uint64_t sequence)
+{
+    m_lastTrackPlay[track] = sequence;
+
+    const Tags tags = GetTags(track);
+    if (!tags.artist.empty()) m_lastArtistPlay[tags.artist] = sequence;
+    if (!tags.album.empty())  m_lastAlbumPlay[tags.album] = sequence;
+}
+
+void ShuffleEngine::RecordPlay(const TrackId& track)
+{
+    if (m_history.size() < m_settings.historySize)
+    {
+        m_history.push_back(track);
+    }
+    else
+    {
+        m_history[m_historyStart] = track;
+        m_historyStart = (m_historyStart + 1) % m_history.size();
+    }
+    Remember(track, ++m_playCount);
+
+    // Les entrées plus anciennes que l'historique ne servent plus : purge amortie
+    if (m_lastTrackPlay.size() > 2 * m_settings.historySize)
+    {
+        PruneHistory();
+    }
+
+    // Écrit plus tard par Update : pas d'accès disque au démarrage d'un morceau
+    m_historyDirty = !m_historyFile.empty();
+}
+
+void ShuffleEngine::PruneHistory()
+{
+    const uint64_t oldest = m_playCount > m_history.size() ? m_playCount - m_history.size() : 0;
+    auto prune = [oldest](auto& lastPlay) {
+        for (auto it = lastPlay.begin(); it != lastPlay.end();)
+        {
+            if (it->second <= oldest) it = lastPlay.erase(it);
+            else ++it;
+        }
+    };
+    prune(m_lastTrackPlay);
+    prune(m_lastArtistPlay);
+    prune(m_lastAlbumPlay);
+}
+
+size_t ShuffleEngine::GetPlaysSince(const TrackId& track) const
+{
+    auto it = m_lastTrackPlay.find(track);
+    if (it == m_lastTrackPlay.end()) return std::numeric_limits<size_t>::max();
+    return static_cast<size_t>(m_playCount - it->second);
+}
+
+std::vector<TrackId> ShuffleEngine::GetHistory() const
+{
+    std::vector<TrackId> history;
+    history.reserve(m_history.size());
+    for (size_t i = 0; i < m_history.size(); i++)
+    {
+        history.push_back(m_history[(m_historyStart + i) % m_history.size()]);
+    }
+    return history;
+}
+
+void ShuffleEngine::ClearHistory()
+{
+    m_history.clear();
+    m_historyStart = 0;
+    m_lastTrackPlay.clear();
+    m_lastArtistPlay.clear();
+    m_lastAlbumPlay.clear();
+}
+
+bool ShuffleEngine::SetHistoryFile(const std::string& filePath)
+{
+    FlushHistory();
+    m_historyFile.clear();
+
+    std::error_code ec;
+    if (std::filesystem::exists(filePath, ec) && !LoadHistory(filePath))
+    {
+        return false;
+    }
+    m_historyFile = filePath;
+    return true;
+}
+
+void ShuffleEngine::Update(float deltaTime)
+{
+    if (!m_historyDirty) return;
+
+    m_sinceDirty += deltaTime;
+    if (m_sinceDirty >= SaveInterval)
+    {
+        FlushHistory();
+    }
+}
+
+void ShuffleEngine::FlushHistory()
+{
+    if (!m_historyDirty || m_historyFile.empty()) return;
+
+    // Un échec garde les lectures en attente pour le prochain essai
+    m_sinceDirty = 0.0f;
+    if (SaveHistory(m_historyFile))
+    {
+        m_historyDirty = false;
+    }
+}
+
+bool ShuffleEngine::SaveHistory(const std::string& filePath) const
+{
+    json j;
+    j["playCount"] = m_playCount;
+    j["history"] = json::array();
+    for (const auto& track : GetHistory())
+    {
+        j["history"].push_back(track.str());
+    }
+    j["weights"] = json::object();
+    for (const auto& [track, weight] : m_weights)
+    {
+        j["weights"][track.str()] = weight;
+    }
+
+    // Écrit à côté puis renommé : un arrêt brutal laisse l'ancien fichier intact
+    const std::string tempPath = filePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::trunc);
+        if (!file.is_open())
+        {
+            spdlog::error("Cannot write shuffle history '{}'.", tempPath);
+            return false;
+        }
+        file << j.dump();
+        if (!file.good())
+        {
+            spdlog::error("Cannot write shuffle history '{}'.", tempPath);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, filePath, ec);
+    if (ec)
+    {
+        spdlog::error("Cannot replace shuffle history '{}': {}", filePath, ec.message());
+        return false;
+    }
+    return true;
+}
+
+bool ShuffleEngine::LoadHistory(const std::string& filePath)
+{
+    std::ifstream file(filePath);
+    if (!file.is_open())
+    {
+        spdlog::error("Cannot open shuffle history '{}'.", filePath);
+        return false;
+    }
+
+    try
+    {
+        json j = json::parse(file);
+
+        ClearHistory();
+        m_weights.clear();
+
+        std::vector<TrackId> history;
+        for (const auto& track : j.at("history"))
+        {
+            history.push_back(track.get<std::string>());
+        }
+        if (history.size() > m_settings.historySize)
+        {
+            history.erase(history.begin(), history.end() - m_settings.historySize);
+        }
+
+        m_playCount = std::max<uint64_t>(j.value("playCount", uint64_t(0)), history.size());
+        const uint64_t firstSequence = m_playCount - history.size() + 1;
+        for (size_t i = 0; i < history.size(); i++)
+        {
+            Remember(history[i], firstSequence + i);
+        }
+        m_history = std::move(history);
+
+        if (j.contains("weights"))
+        {
+            for (const auto& item : j["weights"].items())
+            {
+                SetTrackWeight(item.key(), item.value().get<float>());
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Shuffle history '{}' is unreadable: {}", filePath, e.what());
+        return false;
+    }
+
+    spdlog::info("Loaded {} plays of shuffle history.", m_history.size());
+    return true;
+}
+
+} // namespace TSM
@@ -0,0 +1,94 @@
+// tsm_shuffle_engine.h
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+#include "tsm_indexed_sequence.h"
+#include "tsm_track_id.h"
+
+namespace TSM
+{
+
+struct ShuffleSettings
+{
+    size_t minRepeatDistance = 20;  // other tracks played before a track may come back
+    size_t artistSpacing = 3;       // same for the artist tag, best effort
+    size_t albumSpacing = 2;        // same for the album tag, best effort
+    size_t historySize = 512;       // plays remembered, and saved across restarts
+};
+
+// Plans the order of shuffled playlists from the plays heard so far, whatever playlist
+// they came from, so a new cycle never starts with what the audience just heard.
+// Within the cycle, artists and albums are spread apart when the tags allow it and
+// heavier tracks tend to come earlier.
+class ShuffleEngine
+{
+public:
+    // Longest a play stays unsaved while Update is called.
+    static constexpr float SaveInterval = 30.0f;
+
+    ShuffleEngine();
+    ~ShuffleEngine();
+
+    void SetSettings(const ShuffleSettings& settings);
+    const ShuffleSettings& GetSettings() const { return m_settings; }
+    void Seed(uint32_t seed) { m_rng.seed(seed); }
+
+    // 1 by default; a track of weight 4 is four times as likely to open the cycle as a
+    // track of weight 1, until the artist spread moves it.
+    void SetTrackWeight(const TrackId& track, float weight);
+    float GetTrackWeight(const TrackId& track) const;
+
+    // Every index of `tracks` once. O(n) for untagged tracks without weights, O(n log n)
+    // otherwise, so each pick costs O(1) or O(log n) over the cycle.
+    // The repeat distance is kept whenever half the playlist is enough to fill it;
+    // it is shortened for smaller playlists.
+    std::vector<int> BuildOrder(const IndexedSequence<TrackId>& tracks);
+
+    void RecordPlay(const TrackId& track);
+    // Other plays since `track` was last heard, SIZE_MAX if it is not in the history.
+    size_t GetPlaysSince(const TrackId& track) const;
+    std::vector<TrackId> GetHistory() const;    // oldest first
+    void ClearHistory();
+
+    // Loads the file if it exists; history and weights are then written back by Update,
+    // SaveInterval seconds after a play or weight change, and by FlushHistory.
+    bool SetHistoryFile(const std::string& filePath);
+    void Update(float deltaTime);
+    void FlushHistory();
+    bool SaveHistory(const std::string& filePath) const;
+    bool LoadHistory(const std::string& filePath);
+
+private:
+    struct Tags
+    {
+        std::string artist;
+        std::string album;
+    };
+    static Tags GetTags(const TrackId& track);
+
+    void Remember(const TrackId& track, uint64_t sequence);
+    void PruneHistory();
+
+    ShuffleSettings m_settings;
+    std::mt19937 m_rng;
+
+    std::vector<TrackId> m_history;                 // ring buffer of the last plays
+    size_t m_historyStart = 0;
+    uint64_t m_playCount = 0;                       // sequence number of the last play
+
+    std::unordered_map<TrackId, uint64_t> m_lastTrackPlay;
+    std::unordered_map<std::string, uint64_t> m_lastArtistPlay;
+    std::unordered_map<std::string, uint64_t> m_lastAlbumPlay;
+    std::unordered_map<TrackId, float> m_weights;
+
+    std::string m_historyFile;
+    bool m_historyDirty = false;                    // plays or weights not in the file yet
+    float m_sinceDirty = 0.0f;
+};
+
+} // namespace TSM
@@ -0,0 +1,82 @@
+// tsm_track_id.cpp
+
+#include "tsm_track_id.h"
+
+#include <mutex>
+#include <utility>
+
+namespace TSM
+{
+
+TrackIdPool::TrackIdPool()
+{
+    m_strings.emplace_back();
+    m_index.emplace(m_strings.back(), 0);
+}
+
+uint32_t TrackIdPool::Intern(std::string_view text)
+{
+    {
+        std::shared_lock lock(m_mutex);
+        auto it = m_index.find(text);
+        if (it != m_index.end()) return it->second;
+    }
+
+    std::unique_lock lock(m_mutex);
+    auto it = m_index.find(text);
+    if (it != m_index.end()) return it->second;
+
+    const uint32_t index = static_cast<uint32_t>(m_strings.size());
+    m_strings.emplace_back(text);
+    m_strings.back().shrink_to_fit();
+    m_index.emplace(m_strings.back(), index);
+    return index;
+}
+
+bool TrackIdPool::Find(std::string_view text, uint32_t& index) const
+{
+    std::shared_lock lock(m_mutex);
+    auto it = m_index.find(text);
+    if (it == m_index.end()) return false;
+
+    index = it->second;
+    return true;
+}
+
+const std::string& TrackIdPool::GetString(uint32_t index) const
+{
+    std::shared_lock lock(m_mutex);
+    return m_strings[index];
+}
+
+size_t TrackIdPool::GetCount() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_strings.size();
+}
+
+TrackIdPool::MemoryUsage TrackIdPool::GetMemoryUsage() const
+{
+    std::shared_lock lock(m_mutex);
+
+    MemoryUsage usage;
+    usage.count = m_strings.size();
+    for (const auto& text : m_strings)
+    {
+        usage.stringBytes += StringFootprint(text);
+    }
+
+    // Un nœud par entrée (valeur + chaînage + hash mis en cache) et un pointeur par bucket
+    using Entry = std::pair<const std::string_view, uint32_t>;
+    usage.indexBytes = m_index.size() * (sizeof(Entry) + 2 * sizeof(void*))
+                     + m_index.bucket_count() * sizeof(void*);
+    return usage;
+}
+
+size_t TrackIdPool::StringFootprint(const std::string& text)
+{
+    static const size_t inlineCapacity = std::string().capacity();
+    return sizeof(std::string) + (text.capacity() > inlineCapacity ? text.capacity() + 1 : 0);
+}
+
+} // namespace TSM
@@ -0,0 +1,101 @@
+// tsm_track_id.h
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+namespace TSM
+{
+
+// Every distinct track id is stored once; playlists, the sound table and the journal keep
+// 32-bit indices into this pool instead of their own std::string copies.
+// Entries are never removed: an unloaded sound keeps its slot, so indices stay valid.
+class TrackIdPool
+{
+public:
+    static TrackIdPool& GetInstance()
+    {
+        static TrackIdPool instance;
+        return instance;
+    }
+
+    // Separate pools are only useful to measure one library in isolation.
+    TrackIdPool();
+    TrackIdPool(const TrackIdPool&) = delete;
+    TrackIdPool& operator=(const TrackIdPool&) = delete;
+
+    uint32_t Intern(std::string_view text);
+    // Looks the text up without adding it.
+    bool Find(std::string_view text, uint32_t& index) const;
+    const std::string& GetString(uint32_t index) const;
+    size_t GetCount() const;
+
+    struct MemoryUsage
+    {
+        size_t count = 0;
+        size_t stringBytes = 0;     // the std::string objects and their heap buffers
+        size_t indexBytes = 0;      // hash index, estimated from node and bucket counts
+
+        size_t Total() const { return stringBytes + indexBytes; }
+    };
+    MemoryUsage GetMemoryUsage() const;
+
+    // Bytes one std::string copy of `text` costs, short string optimisation included.
+    static size_t StringFootprint(const std::string& text);
+
+private:
+    mutable std::shared_mutex m_mutex;
+    std::deque<std::string> m_strings;  // never relocates, the index keeps views into it
+    std::unordered_map<std::string_view, uint32_t> m_index;
+};
+
+// Interned track id: 4 bytes, compared by index, read as the original string.
+class TrackId
+{
+public:
+    TrackId() = default;
+    TrackId(std::string_view text) : m_index(TrackIdPool::GetInstance().Intern(text)) {}
+    TrackId(const std::string& text) : TrackId(std::string_view(text)) {}
+    TrackId(const char* text) : TrackId(std::string_view(text)) {}
+
+    // Resolves `text` only if it was interned before, so lookups do not grow the pool.
+    static bool Find(std::string_view text, TrackId& id)
+    {
+        return TrackIdPool::GetInstance().Find(text, id.m_index);
+    }
+
+    uint32_t GetIndex() const { return m_index; }
+    const std::string& str() const { return TrackIdPool::GetInstance().GetString(m_index); }
+    const char* c_str() const { return str().c_str(); }
+    bool empty() const { return m_index == 0; }
+
+    operator const std::string&() const { return str(); }
+
+    friend bool operator==(const TrackId& a, const TrackId& b) { return a.m_index == b.m_index; }
+    friend bool operator==(const TrackId& a, const std::string& b) { return a.str() == b; }
+    friend bool operator==(const TrackId& a, const char* b) { return a.str() == b; }
+
+    // Ordered by text, so sorted containers keep their alphabetical order.
+    friend bool operator<(const TrackId& a, const TrackId& b) { return a.m_index != b.m_index && a.str() < b.str(); }
+    friend bool operator<(const TrackId& a, const std::string& b) { return a.str() < b; }
+    friend bool operator<(const std::string& a, const TrackId& b) { return a < b.str(); }
+
+    friend std::ostream& operator<<(std::ostream& stream, const TrackId& id) { return stream << id.str(); }
+
+private:
+    uint32_t m_index = 0;       // 0 is the empty string
+};
+
+} // namespace TSM
+
+template <>
+struct std::hash<TSM::TrackId>
+{
+    size_t operator()(const TSM::TrackId& id) const noexcept { return std::hash<uint32_t>{}(id.GetIndex()); }
+};
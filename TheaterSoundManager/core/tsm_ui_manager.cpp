@@ -14,7 +14,10 @@
 
 #include "tsm_audio_manager.h"
 #include "tsm_playlist_manager.h"
+#include "tsm_playlist_import.h"
 #include "tsm_announcement_manager.h"
+#include "tsm_show_timeline.h"
+#include "tsm_cue_stack.h"
 
 #include <imgui.h>
 #include <imgui_impl_sdl2.h>
@@ -36,6 +39,53 @@ static int  g_plannedHour            = 14;
 static int  g_plannedMinute          = 30; 
 static char g_plannedAnnounceName[128]= "";
 
+static const char* g_cueStackFile     = "data/cues/show.json";
+
+// Used when data/shows/wedding.json does not exist.
+static const char* DefaultWeddingShow = R"show({
+    "name": "Wedding",
+    "parameters": { "autoAdvance": 1, "afterShowPlaylist": 1, "ceremonyLevel": 0.05, "transitionSeconds": 10 },
+    "sequences": [
+        { "name": "entrance", "label": "Phase 1: Ceremony Entrance", "steps": [
+            { "type": "fade", "to": 0, "seconds": 5 },
+            { "type": "stop" },
+            { "type": "play", "sound": "sfx_shine", "bus": "sfx" },
+            { "type": "waitForEnd" },
+            { "type": "wait", "seconds": 6 },
+            { "type": "play", "sound": "wedding_entrance_sound" },
+            { "type": "duck", "to": 1, "seconds": 20 },
+            { "type": "waitForEnd", "before": "transitionSeconds" },
+            { "type": "branch", "if": "autoAdvance", "else": "entranceEnd" },
+            { "type": "fade", "to": 0, "seconds": "transitionSeconds" },
+            { "type": "goto", "then": "ceremony" },
+            { "id": "entranceEnd", "type": "waitForEnd" }
+        ] },
+        { "name": "ceremony", "label": "Phase 2: During Ceremony (with ducking)", "steps": [
+            { "type": "stop" },
+            { "type": "fade", "to": 0 },
+            { "type": "play", "sound": "wedding_ceremony_sound", "loop": true },
+            { "type": "duck", "to": "ceremonyLevel", "seconds": 20 },
+            { "type": "waitForEnd", "before": "transitionSeconds" },
+            { "type": "branch", "if": "autoAdvance", "else": "ceremonyEnd" },
+            { "type": "fade", "to": 0, "seconds": "transitionSeconds" },
+            { "type": "goto", "then": "exit" },
+            { "id": "ceremonyEnd", "type": "waitForEnd" }
+        ] },
+        { "name": "exit", "label": "Phase 3: End of Ceremony", "steps": [
+            { "type": "stop" },
+            { "type": "fade", "to": 0 },
+            { "type": "play", "sound": "wedding_exit_sound" },
+            { "type": "duck", "to": 1, "seconds": 10 },
+            { "type": "waitForEnd", "before": "transitionSeconds" },
+            { "type": "branch", "if": "afterShowPlaylist", "else": "exitEnd" },
+            { "type": "fade", "to": 0, "seconds": "transitionSeconds" },
+            { "type": "playlist" },
+            { "type": "end" },
+            { "id": "exitEnd", "type": "waitForEnd" }
+        ] }
+    ]
+})show";
+
 #ifdef _WIN32
 #include <windows.h>
 #include <shobjidl.h> 
@@ -197,6 +247,7 @@ void ImportAudioFiles() {
         PlaylistManager::GetInstance().CreatePlaylist(g_playlistName);
     }
     
+    std::vector<PlaylistImporter::AudioFileEntry> files;
     for(const auto& path : filePaths) {
         std::string soundID;
         bool isMusic = false;
@@ -217,18 +268,10 @@ void ImportAudioFiles() {
             isMusic = true;
         }
 
-        bool ok = AudioManager::GetInstance().LoadSound(soundID, path, isMusic);
-        if(ok) {
-            spdlog::info("Imported audio file '{}' as '{}'", path, soundID);
-            
-            if(isMusic) {
-                PlaylistManager::GetInstance().AddToPlaylist(g_playlistName, soundID);
-            }
-        }
-        else {
-            spdlog::error("Failed to import audio file: {}", path);
-        }
+        files.push_back({ soundID, path, isMusic, isMusic });
     }
+
+    PlaylistImporter::GetInstance().ImportAudioFiles(files, g_playlistName);
 }
 
 UIManager::UIManager()
@@ -242,11 +285,6 @@ UIManager::UIManager()
       m_announcementVolume(3.0f),
       m_sfxVolume(3.0f),
       m_duckFactor(1.0f),
-      m_weddingModeActive(false),
-      m_weddingPhase(0),
-      m_autoDuckingActive(false),
-      m_originalDuckFactor(1.0f),
-      m_targetDuckFactor(0.3f),
       m_crossfadeDuration(10.0f),
       m_autoTransitionToPhase2(true), 
       m_transitionToNormalMusicAfterWedding(true),  
@@ -345,6 +383,7 @@ bool UIManager::Init(int width, int height)
     m_isInitialized = true;
     
     UpdateWeddingFilePaths();
+    SetupShowTimeline();
     
     return true;
 }
@@ -634,6 +673,34 @@ void UIManager::RenderPlaylistManagerTab()
         }
     }
 
+    auto& playlistHistory = PlaylistManager::GetInstance();
+    bool historyChanged = false;
+
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!playlistHistory.CanUndo());
+    if (ImGui::Button("Undo", ImVec2(100, 30)))
+    {
+        historyChanged = playlistHistory.Undo();
+    }
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!playlistHistory.CanRedo());
+    if (ImGui::Button("Redo", ImVec2(100, 30)))
+    {
+        historyChanged = playlistHistory.Redo();
+    }
+    ImGui::EndDisabled();
+
+    if (historyChanged)
+    {
+        playlistNames = playlistHistory.GetPlaylistNames();
+        if (selectedPlaylistIndex >= static_cast<int>(playlistNames.size()))
+        {
+            selectedPlaylistIndex = -1;
+        }
+    }
+
     ImGui::Separator();
     ImGui::Text("Create a new playlist");
 
@@ -703,11 +770,9 @@ void UIManager::RenderPlaylistManagerTab()
                 auto* playlist = PlaylistManager::GetInstance().GetPlaylistByName(playlistName);
                 if (playlist) {
                     // Utiliser les options configurées de la playlist
+                    // La durée et la courbe de crossfade font partie des options
                     PlaylistManager::GetInstance().Play(playlistName, playlist->options);
                     
-                    // Appliquer aussi la durée de crossfade si elle existe
-                    PlaylistManager::GetInstance().SetCrossfadeDuration(playlist->crossfadeDuration);
-                    
                     // Mettre à jour le nom de playlist actuel dans l'UIManager pour que les contrôles principaux fonctionnent
                     m_playlistName = playlistName;
                 } else {
@@ -818,32 +883,53 @@ void UIManager::RenderPlaylistManagerTab()
             ImGui::PushStyleColor(ImGuiCol_Header, ImVec4(0.2f, 0.7f, 0.2f, 0.3f));
             
             bool optionsChanged = false;
+            PlaylistOptions editedOptions = playlist->options;
             
-            if (ImGui::Checkbox("Random order", const_cast<bool*>(&playlist->options.randomOrder))) {
+            if (ImGui::Checkbox("Random order", &editedOptions.randomOrder)) {
                 optionsChanged = true;
             }
             ImGui::SameLine();
             
-            if (ImGui::Checkbox("Random segment", const_cast<bool*>(&playlist->options.randomSegment))) {
+            if (ImGui::Checkbox("Random segment", &editedOptions.randomSegment)) {
                 optionsChanged = true;
             }
             ImGui::SameLine();
             
-            if (ImGui::Checkbox("Loop playlist", const_cast<bool*>(&playlist->options.loopPlaylist))) {
+            if (ImGui::Checkbox("Loop playlist", &editedOptions.loopPlaylist)) {
                 optionsChanged = true;
             }
-            
-            if (ImGui::SliderFloat("Segment duration", const_cast<float*>(&playlist->options.segmentDuration), 10.0f, 1800.0f, "%.1fs")) {
+            ImGui::SameLine();
+
+            if (ImGui::Checkbox("Gapless", &editedOptions.gapless)) {
                 optionsChanged = true;
             }
             
+            if (ImGui::SliderFloat("Segment duration", &editedOptions.segmentDuration, 10.0f, 1800.0f, "%.1fs")) {
+                optionsChanged = true;
+            }
+
             // AJOUT : Contrôle du crossfade
-            if (ImGui::SliderFloat("Crossfade duration", const_cast<float*>(&playlist->crossfadeDuration), 0.0f, 10.0f, "%.1fs")) {
+            if (ImGui::SliderFloat("Crossfade duration", &editedOptions.crossfadeDuration, 0.0f, 10.0f, "%.1fs")) {
                 optionsChanged = true;
-                // Appliquer immédiatement si la playlist est en cours de lecture
-                if (PlaylistManager::GetInstance().IsPlaylistPlaying(selectedPlaylist)) {
-                    PlaylistManager::GetInstance().SetCrossfadeDuration(playlist->crossfadeDuration);
+            }
+
+            if (ImGui::BeginCombo("Crossfade curve", GetCrossfadeCurveName(editedOptions.crossfadeCurve))) {
+                for (CrossfadeCurve curve : AllCrossfadeCurves) {
+                    if (ImGui::Selectable(GetCrossfadeCurveName(curve), curve == editedOptions.crossfadeCurve)) {
+                        editedOptions.crossfadeCurve = curve;
+                        optionsChanged = true;
+                    }
                 }
+                ImGui::EndCombo();
+            }
+
+            if (editedOptions.crossfadeCurve == CrossfadeCurve::Custom &&
+                ImGui::SliderFloat("Curve shape", &editedOptions.crossfadeShape, 0.25f, 4.0f, "%.2f")) {
+                optionsChanged = true;
+            }
+
+            if (optionsChanged) {
+                PlaylistManager::GetInstance().SetPlaylistOptions(selectedPlaylist, editedOptions);
             }
             
             ImGui::PopStyleColor();
@@ -863,7 +949,6 @@ void UIManager::RenderPlaylistManagerTab()
                     // Redémarrer la playlist avec les nouveaux paramètres
                     PlaylistManager::GetInstance().Stop(selectedPlaylist);
                     PlaylistManager::GetInstance().Play(selectedPlaylist, playlist->options);
-                    PlaylistManager::GetInstance().SetCrossfadeDuration(playlist->crossfadeDuration);
                     
                     spdlog::info("Applied new settings to playlist '{}'", selectedPlaylist);
                 }
@@ -914,7 +999,6 @@ void UIManager::RenderPlaylistManagerTab()
                     {
                         // CORRECTION : Utiliser les options de la playlist pour PlayFromIndex aussi
                         PlaylistManager::GetInstance().Stop(selectedPlaylist);
-                        PlaylistManager::GetInstance().SetCrossfadeDuration(playlist->crossfadeDuration);
                         PlaylistManager::GetInstance().PlayFromIndex(selectedPlaylist, static_cast<int>(i));
                         
                         // Mettre à jour le nom de playlist actuel dans l'UIManager
@@ -974,8 +1058,8 @@ void UIManager::RenderPlaylistManagerTab()
 
                 for (const auto& [soundId, soundData] : AudioManager::GetInstance().GetAllSounds())
                 {
-                    if (soundId.find("sfx_") == std::string::npos &&
-                        soundId.find("announce_") == std::string::npos)
+                    if (soundId.str().find("sfx_") == std::string::npos &&
+                        soundId.str().find("announce_") == std::string::npos)
                     {
                         availableTracks.push_back({soundId, GetDisplayName(soundData.filePath)});
                     }
@@ -993,8 +1077,8 @@ void UIManager::RenderPlaylistManagerTab()
 
                     for (const auto& [soundId, soundData] : AudioManager::GetInstance().GetAllSounds())
                     {
-                        if (soundId.find("sfx_") == std::string::npos &&
-                            soundId.find("announce_") == std::string::npos)
+                        if (soundId.str().find("sfx_") == std::string::npos &&
+                            soundId.str().find("announce_") == std::string::npos)
                         {
                             availableTracks.push_back({soundId, GetDisplayName(soundData.filePath)});
                         }
@@ -1045,16 +1129,44 @@ void UIManager::RenderPlaylistManagerTab()
 
     if (ImGui::CollapsingHeader("Import/Export options", ImGuiTreeNodeFlags_DefaultOpen))
     {
+        auto& importer = PlaylistImporter::GetInstance();
+        static bool importWasRunning = false;
+
         ImGui::InputText("File path", importExportPath, IM_ARRAYSIZE(importExportPath));
 
+        if (importer.IsRunning())
+        {
+            // Les pistes déjà lues sont utilisables pendant l'import
+            char importText[64];
+            snprintf(importText, sizeof(importText), "%zu tracks imported", importer.GetImportedTrackCount());
+            ImGui::ProgressBar(importer.GetProgress(), ImVec2(400, 0), importText);
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel import"))
+            {
+                importer.Cancel();
+            }
+            playlistNames = PlaylistManager::GetInstance().GetPlaylistNames();
+            importWasRunning = true;
+        }
+        else if (importWasRunning)
+        {
+            playlistNames = PlaylistManager::GetInstance().GetPlaylistNames();
+            if (selectedPlaylistIndex >= static_cast<int>(playlistNames.size()))
+            {
+                selectedPlaylistIndex = -1;
+            }
+            importWasRunning = false;
+        }
+
+        ImGui::BeginDisabled(importer.IsRunning());
         if (ImGui::Button("Import all playlists", ImVec2(250, 30)))
         {
-            if (PlaylistManager::GetInstance().LoadPlaylistsFromFile(importExportPath))
+            if (importer.StartLoadAllPlaylists(importExportPath))
             {
-                playlistNames = PlaylistManager::GetInstance().GetPlaylistNames();
                 selectedPlaylistIndex = -1;
             }
         }
+        ImGui::EndDisabled();
 
         ImGui::SameLine();
 
@@ -1080,13 +1192,12 @@ void UIManager::RenderPlaylistManagerTab()
 
             ImGui::SameLine();
 
+            ImGui::BeginDisabled(importer.IsRunning());
             if (ImGui::Button("Import as new playlist", ImVec2(250, 30)))
             {
-                if (PlaylistManager::GetInstance().ImportPlaylist(singlePlaylistPath))
-                {
-                    playlistNames = PlaylistManager::GetInstance().GetPlaylistNames();
-                }
+                importer.StartImportPlaylist(singlePlaylistPath);
             }
+            ImGui::EndDisabled();
         }
     }
 }
@@ -1114,11 +1225,106 @@ void UIManager::RenderAudioLibrary() {
             RenderWeddingModeTab();
             ImGui::EndTabItem();
         }
+        if (ImGui::BeginTabItem("Cue Stack")) {
+            RenderCueStackTab();
+            ImGui::EndTabItem();
+        }
         ImGui::EndTabBar();
     }
     ImGui::End();
 }
 
+void UIManager::RenderCueStackTab() {
+    auto& cues = CueStack::GetInstance();
+    const auto& list = cues.GetCues();
+    const size_t standby = cues.GetStandby();
+
+    ImGui::Text("Cue stack: %s (%d cues)", cues.GetName().c_str(), static_cast<int>(list.size()));
+    ImGui::SameLine();
+    if (ImGui::Button("Reload")) {
+        cues.LoadFile(g_cueStackFile);
+    }
+
+    int preloadCount = static_cast<int>(cues.GetPreloadCount());
+    if (ImGui::SliderInt("Cues armed ahead", &preloadCount, 1, 10)) {
+        cues.SetPreloadCount(preloadCount);
+    }
+
+    ImGui::Separator();
+
+    if (standby < list.size()) {
+        const Cue& next = list[standby];
+        ImGui::Text("Standby: %s  %s", next.number.c_str(), next.label.empty() ? next.target.c_str() : next.label.c_str());
+        if (!cues.IsArmed(standby)) {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "(not armed)");
+        }
+    } else {
+        ImGui::Text("End of the cue stack");
+    }
+
+    // Espace = GO, sauf pendant la saisie d'un texte
+    bool go = ImGui::Button("GO", ImVec2(300, 80));
+    go |= !ImGui::GetIO().WantTextInput && ImGui::IsKeyPressed(ImGuiKey_Space, false);
+    if (go) {
+        cues.Go();
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("(Space)");
+
+    if (ImGui::BeginTable("CueTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Cue", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed, 120.0f);
+        ImGui::TableSetupColumn("Target", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Label", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("State", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+        ImGui::TableHeadersRow();
+
+        for (size_t i = 0; i < list.size(); i++) {
+            const Cue& cue = list[i];
+            ImGui::TableNextRow();
+            ImGui::PushID(static_cast<int>(i));
+
+            // Un clic met la cue en attente
+            ImGui::TableNextColumn();
+            if (ImGui::Selectable(cue.number.c_str(), i == standby, ImGuiSelectableFlags_SpanAllColumns)) {
+                cues.SetStandby(i);
+            }
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%s%s", CueStack::GetCueTypeName(cue.type), cue.autoContinue ? " >" : "");
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", cue.target.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", cue.label.c_str());
+            ImGui::TableNextColumn();
+            if (i == standby) {
+                ImGui::Text("Standby");
+            } else if (cues.IsArmed(i)) {
+                ImGui::Text("Armed");
+            }
+
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::Separator();
+    ImGui::Text("GO latency");
+
+    const auto& latencies = cues.GetLatencies();
+    for (size_t shown = 0; shown < latencies.size() && shown < 8; shown++) {
+        const CueLatency& latency = latencies[latencies.size() - 1 - shown];
+        const char* number = latency.cue < list.size() ? list[latency.cue].number.c_str() : "?";
+        if (latency.measured) {
+            ImGui::Text("Cue %s: GO %.3f ms, first sample %.1f ms (+%.1f ms device buffer)%s", number,
+                latency.dispatchMs, latency.firstSampleMs, latency.outputBufferMs, latency.armed ? "" : ", not armed");
+        } else {
+            ImGui::Text("Cue %s: GO %.3f ms%s", number, latency.dispatchMs, latency.armed ? "" : ", not armed");
+        }
+    }
+}
+
 void UIManager::EnsureDefaultPlaylist() {
     if (!PlaylistManager::GetInstance().GetPlaylistByName(g_playlistName)) {
         PlaylistManager::GetInstance().CreatePlaylist(g_playlistName);
@@ -1162,9 +1368,10 @@ void UIManager::RenderMusicPlaylistTab()
             std::string fileName = "Unknown"; 
 
             auto soundIt = AudioManager::GetInstance().GetAllSounds().find(trackId);
-            if (soundIt != AudioManager::GetInstance().GetAllSounds().end() && soundIt->second.sound) {
-                unsigned int lengthMs = 0;
-                if (soundIt->second.sound->getLength(&lengthMs, FMOD_TIMEUNIT_MS) == FMOD_OK) {
+            if (soundIt != AudioManager::GetInstance().GetAllSounds().end()) {
+                // Fonctionne aussi pour les pistes pas encore ouvertes (durée en cache).
+                unsigned int lengthMs = AudioManager::GetInstance().GetSoundLengthMs(trackId);
+                if (lengthMs > 0) {
                     int minutes = (lengthMs / 1000) / 60;
                     int seconds = (lengthMs / 1000) % 60;
                     char buffer[32];
@@ -1242,8 +1449,8 @@ void UIManager::RenderMusicPlaylistTab()
         const auto& allSounds = AudioManager::GetInstance().GetAllSounds();
         
         for (const auto& kv : allSounds) {
-            if (kv.first.find("sfx") == std::string::npos && 
-                kv.first.find("announce") == std::string::npos) {
+            if (kv.first.str().find("sfx") == std::string::npos && 
+                kv.first.str().find("announce") == std::string::npos) {
                 musicList.push_back({kv.first, kv.second.filePath});
             }
         }
@@ -1304,12 +1511,19 @@ void UIManager::RenderAnnouncementsTab() {
         const auto& allSounds = AudioManager::GetInstance().GetAllSounds();
         
         for (const auto& [soundId, soundData] : allSounds) {
-            if (soundId.find("announce") != std::string::npos || 
-                soundId.find("annonce") != std::string::npos ||
-                soundId.find("buffet") != std::string::npos) {
+            if (soundId.str().find("announce_fragment_") != std::string::npos) {
+                continue;
+            }
+            if (soundId.str().find("announce") != std::string::npos || 
+                soundId.str().find("annonce") != std::string::npos ||
+                soundId.str().find("buffet") != std::string::npos) {
                 announcements.push_back(soundId);
             }
         }
+
+        for (const auto& phraseId : AnnouncementManager::GetInstance().GetPhraseIds()) {
+            announcements.push_back(phraseId);
+        }
         
         for (size_t i = 0; i < announcements.size(); i++) {
             const auto& soundId = announcements[i];
@@ -1330,6 +1544,8 @@ void UIManager::RenderAnnouncementsTab() {
             std::string fileName = "Unknown";
             if (soundIt != allSounds.end()) {
                 fileName = GetDisplayName(soundIt->second.filePath);
+            } else if (AnnouncementManager::GetInstance().IsPhrase(soundId)) {
+                fileName = "Phrase";
             }
             ImGui::Text("%s", fileName.c_str());
 
@@ -1361,7 +1577,7 @@ void UIManager::RenderSFXTab() {
         const auto& allSounds = AudioManager::GetInstance().GetAllSounds();
         for (const auto& kv : allSounds) {
           
-            if (kv.first.find("sfx") != std::string::npos && 
+            if (kv.first.str().find("sfx") != std::string::npos && 
                 kv.first != m_weddingEntranceSoundId && 
                 kv.first != m_weddingCeremonySoundId && 
                 kv.first != m_weddingExitSoundId) {
@@ -1404,9 +1620,8 @@ void UIManager::RenderPlaylistControls()
     if (ImGui::Button("Play")) {
         auto& playlistManager = PlaylistManager::GetInstance();
         
-        playlistManager.SetCrossfadeDuration(m_crossfadeDuration);
+        m_opts.crossfadeDuration = m_crossfadeDuration;
         
-        m_originalDuckFactor = m_duckFactor; 
         SetDuckFactor(0.0f);
         
         playlistManager.Play(m_playlistName, m_opts);
@@ -1418,6 +1633,24 @@ void UIManager::RenderPlaylistControls()
 
     ImGui::SameLine();
 
+    // Enchaîne directement sur la playlist choisie, sans fondu global ni silence
+    if (ImGui::Button("Transition")) {
+        auto& playlistManager = PlaylistManager::GetInstance();
+        m_opts.crossfadeDuration = m_crossfadeDuration;
+        playlistManager.TransitionToPlaylist(m_playlistName, m_opts, m_transition);
+    }
+
+    ImGui::SameLine();
+
+    ImGui::BeginDisabled(!PlaylistManager::GetInstance().HasResumePoint(m_playlistName));
+    if (ImGui::Button("Resume")) {
+        PlaylistManager::GetInstance().Resume(m_playlistName);
+        UpdateAllVolumes();
+    }
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+
     if (ImGui::Button("Stop")) {
         PlaylistManager::GetInstance().Stop(m_playlistName);
     }
@@ -1434,11 +1667,36 @@ void UIManager::RenderPlaylistControls()
     ImGui::Checkbox("Random Order", &m_opts.randomOrder);
     ImGui::Checkbox("Random Segment", &m_opts.randomSegment);
     ImGui::Checkbox("Loop Playlist", &m_opts.loopPlaylist);
+    ImGui::Checkbox("Gapless", &m_opts.gapless);
     ImGui::SliderFloat("Segment Duration", &m_opts.segmentDuration, 10.0f, 300.0f, "%.1f s");
     
     if (ImGui::SliderFloat("Crossfade Duration", &m_crossfadeDuration, 0.0f, 10.0f, "%.1f s")) {
         PlaylistManager::GetInstance().SetCrossfadeDuration(m_crossfadeDuration);
     }
+    if (ImGui::BeginCombo("Crossfade Curve", GetCrossfadeCurveName(m_opts.crossfadeCurve))) {
+        for (CrossfadeCurve curve : AllCrossfadeCurves) {
+            if (ImGui::Selectable(GetCrossfadeCurveName(curve), curve == m_opts.crossfadeCurve)) {
+                m_opts.crossfadeCurve = curve;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    if (m_opts.crossfadeCurve == CrossfadeCurve::Custom) {
+        ImGui::SliderFloat("Crossfade Shape", &m_opts.crossfadeShape, 0.25f, 4.0f, "%.2f");
+    }
+    
+    ImGui::SliderFloat("Transition Duration", &m_transition.duration, 0.0f, 20.0f, "%.1f s");
+    if (ImGui::BeginCombo("Transition Curve", GetCrossfadeCurveName(m_transition.curve))) {
+        for (CrossfadeCurve curve : AllCrossfadeCurves) {
+            if (ImGui::Selectable(GetCrossfadeCurveName(curve), curve == m_transition.curve)) {
+                m_transition.curve = curve;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    if (m_transition.curve == CrossfadeCurve::Custom) {
+        ImGui::SliderFloat("Transition Shape", &m_transition.shape, 0.25f, 4.0f, "%.2f");
+    }
     
     ImGui::Spacing();
     
@@ -1531,6 +1789,18 @@ void UIManager::RenderPlaylistControls()
             ImGui::PopStyleColor();
         }
 
+        if (PlaylistManager::GetInstance().IsInTransition())
+        {
+            float transitionProgress = PlaylistManager::GetInstance().GetTransitionProgress();
+
+            char transitionText[32];
+            snprintf(transitionText, sizeof(transitionText), "Transition: %.1f%%", transitionProgress * 100.0f);
+
+            ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ImVec4(0.6f, 0.3f, 0.8f, 0.8f));
+            ImGui::ProgressBar(transitionProgress, ImVec2(-1, 0), transitionText);
+            ImGui::PopStyleColor();
+        }
+
         if (m_opts.randomSegment)
         {
             float segmentProgress = PlaylistManager::GetInstance().GetSegmentProgress();
@@ -1588,10 +1858,15 @@ void UIManager::RenderAnnouncementControls()
     const auto& allSounds = AudioManager::GetInstance().GetAllSounds();
     
     for (const auto& [soundId, soundData] : allSounds) {
-        if (soundId.find("announce") != std::string::npos) {
+        if (soundId.str().find("announce") != std::string::npos &&
+            soundId.str().find("announce_fragment_") == std::string::npos) {
             announcements.push_back(soundId);
         }
     }
+
+    for (const auto& phraseId : AnnouncementManager::GetInstance().GetPhraseIds()) {
+        announcements.push_back(phraseId);
+    }
     
     static int selectedAnnouncement = -1;
     static char selectedAnnounceName[256] = "";
@@ -1884,258 +2159,17 @@ void UIManager::UpdateWeddingMode(float deltaTime)
             SetDuckFactor(1.0f);
             UpdateAllVolumes();
         }
-
-        if (!m_weddingModeActive) return;
-    }
-
-    if (!m_weddingModeActive) return;
-
-    if (m_weddingPhase == 1) {
-        switch (m_phase1State) {
-            case WeddingPhase1State::IDLE:
-                break;
-
-            case WeddingPhase1State::FADING_OUT_PREVIOUS: {
-                m_phase1DuckTimer += deltaTime;
-                float t = m_phase1DuckTimer / m_phase1FadeOutDuration;
-                if (t > 1.0f) t = 1.0f;
-
-                float newFactor = m_originalDuckFactor * (1.0f - t);
-                SetDuckFactor(newFactor);
-
-                spdlog::debug("Wedding Phase 1: Fade out: {:.2f}/{:.2f}s - Factor: {:.2f}",
-                              m_phase1DuckTimer, m_phase1FadeOutDuration, newFactor);
-
-                UpdateAllVolumes();
-
-                if (t >= 1.0f) {
-                    spdlog::info("Wedding Phase 1: Fade out complete, stopping all music");
-
-                    PlaylistManager::GetInstance().Stop("");
-                    AudioManager::GetInstance().StopAllSounds();
-
-                    m_phase1DuckTimer = 0.0f;
-
-                    float sfxVolume = GetSFXVolume() * GetMasterVolume();
-                    m_phase1SfxChannel = AudioManager::GetInstance().PlaySound("sfx_shine", false, sfxVolume);
-
-                    if (m_phase1SfxChannel) {
-                        m_phase1SfxChannel->setVolume(sfxVolume);
-                        spdlog::info("Wedding Phase 1: Playing SFX 'sfx_shine' at volume {}", sfxVolume);
-                        m_phase1State = WeddingPhase1State::PLAYING_SFX_BEFORE;
-                    } else {
-                        spdlog::error("Wedding Phase 1: Failed to play SFX 'sfx_shine'");
-                        SetDuckFactor(0.0f);
-                        m_phase1State = WeddingPhase1State::DUCKING_IN;
-                    }
-                }
-                break;
-            }
-
-            case WeddingPhase1State::PLAYING_SFX_BEFORE: {
-                if (m_phase1SfxChannel) {
-                    bool isPlaying = false;
-                    m_phase1SfxChannel->isPlaying(&isPlaying);
-
-                    if (!isPlaying) {
-                        spdlog::info("Wedding Phase 1: SFX finished, waiting for {} seconds", m_phase1WaitDuration);
-                        m_phase1SfxChannel = nullptr;
-                        m_phase1DuckTimer = 0.0f;
-                        m_phase1State = WeddingPhase1State::WAITING_AFTER_SFX;
-                    }
-                }
-                else {
-                    spdlog::info("Wedding Phase 1: No SFX channel, moving to wait state");
-                    m_phase1DuckTimer = 0.0f;
-                    m_phase1State = WeddingPhase1State::WAITING_AFTER_SFX;
-                }
-                break;
-            }
-
-            case WeddingPhase1State::WAITING_AFTER_SFX: {
-                m_phase1DuckTimer += deltaTime;
-                float progress = m_phase1DuckTimer / m_phase1WaitDuration;
-
-                spdlog::debug("Wedding Phase 1: Waiting: {:.2f}/{:.2f}s - Progress: {:.1f}%", 
-                             m_phase1DuckTimer, m_phase1WaitDuration, progress * 100.0f);
-
-                if (m_phase1DuckTimer >= m_phase1WaitDuration) {
-                    spdlog::info("Wedding Phase 1: Wait complete, starting entrance music with ducking");
-
-                    SetDuckFactor(0.0f);
-                    float musicVolume = GetMusicVolume() * GetMasterVolume();
-                    m_phase1EntranceChannel = AudioManager::GetInstance().PlaySound(
-                        m_weddingEntranceSoundId, false, musicVolume);
-
-                    UpdateAllVolumes();
-
-                    m_phase1DuckTimer = 0.0f;
-                    m_phase1State = WeddingPhase1State::DUCKING_IN;
-                }
-                break;
-            }
-
-            case WeddingPhase1State::DUCKING_IN: {
-                m_phase1DuckTimer += deltaTime;
-                float t = m_phase1DuckTimer / m_phase1DuckFadeDuration;
-                if (t > 1.0f) t = 1.0f;
-
-                float newFactor = t;
-                SetDuckFactor(newFactor);
-
-                spdlog::debug("Wedding Phase 1: Duck fade: {:.2f}/{:.2f}s - Factor: {:.2f} (20 second fade)", 
-                              m_phase1DuckTimer, m_phase1DuckFadeDuration, newFactor);
-
-                UpdateAllVolumes();
-
-                if (t >= 1.0f) {
-                    spdlog::info("Wedding Phase 1: 20-second ducking complete, music at full volume");
-                    m_phase1State = WeddingPhase1State::PLAYING_ENTRANCE;
-                }
-                break;
-            }
-
-            case WeddingPhase1State::PLAYING_ENTRANCE: {
-                if (m_phase1EntranceChannel) {
-                    bool isPlaying = false;
-                    m_phase1EntranceChannel->isPlaying(&isPlaying);
-                    if (!isPlaying) {
-                        m_phase1EntranceChannel = nullptr;
-                        m_phase1DuckTimer = 0.0f;
-                        m_phase1State = WeddingPhase1State::DUCKING_OUT;
-                    }
-                }
-                break;
-            }
-
-            case WeddingPhase1State::DUCKING_OUT: {
-                m_phase1DuckTimer += deltaTime;
-                float t = m_phase1DuckTimer / m_phase1DuckFadeDuration;
-                if (t > 1.0f) t = 1.0f;
-
-                float newFactor = m_targetDuckFactor + (1.0f - m_targetDuckFactor) * t;
-                SetDuckFactor(newFactor);
-                UpdateAllVolumes();
-
-                if (t >= 1.0f) {
-                    m_phase1State = WeddingPhase1State::IDLE;
-                }
-                break;
-            }
-        }
-        return;
-    }
-
-    if (m_autoDuckingActive) {
-        float currentDuckFactor = GetDuckFactor();
-        float targetDuckFactor = m_targetDuckFactor;
-
-        float newDuckFactor = targetDuckFactor > (currentDuckFactor - (deltaTime / m_crossfadeDuration)) 
-            ? targetDuckFactor 
-            : (currentDuckFactor - (deltaTime / m_crossfadeDuration));
-
-        if (newDuckFactor != currentDuckFactor) {
-            SetDuckFactor(newDuckFactor);
-            UpdateAllVolumes();
-
-            spdlog::debug("Progressive ducking: {} -> {}", currentDuckFactor, newDuckFactor);
-
-            if (newDuckFactor <= targetDuckFactor + 0.01f) {
-                m_autoDuckingActive = false;
-                spdlog::info("Progressive ducking finished for phase {}", m_weddingPhase);
-            }
-        }
     }
-
-    CheckWeddingPhaseTransition();
 }
 
-void UIManager::CheckWeddingPhaseTransition()
+bool UIManager::IsWeddingModeActive() const
 {
-    if (!m_weddingModeActive) return;
-
-    FMOD::Channel* currentChannel = nullptr;
-
-    if (m_weddingPhase == 1) {
-        currentChannel = AudioManager::GetInstance().GetLastChannelOfSound(m_weddingEntranceSoundId);
-    } else if (m_weddingPhase == 2) {
-        currentChannel = AudioManager::GetInstance().GetLastChannelOfSound(m_weddingCeremonySoundId);
-    } else if (m_weddingPhase == 3) {
-        currentChannel = AudioManager::GetInstance().GetLastChannelOfSound(m_weddingExitSoundId);
-    }
-
-    if (!currentChannel) return;
-
-    FMOD::Sound* currentSound = nullptr;
-    unsigned int positionMs = 0;
-    unsigned int lengthMs = 0;
-    bool isPlaying = false;
-
-    currentChannel->isPlaying(&isPlaying);
-    if (!isPlaying) {
-        if (m_weddingPhase == 1 && m_phase1State == WeddingPhase1State::PLAYING_ENTRANCE && m_autoTransitionToPhase2) {
-            spdlog::info("End of phase 1, automatic transition to phase 2");
-            StartWeddingPhase2(m_transitionToNormalMusicAfterWedding);
-        }
-        else if (m_weddingPhase == 2 && m_autoTransitionToPhase2) {
-            spdlog::info("End of phase 2, automatic transition to phase 3");
-            StartWeddingPhase3(m_transitionToNormalMusicAfterWedding, m_normalPlaylistAfterWedding);
-        }
-        else if (m_weddingPhase == 3 && m_transitionToNormalMusicAfterWedding) {
-            StartNormalMusicAfterWedding();
-        }
-        return;
-    }
-
-    if (currentChannel->getCurrentSound(&currentSound) != FMOD_OK || !currentSound) return;
-
-    currentSound->getLength(&lengthMs, FMOD_TIMEUNIT_MS);
-    currentChannel->getPosition(&positionMs, FMOD_TIMEUNIT_MS);
-
-    float progress = static_cast<float>(positionMs) / static_cast<float>(lengthMs);
-
-    unsigned int remainingMs = lengthMs - positionMs;
-
-    unsigned int transitionStartMs = static_cast<unsigned int>(m_phasesTransitionDuration * 1000);
-
-    if (remainingMs <= transitionStartMs) {
-        if (m_weddingPhase == 1 && m_phase1State == WeddingPhase1State::PLAYING_ENTRANCE && m_autoTransitionToPhase2) {
-            float t = 1.0f - (static_cast<float>(remainingMs) / transitionStartMs);
-            float newDuckFactor = 1.0f * (1.0f - t);
-
-            SetDuckFactor(newDuckFactor);
-            UpdateAllVolumes();
-
-            if (remainingMs < 200) {
-                spdlog::info("End of phase 1 with transition, moving to phase 2");
-                StartWeddingPhase2(m_transitionToNormalMusicAfterWedding);
-            }
-        }
-        else if (m_weddingPhase == 2 && m_autoTransitionToPhase2) {
-            float t = 1.0f - (static_cast<float>(remainingMs) / transitionStartMs);
-            float newDuckFactor = 1.0f * (1.0f - t);
-
-            SetDuckFactor(newDuckFactor);
-            UpdateAllVolumes();
-
-            if (remainingMs < 200) {
-                spdlog::info("End of phase 2 with transition, moving to phase 3");
-                StartWeddingPhase3(m_transitionToNormalMusicAfterWedding, m_normalPlaylistAfterWedding);
-            }
-        }
-        else if (m_weddingPhase == 3 && m_transitionToNormalMusicAfterWedding) {
-            float t = 1.0f - (static_cast<float>(remainingMs) / transitionStartMs);
-            float newDuckFactor = 1.0f * (1.0f - t);
-
-            SetDuckFactor(newDuckFactor);
-            UpdateAllVolumes();
+    return ShowTimeline::GetInstance().IsRunning();
+}
 
-            if (remainingMs < 200) {
-                spdlog::info("End of phase 3 with transition, moving to normal playlist");
-                StartNormalMusicAfterWedding();
-            }
-        }
-    }
+int UIManager::GetWeddingPhase() const
+{
+    return ShowTimeline::GetInstance().GetCurrentSequence() + 1;
 }
 
 bool UIManager::ImportWeddingMusic(int phase, const std::string& filePath)
@@ -2168,7 +2202,8 @@ bool UIManager::ImportWeddingMusic(int phase, const std::string& filePath)
         AudioManager::GetInstance().UnloadSound(soundId);
     }
 
-    bool success = AudioManager::GetInstance().LoadSound(soundId, filePath, true);
+    bool success = (phase == 2) ? AudioManager::GetInstance().LoadSeamlessLoop(soundId, filePath)
+                                : AudioManager::GetInstance().LoadSound(soundId, filePath, true);
 
     if (success) {
         *storedPath = filePath;
@@ -2185,32 +2220,40 @@ void UIManager::StartNormalMusicAfterWedding()
     PlaylistManager::GetInstance().Stop("");
     AudioManager::GetInstance().StopAllSoundsWithFadeOut(); 
 
-    m_originalDuckFactor = m_duckFactor;
     SetDuckFactor(0.0f);
     UpdateAllVolumes();
 
-    m_weddingModeActive = false;
-    m_weddingPhase = 0;
-    m_autoDuckingActive = false;
-    m_autoTransitionToPhase2 = false;
     m_transitionToNormalMusicAfterWedding = false;
 
     m_playlistName = m_normalPlaylistAfterWedding;
 
-    // Définir les options standard pour la playlist
-    PlaylistOptions opts;
+    // Définir les options standard pour la playlist, en gardant son crossfade
+    const auto* normalPlaylist = PlaylistManager::GetInstance().GetPlaylistByName(m_normalPlaylistAfterWedding);
+    PlaylistOptions opts = normalPlaylist ? normalPlaylist->options : PlaylistOptions();
     opts.loopPlaylist = true;
     opts.randomOrder = true;
     opts.randomSegment = true;
     opts.segmentDuration = 900.0f;
 
+    // La musique reprend là où la cérémonie l'a interrompue
+    if (PlaylistManager::GetInstance().HasResumePoint(m_normalPlaylistAfterWedding)) {
+        PlaylistManager::GetInstance().SetPlaylistOptions(m_normalPlaylistAfterWedding, opts);
+        if (PlaylistManager::GetInstance().Resume(m_normalPlaylistAfterWedding)) {
+            PlaylistManager::GetInstance().SetCrossfadeDuration(10.0f);
+            m_musicFadeInActive = true;
+            m_musicFadeInTimer = 0.0f;
+            spdlog::info("Normal playlist '{}' resumed after wedding ceremony", m_normalPlaylistAfterWedding);
+            return;
+        }
+    }
+
     // Check if "secret_love" track exists in the playlist
     auto* playlist = PlaylistManager::GetInstance().GetPlaylistByName(m_normalPlaylistAfterWedding);
     bool secretLoveFound = false;
     
     if (playlist) {
         // Appliquer les options à la playlist indépendamment de si on trouve secret_love
-        playlist->options = opts;
+        PlaylistManager::GetInstance().SetPlaylistOptions(m_normalPlaylistAfterWedding, opts);
         
         // Find the "secret_love" track directly by ID
         for (size_t i = 0; i < playlist->tracks.size(); i++) {
@@ -2247,11 +2290,14 @@ void UIManager::StartNormalMusicAfterWedding()
 void UIManager::RenderWeddingModeTab()
 {
     static char normalPlaylistName[256] = "playlist_PostShow";
-    static float ceremonyDuckingFactor = 0.3f;
-    static bool isWeddingModeInitialized = false;
     static float crossfadeDuration = 5.0f;
     static bool transitionToNormalMusic = true;
 
+    // Les boutons suivent le fichier de spectacle : il faut que tous ses sons soient chargés
+    auto& timeline = ShowTimeline::GetInstance();
+    const std::vector<std::string> missingSounds = timeline.GetMissingSounds();
+    const bool isShowReady = missingSounds.empty();
+
     ImGui::Text("Wedding Mode");
     ImGui::Separator();
 
@@ -2284,9 +2330,7 @@ void UIManager::RenderWeddingModeTab()
         if (ImGui::Button("Import entrance music", ImVec2(200, 30))) {
             auto filePaths = OpenFileDialogMultiSelect();
             if (!filePaths.empty()) {
-                if (ImportWeddingMusic(1, filePaths[0])) {
-                    isWeddingModeInitialized = true;
-                }
+                ImportWeddingMusic(1, filePaths[0]);
             }
         }
 
@@ -2298,9 +2342,7 @@ void UIManager::RenderWeddingModeTab()
         if (ImGui::Button("Import ceremony music", ImVec2(200, 30))) {
             auto filePaths = OpenFileDialogMultiSelect();
             if (!filePaths.empty()) {
-                if (ImportWeddingMusic(2, filePaths[0])) {
-                    isWeddingModeInitialized = true;
-                }
+                ImportWeddingMusic(2, filePaths[0]);
             }
         }
 
@@ -2312,9 +2354,7 @@ void UIManager::RenderWeddingModeTab()
         if (ImGui::Button("Import exit music", ImVec2(200, 30))) {
             auto filePaths = OpenFileDialogMultiSelect();
             if (!filePaths.empty()) {
-                if (ImportWeddingMusic(3, filePaths[0])) {
-                    isWeddingModeInitialized = true;
-                }
+                ImportWeddingMusic(3, filePaths[0]);
             }
         }
 
@@ -2325,8 +2365,9 @@ void UIManager::RenderWeddingModeTab()
 
         ImGui::Separator();
 
-        if (ImGui::SliderFloat("Ducking factor during ceremony", &ceremonyDuckingFactor, 0.0f, 1.0f)) {
-            m_targetDuckFactor = ceremonyDuckingFactor;
+        float ceremonyLevel = ShowTimeline::GetInstance().GetParameter("ceremonyLevel");
+        if (ImGui::SliderFloat("Ducking factor during ceremony", &ceremonyLevel, 0.0f, 1.0f)) {
+            ShowTimeline::GetInstance().SetParameter("ceremonyLevel", ceremonyLevel);
         }
 
         if (ImGui::SliderFloat("Crossfade duration (seconds)", &crossfadeDuration, 1.0f, 10.0f)) {
@@ -2336,6 +2377,7 @@ void UIManager::RenderWeddingModeTab()
         ImGui::Checkbox("Automatic transition between phases", &m_autoTransitionToPhase2);
         ImGui::Checkbox("Transition to normal music after ceremony", &transitionToNormalMusic);
         m_transitionToNormalMusicAfterWedding = transitionToNormalMusic;
+        SyncShowParameters();
 
         if (transitionToNormalMusic) {
             ImGui::InputText("Normal playlist after wedding", normalPlaylistName, IM_ARRAYSIZE(normalPlaylistName));
@@ -2348,9 +2390,9 @@ void UIManager::RenderWeddingModeTab()
                 ImGui::Text("Select normal playlist");
                 ImGui::Separator();
 
-                for (const auto& playlist : PlaylistManager::GetInstance().GetAllPlaylists()) {
-                    if (ImGui::Selectable(playlist.name.c_str())) {
-                        strncpy(normalPlaylistName, playlist.name.c_str(), sizeof(normalPlaylistName) - 1);
+                for (const auto* playlist : PlaylistManager::GetInstance().GetAllPlaylists()) {
+                    if (ImGui::Selectable(playlist->name.c_str())) {
+                        strncpy(normalPlaylistName, playlist->name.c_str(), sizeof(normalPlaylistName) - 1);
                         normalPlaylistName[sizeof(normalPlaylistName) - 1] = '\0';
                         m_normalPlaylistAfterWedding = normalPlaylistName;
                     }
@@ -2359,11 +2401,7 @@ void UIManager::RenderWeddingModeTab()
             }
         }
 
-        isWeddingModeInitialized = !m_weddingEntranceFilePath.empty() && 
-                                  !m_weddingCeremonyFilePath.empty() && 
-                                  !m_weddingExitFilePath.empty();
-
-        if (!isWeddingModeInitialized) {
+        if (!isShowReady) {
             ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), 
                 "Please import all music to initialize Wedding Mode");
         }
@@ -2373,215 +2411,71 @@ void UIManager::RenderWeddingModeTab()
 
     ImGui::Text("Wedding Ceremony Controls");
 
-    if (!isWeddingModeInitialized) {
+    const auto& sequences = timeline.GetSequences();
+
+    if (!isShowReady) {
         ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), 
             "Please import all music before using the controls");
-    } else {
-        if (ImGui::Button("Phase 1: Ceremony Entrance", ImVec2(300, 50))) {
-            StartWeddingPhase1(transitionToNormalMusic);
-        }
-
-        if (ImGui::Button("Phase 2: During Ceremony (with ducking)", ImVec2(300, 50))) {
-            StartWeddingPhase2(transitionToNormalMusic);
+        for (const auto& sound : missingSounds) {
+            ImGui::BulletText("%s", sound.c_str());
         }
-
-        if (ImGui::Button("Phase 3: End of Ceremony", ImVec2(300, 50))) {
-            StartWeddingPhase3(transitionToNormalMusic, normalPlaylistName);
+    } else {
+        // Un bouton par séquence du fichier de spectacle
+        for (size_t i = 0; i < sequences.size(); i++) {
+            if (sequences[i].label.empty()) continue;
+            if (ImGui::Button(sequences[i].label.c_str(), ImVec2(300, 50))) {
+                if (transitionToNormalMusic) {
+                    m_normalPlaylistAfterWedding = normalPlaylistName;
+                }
+                StartShowSequence(static_cast<int>(i), transitionToNormalMusic);
+            }
         }
 
         if (ImGui::Button("Stop all music", ImVec2(300, 30))) {
-            PlaylistManager::GetInstance().Stop("");  
-            AudioManager::GetInstance().StopAllSounds(); 
-
-            SetDuckFactor(1.0f);
-            UpdateAllVolumes();
-
-            m_weddingModeActive = false;
-            m_weddingPhase = 0;
-            m_autoDuckingActive = false;
-            m_autoTransitionToPhase2 = false;
-            m_transitionToNormalMusicAfterWedding = false;
-
-            spdlog::info("All music stopped");
+            StopAllMusic();
         }
 
-        if (m_weddingModeActive) {
+        if (IsWeddingModeActive()) {
             ImGui::Separator();
 
-            if (ImGui::Button("Skip to end of phase", ImVec2(300, 40))) {
-                if (m_weddingPhase == 1) {
-                    if (m_phase1State == WeddingPhase1State::FADING_OUT_PREVIOUS) {
-                        spdlog::info("Skip: End of fade out of previous music");
-                        PlaylistManager::GetInstance().Stop("");
-                        AudioManager::GetInstance().StopAllSounds();
-                        m_phase1DuckTimer = 0.0f;
-                        m_phase1State = WeddingPhase1State::PLAYING_SFX_BEFORE;
-
-                        float sfxVolume = GetSFXVolume() * GetMasterVolume();
-                        m_phase1SfxChannel = AudioManager::GetInstance().PlaySound("sfx_shine", false, sfxVolume);
-                    }
-                    else if (m_phase1State == WeddingPhase1State::PLAYING_SFX_BEFORE) {
-                        spdlog::info("Skip: End of SFX");
-                        if (m_phase1SfxChannel) {
-                            m_phase1SfxChannel->stop();
-                            m_phase1SfxChannel = nullptr;
-                        }
-                        m_phase1DuckTimer = 0.0f;
-                        m_phase1State = WeddingPhase1State::WAITING_AFTER_SFX;
-                    }
-                    else if (m_phase1State == WeddingPhase1State::WAITING_AFTER_SFX) {
-                        spdlog::info("Skip: End of waiting after SFX");
-                        m_phase1DuckTimer = m_phase1WaitDuration;
-                        SetDuckFactor(0.0f);
-
-                        float musicVolume = GetMusicVolume() * GetMasterVolume();
-                        m_phase1EntranceChannel = AudioManager::GetInstance().PlaySound(
-                            m_weddingEntranceSoundId, false, musicVolume);
-                        UpdateAllVolumes();
-
-                        m_phase1DuckTimer = 0.0f;
-                        m_phase1State = WeddingPhase1State::DUCKING_IN;
-                    }
-                    else if (m_phase1State == WeddingPhase1State::DUCKING_IN) {
-                        spdlog::info("Skip: End of ducking in");
-                        SetDuckFactor(1.0f);
-                        UpdateAllVolumes();
-                        m_phase1State = WeddingPhase1State::PLAYING_ENTRANCE;
-                    }
-                    else if (m_phase1State == WeddingPhase1State::PLAYING_ENTRANCE) {
-                        spdlog::info("Skip: End of entrance music");
-                        if (m_phase1EntranceChannel) {
-                            m_phase1EntranceChannel->stop();
-                            m_phase1EntranceChannel = nullptr;
-                        }
-                        StartWeddingPhase2(m_transitionToNormalMusicAfterWedding);
-                    }
-                }
-                else if (m_weddingPhase == 2) {
-                    spdlog::info("Skip: End of phase 2");
-                    StartWeddingPhase3(m_transitionToNormalMusicAfterWedding, m_normalPlaylistAfterWedding);
-                }
-                else if (m_weddingPhase == 3) {
-                    spdlog::info("Skip: End of phase 3");
-                    if (m_transitionToNormalMusicAfterWedding) {
-                        StartNormalMusicAfterWedding();
-                    }
-                    else {
-                        StopAllMusic();
-                    }
-                }
+            if (ImGui::Button("Skip to end of step", ImVec2(300, 40))) {
+                spdlog::info("Skip: End of step {}", timeline.GetCurrentStep());
+                timeline.Skip();
             }
 
             if (ImGui::Button("Go to next phase", ImVec2(300, 40))) {
-                if (m_weddingPhase == 1) {
-                    spdlog::info("Direct transition: Phase 1 -> Phase 2");
-                    StartWeddingPhase2(m_transitionToNormalMusicAfterWedding);
-                }
-                else if (m_weddingPhase == 2) {
-                    spdlog::info("Direct transition: Phase 2 -> Phase 3");
-                    StartWeddingPhase3(m_transitionToNormalMusicAfterWedding, m_normalPlaylistAfterWedding);
-                }
-                else if (m_weddingPhase == 3) {
-                    spdlog::info("Direct transition: Phase 3 -> End");
-                    if (m_transitionToNormalMusicAfterWedding) {
-                        StartNormalMusicAfterWedding();
-                    }
-                    else {
-                        StopAllMusic();
-                    }
-                }
+                spdlog::info("Direct transition from phase {}", GetWeddingPhase());
+                NextWeddingPhase();
             }
 
             if (ImGui::Button("Test transition to normal playlist", ImVec2(300, 40))) {
+                timeline.Stop();
                 StartNormalMusicAfterWedding();
                 spdlog::info("Test transition to normal playlist: {}", m_normalPlaylistAfterWedding);
             }
 
             if (ImGui::Button("Jump to 30 sec before end", ImVec2(300, 40))) {
-                FMOD::Channel* currentChannel = nullptr;
-
-                if (m_weddingPhase == 1 && m_phase1State == WeddingPhase1State::PLAYING_ENTRANCE) {
-                    currentChannel = m_phase1EntranceChannel;
-                } else if (m_weddingPhase == 2) {
-                    currentChannel = AudioManager::GetInstance().GetLastChannelOfSound(m_weddingCeremonySoundId);
-                } else if (m_weddingPhase == 3) {
-                    currentChannel = AudioManager::GetInstance().GetLastChannelOfSound(m_weddingExitSoundId);
-                }
-
-                if (currentChannel) {
-                    FMOD::Sound* currentSound = nullptr;
-                    bool isPlaying = false;
-                    currentChannel->isPlaying(&isPlaying);
-
-                    if (isPlaying && currentChannel->getCurrentSound(&currentSound) == FMOD_OK && currentSound) {
-                        unsigned int lengthMs = 0;
-                        currentSound->getLength(&lengthMs, FMOD_TIMEUNIT_MS);
-
-                        unsigned int newPositionMs = 0;
-                        if (lengthMs > 30000) {
-                            newPositionMs = lengthMs - 30000;
-                        }
-
-                        FMOD_RESULT result = currentChannel->setPosition(newPositionMs, FMOD_TIMEUNIT_MS);
-                        if (result == FMOD_OK) {
-                            spdlog::info("Jumped to 30 seconds before end (position: {}ms / {}ms)", 
-                                         newPositionMs, lengthMs);
-                        } else {
-                            spdlog::error("Unable to set music position");
-                        }
-                    } else {
-                        spdlog::error("Unable to get current sound");
-                    }
-                } else {
-                    spdlog::error("No active channel found for phase {}", m_weddingPhase);
+                if (!timeline.SeekBeforeEnd(30.0f)) {
+                    spdlog::error("No sound awaited in phase {}", GetWeddingPhase());
                 }
             }
 
             ImGui::Separator();
             ImGui::Text("Current state:");
 
-            if (m_weddingPhase == 1) {
-                ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Phase 1: Ceremony entrance in progress");
-
-                const char* stateStr = "Unknown";
-                switch (m_phase1State) {
-                    case WeddingPhase1State::IDLE: stateStr = "Idle"; break;
-                    case WeddingPhase1State::FADING_OUT_PREVIOUS: stateStr = "Fading out previous music"; break;
-                    case WeddingPhase1State::PLAYING_SFX_BEFORE: stateStr = "Playing SFX"; break;
-                    case WeddingPhase1State::WAITING_AFTER_SFX: stateStr = "Waiting after SFX"; break;
-                    case WeddingPhase1State::DUCKING_IN: stateStr = "Ducking in (increasing volume)"; break;
-                    case WeddingPhase1State::PLAYING_ENTRANCE: stateStr = "Playing entrance music"; break;
-                    case WeddingPhase1State::DUCKING_OUT: stateStr = "Ducking out"; break;
-                }
-                ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f), "Sub-phase: %s", stateStr);
+            const ShowSequence& sequence = sequences[timeline.GetCurrentSequence()];
+            const uint32_t stepIndex = timeline.GetCurrentStep();
+            ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "%s in progress",
+                               sequence.label.empty() ? sequence.name.c_str() : sequence.label.c_str());
+            ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f), "Step %u: %s", stepIndex - sequence.firstStep,
+                               ShowTimeline::GetStepTypeName(timeline.GetSteps()[stepIndex].type));
 
-                if (m_autoDuckingActive) {
-                    ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.0f, 1.0f), "Automatic ducking active");
-                }
-            } else if (m_weddingPhase == 2) {
-                ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Phase 2: Ceremony in progress");
-            } else if (m_weddingPhase == 3) {
-                ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Phase 3: End of ceremony in progress");
-
-                if (m_transitionToNormalMusicAfterWedding) {
-                    ImGui::TextColored(ImVec4(0.0f, 0.7f, 1.0f, 1.0f), 
-                        "Transition to normal playlist '%s' after end", m_normalPlaylistAfterWedding.c_str());
-                }
-            }
-
-            FMOD::Channel* currentChannel = nullptr;
-
-            if (m_weddingPhase == 1) {
-                currentChannel = AudioManager::GetInstance().GetLastChannelOfSound(m_weddingEntranceSoundId);
-            } else if (m_weddingPhase == 2) 
-            {
-                currentChannel = AudioManager::GetInstance().GetLastChannelOfSound(m_weddingCeremonySoundId);
-            }
-            else if (m_weddingPhase == 3)
-            {
-                currentChannel = AudioManager::GetInstance().GetLastChannelOfSound(m_weddingExitSoundId);
+            if (m_transitionToNormalMusicAfterWedding) {
+                ImGui::TextColored(ImVec4(0.0f, 0.7f, 1.0f, 1.0f), 
+                    "Transition to normal playlist '%s' after end", m_normalPlaylistAfterWedding.c_str());
             }
 
+            FMOD::Channel* currentChannel = timeline.GetAwaitedChannel();
             if (currentChannel) {
                 FMOD::Sound* currentSound = nullptr;
                 unsigned int positionMs = 0;
@@ -2609,9 +2503,6 @@ void UIManager::RenderWeddingModeTab()
             }
         }
     }
-
-    float deltaTime = ImGui::GetIO().DeltaTime;
-    CheckWeddingPhaseTransition();
 }
 
 void UIManager::UpdateWeddingFilePaths()
@@ -2641,7 +2532,8 @@ void UIManager::PlayRandomMusic() {
     PlaylistManager::GetInstance().Stop("");
     AudioManager::GetInstance().StopAllSounds();
 
-    PlaylistOptions opts;
+    const auto* preShow = PlaylistManager::GetInstance().GetPlaylistByName("playlist_PreShow");
+    PlaylistOptions opts = preShow ? preShow->options : PlaylistOptions();
     opts.randomOrder = true;
     opts.randomSegment = true;
     opts.loopPlaylist = true;
@@ -2654,83 +2546,82 @@ void UIManager::PlayRandomMusic() {
 }
 
 void UIManager::StartWeddingPhase1(bool transitionToNormalMusicAfter) {
-
-    m_originalDuckFactor = m_duckFactor; 
-
-    m_weddingModeActive = true;
-    m_weddingPhase = 1;
-    m_phase1State = WeddingPhase1State::FADING_OUT_PREVIOUS;
-    m_phase1DuckTimer = 0.0f;
-    m_transitionToNormalMusicAfterWedding = transitionToNormalMusicAfter;
-
-    spdlog::info("Wedding Phase 1: Starting with progressive fade out ({:.1f} seconds)", m_phase1FadeOutDuration);
+    StartShowSequence(0, transitionToNormalMusicAfter);
 }
 
 void UIManager::StartWeddingPhase2(bool transitionToNormalMusicAfter) {
-    PlaylistManager::GetInstance().Stop("");
-    AudioManager::GetInstance().StopAllSounds();
-
-    m_originalDuckFactor = 1.0f;
-    SetDuckFactor(0.0f);
-
-    FMOD::Channel* channel = AudioManager::GetInstance().PlaySound(m_weddingCeremonySoundId, true, m_musicVolume * m_masterVolume);
-
-    m_weddingModeActive = true;
-    m_weddingPhase = 2;
-    m_autoDuckingActive = true;
-    m_autoTransitionToPhase2 = transitionToNormalMusicAfter;
-    m_transitionToNormalMusicAfterWedding = transitionToNormalMusicAfter;
-
-    m_crossfadeDuration = 20.0f;
-    m_targetDuckFactor = 0.05f;
-
-    UpdateAllVolumes();
-
-    spdlog::info("Wedding phase 2 started with 20-second ducking in");
+    StartShowSequence(1, transitionToNormalMusicAfter);
 }
 
 void UIManager::StartWeddingPhase3(bool transitionToNormalMusicAfter, const std::string& postWeddingPlaylist) {
-    PlaylistManager::GetInstance().Stop("");
-    AudioManager::GetInstance().StopAllSounds();
-
-    m_originalDuckFactor = 1.0f;
-    m_targetDuckFactor = 1.0f;
-    SetDuckFactor(0.0f);
-
-    FMOD::Channel* channel = AudioManager::GetInstance().PlaySound(m_weddingExitSoundId, false, m_musicVolume * m_masterVolume);
-
-    m_weddingModeActive = true;
-    m_weddingPhase = 3;
-    m_autoDuckingActive = true;
-    m_autoTransitionToPhase2 = false;
-    m_transitionToNormalMusicAfterWedding = transitionToNormalMusicAfter;
-
     if (!postWeddingPlaylist.empty()) {
         m_normalPlaylistAfterWedding = postWeddingPlaylist;
     }
-
-    m_crossfadeDuration = 10.0f;
-
-    UpdateAllVolumes();
-
-    spdlog::info("Wedding phase 3 started with 10-second ducking in");
+    StartShowSequence(2, transitionToNormalMusicAfter);
 }
 
 void UIManager::NextWeddingPhase() {
-    if (!m_weddingModeActive) {
-        StartWeddingPhase1(false);
+    if (!IsWeddingModeActive()) {
+        StartShowSequence(0, false);
         return;
     }
 
-    if (m_weddingPhase == 1) {
-        StartWeddingPhase2(m_transitionToNormalMusicAfterWedding);
-    } else if (m_weddingPhase == 2) {
-        StartWeddingPhase3(m_transitionToNormalMusicAfterWedding, m_normalPlaylistAfterWedding);
-    } else if (m_weddingPhase == 3) {
+    const int next = ShowTimeline::GetInstance().GetCurrentSequence() + 1;
+    if (next < static_cast<int>(ShowTimeline::GetInstance().GetSequences().size())) {
+        StartShowSequence(next, m_transitionToNormalMusicAfterWedding);
+    } else {
         StopAllMusic();
     }
 }
 
+void UIManager::StartShowSequence(int sequence, bool transitionToNormalMusicAfter) {
+    m_transitionToNormalMusicAfterWedding = transitionToNormalMusicAfter;
+    m_musicFadeInActive = false;
+    SyncShowParameters();
+
+    if (ShowTimeline::GetInstance().Start(sequence)) {
+        spdlog::info("Wedding phase {} started", sequence + 1);
+    }
+}
+
+void UIManager::SyncShowParameters() {
+    auto& timeline = ShowTimeline::GetInstance();
+    timeline.SetParameter("autoAdvance", m_autoTransitionToPhase2 ? 1.0f : 0.0f);
+    timeline.SetParameter("afterShowPlaylist", m_transitionToNormalMusicAfterWedding ? 1.0f : 0.0f);
+}
+
+void UIManager::SetupShowTimeline() {
+    ShowTimelineHost host;
+    host.getLevel = [this]() { return m_duckFactor; };
+    host.setLevel = [this](float level) {
+        SetDuckFactor(level);
+        UpdateAllVolumes();
+    };
+    host.getVolume = [this](ShowBus bus) {
+        return (bus == ShowBus::Sfx ? m_sfxVolume : m_musicVolume) * m_masterVolume;
+    };
+    host.startPlaylist = [this](const std::string& playlist) {
+        if (!playlist.empty()) {
+            m_normalPlaylistAfterWedding = playlist;
+        }
+        StartNormalMusicAfterWedding();
+    };
+
+    auto& timeline = ShowTimeline::GetInstance();
+    timeline.SetHost(host);
+
+    // Le déroulé du mariage se modifie dans le fichier, sans recompiler
+    if (!timeline.LoadFile("data/shows/wedding.json")) {
+        timeline.LoadString(DefaultWeddingShow, "built-in wedding show");
+    }
+    SyncShowParameters();
+
+    // Les cues du spectacle jouent avec les mêmes volumes que la timeline
+    auto& cues = CueStack::GetInstance();
+    cues.SetHost(host);
+    cues.LoadFile(g_cueStackFile);
+}
+
 void UIManager::StopAllMusic() {
     PlaylistManager::GetInstance().Stop("");
     AudioManager::GetInstance().StopAllSounds();
@@ -2738,13 +2629,10 @@ void UIManager::StopAllMusic() {
     SetDuckFactor(1.0f);
     UpdateAllVolumes();
 
-    m_weddingModeActive = false;
-    m_weddingPhase = 0;
-    m_autoDuckingActive = false;
-    m_autoTransitionToPhase2 = false;
+    ShowTimeline::GetInstance().Stop();
     m_transitionToNormalMusicAfterWedding = false;
 
-    spdlog::info("All music stopped via Bluetooth");
+    spdlog::info("All music stopped");
 }
 
 }
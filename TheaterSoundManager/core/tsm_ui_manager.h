@@ -15,16 +15,6 @@ namespace TSM
 class UIManager
 {
 public:
-    enum class WeddingPhase1State {
-        IDLE,
-        FADING_OUT_PREVIOUS,
-        PLAYING_SFX_BEFORE,
-        WAITING_AFTER_SFX,
-        DUCKING_IN,
-        PLAYING_ENTRANCE,
-        DUCKING_OUT
-    };
-
     static UIManager& GetInstance()
     {
         static UIManager instance;
@@ -55,8 +45,14 @@ public:
 
     void SetDuckFactor(float factor)   { m_duckFactor = factor; }
     float GetDuckFactor() const        { return m_duckFactor; }
+    bool IsMusicFadeInActive() const   { return m_musicFadeInActive; }
 
     void UpdateWeddingMode(float deltaTime);
+    bool IsWeddingModeActive() const;
+    // Index of the running show sequence, from 1; 0 when the show is stopped.
+    int GetWeddingPhase() const;
+    bool IsTransitionToNormalMusicAfterWedding() const { return m_transitionToNormalMusicAfterWedding; }
+    const std::string& GetNormalPlaylistAfterWedding() const { return m_normalPlaylistAfterWedding; }
     
     void UpdateWeddingFilePaths();
 
@@ -87,10 +83,13 @@ private:
     void RenderAnnouncementsTab();
     void RenderSFXTab();
     void RenderWeddingModeTab();
+    void RenderCueStackTab();
 
     void UpdateAllVolumes();
-    void CheckWeddingPhaseTransition();
     
+    void SetupShowTimeline();
+    void StartShowSequence(int sequence, bool transitionToNormalMusicAfter);
+    void SyncShowParameters();
     bool ImportWeddingMusic(int phase, const std::string& filePath);
     void StartNormalMusicAfterWedding();
 
@@ -124,11 +123,6 @@ private:
 
     float m_duckFactor         = 1.0f;
     
-    bool m_weddingModeActive = false;
-    int m_weddingPhase = 0;  
-    bool m_autoDuckingActive = false;
-    float m_originalDuckFactor = 1.0f;
-    float m_targetDuckFactor = 0.3f;
     float m_crossfadeDuration = 10.0f;
     bool m_autoTransitionToPhase2 = false;
     bool m_transitionToNormalMusicAfterWedding = false;
@@ -150,16 +144,7 @@ private:
     
     PlaylistOptions m_opts;
     std::string m_playlistName = "playlist_sample";
-
-    WeddingPhase1State m_phase1State = WeddingPhase1State::IDLE;
-    float m_phase1DuckTimer = 0.0f;
-    float m_phase1DuckFadeDuration = 20.0f;
-    float m_phase1FadeOutDuration = 5.0f;
-    float m_phase1WaitDuration = 6.0f;
-    float m_phasesTransitionDuration = 10.0f;  
-    FMOD::Channel* m_phase1SfxChannel = nullptr;
-    FMOD::Channel* m_phase1EntranceChannel = nullptr;
-    std::string m_phase1SfxName = "sfx_shine";
+    PlaylistTransition m_transition;
 };
 
 } // namespace TSM
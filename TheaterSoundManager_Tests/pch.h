@@ -10,10 +10,29 @@
 #include <random>
 #include <chrono>
 #include <ctime>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <filesystem>
 
 #include "tsm_playlist_manager.h"
+#include "tsm_playlist_journal.h"
+#include "tsm_library_snapshot.h"
+#include "tsm_playlist_import.h"
+#include "tsm_audio_probe.h"
+#include "tsm_indexed_sequence.h"
+#include "tsm_track_id.h"
+#include "tsm_shuffle_engine.h"
+#include "tsm_cue_planner.h"
+#include "tsm_fmod_wrapper.h"
+#include "tsm_pcm_cache.h"
+#include "tsm_loop_renderer.h"
+#include "tsm_show_timeline.h"
+#include "tsm_cue_stack.h"
+#include "tsm_playback_checkpoint.h"
 #include "tsm_announcement_manager.h"
 #include "tsm_audio_manager.h"
-#include "tsm_ui_manager.h"
\ No newline at end of file
+#include "tsm_ui_manager.h"
+
+#include "tsm_test_audio_utils.h"
\ No newline at end of file
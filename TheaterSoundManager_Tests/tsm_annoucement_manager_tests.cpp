@@ -11,6 +11,13 @@ namespace TSM {
                 while (!manager.GetScheduledAnnouncements().empty()) {
                     manager.RemoveScheduledAnnouncement(0);
                 }
+
+                // Les fragments s'ouvrent sur une sortie sans son
+                m_directory = std::filesystem::temp_directory_path() / "tsm_announcement_tests";
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::create_directories(m_directory);
+                m_output = AddNoSoundOutput("test_announcements");
+                manager.SetOutput(m_output);
             }
 
             void TearDown() override {
@@ -19,7 +26,21 @@ namespace TSM {
                 while (!manager.GetScheduledAnnouncements().empty()) {
                     manager.RemoveScheduledAnnouncement(0);
                 }
+
+                for (const auto& phraseId : manager.GetPhraseIds()) {
+                    if (phraseId.rfind("test_", 0) == 0) manager.UnregisterPhrase(phraseId);
+                }
+                manager.SetOutput(FModWrapper::MainOutput);
+                if (FModWrapper::GetInstance().GetSystem(m_output)) FModWrapper::GetInstance().RemoveOutput(m_output);
+                std::filesystem::remove_all(m_directory);
+            }
+
+            static int RefCount(const std::string& fragmentId) {
+                return AudioManager::GetInstance().GetFragmentRefCount(AnnouncementManager::FragmentSoundId(fragmentId));
             }
+
+            std::filesystem::path m_directory;
+            OutputId m_output = FModWrapper::InvalidOutput;
         };
 
         TEST_F(AnnouncementManagerTests, ScheduleAnnouncement) {
@@ -95,5 +116,60 @@ namespace TSM {
             ASSERT_EQ(manager.GetAnnouncementStateString(), "Idle");
         }
 
+        TEST_F(AnnouncementManagerTests, RegisterPhraseWithUnknownFragmentFails) {
+            auto& manager = AnnouncementManager::GetInstance();
+
+            ASSERT_FALSE(manager.RegisterPhrase("test_phrase", { "missing_fragment" }));
+            ASSERT_FALSE(manager.IsPhrase("test_phrase"));
+            ASSERT_FALSE(manager.RegisterPhrase("test_phrase", {}));
+        }
+
+        TEST_F(AnnouncementManagerTests, PhrasesShareFragmentsUntilTheLastOneIsUnregistered) {
+            auto& manager = AnnouncementManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            ASSERT_TRUE(manager.RegisterFragment("test_gate", WriteSilentWav(m_directory / "gate.wav", 48000, 4800)));
+            ASSERT_TRUE(manager.RegisterFragment("test_seven", WriteSilentWav(m_directory / "seven.wav", 48000, 4800)));
+
+            ASSERT_TRUE(manager.RegisterPhrase("test_boarding", { "test_gate", "test_seven" }));
+            ASSERT_TRUE(manager.RegisterPhrase("test_closing", { "test_gate" }));
+            ASSERT_EQ(RefCount("test_gate"), 2);
+            ASSERT_EQ(RefCount("test_seven"), 1);
+            FMOD::Sound* gate = audioManager.GetSound(AnnouncementManager::FragmentSoundId("test_gate"), m_output);
+            ASSERT_NE(gate, nullptr);
+
+            // Redéfinir une phrase reprend ses fragments avant de rendre les anciens
+            ASSERT_TRUE(manager.RegisterPhrase("test_closing", { "test_gate", "test_seven" }));
+            ASSERT_EQ(RefCount("test_gate"), 2);
+            ASSERT_EQ(RefCount("test_seven"), 2);
+            ASSERT_EQ(audioManager.GetSound(AnnouncementManager::FragmentSoundId("test_gate"), m_output), gate);
+
+            manager.UnregisterPhrase("test_boarding");
+            ASSERT_FALSE(manager.IsPhrase("test_boarding"));
+            ASSERT_EQ(RefCount("test_gate"), 1);
+            ASSERT_EQ(RefCount("test_seven"), 1);
+
+            manager.UnregisterPhrase("test_closing");
+            ASSERT_EQ(RefCount("test_gate"), 0);
+            ASSERT_FALSE(audioManager.HasSound(AnnouncementManager::FragmentSoundId("test_gate")));
+            ASSERT_FALSE(audioManager.HasSound(AnnouncementManager::FragmentSoundId("test_seven")));
+        }
+
+        TEST_F(AnnouncementManagerTests, FragmentsFollowEachOtherInOutputSamples) {
+            auto& manager = AnnouncementManager::GetInstance();
+            const unsigned long long outputRate = AudioManager::GetInstance().GetOutputSampleRate(m_output);
+
+            // Un fragment à 24 kHz dure deux fois plus d'échantillons de sortie que de frames
+            ASSERT_TRUE(manager.RegisterFragment("test_chime", WriteSilentWav(m_directory / "chime.wav", 24000, 12000)));
+            ASSERT_TRUE(manager.RegisterFragment("test_word", WriteSilentWav(m_directory / "word.wav", 48000, 4800)));
+            ASSERT_TRUE(manager.RegisterPhrase("test_sentence", { "test_chime", "test_word", "test_chime" }));
+
+            const std::vector<unsigned long long> offsets = manager.GetPhraseOffsets("test_sentence");
+            ASSERT_EQ(offsets.size(), 3u);
+            ASSERT_EQ(offsets[0], 0u);
+            ASSERT_EQ(offsets[1], outputRate / 2);
+            ASSERT_EQ(offsets[2], outputRate / 2 + outputRate / 10);
+            ASSERT_TRUE(manager.GetPhraseOffsets("test_unknown").empty());
+        }
+
     }
 }
\ No newline at end of file
@@ -0,0 +1,268 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        class AudioProbeTests : public ::testing::Test {
+        protected:
+            using Bytes = std::vector<uint8_t>;
+
+            void SetUp() override {
+                m_directory = std::filesystem::temp_directory_path() / "tsm_probe_tests";
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::create_directories(m_directory);
+            }
+
+            void TearDown() override {
+                std::filesystem::remove_all(m_directory);
+            }
+
+            std::string WriteFile(const std::string& fileName, const Bytes& content) {
+                std::string path = (m_directory / fileName).string();
+                std::ofstream file(path, std::ios::binary);
+                file.write(reinterpret_cast<const char*>(content.data()), content.size());
+                return path;
+            }
+
+            static void Append(Bytes& out, const std::string& text) { out.insert(out.end(), text.begin(), text.end()); }
+            static void LE16(Bytes& out, uint32_t v) { out.push_back(uint8_t(v)); out.push_back(uint8_t(v >> 8)); }
+            static void LE32(Bytes& out, uint32_t v) { LE16(out, v & 0xFFFF); LE16(out, v >> 16); }
+            static void BE32(Bytes& out, uint32_t v) { for (int s = 24; s >= 0; s -= 8) out.push_back(uint8_t(v >> s)); }
+
+            // 16-bit PCM; with tags the LIST chunk comes after the data, as most editors write it.
+            static Bytes MakeWav(uint32_t sampleRate, uint16_t channels, uint32_t durationMs,
+                                 const std::string& title = "", const std::string& artist = "") {
+                const uint32_t byteRate = sampleRate * channels * 2;
+                const uint32_t dataSize = uint32_t(uint64_t(byteRate) * durationMs / 1000);
+
+                Bytes body;
+                Append(body, "WAVE");
+                Append(body, "fmt ");
+                LE32(body, 16);
+                LE16(body, 1);
+                LE16(body, channels);
+                LE32(body, sampleRate);
+                LE32(body, byteRate);
+                LE16(body, channels * 2);
+                LE16(body, 16);
+                Append(body, "data");
+                LE32(body, dataSize);
+                body.resize(body.size() + dataSize, 0);
+
+                if (!title.empty()) {
+                    Bytes info;
+                    Append(info, "INFO");
+                    for (auto [id, text] : { std::pair<std::string, std::string>{ "INAM", title }, { "IART", artist } }) {
+                        text.push_back('\0');
+                        Append(info, id);
+                        LE32(info, uint32_t(text.size()));
+                        Append(info, text);
+                        if (text.size() & 1) info.push_back(0);
+                    }
+                    Append(body, "LIST");
+                    LE32(body, uint32_t(info.size()));
+                    body.insert(body.end(), info.begin(), info.end());
+                }
+
+                Bytes file;
+                Append(file, "RIFF");
+                LE32(file, uint32_t(body.size()));
+                file.insert(file.end(), body.begin(), body.end());
+                return file;
+            }
+
+            std::filesystem::path m_directory;
+        };
+
+        TEST_F(AudioProbeTests, ReadsWavAndFlacHeadersAndTags) {
+            AudioProbeResult wav = ProbeAudioFile(WriteFile("tagged.wav", MakeWav(44100, 2, 1500, "Ouverture", "Orchestre")));
+            ASSERT_TRUE(wav.IsValid());
+            ASSERT_EQ(wav.format, "wav");
+            ASSERT_EQ(wav.lengthMs, 1500u);
+            ASSERT_EQ(wav.sampleRate, 44100u);
+            ASSERT_EQ(wav.channels, 2);
+            ASSERT_EQ(wav.title, "Ouverture");
+            ASSERT_EQ(wav.artist, "Orchestre");
+
+            Bytes flac;
+            Append(flac, "fLaC");
+            flac.insert(flac.end(), { 0x00, 0x00, 0x00, 34 });
+            Bytes streamInfo(34, 0);
+            const uint32_t sampleRate = 48000;
+            const uint64_t totalSamples = 48000ull * 3;
+            streamInfo[10] = uint8_t(sampleRate >> 12);
+            streamInfo[11] = uint8_t(sampleRate >> 4);
+            streamInfo[12] = uint8_t(((sampleRate & 0xF) << 4) | ((2 - 1) << 1));
+            streamInfo[13] = uint8_t((15 << 4) | ((totalSamples >> 32) & 0xF));
+            for (int i = 0; i < 4; i++) streamInfo[14 + i] = uint8_t(totalSamples >> (24 - 8 * i));
+            flac.insert(flac.end(), streamInfo.begin(), streamInfo.end());
+
+            Bytes comment;
+            LE32(comment, 3);
+            Append(comment, "tsm");
+            LE32(comment, 3);
+            for (std::string entry : { "title=Entracte", "ARTIST=Quatuor", "Album=Acte II" }) {
+                LE32(comment, uint32_t(entry.size()));
+                Append(comment, entry);
+            }
+            flac.push_back(0x80 | 4);
+            flac.push_back(0);
+            flac.push_back(uint8_t(comment.size() >> 8));
+            flac.push_back(uint8_t(comment.size()));
+            flac.insert(flac.end(), comment.begin(), comment.end());
+
+            AudioProbeResult probe = ProbeAudioFile(WriteFile("tagged.flac", flac));
+            ASSERT_TRUE(probe.IsValid());
+            ASSERT_EQ(probe.format, "flac");
+            ASSERT_EQ(probe.lengthMs, 3000u);
+            ASSERT_EQ(probe.sampleRate, 48000u);
+            ASSERT_EQ(probe.channels, 2);
+            ASSERT_EQ(probe.title, "Entracte");
+            ASSERT_EQ(probe.artist, "Quatuor");
+            ASSERT_EQ(probe.album, "Acte II");
+        }
+
+        TEST_F(AudioProbeTests, ReadsMp3LengthFromFramesOrXingHeader) {
+            // MPEG-1 layer III, 128 kbit/s, 44.1 kHz: 417 bytes per frame.
+            const size_t frameLength = 417;
+            auto makeFrames = [&](size_t count) {
+                Bytes frames;
+                for (size_t i = 0; i < count; i++) {
+                    frames.insert(frames.end(), { 0xFF, 0xFB, 0x90, 0x00 });
+                    frames.resize(frames.size() + frameLength - 4, 0);
+                }
+                return frames;
+            };
+
+            Bytes tag;
+            Append(tag, "TIT2");
+            BE32(tag, 1 + 2 + 8 * 2);
+            tag.insert(tag.end(), { 0, 0 });
+            tag.insert(tag.end(), { 1, 0xFF, 0xFE });
+            for (char c : std::string("Entracte")) { tag.push_back(uint8_t(c)); tag.push_back(0); }
+            Append(tag, "TPE1");
+            BE32(tag, 1 + 7);
+            tag.insert(tag.end(), { 0, 0, 0 });
+            tag.insert(tag.end(), { 'T', 'h', 0xE9, 'a', 't', 'r', 'e' });     // latin-1
+
+            Bytes cbr;
+            Append(cbr, "ID3");
+            cbr.insert(cbr.end(), { 3, 0, 0, 0, 0, 0, uint8_t(tag.size()) });
+            cbr.insert(cbr.end(), tag.begin(), tag.end());
+            Bytes frames = makeFrames(100);
+            cbr.insert(cbr.end(), frames.begin(), frames.end());
+
+            AudioProbeResult probe = ProbeAudioFile(WriteFile("cbr.mp3", cbr));
+            ASSERT_TRUE(probe.IsValid());
+            ASSERT_EQ(probe.format, "mp3");
+            ASSERT_EQ(probe.sampleRate, 44100u);
+            ASSERT_EQ(probe.lengthMs, uint32_t(100 * frameLength * 8 / 128));
+            ASSERT_EQ(probe.title, "Entracte");
+            ASSERT_EQ(probe.artist, "Th\xC3\xA9" "atre");
+
+            Bytes vbr = makeFrames(3);
+            const size_t xing = 4 + 32;
+            std::memcpy(vbr.data() + xing, "Xing", 4);
+            vbr[xing + 7] = 0x01;
+            vbr[xing + 10] = 1000 >> 8;
+            vbr[xing + 11] = 1000 & 0xFF;
+
+            probe = ProbeAudioFile(WriteFile("vbr.mp3", vbr));
+            ASSERT_TRUE(probe.IsValid());
+            ASSERT_EQ(probe.lengthMs, uint32_t(1000ull * 1152 * 1000 / 44100));
+        }
+
+        TEST_F(AudioProbeTests, ReadsEncoderDelayAndPaddingFromLameTag) {
+            Bytes mp3;
+            for (int i = 0; i < 3; i++) {
+                mp3.insert(mp3.end(), { 0xFF, 0xFB, 0x90, 0x00 });
+                mp3.resize(mp3.size() + 417 - 4, 0);
+            }
+            const size_t xing = 4 + 32;
+            std::memcpy(mp3.data() + xing, "Info", 4);
+            mp3[xing + 7] = 0x01;
+            mp3[xing + 11] = 2;
+
+            // Frame count seul, le tag LAME suit directement
+            const size_t lame = xing + 8 + 4;
+            std::memcpy(mp3.data() + lame, "LAME3.100", 9);
+            mp3[lame + 21] = 576 >> 4;
+            mp3[lame + 22] = uint8_t(((576 & 0xF) << 4) | (1200 >> 8));
+            mp3[lame + 23] = 1200 & 0xFF;
+
+            AudioProbeResult probe = ProbeAudioFile(WriteFile("lame.mp3", mp3));
+            ASSERT_TRUE(probe.IsValid());
+            ASSERT_EQ(probe.encoderDelay, 576u);
+            ASSERT_EQ(probe.encoderPadding, 1200u);
+
+            std::memcpy(mp3.data() + lame, "none", 4);
+            probe = ProbeAudioFile(WriteFile("untagged.mp3", mp3));
+            ASSERT_EQ(probe.encoderDelay, 0u);
+            ASSERT_EQ(probe.encoderPadding, 0u);
+        }
+
+        TEST_F(AudioProbeTests, ClassifiesBrokenAndUnknownFiles) {
+            Bytes truncated = MakeWav(22050, 1, 100);
+            truncated.resize(12 + 8 + 16);
+
+            ASSERT_EQ(ProbeAudioFile(WriteFile("truncated.wav", truncated)).status, AudioProbeResult::Status::Invalid);
+            ASSERT_EQ(ProbeAudioFile((m_directory / "missing.wav").string()).status, AudioProbeResult::Status::Invalid);
+
+            Bytes text;
+            Append(text, "not an audio file, FMOD decides");
+            ASSERT_EQ(ProbeAudioFile(WriteFile("notes.mod", text)).status, AudioProbeResult::Status::Unknown);
+        }
+
+        TEST_F(AudioProbeTests, PoolKeepsResultsInInputOrder) {
+            std::vector<std::string> paths;
+            for (uint32_t i = 0; i < 24; i++) {
+                paths.push_back(WriteFile("track_" + std::to_string(i) + ".wav", MakeWav(8000, 1, 100 + 10 * i)));
+            }
+
+            AudioProbePool pool(3);
+            ASSERT_EQ(pool.GetThreadCount(), 3u);
+
+            for (int pass = 0; pass < 2; pass++) {
+                std::vector<AudioProbeResult> results = pool.ProbeAll(paths);
+                ASSERT_EQ(results.size(), paths.size());
+                for (uint32_t i = 0; i < results.size(); i++) {
+                    ASSERT_TRUE(results[i].IsValid());
+                    ASSERT_EQ(results[i].lengthMs, 100 + 10 * i);
+                }
+            }
+            ASSERT_TRUE(pool.ProbeAll({}).empty());
+        }
+
+        TEST_F(AudioProbeTests, ImportAudioFilesSkipsInvalidFilesAndKeepsOrder) {
+            auto& audioManager = AudioManager::GetInstance();
+            auto& playlistManager = PlaylistManager::GetInstance();
+            const std::string playlist = "probe_import_playlist";
+
+            Bytes broken = MakeWav(8000, 1, 100);
+            broken.resize(20);
+
+            std::vector<PlaylistImporter::AudioFileEntry> files = {
+                { "probe_b", WriteFile("b.wav", MakeWav(8000, 1, 250, "Second", "Troupe")), true, true },
+                { "probe_broken", WriteFile("broken.wav", broken), true, true },
+                { "probe_a", WriteFile("a.wav", MakeWav(8000, 1, 500)), true, true },
+                { "probe_sfx", WriteFile("sfx.wav", MakeWav(8000, 1, 50)), false, false },
+            };
+
+            ASSERT_EQ(PlaylistImporter::GetInstance().ImportAudioFiles(files, playlist), 3u);
+
+            const auto* imported = playlistManager.GetPlaylistByName(playlist);
+            ASSERT_NE(imported, nullptr);
+            ASSERT_EQ(imported->tracks, (std::vector<std::string>{ "probe_b", "probe_a" }));
+            ASSERT_FALSE(audioManager.HasSound("probe_broken"));
+            ASSERT_EQ(audioManager.GetSoundLengthMs("probe_b"), 250u);
+            ASSERT_EQ(audioManager.GetAllSounds().at("probe_b").artist, "Troupe");
+            ASSERT_FALSE(audioManager.GetAllSounds().at("probe_sfx").isStream);
+
+            playlistManager.DeletePlaylist(playlist);
+            for (const char* id : { "probe_a", "probe_b", "probe_sfx" }) {
+                audioManager.UnloadSound(id);
+            }
+        }
+
+    }
+}
@@ -0,0 +1,56 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        // Tabulées à la compilation
+        static_assert(CrossfadeTableFor<EqualPowerFade>.FadeIn(0.0f) == 0.0f);
+        static_assert(CrossfadeTableFor<EqualPowerFade>.FadeIn(1.0f) > 0.9999f);
+        static_assert(CrossfadeTableFor<LogarithmicFade>.FadeIn(1.0f) > 0.9999f);
+
+        TEST(CrossfadeCurveTests, EveryCurveStartsAndEndsOnOneChannel) {
+            for (CrossfadeCurve curve : AllCrossfadeCurves) {
+                const CrossfadeTable table = GetCrossfadeTable(curve);
+                const CrossfadeGains start = table(0.0f);
+                const CrossfadeGains end = table(1.0f);
+                EXPECT_NEAR(start.out, 1.0f, 1e-5f) << GetCrossfadeCurveName(curve);
+                EXPECT_NEAR(start.in, 0.0f, 1e-5f) << GetCrossfadeCurveName(curve);
+                EXPECT_NEAR(end.out, 0.0f, 1e-5f) << GetCrossfadeCurveName(curve);
+                EXPECT_NEAR(end.in, 1.0f, 1e-5f) << GetCrossfadeCurveName(curve);
+            }
+        }
+
+        TEST(CrossfadeCurveTests, TablesFollowTheirCurves) {
+            const CrossfadeTable equalPower = GetCrossfadeTable(CrossfadeCurve::EqualPower);
+            for (float t = 0.0f; t <= 1.0f; t += 0.03f) {
+                const CrossfadeGains gains = equalPower(t);
+                ASSERT_NEAR(gains.out * gains.out + gains.in * gains.in, 1.0f, 1e-3f);
+                ASSERT_NEAR(gains.in, std::sin(t * 1.5707963f), 1e-4f);
+            }
+
+            // 48 dB d'une extrémité à l'autre : -24 dB au milieu
+            const CrossfadeTable logarithmic = GetCrossfadeTable(CrossfadeCurve::Logarithmic);
+            ASSERT_NEAR(logarithmic.FadeIn(0.5f), std::pow(10.0f, -24.0f / 20.0f), 1e-4f);
+            ASSERT_NEAR(logarithmic.FadeIn(0.75f), std::pow(10.0f, -12.0f / 20.0f), 1e-4f);
+
+            const CrossfadeTable sCurve = GetCrossfadeTable(CrossfadeCurve::SCurve);
+            ASSERT_NEAR(sCurve.FadeIn(0.5f), 0.5f, 1e-5f);
+            ASSERT_LT(sCurve.FadeIn(0.1f), 0.1f);
+
+            const CrossfadeTable custom = GetCrossfadeTable(CrossfadeCurve::Custom, 0.5f);
+            ASSERT_NEAR(custom.FadeIn(0.25f), 0.5f, 1e-3f);
+        }
+
+        TEST(CrossfadeCurveTests, KeysRoundTrip) {
+            for (CrossfadeCurve curve : AllCrossfadeCurves) {
+                CrossfadeCurve parsed = CrossfadeCurve::Linear;
+                ASSERT_TRUE(ParseCrossfadeCurve(GetCrossfadeCurveKey(curve), parsed));
+                ASSERT_EQ(parsed, curve);
+            }
+            CrossfadeCurve parsed = CrossfadeCurve::SCurve;
+            ASSERT_FALSE(ParseCrossfadeCurve("cubic", parsed));
+            ASSERT_EQ(parsed, CrossfadeCurve::SCurve);
+        }
+
+    }
+}
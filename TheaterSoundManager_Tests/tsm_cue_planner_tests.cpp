@@ -0,0 +1,122 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        static CuePlanItem Item(uint32_t maxMs, uint32_t minMs) {
+            CuePlanItem item;
+            item.maxMs = maxMs;
+            item.minMs = minMs;
+            return item;
+        }
+
+        static void ExpectValidPlan(const CuePlanRequest& request, const CuePlan& plan) {
+            ASSERT_TRUE(plan.found);
+            ASSERT_EQ(plan.order.size(), plan.durationsMs.size());
+            ASSERT_EQ(plan.TotalMs(), request.cueInMs);
+            ASSERT_GE(plan.currentMs, request.current.minMs);
+            ASSERT_LE(plan.currentMs, request.current.maxMs);
+            for (size_t i = 0; i < plan.order.size(); i++) {
+                const CuePlanItem& item = request.upcoming[plan.order[i]];
+                ASSERT_GE(plan.durationsMs[i], item.minMs);
+                ASSERT_LE(plan.durationsMs[i], item.maxMs);
+                if (i > 0) {
+                    ASSERT_LT(plan.order[i - 1], plan.order[i]);
+                }
+            }
+        }
+
+        TEST(CuePlannerTests, CutsTheCurrentTrackWhenTheCueFallsInside) {
+            CuePlanRequest request;
+            request.current = Item(60000, 30000);
+            request.cueInMs = 45000;
+            request.upcoming = { Item(200000, 170000) };
+
+            CuePlan plan = PlanToCue(request);
+            ExpectValidPlan(request, plan);
+            ASSERT_EQ(plan.currentMs, 45000u);
+            ASSERT_TRUE(plan.order.empty());
+
+            // Trop tôt : le morceau courant ne peut pas être coupé avant 30 s
+            request.cueInMs = 10000;
+            ASSERT_FALSE(PlanToCue(request).found);
+        }
+
+        TEST(CuePlannerTests, TrimsAnOrderedPrefix) {
+            CuePlanRequest request;
+            request.current = Item(100000, 80000);
+            request.upcoming = { Item(180000, 150000), Item(240000, 210000), Item(200000, 170000) };
+            request.cueInMs = 100000 + 180000 + 240000 - 25000;
+
+            CuePlan plan = PlanToCue(request);
+            ExpectValidPlan(request, plan);
+            ASSERT_EQ(plan.order, (std::vector<size_t>{ 0, 1 }));
+
+            // The cut is shared by every track instead of falling on the last one.
+            ASSERT_LT(plan.currentMs, 100000u);
+            ASSERT_LT(plan.durationsMs[0], 180000u);
+            ASSERT_LT(plan.durationsMs[1], 240000u);
+        }
+
+        TEST(CuePlannerTests, ReordersWhenThePrefixCannotLand) {
+            CuePlanRequest request;
+            request.current = Item(10000, 10000);
+            request.upcoming = { Item(300000, 290000), Item(120000, 115000), Item(240000, 235000), Item(60000, 55000) };
+            request.cueInMs = 10000 + 120000 + 60000;
+
+            // 300 s d'abord : aucun préfixe ne tombe sur 190 s
+            ASSERT_FALSE(PlanToCue(request).found);
+
+            request.reorder = true;
+            CuePlan plan = PlanToCue(request);
+            ExpectValidPlan(request, plan);
+            ASSERT_EQ(plan.order, (std::vector<size_t>{ 1, 3 }));
+
+            request.cueInMs = 10000 + 30000;
+            ASSERT_FALSE(PlanToCue(request).found);
+        }
+
+        TEST(CuePlannerTests, SkipsTracksOfUnknownLength) {
+            CuePlanRequest request;
+            request.current = Item(5000, 5000);
+            request.upcoming = { Item(0, 0), Item(90000, 80000) };
+            request.cueInMs = 5000 + 85000;
+            ASSERT_FALSE(PlanToCue(request).found);
+
+            request.reorder = true;
+            CuePlan plan = PlanToCue(request);
+            ExpectValidPlan(request, plan);
+            ASSERT_EQ(plan.order, (std::vector<size_t>{ 1 }));
+        }
+
+        TEST(CuePlannerTests, PlansAnHourOfShuffleQuickly) {
+            std::mt19937 rng(7);
+            std::uniform_int_distribution<uint32_t> length(120000, 420000);
+
+            CuePlanRequest request;
+            request.current = Item(150000, 120000);
+            request.reorder = true;
+            for (int i = 0; i < 64; i++) {
+                const uint32_t maxMs = length(rng);
+                request.upcoming.push_back(Item(maxMs, maxMs - 5000));
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            int found = 0;
+            for (uint32_t cueInMs = 3000000; cueInMs < 3600000; cueInMs += 6000) {
+                request.cueInMs = cueInMs;
+                CuePlan plan = PlanToCue(request);
+                if (plan.found) {
+                    ExpectValidPlan(request, plan);
+                    found++;
+                }
+            }
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+            // 100 re-plans of an hour ahead, each one well under a frame
+            ASSERT_EQ(found, 100);
+            ASSERT_LT(elapsed.count(), 1000);
+        }
+
+    }
+}
@@ -0,0 +1,276 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        // Les cues jouent sur une sortie sans son dont le test avance l'horloge à la main.
+        class CueStackTests : public ::testing::Test {
+        protected:
+            static constexpr float Tick = 1024.0f / 48000.0f;
+
+            void SetUp() override {
+                m_directory = std::filesystem::temp_directory_path() / "tsm_cue_tests";
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::create_directories(m_directory);
+
+                m_output = AddNoSoundOutput("test_cues");
+
+                ShowTimelineHost host;
+                host.getLevel = [this]() { return m_level; };
+                host.setLevel = [this](float level) { m_level = level; };
+                host.getVolume = [](ShowBus bus) { return bus == ShowBus::Sfx ? 0.8f : 0.5f; };
+                host.startPlaylist = [this](const std::string& name) { m_playlists.push_back(name); };
+
+                auto& cues = CueStack::GetInstance();
+                cues.SetHost(host);
+                cues.SetOutput(m_output);
+                cues.SetPreloadCount(2);
+            }
+
+            void TearDown() override {
+                auto& cues = CueStack::GetInstance();
+                cues.Disarm();
+                cues.SetHost(ShowTimelineHost{});
+                cues.SetOutput(FModWrapper::MainOutput);
+                cues.SetPreloadCount(3);
+                for (const std::string& id : m_sounds) {
+                    AudioManager::GetInstance().StopSound(id);
+                    AudioManager::GetInstance().UnloadSound(id);
+                }
+                if (FModWrapper::GetInstance().GetSystem(m_output)) FModWrapper::GetInstance().RemoveOutput(m_output);
+                std::filesystem::remove_all(m_directory);
+            }
+
+            std::string AddSound(const std::string& id, uint32_t frames, bool isStream = false) {
+                const std::string path = WriteSilentWav(m_directory / (id + ".wav"), 48000, frames);
+                AudioManager::GetInstance().RegisterDeferredSound(id, path, frames / 48, isStream);
+                m_sounds.push_back(id);
+                return path;
+            }
+
+            void Run(float seconds) {
+                FMOD::System* system = FModWrapper::GetInstance().GetSystem(m_output);
+                for (float t = 0.0f; t < seconds; t += Tick) {
+                    system->update();
+                    CueStack::GetInstance().Update(Tick);
+                }
+            }
+
+            static bool IsPaused(FMOD::Channel* channel) {
+                bool paused = false;
+                return channel && channel->getPaused(&paused) == FMOD_OK && paused;
+            }
+
+            static bool IsPlaying(FMOD::Channel* channel) {
+                bool playing = false;
+                return channel && channel->isPlaying(&playing) == FMOD_OK && playing;
+            }
+
+            std::filesystem::path m_directory;
+            OutputId m_output = FModWrapper::InvalidOutput;
+            std::vector<std::string> m_sounds;
+            float m_level = 1.0f;
+            std::vector<std::string> m_playlists;
+        };
+
+        TEST_F(CueStackTests, LoadsCuesAndKeepsTheStackOnErrors) {
+            auto& cues = CueStack::GetInstance();
+            ASSERT_TRUE(cues.LoadString(R"({
+                "name": "Act 1",
+                "cues": [
+                    { "number": 1, "type": "playlist", "name": "Preshow" },
+                    { "number": "2.5", "type": "play", "sound": "thunder", "start": 1.5, "bus": "music", "continue": true },
+                    { "type": "fade", "sound": "rain", "to": 0, "seconds": 5, "stop": true },
+                    { "type": "stop" }
+                ]
+            })", "test"));
+
+            const auto& list = cues.GetCues();
+            ASSERT_EQ(list.size(), 4u);
+            ASSERT_EQ(list[0].number, "1");
+            ASSERT_EQ(list[1].number, "2.5");
+            ASSERT_EQ(list[2].number, "3");
+            ASSERT_EQ(list[1].bus, ShowBus::Music);
+            ASSERT_FLOAT_EQ(list[1].startSeconds, 1.5f);
+            ASSERT_TRUE(list[1].autoContinue);
+            ASSERT_TRUE(list[2].stopAtEnd);
+            ASSERT_TRUE(list[3].target.empty());
+            ASSERT_EQ(cues.GetStandby(), 0u);
+
+            ASSERT_FALSE(cues.LoadString(R"({ "cues": [ { "type": "play" } ] })", "broken"));
+            ASSERT_FALSE(cues.LoadString(R"({ "cues": [ { "type": "blackout" } ] })", "broken"));
+            ASSERT_EQ(cues.GetName(), "Act 1");
+            ASSERT_FALSE(cues.SetStandby(4));
+        }
+
+        TEST_F(CueStackTests, GoStartsTheArmedChannelWithoutTheFile) {
+            ASSERT_NE(m_output, FModWrapper::InvalidOutput);
+            const std::string path = AddSound("test_cue_shot", 48000 * 2);
+
+            auto& cues = CueStack::GetInstance();
+            ASSERT_TRUE(cues.LoadString(R"({ "cues": [
+                { "type": "play", "sound": "test_cue_shot", "start": 0.5 } ] })", "test"));
+            Run(Tick);
+
+            // Canal en pause, déjà positionné au départ de la cue
+            FMOD::Channel* armed = cues.GetArmedChannel(0);
+            ASSERT_TRUE(cues.IsArmed(0));
+            ASSERT_TRUE(IsPaused(armed));
+            unsigned int positionMs = 0;
+            armed->getPosition(&positionMs, FMOD_TIMEUNIT_MS);
+            ASSERT_EQ(positionMs, 500u);
+            float volume = 0.0f;
+            armed->getVolume(&volume);
+            ASSERT_FLOAT_EQ(volume, 0.8f);
+
+            // Rien ne s'ouvre plus à la GO
+            std::filesystem::remove(path);
+            ASSERT_TRUE(cues.Go());
+            ASSERT_TRUE(IsPlaying(armed));
+            ASSERT_FALSE(IsPaused(armed));
+            ASSERT_EQ(cues.GetStandby(), 1u);
+            ASSERT_FALSE(cues.Go());
+
+            Run(3 * Tick);
+            ASSERT_EQ(cues.GetLatencies().size(), 1u);
+            const CueLatency& latency = cues.GetLatencies().back();
+            ASSERT_TRUE(latency.armed);
+            ASSERT_TRUE(latency.measured);
+            ASSERT_LE(latency.firstSampleMs, 1000.0 * Tick + 0.1);
+            ASSERT_GT(latency.outputBufferMs, 0.0);
+
+            // Une fois partie, la cue appartient à l'AudioManager
+            AudioManager::GetInstance().StopAllSounds();
+            ASSERT_FALSE(IsPlaying(armed));
+        }
+
+        TEST_F(CueStackTests, ArmsTheStandbyWindowOnly) {
+            ASSERT_NE(m_output, FModWrapper::InvalidOutput);
+            for (int i = 0; i < 5; i++) AddSound("test_cue_" + std::to_string(i), 48000);
+
+            auto& cues = CueStack::GetInstance();
+            ASSERT_TRUE(cues.LoadString(R"({ "cues": [
+                { "type": "play", "sound": "test_cue_0" },
+                { "type": "play", "sound": "test_cue_1", "continue": true },
+                { "type": "play", "sound": "test_cue_2", "continue": true },
+                { "type": "play", "sound": "test_cue_3" },
+                { "type": "play", "sound": "test_cue_4" } ] })", "test"));
+            Run(Tick);
+
+            // La fenêtre s'étend jusqu'au bout des cues enchaînées
+            ASSERT_TRUE(cues.IsArmed(0));
+            ASSERT_TRUE(cues.IsArmed(1));
+            ASSERT_TRUE(cues.IsArmed(2));
+            ASSERT_TRUE(cues.IsArmed(3));
+            ASSERT_FALSE(cues.IsArmed(4));
+
+            // Un arrêt général laisse les cues armées en place
+            AudioManager::GetInstance().StopAllSounds();
+            ASSERT_TRUE(cues.IsArmed(1));
+
+            FMOD::Channel* first = cues.GetArmedChannel(0);
+            ASSERT_TRUE(cues.SetStandby(3));
+            Run(Tick);
+            ASSERT_FALSE(IsPlaying(first));
+            ASSERT_FALSE(cues.IsArmed(0));
+            ASSERT_TRUE(cues.IsArmed(3));
+            ASSERT_TRUE(cues.IsArmed(4));
+
+            ASSERT_TRUE(cues.SetStandby(1));
+            Run(Tick);
+            FMOD::Channel* chained = cues.GetArmedChannel(3);
+            ASSERT_TRUE(cues.Go());
+            ASSERT_EQ(cues.GetStandby(), 4u);
+            ASSERT_EQ(cues.GetLatencies().size(), 3u);
+            for (const CueLatency& latency : cues.GetLatencies()) ASSERT_TRUE(latency.armed);
+            ASSERT_TRUE(IsPlaying(chained));
+        }
+
+        TEST_F(CueStackTests, FadesDucksAndSwitchesPlaylists) {
+            ASSERT_NE(m_output, FModWrapper::InvalidOutput);
+            AddSound("test_cue_bed", 48000 * 4);
+
+            auto& cues = CueStack::GetInstance();
+            ASSERT_TRUE(cues.LoadString(R"({ "cues": [
+                { "type": "play", "sound": "test_cue_bed", "continue": true },
+                { "type": "duck", "to": 0.25, "seconds": 0.5 },
+                { "type": "fade", "sound": "test_cue_bed", "to": 0, "seconds": 0.5, "stop": true },
+                { "type": "playlist", "name": "After" } ] })", "test"));
+            Run(Tick);
+
+            ASSERT_TRUE(cues.Go());
+            FMOD::Channel* bed = AudioManager::GetInstance().GetLastChannelOfSound("test_cue_bed");
+            ASSERT_TRUE(IsPlaying(bed));
+            Run(0.25f);
+            ASSERT_GT(m_level, 0.25f);
+            ASSERT_LT(m_level, 1.0f);
+            Run(0.3f);
+            ASSERT_FLOAT_EQ(m_level, 0.25f);
+
+            // Le fondu s'arrête sur l'horloge DSP, sans attendre la fin du son
+            ASSERT_TRUE(cues.Go());
+            Run(0.4f);
+            ASSERT_TRUE(IsPlaying(bed));
+            Run(0.2f);
+            ASSERT_FALSE(IsPlaying(bed));
+
+            ASSERT_TRUE(cues.Go());
+            ASSERT_EQ(m_playlists, std::vector<std::string>{ "After" });
+        }
+
+        TEST_F(CueStackTests, LeavesAPlayingStreamAloneUntilGo) {
+            ASSERT_NE(m_output, FModWrapper::InvalidOutput);
+            AddSound("test_cue_stream", 48000 * 2, true);
+            FMOD::Channel* playing = AudioManager::GetInstance().PlaySound("test_cue_stream", false, 1.0f, 1.0f, m_output);
+            ASSERT_TRUE(IsPlaying(playing));
+
+            auto& cues = CueStack::GetInstance();
+            ASSERT_TRUE(cues.LoadString(R"({ "cues": [
+                { "type": "play", "sound": "test_cue_stream", "loop": true } ] })", "test"));
+            Run(Tick);
+
+            // Armer le flux le couperait dès maintenant
+            ASSERT_FALSE(cues.IsArmed(0));
+            ASSERT_TRUE(IsPlaying(playing));
+
+            // La GO le reprend, en boucle sur son propre canal
+            ASSERT_TRUE(cues.Go());
+            FMOD::Channel* started = AudioManager::GetInstance().GetLastChannelOfSound("test_cue_stream");
+            ASSERT_TRUE(IsPlaying(started));
+            ASSERT_FALSE(IsPlaying(playing));
+
+            FMOD_MODE mode = 0;
+            ASSERT_EQ(started->getMode(&mode), FMOD_OK);
+            ASSERT_TRUE(mode & FMOD_LOOP_NORMAL);
+            FMOD::Sound* sound = nullptr;
+            started->getCurrentSound(&sound);
+            ASSERT_EQ(sound->getMode(&mode), FMOD_OK);
+            ASSERT_FALSE(mode & FMOD_LOOP_NORMAL);
+        }
+
+        TEST_F(CueStackTests, UnloadingASoundReleasesItsArmedCue) {
+            ASSERT_NE(m_output, FModWrapper::InvalidOutput);
+            const std::string path = AddSound("test_cue_unloaded", 48000);
+
+            auto& cues = CueStack::GetInstance();
+            ASSERT_TRUE(cues.LoadString(R"({ "cues": [
+                { "type": "play", "sound": "test_cue_unloaded" } ] })", "test"));
+            Run(Tick);
+            FMOD::Channel* armed = cues.GetArmedChannel(0);
+            ASSERT_TRUE(IsPaused(armed));
+
+            // Le canal en pause part avec le son, et la cue ne le garde pas
+            ASSERT_TRUE(AudioManager::GetInstance().UnloadSound("test_cue_unloaded"));
+            ASSERT_FALSE(IsPlaying(armed));
+            ASSERT_FALSE(cues.IsArmed(0));
+            ASSERT_EQ(cues.GetArmedChannel(0), nullptr);
+
+            // Le son revenu, la cue se réarme dessus
+            AudioManager::GetInstance().RegisterDeferredSound("test_cue_unloaded", path, 1000, false);
+            Run(Tick);
+            ASSERT_TRUE(cues.IsArmed(0));
+            ASSERT_TRUE(IsPaused(cues.GetArmedChannel(0)));
+        }
+
+    }
+}
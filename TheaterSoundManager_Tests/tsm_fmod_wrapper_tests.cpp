@@ -0,0 +1,117 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        // No-sound outputs stand in for the amplifiers, so these run on any machine.
+        class FModWrapperTests : public ::testing::Test {
+        protected:
+            void SetUp() override {
+                m_directory = std::filesystem::temp_directory_path() / "tsm_output_tests";
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::create_directories(m_directory);
+            }
+
+            void TearDown() override {
+                auto& fmod = FModWrapper::GetInstance();
+                for (OutputId output : m_outputs) {
+                    if (fmod.GetSystem(output)) fmod.RemoveOutput(output);
+                }
+                std::filesystem::remove_all(m_directory);
+            }
+
+            // Removed again in TearDown.
+            OutputId AddTrackedOutput(const std::string& name, const std::string& driver = "") {
+                OutputId output = AddNoSoundOutput(name, 16, driver);
+                m_outputs.push_back(output);
+                return output;
+            }
+
+            // A short ramp so the samples are not all zero.
+            static std::vector<int16_t> Ramp(uint32_t frames) {
+                std::vector<int16_t> samples(frames);
+                for (uint32_t i = 0; i < frames; i++) {
+                    samples[i] = static_cast<int16_t>((i % 200) * 100);
+                }
+                return samples;
+            }
+
+            std::filesystem::path m_directory;
+            std::vector<OutputId> m_outputs;
+        };
+
+        TEST_F(FModWrapperTests, OpensOutputsByDriverNameOrGuid) {
+            auto& fmod = FModWrapper::GetInstance();
+
+            const OutputId terrace = AddTrackedOutput("test_terrace");
+            ASSERT_NE(terrace, FModWrapper::InvalidOutput);
+            ASSERT_NE(terrace, FModWrapper::MainOutput);
+            ASSERT_NE(fmod.GetSystem(terrace), nullptr);
+            ASSERT_EQ(fmod.FindOutput("test_terrace"), terrace);
+            ASSERT_EQ(fmod.GetOutputName(terrace), "test_terrace");
+            ASSERT_EQ(AddTrackedOutput("test_terrace"), FModWrapper::InvalidOutput);
+            ASSERT_EQ(AddTrackedOutput("test_missing", "No Such Device"), FModWrapper::InvalidOutput);
+
+            std::vector<std::string> drivers = FModWrapper::GetDriverNames(fmod.GetSystem(terrace));
+            ASSERT_FALSE(drivers.empty());
+            const OutputId hall = AddTrackedOutput("test_hall", drivers[0]);
+            ASSERT_NE(hall, FModWrapper::InvalidOutput);
+            ASSERT_EQ(fmod.GetOutputDriver(hall), drivers[0]);
+
+            FMOD_GUID guid = {};
+            ASSERT_EQ(fmod.GetSystem(hall)->getDriverInfo(0, nullptr, 0, &guid, nullptr, nullptr, nullptr), FMOD_OK);
+            std::string guidText = FModWrapper::FormatGuid(guid);
+            std::transform(guidText.begin(), guidText.end(), guidText.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+            ASSERT_NE(AddTrackedOutput("test_lobby", guidText), FModWrapper::InvalidOutput);
+
+            fmod.Update();
+
+            ASSERT_FALSE(fmod.RemoveOutput(FModWrapper::MainOutput));
+            ASSERT_TRUE(fmod.RemoveOutput(hall));
+            ASSERT_EQ(fmod.GetSystem(hall), nullptr);
+            ASSERT_EQ(fmod.FindOutput("test_hall"), FModWrapper::InvalidOutput);
+            ASSERT_FALSE(fmod.RemoveOutput(hall));
+        }
+
+        TEST_F(FModWrapperTests, FormatsGuidsLikeWindows) {
+            FMOD_GUID guid = { 0x0A1B2C3D, 0x4E5F, 0x6071, { 0x82, 0x93, 0xA4, 0xB5, 0xC6, 0xD7, 0xE8, 0xF9 } };
+            ASSERT_EQ(FModWrapper::FormatGuid(guid), "{0A1B2C3D-4E5F-6071-8293-A4B5C6D7E8F9}");
+        }
+
+        TEST_F(FModWrapperTests, SamplesAreDecodedOnceForEveryOutput) {
+            const OutputId terrace = AddTrackedOutput("test_pcm_terrace");
+            const OutputId hall = AddTrackedOutput("test_pcm_hall");
+            ASSERT_NE(terrace, FModWrapper::InvalidOutput);
+            ASSERT_NE(hall, FModWrapper::InvalidOutput);
+
+            auto& audioManager = AudioManager::GetInstance();
+            const std::string id = "test_pcm_chime";
+            audioManager.RegisterDeferredSound(id, WriteWav(m_directory / "chime.wav", 22050, Ramp(11025)), 500, false);
+
+            FMOD::Channel* onTerrace = audioManager.PlaySound(id, false, 1.0f, 1.0f, terrace);
+            FMOD::Channel* inHall = audioManager.PlaySound(id, false, 1.0f, 1.0f, hall);
+            ASSERT_NE(onTerrace, nullptr);
+            ASSERT_NE(inHall, nullptr);
+
+            FMOD::Sound* terraceSound = nullptr;
+            FMOD::Sound* hallSound = nullptr;
+            onTerrace->getCurrentSound(&terraceSound);
+            inHall->getCurrentSound(&hallSound);
+            ASSERT_NE(terraceSound, hallSound);
+
+            unsigned int frames = 0;
+            ASSERT_EQ(hallSound->getLength(&frames, FMOD_TIMEUNIT_PCM), FMOD_OK);
+            ASSERT_EQ(frames, 11025u);
+
+            // Deux sons, un seul buffer décodé
+            ASSERT_EQ(PcmCache::GetInstance().GetBufferCount(), 1u);
+            ASSERT_EQ(PcmCache::GetInstance().GetBufferBytes(), 11025u * 2);
+
+            ASSERT_TRUE(FModWrapper::GetInstance().RemoveOutput(hall));
+            ASSERT_EQ(PcmCache::GetInstance().GetBufferCount(), 1u);
+            ASSERT_TRUE(audioManager.UnloadSound(id));
+            ASSERT_EQ(PcmCache::GetInstance().GetBufferCount(), 0u);
+        }
+
+    }
+}
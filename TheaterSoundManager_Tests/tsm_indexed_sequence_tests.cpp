@@ -0,0 +1,86 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        TEST(IndexedSequenceTests, MatchesVectorUnderRandomEdits) {
+            IndexedSequence<int> sequence;
+            std::vector<int> reference;
+            std::mt19937 rng(42);
+
+            for (int step = 0; step < 5000; step++) {
+                const size_t size = reference.size();
+                switch (rng() % 5) {
+                case 0:
+                    sequence.push_back(step);
+                    reference.push_back(step);
+                    break;
+                case 1: {
+                    size_t index = rng() % (size + 1);
+                    sequence.insert(index, step);
+                    reference.insert(reference.begin() + index, step);
+                    break;
+                }
+                case 2: {
+                    if (size == 0) break;
+                    size_t index = rng() % size;
+                    size_t count = std::min<size_t>(1 + rng() % 3, size - index);
+                    sequence.erase(index, count);
+                    reference.erase(reference.begin() + index, reference.begin() + index + count);
+                    break;
+                }
+                case 3: {
+                    if (size == 0) break;
+                    size_t from = rng() % size, to = rng() % size;
+                    sequence.move(from, to);
+                    int value = reference[from];
+                    reference.erase(reference.begin() + from);
+                    reference.insert(reference.begin() + to, value);
+                    break;
+                }
+                default: {
+                    size_t index = rng() % (size + 1);
+                    std::vector<int> values = { step, -step, step * 2 };
+                    sequence.insert(index, values.begin(), values.end());
+                    reference.insert(reference.begin() + index, values.begin(), values.end());
+                    break;
+                }
+                }
+
+                ASSERT_EQ(sequence.size(), reference.size());
+                if (!reference.empty()) {
+                    size_t probe = rng() % reference.size();
+                    ASSERT_EQ(sequence[probe], reference[probe]);
+                }
+            }
+
+            ASSERT_EQ(sequence, reference);
+            ASSERT_TRUE(std::equal(sequence.begin(), sequence.end(), reference.begin(), reference.end()));
+
+            sequence.clear();
+            ASSERT_TRUE(sequence.empty());
+        }
+
+        TEST(IndexedSequenceTests, EditsLargePlaylistWithoutShifting) {
+            IndexedSequence<std::string> tracks;
+            for (int i = 0; i < 100000; i++) {
+                tracks.push_back("track_" + std::to_string(i));
+            }
+
+            // Drag the first track to the end and back, one step at a time from the middle.
+            for (size_t i = 0; i < 20000; i++) {
+                tracks.move(0, tracks.size() - 1);
+            }
+            ASSERT_EQ(tracks.front(), "track_20000");
+            ASSERT_EQ(tracks.back(), "track_19999");
+
+            tracks.erase(50000, 1000);
+            ASSERT_EQ(tracks.size(), 99000u);
+            ASSERT_EQ(tracks[50000], "track_71000");
+
+            tracks.set(0, "renamed");
+            ASSERT_EQ(tracks.ToVector().front(), "renamed");
+        }
+
+    }
+}
@@ -0,0 +1,163 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        class LibrarySnapshotTests : public ::testing::Test {
+        protected:
+            void SetUp() override {
+                m_directory = std::filesystem::temp_directory_path() / "tsm_library_snapshot_tests";
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::create_directories(m_directory);
+                ClearPlaylists();
+            }
+
+            void TearDown() override {
+                PlaylistJournal::GetInstance().Close();
+                ClearPlaylists();
+                std::filesystem::remove_all(m_directory);
+            }
+
+            void ClearPlaylists() {
+                auto& manager = PlaylistManager::GetInstance();
+                for (const auto& name : manager.GetPlaylistNames()) {
+                    manager.DeletePlaylist(name);
+                }
+            }
+
+            std::string SnapshotPath() const {
+                return (m_directory / "library.snapshot").string();
+            }
+
+            std::filesystem::path m_directory;
+        };
+
+        TEST_F(LibrarySnapshotTests, RoundTripKeepsPlaylistsAndDurations) {
+            PlaylistOptions options;
+            options.randomOrder = true;
+            options.loopPlaylist = true;
+            options.segmentDuration = 120.0f;
+            options.crossfadeDuration = 4.0f;
+            options.crossfadeCurve = CrossfadeCurve::Custom;
+            options.crossfadeShape = 0.5f;
+
+            LibrarySnapshotWriter writer;
+            writer.SetSequence(42);
+            writer.AddTrack("track1", "music/track1.mp3", 185000);
+            writer.AddTrack("track2", "music/track2.mp3", 0);
+            writer.AddPlaylist("first", options, { "track1", "track2", "track1" });
+            writer.AddPlaylist("second", PlaylistOptions(), {});
+            ASSERT_TRUE(writer.WriteToFile(SnapshotPath()));
+
+            LibrarySnapshot snapshot;
+            ASSERT_TRUE(snapshot.Open(SnapshotPath()));
+            ASSERT_EQ(snapshot.GetSequence(), 42u);
+            ASSERT_EQ(snapshot.GetTrackCount(), 2u);
+            ASSERT_EQ(snapshot.GetPlaylistCount(), 2u);
+
+            ASSERT_EQ(snapshot.GetPlaylistName(0), "first");
+            auto tracks = snapshot.GetPlaylistTracks(0);
+            ASSERT_EQ(tracks.size(), 3u);
+            ASSERT_EQ(snapshot.GetTrackId(tracks[0]), "track1");
+            ASSERT_EQ(snapshot.GetTrackId(tracks[1]), "track2");
+            ASSERT_EQ(tracks[2], tracks[0]);
+            ASSERT_EQ(snapshot.GetTrackPath(tracks[0]), "music/track1.mp3");
+            ASSERT_EQ(snapshot.GetTrackLengthMs(tracks[0]), 185000u);
+
+            PlaylistOptions loaded = snapshot.GetPlaylistOptions(0);
+            ASSERT_TRUE(loaded.randomOrder);
+            ASSERT_FALSE(loaded.randomSegment);
+            ASSERT_TRUE(loaded.loopPlaylist);
+            ASSERT_FLOAT_EQ(loaded.segmentDuration, 120.0f);
+            ASSERT_FLOAT_EQ(loaded.crossfadeDuration, 4.0f);
+            ASSERT_EQ(loaded.crossfadeCurve, CrossfadeCurve::Custom);
+            ASSERT_FLOAT_EQ(loaded.crossfadeShape, 0.5f);
+
+            ASSERT_EQ(snapshot.GetPlaylistName(1), "second");
+            ASSERT_TRUE(snapshot.GetPlaylistTracks(1).empty());
+            ASSERT_EQ(snapshot.GetPlaylistOptions(1).crossfadeCurve, CrossfadeCurve::EqualPower);
+        }
+
+        TEST_F(LibrarySnapshotTests, RejectsTruncatedFile) {
+            LibrarySnapshotWriter writer;
+            writer.AddPlaylist("playlist", PlaylistOptions(), { "track1", "track2" });
+            ASSERT_TRUE(writer.WriteToFile(SnapshotPath()));
+
+            const auto size = std::filesystem::file_size(SnapshotPath());
+            std::filesystem::resize_file(SnapshotPath(), size - 4);
+
+            LibrarySnapshot snapshot;
+            ASSERT_FALSE(snapshot.Open(SnapshotPath()));
+            ASSERT_FALSE(snapshot.IsOpen());
+        }
+
+        // Cold start of 50k tracks spread over 500 playlists: JSON import versus the
+        // journal's mapped snapshot. Run with --gtest_also_run_disabled_tests.
+        TEST_F(LibrarySnapshotTests, DISABLED_ColdStartBenchmark) {
+            constexpr size_t PlaylistCount = 500;
+            constexpr size_t TracksPerPlaylist = 100;
+
+            auto& manager = PlaylistManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            auto& journal = PlaylistJournal::GetInstance();
+
+            auto trackId = [](size_t playlist, size_t track) {
+                return "bench_" + std::to_string(playlist) + "_" + std::to_string(track);
+            };
+            auto registerTracks = [&]() {
+                for (size_t p = 0; p < PlaylistCount; p++)
+                    for (size_t t = 0; t < TracksPerPlaylist; t++)
+                        audioManager.RegisterDeferredSound(trackId(p, t), "bench/" + trackId(p, t) + ".mp3", static_cast<unsigned int>(180000 + t));
+            };
+            auto unregisterTracks = [&]() {
+                for (size_t p = 0; p < PlaylistCount; p++)
+                    for (size_t t = 0; t < TracksPerPlaylist; t++)
+                        audioManager.UnloadSound(trackId(p, t));
+            };
+
+            registerTracks();
+            ASSERT_TRUE(journal.Open(m_directory.string()));
+            {
+                PlaylistManager::BatchScope batch;
+                for (size_t p = 0; p < PlaylistCount; p++) {
+                    std::vector<std::string> tracks;
+                    for (size_t t = 0; t < TracksPerPlaylist; t++)
+                        tracks.push_back(trackId(p, t));
+                    manager.CreatePlaylist("bench_playlist_" + std::to_string(p));
+                    manager.AddTracksToPlaylist("bench_playlist_" + std::to_string(p), tracks);
+                }
+            }
+            journal.Close();
+
+            const std::string jsonPath = (m_directory / "playlists.json").string();
+            ASSERT_TRUE(manager.SavePlaylistsToFile(jsonPath));
+            ClearPlaylists();
+
+            // Sounds stay registered here so the JSON path is measured without file I/O.
+            auto jsonStart = std::chrono::steady_clock::now();
+            ASSERT_TRUE(manager.LoadPlaylistsFromFile(jsonPath));
+            auto jsonElapsed = std::chrono::steady_clock::now() - jsonStart;
+            ASSERT_EQ(manager.GetPlaylistNames().size(), PlaylistCount);
+
+            ClearPlaylists();
+            unregisterTracks();
+
+            auto snapshotStart = std::chrono::steady_clock::now();
+            ASSERT_TRUE(journal.Open(m_directory.string()));
+            journal.ApplyRecoveredState();
+            auto snapshotElapsed = std::chrono::steady_clock::now() - snapshotStart;
+            ASSERT_EQ(manager.GetPlaylistNames().size(), PlaylistCount);
+            ASSERT_EQ(audioManager.GetSoundLengthMs(trackId(0, 5)), 180005u);
+
+            journal.Close();
+            ClearPlaylists();
+            unregisterTracks();
+
+            // Le snapshot réenregistre aussi les sons, et reste plus rapide que le JSON qui les trouve déjà là
+            ASSERT_LT(snapshotElapsed, jsonElapsed);
+            RecordProperty("jsonImportMs", static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(jsonElapsed).count()));
+            RecordProperty("snapshotMs", static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(snapshotElapsed).count()));
+        }
+
+    }
+}
@@ -0,0 +1,127 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        class LoopRendererTests : public ::testing::Test {
+        protected:
+            static constexpr int Rate = 8000;
+            static constexpr int Period = 80;   // 100 Hz
+
+            void SetUp() override {
+                m_directory = std::filesystem::temp_directory_path() / "tsm_loop_tests";
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::create_directories(m_directory);
+                m_previousCacheDirectory = LoopRenderer::GetInstance().GetCacheDirectory();
+                LoopRenderer::GetInstance().SetCacheDirectory((m_directory / "loops").string());
+
+                m_settings.crossfadeSec = 0.5f;
+                m_settings.searchSec = 1.0f;
+                m_settings.matchSec = 0.1f;
+            }
+
+            void TearDown() override {
+                LoopRenderer::GetInstance().SetCacheDirectory(m_previousCacheDirectory);
+                std::filesystem::remove_all(m_directory);
+            }
+
+            static std::vector<int16_t> Sine(int frames) {
+                std::vector<int16_t> samples(frames);
+                for (int i = 0; i < frames; i++) {
+                    samples[i] = static_cast<int16_t>(std::lround(16000.0 * std::sin(2.0 * 3.14159265358979 * i / Period)));
+                }
+                return samples;
+            }
+
+            static PcmBuffer ToBuffer(const std::vector<int16_t>& samples) {
+                PcmBuffer pcm;
+                pcm.format = FMOD_SOUND_FORMAT_PCM16;
+                pcm.channels = 1;
+                pcm.sampleRate = Rate;
+                pcm.data.resize(samples.size() * sizeof(int16_t));
+                std::memcpy(pcm.data.data(), samples.data(), pcm.data.size());
+                return pcm;
+            }
+
+            static const int16_t* Samples(const RenderedLoop& loop) {
+                return reinterpret_cast<const int16_t*>(loop.pcm->data.data());
+            }
+
+            std::filesystem::path m_directory;
+            std::string m_previousCacheDirectory;
+            LoopRenderSettings m_settings;
+        };
+
+        TEST_F(LoopRendererTests, ClosesTheLoopOnAWholeNumberOfPeriods) {
+            const PcmBuffer source = ToBuffer(Sine(Rate * 6));
+            RenderedLoop loop;
+            ASSERT_TRUE(LoopRenderer::RenderBuffer(source, 100, 200, m_settings, loop));
+
+            const size_t frames = loop.pcm->data.size() / 2;
+            ASSERT_EQ(frames, loop.sourceEnd - loop.sourceStart);
+            ASSERT_EQ(loop.sourceStart, 100u);
+            ASSERT_LE(loop.sourceEnd, static_cast<unsigned>(Rate * 6 - 200));
+            ASSERT_EQ(frames % Period, 0u);
+            ASSERT_GT(loop.correlation, 0.99f);
+
+            // La fin de boucle mène au début comme un échantillon suivant
+            const int16_t* samples = Samples(loop);
+            const std::vector<int16_t> sine = Sine(Period + 1);
+            ASSERT_NEAR(samples[frames - 1], sine[(100 + frames - 1) % Period], 2);
+            ASSERT_NEAR(samples[0], sine[100 % Period], 2);
+        }
+
+        TEST_F(LoopRendererTests, FindsTheShiftedWindow) {
+            std::mt19937 rng(7);
+            std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+            std::vector<float> region(4000);
+            for (float& sample : region) sample = noise(rng);
+            const std::vector<float> head(region.begin() + 1234, region.begin() + 1634);
+
+            float correlation = 0.0f;
+            ASSERT_EQ(LoopRenderer::FindBestMatch(head, region, 1, correlation), 1234u);
+            ASSERT_NEAR(correlation, 1.0f, 1e-4f);
+
+            // Avec décimation : recherche grossière, puis affinage à l'échantillon
+            std::vector<float> smooth(4000);
+            for (size_t i = 0; i < smooth.size(); i++) smooth[i] = std::sin(i * 0.01f) + 0.3f * std::sin(i * 0.037f);
+            const std::vector<float> smoothHead(smooth.begin() + 2001, smooth.begin() + 2401);
+            ASSERT_EQ(LoopRenderer::FindBestMatch(smoothHead, smooth, 4, correlation), 2001u);
+        }
+
+        TEST_F(LoopRendererTests, RefusesSourcesShorterThanTheCrossfade) {
+            const PcmBuffer source = ToBuffer(Sine(Rate / 2));
+            RenderedLoop loop;
+            ASSERT_FALSE(LoopRenderer::RenderBuffer(source, 0, 0, m_settings, loop));
+            ASSERT_EQ(loop.pcm, nullptr);
+        }
+
+        TEST_F(LoopRendererTests, SecondRenderComesFromTheCache) {
+            const std::string path = WriteWav(m_directory / "bed.wav", Rate, Sine(Rate * 4));
+
+            const OutputId output = AddNoSoundOutput("test_loop_render", 4);
+            ASSERT_NE(output, FModWrapper::InvalidOutput);
+            FMOD::System* system = FModWrapper::GetInstance().GetSystem(output);
+
+            auto& renderer = LoopRenderer::GetInstance();
+            RenderedLoop first;
+            ASSERT_TRUE(renderer.Render(system, path, 0, 0, m_settings, first));
+            ASSERT_FALSE(first.fromCache);
+            ASSERT_TRUE(std::filesystem::exists(renderer.GetCachePath(path, 0, 0, m_settings)));
+
+            RenderedLoop second;
+            ASSERT_TRUE(renderer.Render(system, path, 0, 0, m_settings, second));
+            ASSERT_TRUE(second.fromCache);
+            ASSERT_EQ(second.sourceEnd, first.sourceEnd);
+            ASSERT_EQ(second.pcm->data, first.pcm->data);
+
+            // D'autres réglages, un autre rendu
+            LoopRenderSettings longer = m_settings;
+            longer.crossfadeSec = 0.25f;
+            ASSERT_NE(renderer.GetCachePath(path, 0, 0, longer), renderer.GetCachePath(path, 0, 0, m_settings));
+
+            ASSERT_TRUE(FModWrapper::GetInstance().RemoveOutput(output));
+        }
+
+    }
+}
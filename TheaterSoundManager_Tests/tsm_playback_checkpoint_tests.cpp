@@ -0,0 +1,140 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        class PlaybackCheckpointTests : public ::testing::Test {
+        protected:
+            void SetUp() override {
+                m_directory = std::filesystem::temp_directory_path() / "tsm_checkpoint_tests";
+                std::filesystem::remove_all(m_directory);
+
+                auto& ui = UIManager::GetInstance();
+                m_masterVolume = ui.GetMasterVolume();
+                m_musicVolume = ui.GetMusicVolume();
+            }
+
+            void TearDown() override {
+                PlaybackCheckpoint::GetInstance().Close();
+                auto& ui = UIManager::GetInstance();
+                ui.SetMasterVolume(m_masterVolume);
+                ui.SetMusicVolume(m_musicVolume);
+                ui.SetDuckFactor(1.0f);
+                std::filesystem::remove_all(m_directory);
+            }
+
+            // Flips one byte of the slot's state, as a copy cut short by a crash would leave it.
+            void TearSlot(size_t slot) {
+                std::fstream file(PlaybackCheckpoint::GetInstance().GetPath(), std::ios::in | std::ios::out | std::ios::binary);
+                file.seekg(slot * PlaybackCheckpoint::SlotSize + sizeof(PlaybackCheckpoint::SlotHeader) + 8);
+                char byte = 0;
+                file.read(&byte, 1);
+                byte ^= 0x5A;
+                file.seekp(slot * PlaybackCheckpoint::SlotSize + sizeof(PlaybackCheckpoint::SlotHeader) + 8);
+                file.write(&byte, 1);
+            }
+
+            std::filesystem::path m_directory;
+            float m_masterVolume = 0.5f;
+            float m_musicVolume = 0.5f;
+        };
+
+        TEST_F(PlaybackCheckpointTests, Crc32MatchesTheStandardCheckValue) {
+            ASSERT_EQ(PlaybackCheckpoint::Crc32("123456789", 9), 0xCBF43926u);
+        }
+
+        TEST_F(PlaybackCheckpointTests, TornSlotFallsBackToThePreviousOne) {
+            auto& checkpoint = PlaybackCheckpoint::GetInstance();
+            auto& ui = UIManager::GetInstance();
+
+            ASSERT_TRUE(checkpoint.Open(m_directory.string()));
+            ASSERT_FALSE(checkpoint.HasRecoveredState());
+
+            ui.SetMasterVolume(0.7f);
+            ASSERT_TRUE(checkpoint.Write());
+            ui.SetMasterVolume(0.2f);
+            ASSERT_TRUE(checkpoint.Write());
+            checkpoint.Close();
+
+            // Séquences 1, 2 puis 3 pour la sortie propre, dans le slot 1
+            ASSERT_TRUE(checkpoint.Open(m_directory.string()));
+            ASSERT_EQ(checkpoint.GetSequence(), 3u);
+            ASSERT_TRUE(checkpoint.GetRecoveredState().flags & CheckpointState::CleanExit);
+            ASSERT_FLOAT_EQ(checkpoint.GetRecoveredState().masterVolume, 0.2f);
+            ui.SetMasterVolume(0.5f);
+            checkpoint.Close();
+
+            // La séquence 4 (slot 0) est déchirée : retour à la 3
+            TearSlot(0);
+            ASSERT_TRUE(checkpoint.Open(m_directory.string()));
+            ASSERT_EQ(checkpoint.GetSequence(), 3u);
+            ASSERT_FLOAT_EQ(checkpoint.GetRecoveredState().masterVolume, 0.2f);
+            checkpoint.Close();
+
+            // Both slots torn: nothing is recovered rather than garbage.
+            TearSlot(0);
+            TearSlot(1);
+            ASSERT_TRUE(checkpoint.Open(m_directory.string()));
+            ASSERT_FALSE(checkpoint.HasRecoveredState());
+        }
+
+        TEST_F(PlaybackCheckpointTests, InterruptedRunResumesPlayback) {
+            auto& checkpoint = PlaybackCheckpoint::GetInstance();
+            auto& manager = PlaylistManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            auto& ui = UIManager::GetInstance();
+
+            for (const std::string id : { "checkpoint_a", "checkpoint_b" }) {
+                audioManager.RegisterDeferredSound(id, id + ".mp3", 60000);
+            }
+            manager.CreatePlaylist("checkpoint_bed");
+            manager.AddTracksToPlaylist("checkpoint_bed", { "checkpoint_a", "checkpoint_b" });
+
+            const OutputId output = AddNoSoundOutput("checkpoint_output");
+            ASSERT_NE(output, FModWrapper::InvalidOutput);
+            const ZoneId zone = manager.CreateZone("checkpoint_zone");
+            ASSERT_TRUE(manager.SetZoneOutput(zone, output));
+
+            PlaylistOptions options;
+            options.loopPlaylist = true;
+            manager.Play("checkpoint_bed", options, zone);
+            manager.GetCurrentChannel(zone)->setPosition(48000, FMOD_TIMEUNIT_PCM);
+            manager.SetZoneVolume(zone, 0.6f);
+            ui.SetMasterVolume(0.7f);
+
+            ASSERT_TRUE(checkpoint.Open(m_directory.string()));
+            ASSERT_TRUE(checkpoint.Write());
+            const uint64_t crashSequence = checkpoint.GetSequence();
+
+            // Le processus "meurt" : la sortie propre qui suit est perdue
+            manager.Stop("checkpoint_bed");
+            manager.ClearResumePoint("checkpoint_bed");
+            manager.SetZoneVolume(zone, 1.0f);
+            ui.SetMasterVolume(0.1f);
+            checkpoint.Close();
+            TearSlot((crashSequence + 1) % 2);
+
+            ASSERT_TRUE(checkpoint.Open(m_directory.string()));
+            ASSERT_TRUE(checkpoint.HasRecoveredState());
+            ASSERT_FALSE(checkpoint.GetRecoveredState().flags & CheckpointState::CleanExit);
+            checkpoint.ApplyRecoveredState();
+
+            ASSERT_FLOAT_EQ(ui.GetMasterVolume(), 0.7f);
+            ASSERT_FLOAT_EQ(manager.GetZoneVolume(zone), 0.6f);
+            ASSERT_TRUE(manager.IsPlaylistPlaying("checkpoint_bed"));
+            ASSERT_EQ(manager.GetActivePlaylistHandle(zone), manager.GetPlaylistHandle("checkpoint_bed"));
+            ASSERT_EQ(manager.GetCurrentTrackName(zone), "checkpoint_a");
+            unsigned int position = 0;
+            manager.GetCurrentChannel(zone)->getPosition(&position, FMOD_TIMEUNIT_PCM);
+            ASSERT_EQ(position, 48000u);
+
+            checkpoint.Close();
+            manager.RemoveZone(zone);
+            FModWrapper::GetInstance().RemoveOutput(output);
+            for (const std::string id : { "checkpoint_a", "checkpoint_b" }) {
+                audioManager.UnloadSound(id);
+            }
+        }
+
+    }
+}
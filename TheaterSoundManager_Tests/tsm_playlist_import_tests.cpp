@@ -0,0 +1,162 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        class PlaylistImportTests : public ::testing::Test {
+        protected:
+            void SetUp() override {
+                m_directory = std::filesystem::temp_directory_path() / "tsm_import_tests";
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::create_directories(m_directory);
+                ClearPlaylists();
+
+                for (int i = 0; i < TrackCount; i++) {
+                    AudioManager::GetInstance().RegisterDeferredSound(TrackId(i), "music/" + TrackId(i) + ".mp3", 0);
+                }
+            }
+
+            void TearDown() override {
+                PlaylistImporter::GetInstance().Cancel();
+                PlaylistImporter::GetInstance().SetBatchSize(256);
+                ClearPlaylists();
+                for (int i = 0; i < TrackCount; i++) {
+                    AudioManager::GetInstance().UnloadSound(TrackId(i));
+                }
+                std::filesystem::remove_all(m_directory);
+            }
+
+            void ClearPlaylists() {
+                auto& manager = PlaylistManager::GetInstance();
+                for (const auto& name : manager.GetPlaylistNames()) {
+                    manager.DeletePlaylist(name);
+                }
+            }
+
+            static std::string TrackId(int index) {
+                return "import_track_" + std::to_string(index);
+            }
+
+            std::string WriteFile(const std::string& fileName, const std::string& content) {
+                std::string path = (m_directory / fileName).string();
+                std::ofstream file(path, std::ios::binary);
+                file << content;
+                return path;
+            }
+
+            static std::string TracksJson(int first, int count) {
+                std::string tracks = "[";
+                for (int i = first; i < first + count; i++) {
+                    if (i > first) tracks += ",";
+                    tracks += "{\"id\":\"" + TrackId(i) + "\"}";
+                }
+                return tracks + "]";
+            }
+
+            static constexpr int TrackCount = 40;
+            std::filesystem::path m_directory;
+        };
+
+        TEST_F(PlaylistImportTests, ImportsTracksListedBeforeNameAndOptions) {
+            auto& manager = PlaylistManager::GetInstance();
+            auto& importer = PlaylistImporter::GetInstance();
+            importer.SetBatchSize(8);
+
+            std::string path = WriteFile("single.json",
+                "{\"tracks\":" + TracksJson(0, 35) + ","
+                "\"name\":\"streamed\","
+                "\"options\":{\"randomOrder\":false,\"segmentDuration\":42}}");
+
+            ASSERT_TRUE(manager.ImportPlaylist(path));
+            ASSERT_EQ(manager.GetPlaylistTrackCount("streamed"), 35u);
+
+            const auto* playlist = manager.GetPlaylistByName("streamed");
+            ASSERT_NE(playlist, nullptr);
+            ASSERT_EQ(playlist->tracks.front(), TrackId(0));
+            ASSERT_EQ(playlist->tracks.back(), TrackId(34));
+            ASSERT_FALSE(playlist->options.randomOrder);
+            ASSERT_TRUE(playlist->options.loopPlaylist);
+            ASSERT_FLOAT_EQ(playlist->options.segmentDuration, 42.0f);
+        }
+
+        TEST_F(PlaylistImportTests, BackgroundLoadAppliesBatchesOnUpdate) {
+            auto& manager = PlaylistManager::GetInstance();
+            auto& importer = PlaylistImporter::GetInstance();
+            importer.SetBatchSize(4);
+
+            manager.CreatePlaylist("replaced_playlist");
+
+            std::string path = WriteFile("all.json",
+                "[{\"name\":\"first\",\"tracks\":" + TracksJson(0, 20) + "},"
+                " {\"name\":\"second\",\"options\":{\"loopPlaylist\":false},\"tracks\":" + TracksJson(20, 20) + "}]");
+
+            ASSERT_TRUE(importer.StartLoadAllPlaylists(path));
+            ASSERT_FALSE(importer.StartLoadAllPlaylists(path));
+
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (importer.IsRunning() && std::chrono::steady_clock::now() < deadline) {
+                importer.Update();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            ASSERT_FALSE(importer.IsRunning());
+            ASSERT_TRUE(importer.LastImportSucceeded());
+            ASSERT_EQ(manager.GetPlaylistNames(), (std::vector<std::string>{ "first", "second" }));
+            ASSERT_EQ(manager.GetPlaylistTrackCount("first"), 20u);
+            ASSERT_EQ(manager.GetPlaylistTrackCount("second"), 20u);
+            ASSERT_FALSE(manager.GetPlaylistByName("second")->options.loopPlaylist);
+        }
+
+        TEST_F(PlaylistImportTests, ReimportReconcilesPlayingPlaylist) {
+            auto& manager = PlaylistManager::GetInstance();
+
+            manager.CreatePlaylist("streamed");
+            std::vector<std::string> initial;
+            for (int i = 0; i < 10; i++) initial.push_back(TrackId(i));
+            manager.AddTracksToPlaylist("streamed", initial);
+
+            auto* playlist = manager.GetPlaylistByName("streamed");
+            playlist->isPlaying = true;
+            playlist->currentIndex = 6;
+
+            std::vector<PlaylistChangeEvent> received;
+            auto token = manager.RegisterPlaylistChangeCallback(
+                [&](const std::vector<PlaylistChangeEvent>& events) {
+                    received.insert(received.end(), events.begin(), events.end());
+                });
+
+            std::string path = WriteFile("resync.json",
+                "{\"name\":\"streamed\",\"tracks\":" + TracksJson(2, 10) + "}");
+            ASSERT_TRUE(manager.ImportPlaylist(path));
+            manager.UnregisterPlaylistChangeCallback(token);
+
+            ASSERT_EQ(playlist->tracks.size(), 10u);
+            ASSERT_EQ(playlist->tracks.front(), TrackId(2));
+            ASSERT_EQ(playlist->tracks.back(), TrackId(11));
+            ASSERT_TRUE(playlist->isPlaying);
+            ASSERT_EQ(playlist->tracks[playlist->currentIndex], TrackId(6));
+
+            // Only the two dropped tracks and the two new ones show up as changes.
+            size_t removed = 0, inserted = 0;
+            for (const auto& event : received) {
+                if (event.type == PlaylistChangeType::TracksRemoved) removed += event.tracks.size();
+                if (event.type == PlaylistChangeType::TracksInserted) inserted += event.tracks.size();
+            }
+            ASSERT_EQ(removed, 2u);
+            ASSERT_EQ(inserted, 2u);
+
+            playlist->isPlaying = false;
+        }
+
+        TEST_F(PlaylistImportTests, RejectsUnexpectedLayout) {
+            auto& manager = PlaylistManager::GetInstance();
+
+            std::string path = WriteFile("array.json", "[{\"name\":\"not_single\",\"tracks\":[]}]");
+
+            ASSERT_FALSE(manager.ImportPlaylist(path));
+            ASSERT_TRUE(manager.GetPlaylistNames().empty());
+            ASSERT_FALSE(manager.ImportPlaylist((m_directory / "missing.json").string()));
+        }
+
+    }
+}
@@ -0,0 +1,128 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        class PlaylistJournalTests : public ::testing::Test {
+        protected:
+            void SetUp() override {
+                m_directory = std::filesystem::temp_directory_path() / "tsm_journal_tests";
+                m_crashDirectory = std::filesystem::temp_directory_path() / "tsm_journal_tests_crash";
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::remove_all(m_crashDirectory);
+                ClearPlaylists();
+            }
+
+            void TearDown() override {
+                PlaylistJournal::GetInstance().Close();
+                ClearPlaylists();
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::remove_all(m_crashDirectory);
+            }
+
+            void ClearPlaylists() {
+                auto& manager = PlaylistManager::GetInstance();
+                for (const auto& name : manager.GetPlaylistNames()) {
+                    manager.DeletePlaylist(name);
+                }
+            }
+
+            std::filesystem::path m_directory;
+            std::filesystem::path m_crashDirectory;
+        };
+
+        TEST_F(PlaylistJournalTests, ReplaysJournalAfterCrash) {
+            auto& journal = PlaylistJournal::GetInstance();
+            auto& manager = PlaylistManager::GetInstance();
+
+            ASSERT_TRUE(journal.Open(m_directory.string()));
+            ASSERT_FALSE(journal.HasRecoveredState());
+
+            manager.CreatePlaylist("journal_playlist");
+            manager.AddTracksToPlaylist("journal_playlist", { "track1", "track2", "track3" });
+            manager.MoveTrackToPosition("journal_playlist", 2, 0);
+            manager.RemoveFromPlaylist("journal_playlist", "track2");
+            manager.RenamePlaylist("journal_playlist", "renamed_playlist");
+            journal.Flush();
+
+            // Copy the files as they are on disk right now, as if the process died here,
+            // and simulate a record torn by the crash.
+            std::filesystem::copy(m_directory, m_crashDirectory);
+            {
+                std::ofstream torn((m_crashDirectory / "playlists.journal").string(), std::ios::app | std::ios::binary);
+                torn << "{\"op\":\"insert\",\"name\":\"renamed_pla";
+            }
+
+            journal.Close();
+            ClearPlaylists();
+
+            ASSERT_TRUE(journal.Open(m_crashDirectory.string()));
+            ASSERT_TRUE(journal.HasRecoveredState());
+
+            const auto& recovered = journal.GetRecoveredPlaylists();
+            ASSERT_EQ(recovered.size(), 1u);
+            ASSERT_EQ(recovered[0].name, "renamed_playlist");
+            ASSERT_EQ(recovered[0].tracks.size(), 2u);
+            ASSERT_EQ(recovered[0].tracks[0], "track3");
+            ASSERT_EQ(recovered[0].tracks[1], "track1");
+        }
+
+        TEST_F(PlaylistJournalTests, CompactionKeepsState) {
+            auto& journal = PlaylistJournal::GetInstance();
+            auto& manager = PlaylistManager::GetInstance();
+
+            ASSERT_TRUE(journal.Open(m_directory.string()));
+            journal.SetCompactionThreshold(4);
+
+            manager.CreatePlaylist("compacted_playlist");
+            for (int i = 0; i < 10; i++) {
+                manager.AddToPlaylist("compacted_playlist", "track" + std::to_string(i));
+            }
+            journal.Flush();
+            journal.Close();
+            journal.SetCompactionThreshold(1000);
+            ClearPlaylists();
+
+            ASSERT_TRUE(journal.Open(m_directory.string()));
+            const auto& recovered = journal.GetRecoveredPlaylists();
+            ASSERT_EQ(recovered.size(), 1u);
+            ASSERT_EQ(recovered[0].tracks.size(), 10u);
+            ASSERT_EQ(recovered[0].tracks[9], "track9");
+        }
+
+        TEST_F(PlaylistJournalTests, UndoIsJournaledPerPlaylist) {
+            auto& journal = PlaylistJournal::GetInstance();
+            auto& manager = PlaylistManager::GetInstance();
+
+            ASSERT_TRUE(journal.Open(m_directory.string()));
+            manager.CreatePlaylist("undo_first");
+            manager.AddTracksToPlaylist("undo_first", { "track1" });
+            manager.CreatePlaylist("undo_second");
+            manager.AddTracksToPlaylist("undo_second", { "track2", "track3" });
+            manager.DeletePlaylist("undo_first");
+            manager.RemoveFromPlaylist("undo_second", "track2");
+            ASSERT_TRUE(manager.Undo());
+            ASSERT_TRUE(manager.Undo());
+            journal.Flush();
+
+            // Pas de réécriture de toute la bibliothèque : un enregistrement par playlist changée
+            std::ifstream file((m_directory / "playlists.journal").string());
+            const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            ASSERT_EQ(contents.find("\"reset\""), std::string::npos);
+            ASSERT_NE(contents.find("\"replace\""), std::string::npos);
+
+            journal.Close();
+            ClearPlaylists();
+
+            ASSERT_TRUE(journal.Open(m_directory.string()));
+            const auto& recovered = journal.GetRecoveredPlaylists();
+            ASSERT_EQ(recovered.size(), 2u);
+            ASSERT_EQ(recovered[0].name, "undo_first");
+            ASSERT_EQ(recovered[0].tracks.size(), 1u);
+            ASSERT_EQ(recovered[1].name, "undo_second");
+            ASSERT_EQ(recovered[1].tracks.size(), 2u);
+            ASSERT_EQ(recovered[1].tracks[0], "track2");
+        }
+
+    }
+}
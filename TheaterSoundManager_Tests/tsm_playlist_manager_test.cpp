@@ -13,6 +13,8 @@ namespace TSM {
                 for (const auto& name : manager.GetPlaylistNames()) {
                     manager.DeletePlaylist(name);
                 }
+                manager.SetHistoryLimit(100);
+                manager.ClearHistory();
             }
 
             void TearDown() override {
@@ -23,6 +25,45 @@ namespace TSM {
                 }
             }
 
+            // Replays change events on a copy, as a listener mirroring the playlist would.
+            static void ApplyEvents(std::vector<std::string>& tracks, const std::vector<PlaylistChangeEvent>& events) {
+                for (const auto& event : events) {
+                    if (event.type == PlaylistChangeType::TracksInserted) {
+                        tracks.insert(tracks.begin() + event.index, event.tracks.begin(), event.tracks.end());
+                    }
+                    else if (event.type == PlaylistChangeType::TracksRemoved) {
+                        tracks.erase(tracks.begin() + event.index, tracks.begin() + event.index + event.tracks.size());
+                    }
+                    else if (event.type == PlaylistChangeType::TrackMoved) {
+                        std::string track = tracks[event.fromIndex];
+                        tracks.erase(tracks.begin() + event.fromIndex);
+                        tracks.insert(tracks.begin() + event.toIndex, track);
+                    }
+                }
+            }
+
+            // Zone playing through a no-sound output: its channels exist without a device.
+            ZoneId CreateSilentZone(const std::string& name, OutputId& output) {
+                output = AddNoSoundOutput(name + "_output");
+                auto& manager = PlaylistManager::GetInstance();
+                const ZoneId zone = manager.CreateZone(name);
+                if (output == FModWrapper::InvalidOutput || !manager.SetZoneOutput(zone, output)) return PlaylistManager::InvalidZone;
+                return zone;
+            }
+
+            // Non fatal : la sortie est libérée même si la zone refuse de partir
+            void RemoveSilentZone(ZoneId zone, OutputId output) {
+                EXPECT_TRUE(PlaylistManager::GetInstance().RemoveZone(zone));
+                FModWrapper::GetInstance().RemoveOutput(output);
+            }
+
+            // Silent track in the test directory, short enough to play out in a few hundred mixer updates.
+            static std::string WriteTrack(const std::string& fileName, uint32_t sampleRate, uint32_t frames) {
+                const auto directory = std::filesystem::temp_directory_path() / "tsm_playlist_tests";
+                std::filesystem::create_directories(directory);
+                return WriteSilentWav(directory / fileName, sampleRate, frames);
+            }
+
             std::string m_playlistName;
         };
 
@@ -69,6 +110,166 @@ namespace TSM {
             ASSERT_NE(std::find(playlists.begin(), playlists.end(), duplicateName), playlists.end());
         }
 
+        TEST_F(PlaylistManagerTests, HandleSurvivesRenameAndInvalidatesOnDelete) {
+            auto& manager = PlaylistManager::GetInstance();
+            std::string newName = "renamed_playlist";
+
+            manager.CreatePlaylist(m_playlistName);
+            PlaylistHandle handle = manager.GetPlaylistHandle(m_playlistName);
+            ASSERT_TRUE(manager.IsValidHandle(handle));
+
+            manager.RenamePlaylist(m_playlistName, newName);
+            ASSERT_TRUE(manager.IsValidHandle(handle));
+            ASSERT_EQ(manager.GetPlaylistHandle(newName), handle);
+            ASSERT_FALSE(manager.GetPlaylistHandle(m_playlistName).IsValid());
+
+            manager.DeletePlaylist(newName);
+            ASSERT_FALSE(manager.IsValidHandle(handle));
+
+            // The freed slot is reused with a new generation.
+            manager.CreatePlaylist(m_playlistName);
+            PlaylistHandle reused = manager.GetPlaylistHandle(m_playlistName);
+            ASSERT_TRUE(manager.IsValidHandle(reused));
+            ASSERT_NE(reused, handle);
+            ASSERT_FALSE(manager.IsValidHandle(handle));
+        }
+
+        TEST_F(PlaylistManagerTests, BatchFiresSingleNotification) {
+            auto& manager = PlaylistManager::GetInstance();
+
+            manager.CreatePlaylist(m_playlistName);
+
+            int notifications = 0;
+            std::vector<PlaylistChangeEvent> received;
+            auto token = manager.RegisterPlaylistChangeCallback(
+                [&](const std::vector<PlaylistChangeEvent>& events) {
+                    notifications++;
+                    received = events;
+                });
+
+            {
+                PlaylistManager::BatchScope batch;
+                manager.AddToPlaylist(m_playlistName, "track1");
+                manager.AddTracksToPlaylist(m_playlistName, { "track2", "track3", "track4" });
+                manager.RemoveFromPlaylist(m_playlistName, "track1");
+                ASSERT_EQ(notifications, 0);
+            }
+
+            manager.UnregisterPlaylistChangeCallback(token);
+
+            ASSERT_EQ(notifications, 1);
+            ASSERT_EQ(manager.GetPlaylistTrackCount(m_playlistName), 3u);
+
+            // The two appends coalesce into one insert event, followed by the removal.
+            ASSERT_EQ(received.size(), 2u);
+            ASSERT_EQ(received[0].type, PlaylistChangeType::TracksInserted);
+            ASSERT_EQ(received[0].index, 0u);
+            ASSERT_EQ(received[0].tracks.size(), 4u);
+            ASSERT_EQ(received[1].type, PlaylistChangeType::TracksRemoved);
+            ASSERT_EQ(received[1].index, 0u);
+            ASSERT_EQ(received[1].tracks[0], "track1");
+
+            manager.AddToPlaylist(m_playlistName, "track5");
+            ASSERT_EQ(notifications, 1);
+        }
+
+        TEST_F(PlaylistManagerTests, ReconcileKeepsPlayingEntryAndEmitsReplayableEdits) {
+            auto& manager = PlaylistManager::GetInstance();
+
+            manager.CreatePlaylist(m_playlistName);
+            manager.AddTracksToPlaylist(m_playlistName, { "a", "b", "c", "d", "e", "a" });
+
+            auto* playlist = manager.GetPlaylistByName(m_playlistName);
+            playlist->isPlaying = true;
+            playlist->currentIndex = 3;
+
+            std::vector<PlaylistChangeEvent> received;
+            auto token = manager.RegisterPlaylistChangeCallback(
+                [&](const std::vector<PlaylistChangeEvent>& events) { received = events; });
+
+            const std::vector<std::string> target = { "a", "b", "c", "new", "e", "d", "a" };
+            ASSERT_TRUE(manager.ReconcilePlaylist(m_playlistName, target));
+            manager.UnregisterPlaylistChangeCallback(token);
+
+            ASSERT_EQ(playlist->tracks, target);
+            ASSERT_EQ(playlist->currentIndex, 5);
+            ASSERT_TRUE(playlist->isPlaying);
+
+            // Everything but "d" keeps its relative order: one move, one insert.
+            std::vector<std::string> mirror = { "a", "b", "c", "d", "e", "a" };
+            ApplyEvents(mirror, received);
+            ASSERT_EQ(mirror, target);
+            ASSERT_EQ(std::count_if(received.begin(), received.end(),
+                [](const PlaylistChangeEvent& e) { return e.type == PlaylistChangeType::TrackMoved; }), 1);
+            ASSERT_EQ(std::count_if(received.begin(), received.end(),
+                [](const PlaylistChangeEvent& e) { return e.type == PlaylistChangeType::TracksInserted; }), 1);
+
+            // Random lists over a small alphabet exercise duplicates, reversals and empty results.
+            std::mt19937 rng(1234);
+            for (int round = 0; round < 200; round++) {
+                std::vector<std::string> before(rng() % 12), after(rng() % 12);
+                for (auto& track : before) track = std::string(1, char('a' + rng() % 5));
+                for (auto& track : after) track = std::string(1, char('a' + rng() % 5));
+
+                manager.ClearPlaylist(m_playlistName);
+                manager.AddTracksToPlaylist(m_playlistName, before);
+
+                received.clear();
+                token = manager.RegisterPlaylistChangeCallback(
+                    [&](const std::vector<PlaylistChangeEvent>& events) { received = events; });
+                manager.ReconcilePlaylist(m_playlistName, after);
+                manager.UnregisterPlaylistChangeCallback(token);
+
+                ASSERT_EQ(playlist->tracks, after);
+                ApplyEvents(before, received);
+                ASSERT_EQ(before, after) << "round " << round;
+            }
+        }
+
+        TEST_F(PlaylistManagerTests, ReconcileMovesOnWhenThePlayingTrackIsRemoved) {
+            auto& manager = PlaylistManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            const std::vector<std::string> sounds = { "reconcile_a", "reconcile_b", "reconcile_c" };
+            for (const auto& id : sounds) {
+                audioManager.RegisterDeferredSound(id, WriteTrack(id + ".wav", 8000, 80000), 10000, false);
+            }
+            manager.CreatePlaylist("reconcile_bed");
+            manager.AddTracksToPlaylist("reconcile_bed", sounds);
+
+            OutputId output = FModWrapper::InvalidOutput;
+            const ZoneId zone = CreateSilentZone("reconcile_zone", output);
+            ASSERT_NE(zone, PlaylistManager::InvalidZone);
+
+            manager.Play("reconcile_bed", PlaylistOptions(), zone);
+            FMOD::Channel* removed = manager.GetCurrentChannel(zone);
+            ASSERT_NE(removed, nullptr);
+
+            // Le morceau suivant, au début de la nouvelle liste, prend la main
+            ASSERT_TRUE(manager.ReconcilePlaylist("reconcile_bed", { "reconcile_b", "reconcile_c" }));
+            ASSERT_TRUE(manager.IsPlaylistPlaying("reconcile_bed"));
+            ASSERT_EQ(manager.GetCurrentTrackName(zone), "reconcile_b");
+            FMOD::Channel* following = manager.GetCurrentChannel(zone);
+            ASSERT_NE(following, nullptr);
+            ASSERT_NE(following, removed);
+
+            for (int i = 0; i < 150; i++) {
+                FModWrapper::GetInstance().Update();
+            }
+            bool isPlaying = true;
+            ASSERT_FALSE(removed->isPlaying(&isPlaying) == FMOD_OK && isPlaying);
+            ASSERT_EQ(following->isPlaying(&isPlaying), FMOD_OK);
+            ASSERT_TRUE(isPlaying);
+
+            // Plus rien après le morceau retiré : la playlist s'arrête
+            ASSERT_TRUE(manager.ReconcilePlaylist("reconcile_bed", { "reconcile_a" }));
+            ASSERT_FALSE(manager.IsPlaylistPlaying("reconcile_bed"));
+
+            RemoveSilentZone(zone, output);
+            for (const auto& id : sounds) {
+                audioManager.UnloadSound(id);
+            }
+        }
+
         TEST_F(PlaylistManagerTests, MoveTrackToPosition) {
             auto& manager = PlaylistManager::GetInstance();
 
@@ -80,7 +281,7 @@ namespace TSM {
 
             auto* playlist = manager.GetPlaylistByName(m_playlistName);
             ASSERT_NE(playlist, nullptr);
-            ASSERT_EQ(playlist->tracks.size(), 3);
+            ASSERT_EQ(playlist->tracks.size(), 3u);
             ASSERT_EQ(playlist->tracks[0], "track1");
             ASSERT_EQ(playlist->tracks[1], "track2");
             ASSERT_EQ(playlist->tracks[2], "track3");
@@ -92,5 +293,610 @@ namespace TSM {
             ASSERT_EQ(playlist->tracks[2], "track1");
         }
 
+        TEST_F(PlaylistManagerTests, UndoRedoRestoresEachStep) {
+            auto& manager = PlaylistManager::GetInstance();
+            ASSERT_FALSE(manager.CanUndo());
+
+            manager.CreatePlaylist(m_playlistName);
+            manager.AddTracksToPlaylist(m_playlistName, { "a", "b", "c" });
+            {
+                PlaylistManager::BatchScope batch;
+                manager.RemoveFromPlaylistAtIndex(m_playlistName, 0);
+                manager.AddToPlaylist(m_playlistName, "d");
+            }
+            manager.CreatePlaylist("other");
+
+            ASSERT_TRUE(manager.Undo());
+            ASSERT_EQ(manager.GetPlaylistByName("other"), nullptr);
+            ASSERT_EQ(manager.GetPlaylistByName(m_playlistName)->tracks, (std::vector<std::string>{ "b", "c", "d" }));
+
+            // Le batch est annulé en une seule étape
+            ASSERT_TRUE(manager.Undo());
+            ASSERT_EQ(manager.GetPlaylistByName(m_playlistName)->tracks, (std::vector<std::string>{ "a", "b", "c" }));
+
+            ASSERT_TRUE(manager.Undo());
+            ASSERT_TRUE(manager.Undo());
+            ASSERT_TRUE(manager.GetPlaylistNames().empty());
+            ASSERT_FALSE(manager.Undo());
+
+            ASSERT_TRUE(manager.Redo());
+            ASSERT_TRUE(manager.Redo());
+            ASSERT_TRUE(manager.Redo());
+            ASSERT_EQ(manager.GetPlaylistByName(m_playlistName)->tracks, (std::vector<std::string>{ "b", "c", "d" }));
+
+            manager.ClearPlaylist(m_playlistName);
+            ASSERT_FALSE(manager.CanRedo());
+            ASSERT_TRUE(manager.Undo());
+            ASSERT_EQ(manager.GetPlaylistByName(m_playlistName)->tracks, (std::vector<std::string>{ "b", "c", "d" }));
+
+            manager.DeletePlaylist(m_playlistName);
+            ASSERT_TRUE(manager.Undo());
+            ASSERT_EQ(manager.GetPlaylistNames(), (std::vector<std::string>{ m_playlistName }));
+            ASSERT_EQ(manager.GetPlaylistByName(m_playlistName)->tracks, (std::vector<std::string>{ "b", "c", "d" }));
+        }
+
+        TEST_F(PlaylistManagerTests, CopiesShareTracksUntilEdited) {
+            auto& manager = PlaylistManager::GetInstance();
+            std::vector<std::string> tracks;
+            for (int i = 0; i < 1000; i++) {
+                tracks.push_back("track" + std::to_string(i));
+            }
+            manager.CreatePlaylist(m_playlistName);
+            manager.AddTracksToPlaylist(m_playlistName, tracks);
+            manager.DuplicatePlaylist(m_playlistName, "copy");
+
+            const auto* source = manager.GetPlaylistByName(m_playlistName);
+            const auto* copy = manager.GetPlaylistByName("copy");
+            ASSERT_TRUE(copy->tracks.SharesStorageWith(source->tracks));
+
+            const LibraryVersion& committed = manager.GetLibraryVersion();
+            ASSERT_EQ(committed.size(), 2u);
+            ASSERT_TRUE(committed[0].tracks.SharesStorageWith(source->tracks));
+            const LibraryVersion before = committed;
+
+            manager.MoveTrackUp("copy", 500);
+            ASSERT_FALSE(copy->tracks.SharesStorageWith(source->tracks));
+
+            // Seule l'entrée de la playlist modifiée est remplacée ; la version précédente ne bouge pas
+            const LibraryVersion& after = manager.GetLibraryVersion();
+            ASSERT_EQ(after.size(), 2u);
+            ASSERT_TRUE(after[0].tracks.SharesStorageWith(source->tracks));
+            ASSERT_TRUE(after[1].tracks.SharesStorageWith(copy->tracks));
+            ASSERT_TRUE(before[1].tracks.SharesStorageWith(source->tracks));
+            ASSERT_EQ(source->tracks, tracks);
+            ASSERT_EQ(copy->tracks[499], "track500");
+            ASSERT_EQ(copy->tracks[500], "track499");
+        }
+
+        TEST_F(PlaylistManagerTests, HistoryLimitDropsOldestSteps) {
+            auto& manager = PlaylistManager::GetInstance();
+            manager.SetHistoryLimit(3);
+            manager.CreatePlaylist(m_playlistName);
+            for (int i = 0; i < 5; i++) {
+                manager.AddToPlaylist(m_playlistName, "track" + std::to_string(i));
+            }
+
+            int steps = 0;
+            while (manager.Undo()) {
+                steps++;
+            }
+            ASSERT_EQ(steps, 3);
+            ASSERT_EQ(manager.GetPlaylistByName(m_playlistName)->tracks, (std::vector<std::string>{ "track0", "track1" }));
+        }
+
+        TEST_F(PlaylistManagerTests, UndoNotifiesOnlyTheChangedPlaylists) {
+            auto& manager = PlaylistManager::GetInstance();
+            manager.CreatePlaylist("first");
+            manager.CreatePlaylist("second");
+            manager.AddTracksToPlaylist("second", { "a", "b" });
+            manager.DeletePlaylist("first");
+            manager.AddToPlaylist("second", "c");
+
+            std::vector<PlaylistChangeEvent> received;
+            auto token = manager.RegisterPlaylistChangeCallback(
+                [&](const std::vector<PlaylistChangeEvent>& events) { received = events; });
+
+            ASSERT_TRUE(manager.Undo());
+            ASSERT_EQ(received.size(), 1u);
+            ASSERT_EQ(received[0].type, PlaylistChangeType::TracksReplaced);
+            ASSERT_EQ(received[0].playlistName, "second");
+            ASSERT_EQ(received[0].tracks, (std::vector<TrackId>{ "a", "b" }));
+
+            // La playlist supprimée revient à sa place, sans toucher à l'autre
+            ASSERT_TRUE(manager.Undo());
+            ASSERT_EQ(received.size(), 1u);
+            ASSERT_EQ(received[0].type, PlaylistChangeType::Created);
+            ASSERT_EQ(received[0].playlistName, "first");
+            ASSERT_EQ(received[0].index, 0u);
+            ASSERT_EQ(manager.GetPlaylistNames(), (std::vector<std::string>{ "first", "second" }));
+
+            manager.SetPlaylistOptions("second", PlaylistOptions());
+            ASSERT_TRUE(manager.Undo());
+            ASSERT_EQ(received.size(), 1u);
+            ASSERT_EQ(received[0].type, PlaylistChangeType::OptionsChanged);
+            ASSERT_EQ(received[0].playlistName, "second");
+
+            manager.UnregisterPlaylistChangeCallback(token);
+        }
+
+        TEST_F(PlaylistManagerTests, ZonesPlayTheirOwnPlaylist) {
+            auto& manager = PlaylistManager::GetInstance();
+            for (const std::string name : { "zone_lobby", "zone_terrace" }) {
+                manager.CreatePlaylist(name);
+                manager.AddTracksToPlaylist(name, { name + "_a", name + "_b" });
+            }
+
+            const ZoneId lobby = manager.CreateZone("lobby");
+            const ZoneId terrace = manager.CreateZone("terrace");
+            ASSERT_NE(lobby, PlaylistManager::MainZone);
+            ASSERT_NE(lobby, terrace);
+            ASSERT_EQ(manager.CreateZone("lobby"), lobby);
+            ASSERT_EQ(manager.FindZone("terrace"), terrace);
+            ASSERT_EQ(manager.FindZone("main"), PlaylistManager::MainZone);
+
+            manager.Play("zone_lobby", PlaylistOptions(), lobby);
+            manager.Play("zone_terrace", PlaylistOptions(), terrace);
+            ASSERT_TRUE(manager.IsPlaylistPlaying("zone_lobby"));
+            ASSERT_TRUE(manager.IsPlaylistPlaying("zone_terrace"));
+            ASSERT_EQ(manager.GetActivePlaylistHandle(lobby), manager.GetPlaylistHandle("zone_lobby"));
+            ASSERT_EQ(manager.GetActivePlaylistHandle(terrace), manager.GetPlaylistHandle("zone_terrace"));
+            ASSERT_FALSE(manager.GetActivePlaylistHandle().IsValid());
+
+            // Une playlist ne joue que dans une zone : la relancer ailleurs la déplace
+            manager.Play("zone_lobby", PlaylistOptions(), terrace);
+            ASSERT_EQ(manager.GetActivePlaylistHandle(terrace), manager.GetPlaylistHandle("zone_lobby"));
+            ASSERT_FALSE(manager.GetActivePlaylistHandle(lobby).IsValid());
+            ASSERT_FALSE(manager.IsPlaylistPlaying("zone_terrace"));
+
+            manager.SetZoneVolume(lobby, 1.5f);
+            manager.SetZoneDuckFactor(lobby, 0.25f);
+            ASSERT_FLOAT_EQ(manager.GetZoneVolume(lobby), 1.0f);
+            ASSERT_FLOAT_EQ(manager.GetZoneDuckFactor(lobby), 0.25f);
+            ASSERT_FLOAT_EQ(manager.GetZoneDuckFactor(terrace), 1.0f);
+
+            manager.StopZone(terrace);
+            ASSERT_FALSE(manager.IsPlaylistPlaying("zone_lobby"));
+
+            ASSERT_FALSE(manager.RemoveZone(PlaylistManager::MainZone));
+            ASSERT_TRUE(manager.RemoveZone(lobby));
+            ASSERT_EQ(manager.FindZone("lobby"), PlaylistManager::InvalidZone);
+            ASSERT_FLOAT_EQ(manager.GetZoneVolume(lobby), 0.0f);
+
+            const ZoneId hall = manager.CreateZone("hall");
+            ASSERT_EQ(hall, lobby);
+            ASSERT_FLOAT_EQ(manager.GetZoneVolume(hall), 1.0f);
+            ASSERT_TRUE(manager.RemoveZone(hall));
+            ASSERT_TRUE(manager.RemoveZone(terrace));
+        }
+
+        TEST_F(PlaylistManagerTests, StoppingAZoneLeavesTheSameTrackPlayingElsewhere) {
+            auto& manager = PlaylistManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            audioManager.RegisterDeferredSound("zone_shared", WriteTrack("zone_shared.wav", 8000, 80000), 10000, false);
+            for (const std::string name : { "zone_stop_lobby", "zone_stop_terrace" }) {
+                manager.CreatePlaylist(name);
+                manager.AddToPlaylist(name, "zone_shared");
+            }
+
+            OutputId lobbyOutput = FModWrapper::InvalidOutput;
+            OutputId terraceOutput = FModWrapper::InvalidOutput;
+            const ZoneId lobby = CreateSilentZone("stop_lobby", lobbyOutput);
+            const ZoneId terrace = CreateSilentZone("stop_terrace", terraceOutput);
+            ASSERT_NE(lobby, PlaylistManager::InvalidZone);
+            ASSERT_NE(terrace, PlaylistManager::InvalidZone);
+
+            manager.Play("zone_stop_lobby", PlaylistOptions(), lobby);
+            manager.Play("zone_stop_terrace", PlaylistOptions(), terrace);
+            FMOD::Channel* inLobby = manager.GetCurrentChannel(lobby);
+            FMOD::Channel* onTerrace = manager.GetCurrentChannel(terrace);
+            ASSERT_NE(inLobby, nullptr);
+            ASSERT_NE(onTerrace, nullptr);
+
+            // Le fondu est posé sur le canal de la zone, pas sur le nom du morceau
+            manager.StopZone(lobby);
+            for (int i = 0; i < 150; i++) {
+                FModWrapper::GetInstance().Update();
+            }
+            bool isPlaying = true;
+            ASSERT_FALSE(inLobby->isPlaying(&isPlaying) == FMOD_OK && isPlaying);
+            ASSERT_EQ(onTerrace->isPlaying(&isPlaying), FMOD_OK);
+            ASSERT_TRUE(isPlaying);
+            ASSERT_TRUE(manager.IsPlaylistPlaying("zone_stop_terrace"));
+
+            manager.StopZone(terrace);
+            RemoveSilentZone(lobby, lobbyOutput);
+            RemoveSilentZone(terrace, terraceOutput);
+            audioManager.UnloadSound("zone_shared");
+        }
+
+        TEST_F(PlaylistManagerTests, TransitionCrossfadesIntoNextPlaylist) {
+            auto& manager = PlaylistManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            const std::vector<std::string> sounds = { "transition_pre_a", "transition_pre_b", "transition_post_a" };
+            for (const auto& id : sounds) {
+                audioManager.RegisterDeferredSound(id, id + ".mp3", 60000);
+            }
+            audioManager.RegisterDeferredSound("transition_missing", "transition_missing.wav", 60000);
+
+            manager.CreatePlaylist("transition_pre");
+            manager.AddTracksToPlaylist("transition_pre", { "transition_pre_a", "transition_pre_b" });
+            manager.CreatePlaylist("transition_post");
+            manager.AddToPlaylist("transition_post", "transition_post_a");
+            manager.CreatePlaylist("transition_broken");
+            manager.AddToPlaylist("transition_broken", "transition_missing");
+
+            OutputId output = FModWrapper::InvalidOutput;
+            const ZoneId zone = CreateSilentZone("transition_zone", output);
+            ASSERT_NE(zone, PlaylistManager::InvalidZone);
+
+            manager.Play("transition_pre", PlaylistOptions(), zone);
+            FMOD::Channel* outgoing = manager.GetCurrentChannel(zone);
+            ASSERT_NE(outgoing, nullptr);
+            float startVolume = 0.0f;
+            outgoing->getVolume(&startVolume);
+
+            PlaylistTransition transition;
+            transition.duration = 2.0f;
+            transition.curve = CrossfadeCurve::EqualPower;
+            ASSERT_TRUE(manager.TransitionToPlaylist("transition_post", PlaylistOptions(), transition, zone));
+            ASSERT_TRUE(manager.IsInTransition(zone));
+            ASSERT_FALSE(manager.IsPlaylistPlaying("transition_pre"));
+            ASSERT_EQ(manager.GetActivePlaylistHandle(zone), manager.GetPlaylistHandle("transition_post"));
+
+            FMOD::Channel* incoming = manager.GetCurrentChannel(zone);
+            ASSERT_NE(incoming, nullptr);
+            ASSERT_NE(incoming, outgoing);
+            float volume = 1.0f;
+            incoming->getVolume(&volume);
+            ASSERT_FLOAT_EQ(volume, 0.0f);
+
+            // À mi-chemin, chaque canal est à -3 dB
+            const auto& ui = UIManager::GetInstance();
+            const float musicVolume = ui.GetMasterVolume() * ui.GetMusicVolume() * ui.GetDuckFactor();
+            manager.Update(1.0f);
+            ASSERT_NEAR(manager.GetTransitionProgress(zone), 0.5f, 1e-4f);
+            outgoing->getVolume(&volume);
+            ASSERT_NEAR(volume, startVolume * 0.70711f, 1e-4f);
+            incoming->getVolume(&volume);
+            ASSERT_NEAR(volume, musicVolume * 0.70711f, 1e-4f);
+
+            manager.Update(1.5f);
+            ASSERT_FALSE(manager.IsInTransition(zone));
+            bool isPlaying = true;
+            outgoing->isPlaying(&isPlaying);
+            ASSERT_FALSE(isPlaying);
+            incoming->getVolume(&volume);
+            ASSERT_NEAR(volume, musicVolume, 1e-4f);
+
+            // Nothing changes when the next playlist cannot be opened.
+            ASSERT_FALSE(manager.TransitionToPlaylist("transition_broken", PlaylistOptions(), transition, zone));
+            ASSERT_TRUE(manager.IsPlaylistPlaying("transition_post"));
+            ASSERT_EQ(manager.GetCurrentChannel(zone), incoming);
+            ASSERT_FALSE(manager.IsInTransition(zone));
+
+            RemoveSilentZone(zone, output);
+            for (const auto& id : sounds) {
+                audioManager.UnloadSound(id);
+            }
+            audioManager.UnloadSound("transition_missing");
+        }
+
+        TEST_F(PlaylistManagerTests, ResumeRestartsWhereThePlaylistStopped) {
+            auto& manager = PlaylistManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            const std::vector<std::string> sounds = { "resume_a", "resume_b", "resume_c", "resume_d" };
+            for (const auto& id : sounds) {
+                audioManager.RegisterDeferredSound(id, id + ".mp3", 60000);
+            }
+            manager.CreatePlaylist("resume_bed");
+            manager.AddTracksToPlaylist("resume_bed", sounds);
+
+            OutputId output = FModWrapper::InvalidOutput;
+            const ZoneId zone = CreateSilentZone("resume_zone", output);
+            ASSERT_NE(zone, PlaylistManager::InvalidZone);
+
+            PlaylistOptions options;
+            options.randomOrder = true;
+            options.loopPlaylist = true;
+            manager.Play("resume_bed", options, zone);
+            ASSERT_FALSE(manager.HasResumePoint("resume_bed"));
+            manager.SkipToNextTrack("resume_bed");
+            manager.Update(20.0f);
+
+            const std::string track = manager.GetCurrentTrackName(zone);
+            manager.GetCurrentChannel(zone)->setPosition(44100 * 3, FMOD_TIMEUNIT_PCM);
+            manager.Stop("resume_bed");
+            ASSERT_TRUE(manager.HasResumePoint("resume_bed"));
+
+            // Pré-positionné avant d'être entendu, sur le même morceau
+            ASSERT_TRUE(manager.Resume("resume_bed", zone));
+            ASSERT_TRUE(manager.IsPlaylistPlaying("resume_bed"));
+            ASSERT_EQ(manager.GetCurrentTrackName(zone), track);
+            unsigned int position = 0;
+            manager.GetCurrentChannel(zone)->getPosition(&position, FMOD_TIMEUNIT_PCM);
+            ASSERT_EQ(position, 44100u * 3);
+
+            // The track is found again after the playlist was reordered.
+            manager.Stop("resume_bed");
+            const auto* playlist = manager.GetPlaylistByName("resume_bed");
+            const int index = static_cast<int>(std::find(playlist->tracks.begin(), playlist->tracks.end(), track) - playlist->tracks.begin());
+            manager.MoveTrackToPosition("resume_bed", index, index == 0 ? 3 : 0);
+            ASSERT_TRUE(manager.Resume("resume_bed", zone));
+            ASSERT_EQ(manager.GetCurrentTrackName(zone), track);
+
+            // Plus de point de reprise quand le morceau a quitté la playlist
+            manager.Stop("resume_bed");
+            manager.RemoveFromPlaylist("resume_bed", track);
+            ASSERT_FALSE(manager.Resume("resume_bed", zone));
+            ASSERT_FALSE(manager.HasResumePoint("resume_bed"));
+            ASSERT_FALSE(manager.IsPlaylistPlaying("resume_bed"));
+
+            RemoveSilentZone(zone, output);
+            for (const auto& id : sounds) {
+                audioManager.UnloadSound(id);
+            }
+        }
+
+        TEST_F(PlaylistManagerTests, TrackCrossfadeFollowsThePlaylistCurve) {
+            auto& manager = PlaylistManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            const std::vector<std::string> sounds = { "curve_a", "curve_b" };
+            for (const auto& id : sounds) {
+                audioManager.RegisterDeferredSound(id, id + ".mp3", 60000);
+            }
+            manager.CreatePlaylist("curve_bed");
+            manager.AddTracksToPlaylist("curve_bed", sounds);
+
+            OutputId output = FModWrapper::InvalidOutput;
+            const ZoneId zone = CreateSilentZone("curve_zone", output);
+            ASSERT_NE(zone, PlaylistManager::InvalidZone);
+
+            PlaylistOptions options;
+            options.loopPlaylist = true;
+            options.crossfadeDuration = 4.0f;
+            options.crossfadeCurve = CrossfadeCurve::Logarithmic;
+            manager.SetPlaylistOptions("curve_bed", options);
+            manager.Play("curve_bed", options, zone);
+            manager.SkipToNextTrack("curve_bed");
+            ASSERT_TRUE(manager.IsInCrossfade(zone));
+            manager.Update(1.0f);
+
+            // À t = 0.25 : -12 dB pour le morceau sortant, -36 dB pour l'entrant
+            float outVolume = 0.0f;
+            float inVolume = 0.0f;
+            manager.GetCurrentChannel(zone)->getVolume(&outVolume);
+            manager.GetNextChannel(zone)->getVolume(&inVolume);
+            ASSERT_GT(outVolume, 0.0f);
+            ASSERT_NEAR(inVolume / outVolume, std::pow(10.0f, -24.0f / 20.0f), 1e-3f);
+
+            // Les options données à Play et SetCrossfadeDuration ne valent que pour la lecture en cours
+            manager.Play("curve_bed", PlaylistOptions(), zone);
+            manager.SetCrossfadeDuration(1.0f, zone);
+            const auto* playlist = manager.GetPlaylistByName("curve_bed");
+            ASSERT_EQ(playlist->options.crossfadeCurve, CrossfadeCurve::Logarithmic);
+            ASSERT_FLOAT_EQ(playlist->options.crossfadeDuration, 4.0f);
+            ASSERT_TRUE(playlist->options.loopPlaylist);
+
+            // On repart d'un index avec les réglages de la playlist
+            manager.PlayFromIndex("curve_bed", 1);
+            ASSERT_EQ(playlist->playback.crossfadeCurve, CrossfadeCurve::Logarithmic);
+            ASSERT_FLOAT_EQ(playlist->playback.crossfadeDuration, 4.0f);
+
+            manager.SetPlaylistCrossfadeCurve("curve_bed", CrossfadeCurve::Custom, 0.5f);
+            ASSERT_EQ(playlist->options.crossfadeCurve, CrossfadeCurve::Custom);
+            ASSERT_FLOAT_EQ(playlist->options.crossfadeShape, 0.5f);
+
+            manager.Stop("curve_bed");
+            RemoveSilentZone(zone, output);
+            for (const auto& id : sounds) {
+                audioManager.UnloadSound(id);
+            }
+        }
+
+        TEST_F(PlaylistManagerTests, TrackEndCallbackStartsTheNextTrack) {
+            auto& manager = PlaylistManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            const std::vector<std::string> sounds = { "end_a", "end_b" };
+            for (const auto& id : sounds) {
+                audioManager.RegisterDeferredSound(id, WriteTrack(id + ".wav", 8000, 8000), 1000, false);
+            }
+            manager.CreatePlaylist("end_bed");
+            manager.AddTracksToPlaylist("end_bed", sounds);
+
+            OutputId output = FModWrapper::InvalidOutput;
+            const ZoneId zone = CreateSilentZone("end_zone", output);
+            ASSERT_NE(zone, PlaylistManager::InvalidZone);
+
+            PlaylistOptions options;
+            options.loopPlaylist = true;
+            options.crossfadeDuration = 0.5f;
+            manager.Play("end_bed", options, zone);
+            FMOD::Channel* first = manager.GetCurrentChannel(zone);
+            ASSERT_NE(first, nullptr);
+
+            // Sans fin signalée, Update ne change rien
+            manager.Update(0.1f);
+            ASSERT_EQ(manager.GetCurrentChannel(zone), first);
+            ASSERT_FALSE(manager.IsInCrossfade(zone));
+
+            // Un canal fini peut aussi répondre par un handle invalide
+            bool isPlaying = true;
+            for (int i = 0; i < 200 && isPlaying; i++) {
+                FModWrapper::GetInstance().Update();
+                isPlaying = first->isPlaying(&isPlaying) == FMOD_OK && isPlaying;
+            }
+            ASSERT_FALSE(isPlaying);
+
+            // La fin arrive par le callback, le morceau suivant part à l'Update suivant
+            manager.Update(0.01f);
+            ASSERT_TRUE(manager.IsInCrossfade(zone));
+            ASSERT_NE(manager.GetNextChannel(zone), nullptr);
+
+            manager.Stop("end_bed");
+            RemoveSilentZone(zone, output);
+            for (const auto& id : sounds) {
+                audioManager.UnloadSound(id);
+            }
+        }
+
+        TEST_F(PlaylistManagerTests, GaplessTracksStartOnTheSampleThePreviousOneEnds) {
+            auto& manager = PlaylistManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            const std::vector<std::string> sounds = { "gapless_a", "gapless_b" };
+            for (const auto& id : sounds) {
+                audioManager.RegisterDeferredSound(id, WriteTrack(id + ".wav", 8000, 8000), 1000, false);
+            }
+            manager.CreatePlaylist("gapless_bed");
+            manager.AddTracksToPlaylist("gapless_bed", sounds);
+
+            OutputId output = FModWrapper::InvalidOutput;
+            const ZoneId zone = CreateSilentZone("gapless_zone", output);
+            ASSERT_NE(zone, PlaylistManager::InvalidZone);
+
+            PlaylistOptions options;
+            options.loopPlaylist = true;
+            options.gapless = true;
+            manager.Play("gapless_bed", options, zone);
+
+            FMOD::Channel* first = manager.GetCurrentChannel(zone);
+            FMOD::Channel* queued = manager.GetQueuedChannel(zone);
+            ASSERT_NE(first, nullptr);
+            ASSERT_NE(queued, nullptr);
+
+            // Une seconde à 8 kHz : 48000 échantillons du mixeur, et le suivant part sur le dernier
+            const unsigned long long outputRate = audioManager.GetOutputSampleRate(output);
+            unsigned long long start = 0, end = 0, queuedStart = 0, queuedEnd = 0;
+            first->getDelay(&start, &end);
+            queued->getDelay(&queuedStart, &queuedEnd);
+            ASSERT_EQ(end - start, outputRate);
+            ASSERT_EQ(queuedStart, end);
+            ASSERT_EQ(queuedEnd - queuedStart, outputRate);
+
+            bool isPlaying = true;
+            for (int i = 0; i < 400 && isPlaying; i++) {
+                FModWrapper::GetInstance().Update();
+                isPlaying = first->isPlaying(&isPlaying) == FMOD_OK && isPlaying;
+            }
+            ASSERT_FALSE(isPlaying);
+
+            // Pas de fondu : le canal en attente devient le courant et le suivant est programmé
+            manager.Update(0.01f);
+            ASSERT_FALSE(manager.IsInCrossfade(zone));
+            ASSERT_EQ(manager.GetCurrentChannel(zone), queued);
+            FMOD::Channel* following = manager.GetQueuedChannel(zone);
+            ASSERT_NE(following, nullptr);
+            unsigned long long followingStart = 0;
+            following->getDelay(&followingStart, nullptr);
+            ASSERT_EQ(followingStart, queuedEnd);
+
+            manager.Stop("gapless_bed");
+            ASSERT_EQ(manager.GetQueuedChannel(zone), nullptr);
+            RemoveSilentZone(zone, output);
+            for (const auto& id : sounds) {
+                audioManager.UnloadSound(id);
+            }
+        }
+
+        TEST_F(PlaylistManagerTests, DuplicateLeavesTheSourceQueuedTrackAlone) {
+            auto& manager = PlaylistManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            const std::vector<std::string> sounds = { "copy_a", "copy_b" };
+            for (const auto& id : sounds) {
+                audioManager.RegisterDeferredSound(id, WriteTrack(id + ".wav", 8000, 8000), 1000, false);
+            }
+            manager.CreatePlaylist("copy_source");
+            manager.AddTracksToPlaylist("copy_source", sounds);
+
+            OutputId sourceOutput = FModWrapper::InvalidOutput;
+            OutputId copyOutput = FModWrapper::InvalidOutput;
+            const ZoneId sourceZone = CreateSilentZone("copy_source_zone", sourceOutput);
+            const ZoneId copyZone = CreateSilentZone("copy_zone", copyOutput);
+            ASSERT_NE(sourceZone, PlaylistManager::InvalidZone);
+            ASSERT_NE(copyZone, PlaylistManager::InvalidZone);
+
+            PlaylistOptions options;
+            options.loopPlaylist = true;
+            options.gapless = true;
+            manager.SetPlaylistOptions("copy_source", options);
+            manager.Play("copy_source", options, sourceZone);
+            FMOD::Channel* queued = manager.GetQueuedChannel(sourceZone);
+            ASSERT_NE(queued, nullptr);
+
+            // La copie n'emporte ni canaux ni file gapless : la démarrer ne touche pas à la source
+            manager.DuplicatePlaylist("copy_source", "copy_dest");
+            const auto* copy = manager.GetPlaylistByName("copy_dest");
+            ASSERT_NE(copy, nullptr);
+            ASSERT_FALSE(copy->isPlaying);
+            ASSERT_EQ(copy->queuedChannel, nullptr);
+            ASSERT_FALSE(copy->resume.valid);
+            ASSERT_TRUE(copy->options.gapless);
+
+            manager.Play("copy_dest", copy->options, copyZone);
+            ASSERT_EQ(manager.GetQueuedChannel(sourceZone), queued);
+            bool isPlaying = false;
+            ASSERT_EQ(queued->isPlaying(&isPlaying), FMOD_OK);
+            ASSERT_TRUE(isPlaying);
+            ASSERT_NE(manager.GetQueuedChannel(copyZone), queued);
+
+            manager.Stop("copy_dest");
+            manager.Stop("copy_source");
+            RemoveSilentZone(copyZone, copyOutput);
+            RemoveSilentZone(sourceZone, sourceOutput);
+            for (const auto& id : sounds) {
+                audioManager.UnloadSound(id);
+            }
+        }
+
+        TEST_F(PlaylistManagerTests, UndoFollowsThePlayingTrackAndRequeuesTheNextOne) {
+            auto& manager = PlaylistManager::GetInstance();
+            auto& audioManager = AudioManager::GetInstance();
+            const std::vector<std::string> sounds = { "undo_a", "undo_b", "undo_x" };
+            for (const auto& id : sounds) {
+                audioManager.RegisterDeferredSound(id, WriteTrack(id + ".wav", 8000, 8000), 1000, false);
+            }
+            manager.CreatePlaylist("undo_play");
+            manager.AddTracksToPlaylist("undo_play", { "undo_a", "undo_b" });
+
+            OutputId output = FModWrapper::InvalidOutput;
+            const ZoneId zone = CreateSilentZone("undo_zone", output);
+            ASSERT_NE(zone, PlaylistManager::InvalidZone);
+
+            PlaylistOptions options;
+            options.gapless = true;
+            manager.Play("undo_play", options, zone);
+            const auto* playlist = manager.GetPlaylistByName("undo_play");
+            FMOD::Channel* playing = manager.GetCurrentChannel(zone);
+            ASSERT_NE(playing, nullptr);
+
+            manager.ReconcilePlaylist("undo_play", { "undo_x", "undo_a", "undo_b" });
+            ASSERT_EQ(playlist->currentIndex, 1);
+
+            // Le morceau en cours est retrouvé par son id et la suite gapless est recalculée
+            ASSERT_TRUE(manager.Undo());
+            EXPECT_EQ(playlist->currentIndex, 0);
+            EXPECT_EQ(manager.GetCurrentChannel(zone), playing);
+            ASSERT_NE(playlist->queuedChannel, nullptr);
+            EXPECT_EQ(playlist->queuedIndex, 1);
+            EXPECT_EQ(playlist->queuedTrack.str(), "undo_b");
+
+            ASSERT_TRUE(manager.Redo());
+            EXPECT_EQ(playlist->currentIndex, 1);
+            EXPECT_EQ(manager.GetCurrentChannel(zone), playing);
+            ASSERT_NE(playlist->queuedChannel, nullptr);
+            EXPECT_EQ(playlist->queuedIndex, 2);
+
+            // Une liste vide arrête la playlist
+            ASSERT_TRUE(manager.Undo());
+            ASSERT_TRUE(manager.Undo());
+            EXPECT_TRUE(playlist->tracks.empty());
+            EXPECT_FALSE(playlist->isPlaying);
+            EXPECT_EQ(playlist->queuedChannel, nullptr);
+
+            RemoveSilentZone(zone, output);
+            for (const auto& id : sounds) {
+                audioManager.UnloadSound(id);
+            }
+        }
+
     }
-}
\ No newline at end of file
+}
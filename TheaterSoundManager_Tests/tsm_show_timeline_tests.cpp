@@ -0,0 +1,222 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        // The show plays on a no-sound output whose clock the test advances by hand.
+        class ShowTimelineTests : public ::testing::Test {
+        protected:
+            static constexpr float Tick = 1024.0f / 48000.0f;
+
+            void SetUp() override {
+                m_directory = std::filesystem::temp_directory_path() / "tsm_show_tests";
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::create_directories(m_directory);
+
+                m_output = AddNoSoundOutput("test_show");
+
+                ShowTimelineHost host;
+                host.getLevel = [this]() { return m_level; };
+                host.setLevel = [this](float level) { m_level = level; };
+                host.getVolume = [](ShowBus bus) { return bus == ShowBus::Sfx ? 0.8f : 0.5f; };
+                host.startPlaylist = [this](const std::string& name) { m_playlists.push_back(name); };
+
+                auto& timeline = ShowTimeline::GetInstance();
+                timeline.SetHost(host);
+                timeline.SetOutput(m_output);
+            }
+
+            void TearDown() override {
+                auto& timeline = ShowTimeline::GetInstance();
+                timeline.Stop();
+                timeline.SetHost(ShowTimelineHost{});
+                timeline.SetOutput(FModWrapper::MainOutput);
+                for (const std::string& id : m_sounds) AudioManager::GetInstance().UnloadSound(id);
+                if (FModWrapper::GetInstance().GetSystem(m_output)) FModWrapper::GetInstance().RemoveOutput(m_output);
+                std::filesystem::remove_all(m_directory);
+            }
+
+            void AddSound(const std::string& id, uint32_t frames) {
+                const std::string path = WriteSilentWav(m_directory / (id + ".wav"), 48000, frames);
+                AudioManager::GetInstance().RegisterDeferredSound(id, path, frames / 48, false);
+                m_sounds.push_back(id);
+            }
+
+            // Advances the output and the timeline together, like the main loop.
+            void Run(float seconds) {
+                FMOD::System* system = FModWrapper::GetInstance().GetSystem(m_output);
+                for (float t = 0.0f; t < seconds; t += Tick) {
+                    system->update();
+                    ShowTimeline::GetInstance().Update(Tick);
+                }
+            }
+
+            std::filesystem::path m_directory;
+            OutputId m_output = FModWrapper::InvalidOutput;
+            std::vector<std::string> m_sounds;
+            float m_level = 1.0f;
+            std::vector<std::string> m_playlists;
+        };
+
+        TEST_F(ShowTimelineTests, CompilesSequencesIntoOneStepTable) {
+            auto& timeline = ShowTimeline::GetInstance();
+            ASSERT_TRUE(timeline.LoadString(R"({
+                "name": "Test",
+                "parameters": { "again": 0 },
+                "sequences": [
+                    { "name": "first", "label": "First", "steps": [
+                        { "type": "play", "sound": "test_show_a" },
+                        { "type": "wait", "seconds": 1 },
+                        { "type": "branch", "if": "again", "then": "first", "else": "second" }
+                    ] },
+                    { "name": "second", "steps": [
+                        { "type": "play", "sound": "test_show_b" },
+                        { "type": "waitForEnd" }
+                    ] }
+                ]
+            })", "test"));
+
+            const auto& steps = timeline.GetSteps();
+            const auto& sequences = timeline.GetSequences();
+            ASSERT_EQ(sequences.size(), 2u);
+            ASSERT_EQ(steps.size(), 7u);
+            ASSERT_EQ(sequences[1].firstStep, 4u);
+            ASSERT_EQ(steps[3].type, ShowStepType::End);
+            ASSERT_EQ(steps[2].target, 0u);
+            ASSERT_EQ(steps[2].elseTarget, 4u);
+            ASSERT_EQ(steps[5].sound, steps[4].sound);
+
+            // Pendant l'attente, les deux issues du branchement sont ouvertes d'avance
+            ASSERT_EQ(sequences[0].preloadCount, 1u);
+            ASSERT_EQ(steps[1].preloadCount, 2u);
+
+            // Un spectacle invalide laisse le précédent en place
+            ASSERT_FALSE(timeline.LoadString(R"({ "sequences": [ { "name": "x", "steps": [
+                { "type": "goto", "then": "nowhere" } ] } ] })", "broken"));
+            ASSERT_FALSE(timeline.LoadString(R"({ "sequences": [ { "name": "x", "steps": [
+                { "type": "jump" } ] } ] })", "broken"));
+            ASSERT_EQ(timeline.GetShowName(), "Test");
+        }
+
+        TEST_F(ShowTimelineTests, AdvancesOnChannelEndsDeadlinesAndFades) {
+            ASSERT_NE(m_output, FModWrapper::InvalidOutput);
+            AddSound("test_show_sfx", 9600);
+            AddSound("test_show_music", 48000 * 4);
+
+            auto& timeline = ShowTimeline::GetInstance();
+            ASSERT_TRUE(timeline.LoadString(R"({
+                "parameters": { "toPlaylist": 1 },
+                "sequences": [
+                    { "name": "intro", "steps": [
+                        { "type": "fade", "to": 0, "seconds": 0.5 },
+                        { "type": "play", "sound": "test_show_sfx", "bus": "sfx" },
+                        { "type": "waitForEnd" },
+                        { "type": "wait", "seconds": 0.3 },
+                        { "type": "play", "sound": "test_show_music" },
+                        { "type": "duck", "to": 1, "seconds": 1 },
+                        { "type": "waitForEnd", "before": 1 },
+                        { "type": "branch", "if": "toPlaylist", "then": "outro" }
+                    ] },
+                    { "name": "outro", "steps": [
+                        { "type": "playlist", "name": "playlist_after" }
+                    ] }
+                ]
+            })", "test"));
+
+            ASSERT_TRUE(timeline.Start("intro"));
+            ASSERT_EQ(timeline.GetCurrentSequence(), 0);
+            ASSERT_EQ(timeline.GetSteps()[timeline.GetCurrentStep()].type, ShowStepType::Fade);
+
+            Run(0.6f);
+            ASSERT_FLOAT_EQ(m_level, 0.0f);
+            ASSERT_EQ(timeline.GetSteps()[timeline.GetCurrentStep()].type, ShowStepType::WaitForEnd);
+            ASSERT_NE(timeline.GetAwaitedChannel(), nullptr);
+
+            // 0,2 s d'effet puis 0,3 s d'attente
+            Run(0.5f);
+            ASSERT_EQ(timeline.GetCurrentStep(), 6u);
+            ASSERT_GT(m_level, 0.0f);
+
+            Run(1.0f);
+            ASSERT_FLOAT_EQ(m_level, 1.0f);
+            ASSERT_TRUE(timeline.IsRunning());
+            ASSERT_TRUE(m_playlists.empty());
+
+            // Une seconde avant la fin de la musique
+            Run(2.0f);
+            ASSERT_FALSE(timeline.IsRunning());
+            ASSERT_EQ(m_playlists, std::vector<std::string>{ "playlist_after" });
+            ASSERT_EQ(timeline.GetCurrentSequence(), -1);
+        }
+
+        TEST_F(ShowTimelineTests, SkipAndParametersDriveTheSteps) {
+            ASSERT_NE(m_output, FModWrapper::InvalidOutput);
+            AddSound("test_show_long", 48000 * 60);
+
+            auto& timeline = ShowTimeline::GetInstance();
+            ASSERT_TRUE(timeline.LoadString(R"({
+                "parameters": { "hold": 100, "margin": 10 },
+                "sequences": [
+                    { "name": "main", "label": "Main", "steps": [
+                        { "type": "wait", "seconds": "hold" },
+                        { "type": "play", "sound": "test_show_long" },
+                        { "type": "waitForEnd", "before": "margin" },
+                        { "type": "wait", "seconds": 100 }
+                    ] }
+                ]
+            })", "test"));
+            ASSERT_FLOAT_EQ(timeline.GetParameter("hold"), 100.0f);
+            ASSERT_FALSE(timeline.SetParameter("missing", 1.0f));
+
+            ASSERT_TRUE(timeline.Start("main"));
+            Run(0.5f);
+            ASSERT_EQ(timeline.GetCurrentStep(), 0u);
+            timeline.Skip();
+            ASSERT_EQ(timeline.GetCurrentStep(), 2u);
+
+            FMOD::Channel* music = timeline.GetAwaitedChannel();
+            ASSERT_NE(music, nullptr);
+            ASSERT_TRUE(timeline.SeekBeforeEnd(10.5f));
+            unsigned int positionMs = 0;
+            music->getPosition(&positionMs, FMOD_TIMEUNIT_MS);
+            ASSERT_EQ(positionMs, 49500u);
+
+            Run(1.0f);
+            ASSERT_EQ(timeline.GetCurrentStep(), 3u);
+
+            // Un paramètre change la durée des attentes suivantes
+            ASSERT_TRUE(timeline.SetParameter("hold", 0.2f));
+            ASSERT_TRUE(timeline.Start(0));
+            Run(0.3f);
+            ASSERT_EQ(timeline.GetCurrentStep(), 2u);
+
+            ASSERT_FALSE(timeline.Start("missing"));
+            ASSERT_TRUE(timeline.IsRunning());
+        }
+
+        TEST_F(ShowTimelineTests, StopsABranchLoopThatNeverWaits) {
+            auto& timeline = ShowTimeline::GetInstance();
+            ASSERT_TRUE(timeline.LoadString(R"({ "sequences": [ { "name": "spin", "steps": [
+                { "id": "top", "type": "duck", "to": 0.5 },
+                { "type": "goto", "then": "top" } ] } ] })", "test"));
+
+            ASSERT_TRUE(timeline.Start("spin"));
+            ASSERT_FALSE(timeline.IsRunning());
+            ASSERT_FLOAT_EQ(m_level, 0.5f);
+        }
+
+        TEST_F(ShowTimelineTests, ListsTheSoundsNotRegisteredYet) {
+            auto& timeline = ShowTimeline::GetInstance();
+            ASSERT_TRUE(timeline.LoadString(R"({ "sequences": [ { "name": "entrance", "steps": [
+                { "type": "play", "sound": "missing_a" },
+                { "type": "play", "sound": "missing_b", "bus": "sfx" } ] } ] })", "test"));
+            ASSERT_EQ(timeline.GetMissingSounds(), (std::vector<std::string>{ "missing_a", "missing_b" }));
+
+            AddSound("missing_a", 4800);
+            ASSERT_EQ(timeline.GetMissingSounds(), std::vector<std::string>{ "missing_b" });
+            AddSound("missing_b", 4800);
+            ASSERT_TRUE(timeline.GetMissingSounds().empty());
+        }
+
+    }
+}
@@ -0,0 +1,212 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        class ShuffleEngineTests : public ::testing::Test {
+        protected:
+            void SetUp() override {
+                m_directory = std::filesystem::temp_directory_path() / "tsm_shuffle_tests";
+                std::filesystem::remove_all(m_directory);
+                std::filesystem::create_directories(m_directory);
+            }
+
+            void TearDown() override {
+                for (const auto& id : m_sounds) {
+                    AudioManager::GetInstance().UnloadSound(id);
+                }
+                std::filesystem::remove_all(m_directory);
+            }
+
+            // Deferred sounds only need a path, the file is never opened here.
+            std::string AddSound(const std::string& id, const std::string& artist, const std::string& album = "") {
+                auto& audioManager = AudioManager::GetInstance();
+                audioManager.RegisterDeferredSound(id, (m_directory / (id + ".mp3")).string(), 1000);
+                audioManager.SetSoundMetadata(id, id, artist, album);
+                m_sounds.push_back(id);
+                return id;
+            }
+
+            static std::vector<TrackId> PlayCycle(ShuffleEngine& engine, const IndexedSequence<TrackId>& tracks) {
+                std::vector<int> order = engine.BuildOrder(tracks);
+                std::vector<int> sorted = order;
+                std::sort(sorted.begin(), sorted.end());
+                for (size_t i = 0; i < sorted.size(); i++) {
+                    EXPECT_EQ(sorted[i], static_cast<int>(i));
+                }
+
+                std::vector<TrackId> played;
+                for (int index : order) {
+                    engine.RecordPlay(tracks[index]);
+                    played.push_back(tracks[index]);
+                }
+                return played;
+            }
+
+            std::filesystem::path m_directory;
+            std::vector<std::string> m_sounds;
+        };
+
+        TEST_F(ShuffleEngineTests, KeepsRepeatDistanceAcrossCycles) {
+            ShuffleEngine engine;
+            engine.Seed(11);
+            ShuffleSettings settings;
+            settings.minRepeatDistance = 6;
+            engine.SetSettings(settings);
+
+            IndexedSequence<TrackId> tracks;
+            for (int i = 0; i < 12; i++) {
+                tracks.push_back("shuffle_distance_" + std::to_string(i));
+            }
+
+            std::vector<TrackId> played;
+            for (int cycle = 0; cycle < 200; cycle++) {
+                std::vector<TrackId> cyclePlays = PlayCycle(engine, tracks);
+                played.insert(played.end(), cyclePlays.begin(), cyclePlays.end());
+            }
+
+            std::unordered_map<TrackId, size_t> lastSeen;
+            for (size_t i = 0; i < played.size(); i++) {
+                auto it = lastSeen.find(played[i]);
+                if (it != lastSeen.end()) {
+                    ASSERT_GT(i - it->second - 1, 5u) << "at play " << i;
+                }
+                lastSeen[played[i]] = i;
+            }
+
+            // Une playlist de deux morceaux ne rejoue jamais le même deux fois de suite
+            IndexedSequence<TrackId> pair{ "shuffle_pair_a", "shuffle_pair_b" };
+            TrackId previous;
+            for (int cycle = 0; cycle < 50; cycle++) {
+                for (const auto& track : PlayCycle(engine, pair)) {
+                    ASSERT_NE(track, previous);
+                    previous = track;
+                }
+            }
+        }
+
+        TEST_F(ShuffleEngineTests, SpreadsArtistsAndAlbums) {
+            IndexedSequence<TrackId> tracks;
+            for (int artist = 0; artist < 5; artist++) {
+                for (int track = 0; track < 4; track++) {
+                    const std::string id = "shuffle_artist_" + std::to_string(artist) + "_" + std::to_string(track);
+                    tracks.push_back(AddSound(id, "Artist " + std::to_string(artist), "Album " + std::to_string(track % 2)));
+                }
+            }
+            auto artistOf = [](const TrackId& track) { return AudioManager::GetInstance().GetAllSounds().at(track).artist; };
+
+            ShuffleEngine engine;
+            engine.Seed(5);
+            ShuffleSettings settings;
+            settings.minRepeatDistance = 5;
+            settings.artistSpacing = 3;
+            settings.albumSpacing = 0;
+            engine.SetSettings(settings);
+
+            size_t plays = 0;
+            size_t closeRepeats = 0;
+            std::vector<std::string> recentArtists;
+            for (int cycle = 0; cycle < 100; cycle++) {
+                for (const auto& track : PlayCycle(engine, tracks)) {
+                    const std::string artist = artistOf(track);
+                    if (std::find(recentArtists.begin(), recentArtists.end(), artist) != recentArtists.end()) {
+                        closeRepeats++;
+                    }
+                    recentArtists.push_back(artist);
+                    if (recentArtists.size() > 3) recentArtists.erase(recentArtists.begin());
+                    plays++;
+                }
+            }
+
+            // A plain shuffle repeats an artist within 3 plays about half the time.
+            ASSERT_LT(closeRepeats * 50, plays);
+        }
+
+        TEST_F(ShuffleEngineTests, HeavierTracksComeFirst) {
+            ShuffleEngine engine;
+            engine.Seed(3);
+            ShuffleSettings settings;
+            settings.minRepeatDistance = 0;
+            engine.SetSettings(settings);
+
+            IndexedSequence<TrackId> tracks;
+            for (int i = 0; i < 10; i++) {
+                tracks.push_back("shuffle_weight_" + std::to_string(i));
+            }
+            engine.SetTrackWeight(tracks[7], 9.0f);
+            ASSERT_FLOAT_EQ(engine.GetTrackWeight(tracks[7]), 9.0f);
+            ASSERT_FLOAT_EQ(engine.GetTrackWeight(tracks[0]), 1.0f);
+
+            int first = 0;
+            const int Cycles = 2000;
+            for (int cycle = 0; cycle < Cycles; cycle++) {
+                if (engine.BuildOrder(tracks).front() == 7) first++;
+            }
+            // 9 / (9 + 9) : la moitié des cycles commencent par le morceau lourd
+            ASSERT_GT(first, Cycles * 4 / 10);
+            ASSERT_LT(first, Cycles * 6 / 10);
+        }
+
+        TEST_F(ShuffleEngineTests, HistorySurvivesRestart) {
+            const std::string historyPath = (m_directory / "shuffle_history.json").string();
+            IndexedSequence<TrackId> tracks;
+            for (int i = 0; i < 8; i++) {
+                tracks.push_back("shuffle_restart_" + std::to_string(i));
+            }
+
+            ShuffleSettings settings;
+            settings.minRepeatDistance = 3;
+            settings.historySize = 16;
+
+            std::vector<TrackId> lastPlays;
+            {
+                ShuffleEngine engine;
+                engine.SetSettings(settings);
+                ASSERT_TRUE(engine.SetHistoryFile(historyPath));
+                engine.SetTrackWeight(tracks[2], 2.5f);
+                for (int cycle = 0; cycle < 3; cycle++) {
+                    lastPlays = PlayCycle(engine, tracks);
+                }
+                ASSERT_EQ(engine.GetHistory().size(), 16u);
+            }
+
+            ShuffleEngine restarted;
+            restarted.SetSettings(settings);
+            ASSERT_TRUE(restarted.SetHistoryFile(historyPath));
+            std::vector<TrackId> history = restarted.GetHistory();
+            ASSERT_EQ(history.size(), 16u);
+            ASSERT_TRUE(std::equal(lastPlays.begin(), lastPlays.end(), history.end() - lastPlays.size()));
+            ASSERT_EQ(restarted.GetPlaysSince(lastPlays.back()), 0u);
+            ASSERT_FLOAT_EQ(restarted.GetTrackWeight(tracks[2]), 2.5f);
+
+            // Le premier cycle après redémarrage évite les derniers morceaux entendus
+            std::vector<int> order = restarted.BuildOrder(tracks);
+            for (size_t slot = 0; slot < 3; slot++) {
+                const TrackId& track = tracks[order[slot]];
+                ASSERT_GT(restarted.GetPlaysSince(track) + slot, 2u);
+            }
+        }
+
+        TEST_F(ShuffleEngineTests, PlaysAreSavedInBatches) {
+            const std::string historyPath = (m_directory / "shuffle_batch.json").string();
+            ShuffleEngine engine;
+            ASSERT_TRUE(engine.SetHistoryFile(historyPath));
+
+            // Le démarrage d'un morceau n'écrit rien sur le disque
+            engine.RecordPlay("shuffle_batch_a");
+            engine.RecordPlay("shuffle_batch_b");
+            engine.Update(ShuffleEngine::SaveInterval / 2);
+            ASSERT_FALSE(std::filesystem::exists(historyPath));
+
+            engine.Update(ShuffleEngine::SaveInterval / 2);
+            ASSERT_TRUE(std::filesystem::exists(historyPath));
+
+            engine.RecordPlay("shuffle_batch_c");
+            engine.FlushHistory();
+            ShuffleEngine restarted;
+            ASSERT_TRUE(restarted.SetHistoryFile(historyPath));
+            ASSERT_EQ(restarted.GetHistory().size(), 3u);
+        }
+
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "tsm_fmod_wrapper.h"
+
+namespace TSM {
+    namespace Tests {
+
+        // 16-bit mono PCM written as a RIFF WAVE file at `path`.
+        inline std::string WriteWav(const std::filesystem::path& path, uint32_t sampleRate, const std::vector<int16_t>& samples) {
+            std::vector<char> file;
+            auto append = [&file](const void* data, size_t size) {
+                file.insert(file.end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+            };
+            const uint32_t dataSize = static_cast<uint32_t>(samples.size() * 2);
+            const uint32_t riffSize = 36 + dataSize;
+            const uint32_t fmtSize = 16;
+            const uint16_t pcm = 1, channels = 1, blockAlign = 2, bits = 16;
+            const uint32_t byteRate = sampleRate * 2;
+            append("RIFF", 4); append(&riffSize, 4); append("WAVE", 4);
+            append("fmt ", 4); append(&fmtSize, 4); append(&pcm, 2); append(&channels, 2);
+            append(&sampleRate, 4); append(&byteRate, 4); append(&blockAlign, 2); append(&bits, 2);
+            append("data", 4); append(&dataSize, 4);
+            append(samples.data(), dataSize);
+
+            std::ofstream(path, std::ios::binary).write(file.data(), file.size());
+            return path.string();
+        }
+
+        inline std::string WriteSilentWav(const std::filesystem::path& path, uint32_t sampleRate, uint32_t frames) {
+            return WriteWav(path, sampleRate, std::vector<int16_t>(frames, 0));
+        }
+
+        // Output without a device: its channels exist and its mixer only advances on update().
+        inline OutputId AddNoSoundOutput(const std::string& name, int maxChannels = 16, const std::string& driver = "") {
+            OutputConfig config;
+            config.name = name;
+            config.driver = driver;
+            config.outputType = FMOD_OUTPUTTYPE_NOSOUND_NRT;
+            config.maxChannels = maxChannels;
+            return FModWrapper::GetInstance().AddOutput(config);
+        }
+
+    }
+}
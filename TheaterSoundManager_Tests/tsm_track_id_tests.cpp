@@ -0,0 +1,73 @@
+#include "pch.h"
+
+namespace TSM {
+    namespace Tests {
+
+        TEST(TrackIdTests, InternsEachStringOnce) {
+            static_assert(sizeof(TrackId) == 4);
+
+            TrackId first("interned_track");
+            TrackId second(std::string("interned_track"));
+            ASSERT_EQ(first, second);
+            ASSERT_EQ(first.GetIndex(), second.GetIndex());
+            ASSERT_EQ(first.str(), "interned_track");
+            ASSERT_EQ(first, std::string("interned_track"));
+            ASSERT_NE(first, TrackId("other_track"));
+            ASSERT_TRUE(TrackId().empty());
+
+            const size_t count = TrackIdPool::GetInstance().GetCount();
+            TrackId found;
+            ASSERT_TRUE(TrackId::Find("interned_track", found));
+            ASSERT_EQ(found, first);
+            ASSERT_FALSE(TrackId::Find("never_interned_track", found));
+            ASSERT_EQ(TrackIdPool::GetInstance().GetCount(), count);
+
+            // Les conteneurs triés restent dans l'ordre alphabétique
+            std::map<TrackId, int, std::less<>> sorted;
+            for (const char* name : { "zeta", "alpha", "mu" }) {
+                sorted[name] = 0;
+            }
+            ASSERT_EQ(sorted.begin()->first, "alpha");
+            ASSERT_EQ(sorted.rbegin()->first, "zeta");
+            ASSERT_NE(sorted.find(std::string("mu")), sorted.end());
+        }
+
+        TEST(TrackIdTests, SyntheticLibraryMemory) {
+            const size_t LibrarySize = 100000;
+            const size_t PlaylistCount = 40;
+            const size_t TracksPerPlaylist = 20000;
+
+            TrackIdPool pool;
+            std::vector<std::string> names;
+            names.reserve(LibrarySize);
+            for (size_t i = 0; i < LibrarySize; i++) {
+                names.push_back("library_track_" + std::to_string(1000000 + i));
+                pool.Intern(names.back());
+            }
+
+            // Sans interning : une clé par son dans la bibliothèque, un nœud portant une copie
+            // de la chaîne par entrée de playlist
+            size_t stringBytes = 0;
+            for (const auto& name : names) {
+                stringBytes += TrackIdPool::StringFootprint(name);
+            }
+            std::mt19937 rng(7);
+            std::uniform_int_distribution<size_t> pick(0, LibrarySize - 1);
+            for (size_t p = 0; p < PlaylistCount * TracksPerPlaylist; p++) {
+                const std::string& name = names[pick(rng)];
+                stringBytes += IndexedSequence<std::string>::NodeFootprint()
+                             + TrackIdPool::StringFootprint(name) - sizeof(std::string);
+            }
+
+            // Avec : le pool, une clé de 4 octets par son et un nœud par entrée de playlist
+            const TrackIdPool::MemoryUsage usage = pool.GetMemoryUsage();
+            ASSERT_EQ(usage.count, LibrarySize + 1);
+            const size_t internedBytes = usage.Total() + LibrarySize * sizeof(TrackId)
+                                       + PlaylistCount * TracksPerPlaylist * IndexedSequence<TrackId>::NodeFootprint();
+
+            // Le chaînage des nœuds coûte autant dans les deux cas : l'écart vient de la chaîne
+            ASSERT_LT(internedBytes * 3, stringBytes * 2);
+        }
+
+    }
+}